@@ -63,7 +63,7 @@ ipcMain.handle('apply-diff', async (_evt, payload) => {
       return { ok: false, message: 'Kai core not built. From repo root, run: npm run build' };
     }
 
-    const fs = new FileSystem();
+    const fs = new FileSystem(payload.projectRoot);
     const absPath = path.resolve(payload.projectRoot, payload.filePath);
     const ok = await fs.applyDiffToFile(absPath, payload.diff);
     return ok
@@ -164,3 +164,80 @@ ipcMain.handle('load-conversation', async (_evt, payload) => {
     return { ok: false, message: (err && err.message) || String(err) };
   }
 });
+
+// --- Streamed chat ---
+// One DesktopChat per project root (its creation promise, so concurrent sends share it);
+// in-flight requests can be cancelled by id.
+const chats = new Map();
+const activeStreams = new Map();
+const DELTA_FLUSH_MS = 16; // Coalesce model deltas into at most one IPC message per frame
+
+function chatFor(projectRoot) {
+  let chat = chats.get(projectRoot);
+  if (!chat) {
+    const req = createRequire(import.meta.url);
+    const { DesktopChat } = req('../../bin/lib/desktop/DesktopChat.js');
+    chat = DesktopChat.create(projectRoot);
+    chats.set(projectRoot, chat);
+    chat.catch(() => chats.delete(projectRoot)); // Let the next send try again
+  }
+  return chat;
+}
+
+// IPC: send a user message and stream the answer back as 'chat-delta' events
+ipcMain.handle('send-message', async (evt, payload) => {
+  // payload: { projectRoot: string, conversationPath: string, requestId: string, content: string }
+  if (!payload?.projectRoot || !payload?.conversationPath || !payload?.requestId || !payload?.content) {
+    return { ok: false, message: 'projectRoot, conversationPath, requestId, and content required' };
+  }
+  let chat;
+  try {
+    chat = await chatFor(payload.projectRoot);
+  } catch (err) {
+    // Config errors (e.g. MissingApiKeyError) come back to the window by name; the app keeps running
+    const missing = err && err.code === 'MODULE_NOT_FOUND';
+    return {
+      ok: false,
+      error: (err && err.name) || 'Error',
+      message: missing ? 'Kai core not built. From repo root, run: npm run build' : (err && err.message) || String(err),
+    };
+  }
+
+  const sender = evt.sender;
+  const controller = new AbortController();
+  activeStreams.set(payload.requestId, controller);
+  const abortOnClose = () => controller.abort(); // Window closed mid-stream
+  sender.once('destroyed', abortOnClose);
+  let pending = '';
+  let timer = null;
+  const flush = () => {
+    timer = null;
+    if (!pending || sender.isDestroyed()) return;
+    sender.send('chat-delta', { requestId: payload.requestId, text: pending });
+    pending = '';
+  };
+  const onDelta = (text) => {
+    pending += text;
+    if (!timer) timer = setTimeout(flush, DELTA_FLUSH_MS);
+  };
+
+  try {
+    const result = await chat.send(payload.conversationPath, payload.content, onDelta, controller.signal);
+    return { ok: true, cancelled: result.cancelled, text: result.text };
+  } catch (err) {
+    return { ok: false, message: (err && err.message) || String(err) };
+  } finally {
+    if (timer) clearTimeout(timer);
+    flush(); // Deliver the tail before the invoke resolves
+    activeStreams.delete(payload.requestId);
+    if (!sender.isDestroyed()) sender.removeListener('destroyed', abortOnClose);
+  }
+});
+
+// IPC: cancel an in-flight send-message
+ipcMain.handle('cancel-message', async (_evt, payload) => {
+  const controller = activeStreams.get(payload?.requestId);
+  if (!controller) return { ok: false, message: 'No active request' };
+  controller.abort();
+  return { ok: true };
+});
@@ -8,6 +8,14 @@ try {
     startConversation: async (payload) => ipcRenderer.invoke('start-conversation', payload),
     appendMessage: async (payload) => ipcRenderer.invoke('append-message', payload),
     loadConversation: async (payload) => ipcRenderer.invoke('load-conversation', payload),
+    sendMessage: async (payload) => ipcRenderer.invoke('send-message', payload),
+    cancelMessage: async (payload) => ipcRenderer.invoke('cancel-message', payload),
+    // Returns an unsubscribe function
+    onChatDelta: (callback) => {
+      const listener = (_evt, delta) => callback(delta);
+      ipcRenderer.on('chat-delta', listener);
+      return () => ipcRenderer.removeListener('chat-delta', listener);
+    },
   });
 } catch (e) {
   // eslint-disable-next-line no-console
@@ -80,17 +80,54 @@ startConvBtn.addEventListener('click', async () => {
   }
 });
 
+let activeRequestId = null;
+
 sendMessageBtn.addEventListener('click', async () => {
+  if (activeRequestId) {
+    // Stop: the main process aborts the stream; the partial answer stays on screen
+    await window.kai.cancelMessage({ requestId: activeRequestId });
+    return;
+  }
   const text = messageInputEl.value.trim();
-  if (!text || !conversationPath) return;
-  await window.kai.appendMessage({
-    conversationPath,
-    type: 'request',
-    role: 'user',
-    content: text,
-  });
+  if (!text || !conversationPath || !projectRoot) return;
   messageInputEl.value = '';
-  await loadAndRenderConversation();
+  appendMessageDiv('user', text);
+  const assistantText = document.createTextNode('');
+  appendMessageDiv('assistant', '').appendChild(assistantText);
+  messagesEl.scrollTop = messagesEl.scrollHeight;
+
+  const requestId = crypto.randomUUID();
+  activeRequestId = requestId;
+  sendMessageBtn.textContent = 'Stop';
+
+  // Deltas arrive in bursts; write them to the DOM at most once per animation frame
+  let pending = '';
+  let frame = 0;
+  const flush = () => {
+    frame = 0;
+    if (!pending) return;
+    const atBottom = messagesEl.scrollHeight - messagesEl.scrollTop - messagesEl.clientHeight < 24;
+    assistantText.appendData(pending);
+    pending = '';
+    if (atBottom) messagesEl.scrollTop = messagesEl.scrollHeight;
+  };
+  const unsubscribe = window.kai.onChatDelta((delta) => {
+    if (delta.requestId !== requestId) return;
+    pending += delta.text;
+    if (!frame) frame = requestAnimationFrame(flush);
+  });
+
+  try {
+    const res = await window.kai.sendMessage({ projectRoot, conversationPath, requestId, content: text });
+    if (frame) cancelAnimationFrame(frame);
+    flush();
+    if (!res?.ok) appendMessageDiv('system', res?.message || 'Failed to get a response');
+    else if (res.cancelled) appendMessageDiv('system', 'Response cancelled');
+  } finally {
+    unsubscribe();
+    activeRequestId = null;
+    sendMessageBtn.textContent = 'Send';
+  }
 });
 
 async function loadAndRenderConversation() {
@@ -106,14 +143,20 @@ async function loadAndRenderConversation() {
 function renderMessages(entries) {
   messagesEl.innerHTML = '';
   entries.forEach((e) => {
-    const div = document.createElement('div');
     const role = e.role || (e.type === 'request' ? 'user' : e.type === 'response' ? 'assistant' : 'system');
-    div.textContent = `${role}: ${e.content || e.error || ''}`;
-    div.style.marginBottom = '6px';
-    if (role === 'user') div.style.color = '#111827';
-    if (role === 'assistant') div.style.color = '#1f2937';
-    if (role === 'system') div.style.color = '#6b7280';
-    messagesEl.appendChild(div);
+    appendMessageDiv(role, e.content || e.error || '');
   });
   messagesEl.scrollTop = messagesEl.scrollHeight;
 }
+
+function appendMessageDiv(role, text) {
+  const div = document.createElement('div');
+  div.textContent = `${role}: ${text}`;
+  div.style.marginBottom = '6px';
+  div.style.whiteSpace = 'pre-wrap';
+  if (role === 'user') div.style.color = '#111827';
+  if (role === 'assistant') div.style.color = '#1f2937';
+  if (role === 'system') div.style.color = '#6b7280';
+  messagesEl.appendChild(div);
+  return div;
+}
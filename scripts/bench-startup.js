@@ -0,0 +1,56 @@
+#!/usr/bin/env node
+// scripts/bench-startup.js
+// Measures Kai's time-to-menu by launching the compiled CLI (bin/kai.js) with
+// KAI_STARTUP_BENCH=1, which makes it print its timing and exit right before the menu.
+// Usage: npm run build && npm run bench:startup [-- --runs 7 --budget 1500]
+const { spawnSync, execSync } = require('child_process');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+function arg(name, fallback) {
+    const i = process.argv.indexOf(`--${name}`);
+    return i > -1 ? Number(process.argv[i + 1]) : fallback;
+}
+
+const runs = arg('runs', 7);
+const budgetMs = arg('budget', Number(process.env.KAI_STARTUP_BUDGET_MS) || 1500);
+const kaiBin = path.resolve(__dirname, '..', 'bin', 'kai.js');
+
+if (!fs.existsSync(kaiBin)) {
+    console.error(`Compiled CLI not found at ${kaiBin}. Run 'npm run build' first.`);
+    process.exit(1);
+}
+
+// A throwaway git repo so startup checks run their normal (non-interactive) path.
+const projectDir = fs.mkdtempSync(path.join(os.tmpdir(), 'kai-startup-'));
+execSync('git init -q', { cwd: projectDir });
+
+const samples = [];
+try {
+    for (let i = 0; i < runs; i++) {
+        const res = spawnSync(process.execPath, [kaiBin], {
+            cwd: projectDir,
+            env: { ...process.env, KAI_STARTUP_BENCH: '1', GEMINI_API_KEY: process.env.GEMINI_API_KEY || 'bench-key' },
+            encoding: 'utf8',
+            timeout: 30000,
+        });
+        const match = /KAI_STARTUP_BENCH (\{.*\})/.exec(res.stdout || '');
+        if (!match) {
+            console.error(`Run ${i + 1} did not report timing (exit ${res.status}).\n${res.stderr}`);
+            process.exit(1);
+        }
+        samples.push(JSON.parse(match[1]).timeToMenuMs);
+    }
+} finally {
+    fs.rmSync(projectDir, { recursive: true, force: true });
+}
+
+samples.sort((a, b) => a - b);
+const median = samples[Math.floor(samples.length / 2)];
+// The first run also warms Node's compile cache; the median keeps that outlier out of the verdict.
+console.log(JSON.stringify({ runs, samples, medianMs: median, budgetMs }));
+if (median > budgetMs) {
+    console.error(`Time-to-menu median ${median}ms exceeds budget ${budgetMs}ms.`);
+    process.exit(1);
+}
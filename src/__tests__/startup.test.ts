@@ -0,0 +1,98 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+
+// Record every heavy module that gets loaded. Factories only run on first require,
+// so an entry here means something on the startup path pulled the module in.
+const mockLoaded: string[] = [];
+jest.mock('openai', () => { mockLoaded.push('openai'); return {}; });
+jest.mock('@anthropic-ai/sdk', () => { mockLoaded.push('@anthropic-ai/sdk'); return {}; });
+jest.mock('@google/generative-ai', () => { mockLoaded.push('@google/generative-ai'); return {}; });
+jest.mock('marked', () => { mockLoaded.push('marked'); return { marked: { parse: (s: string) => s } }; });
+jest.mock('gpt-3-encoder', () => {
+  mockLoaded.push('gpt-3-encoder');
+  return { encode: (t: string) => t.split(' '), decode: (t: string[]) => t.join(' ') };
+});
+
+// Upper bound for the in-process startup path (checks + service construction) up to the menu.
+const TIME_TO_MENU_BUDGET_MS = Number(process.env.KAI_STARTUP_BUDGET_MS) || 1000;
+
+describe('startup', () => {
+  let tmpDir: string;
+
+  beforeAll(() => {
+    process.env.GEMINI_API_KEY = process.env.GEMINI_API_KEY || 'test-key';
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+    jest.spyOn(console, 'warn').mockImplementation(() => {});
+  });
+
+  beforeEach(() => {
+    tmpDir = fs.mkdtempSync(path.join(os.tmpdir(), 'kai-startup-'));
+  });
+
+  afterEach(() => {
+    fs.rmSync(tmpDir, { recursive: true, force: true });
+  });
+
+  it('loads the CLI and constructs AIClient without loading provider SDKs or the tokenizer', () => {
+    require('../kai');
+    const { AIClient } = require('../lib/AIClient');
+    new AIClient({ gemini: { api_key: 'k', model_name: 'gemini-2.5-pro' }, openai: { api_key: 'o' } });
+    expect(mockLoaded).toEqual([]);
+  });
+
+  it('loads the tokenizer on the first token count', () => {
+    const { countTokens } = require('../lib/utils');
+    expect(countTokens('a b c')).toBe(3);
+    expect(mockLoaded).toContain('gpt-3-encoder');
+  });
+
+  it('runs git setup and .kai scaffolding concurrently', async () => {
+    const { performStartupChecks } = require('../kai');
+    const { FileSystem } = require('../lib/FileSystem');
+    let gitignoreDone = false;
+    let gitignorePendingWhenScaffolding: boolean | null = null;
+    const gitService: any = {
+      isGitRepository: jest.fn().mockResolvedValue(true),
+      ensureGitignoreRules: jest.fn(() => new Promise<void>(r => setTimeout(() => { gitignoreDone = true; r(); }, 30))),
+    };
+    const fsUtil = new FileSystem();
+    const realEnsure = fsUtil.ensureKaiDirectoryExists.bind(fsUtil);
+    jest.spyOn(fsUtil, 'ensureKaiDirectoryExists').mockImplementation(async (dir: any) => {
+      gitignorePendingWhenScaffolding = !gitignoreDone;
+      return realEnsure(dir);
+    });
+
+    const ok = await performStartupChecks(tmpDir, fsUtil, gitService, {} as any);
+
+    expect(ok).toBe(true);
+    expect(gitignorePendingWhenScaffolding).toBe(true);
+    expect(fs.existsSync(path.join(tmpDir, '.kai', 'config.yaml'))).toBe(true);
+    expect(fs.existsSync(path.join(tmpDir, '.kaiignore'))).toBe(true);
+  });
+
+  it(`reaches the menu within ${TIME_TO_MENU_BUDGET_MS}ms`, async () => {
+    const { performStartupChecks } = require('../kai');
+    const { FileSystem } = require('../lib/FileSystem');
+    const { Config } = require('../lib/Config');
+    const { UserInterface } = require('../lib/UserInterface');
+    const { AIClient } = require('../lib/AIClient');
+    const { ProjectContextBuilder } = require('../lib/ProjectContextBuilder');
+    const gitService: any = {
+      isGitRepository: jest.fn().mockResolvedValue(true),
+      ensureGitignoreRules: jest.fn().mockResolvedValue(undefined),
+    };
+
+    const start = performance.now();
+    const fsUtil = new FileSystem();
+    expect(await performStartupChecks(tmpDir, fsUtil, gitService, {} as any)).toBe(true);
+    const config = await Config.load();
+    new UserInterface(config);
+    const aiClient = new AIClient(config);
+    new ProjectContextBuilder(fsUtil, gitService, tmpDir, config, aiClient);
+    const elapsed = performance.now() - start;
+
+    expect(elapsed).toBeLessThan(TIME_TO_MENU_BUDGET_MS);
+    expect(mockLoaded).not.toContain('@google/generative-ai');
+  });
+});
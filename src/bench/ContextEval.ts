@@ -0,0 +1,177 @@
+// src/bench/ContextEval.ts
+// Offline evaluation of context strategies: past conversation turns, with the files their
+// consolidation went on to change as ground truth, are replayed through each context mode at
+// several prompt budgets. Scores are recall of the changed files, tokens spent and build time.
+import { performance } from 'perf_hooks';
+import type { Config } from '../lib/Config';
+import type { ProjectContextBuilder } from '../lib/ProjectContextBuilder';
+import type { FeedbackRecord } from '../lib/analysis/RelevanceFeedback';
+import Conversation, { JsonlLogEntry, Message, summarizeHistory } from '../lib/models/Conversation';
+import { ContextDeltaTracker } from '../lib/context/ContextDeltaTracker';
+import { CONSOLIDATION_CHANGED_FILES_PREFIX, CONSOLIDATION_SUCCESS_MARKER } from '../lib/consolidation/constants';
+import { percentile } from '../lib/telemetry/Metrics';
+import { median } from './runBench';
+
+export type ContextStrategy = 'full' | 'analysis_cache' | 'dynamic' | 'auto';
+
+export interface EvalCase {
+    source: string;          // Conversation name, or 'feedback' for relevance feedback records
+    query: string;
+    historySummary: string | null;
+    changed: string[];       // Files the following consolidation wrote or deleted
+}
+
+export interface StrategyScore {
+    strategy: ContextStrategy;
+    budget: number;          // gemini.max_prompt_tokens for the run
+    cases: number;
+    recall: number;          // Mean share of changed files whose code was in a context that fit the budget
+    coverage: number;        // ...named at all (code or summary)
+    overBudget: number;      // Cases whose context exceeded the budget (scored 0)
+    errors: number;
+    meanTokens: number;
+    recallPer1kTokens: number;
+    medianMs: number;
+    p95Ms: number;
+}
+
+const normalize = (filePath: string) => filePath.replace(/\\/g, '/').replace(/^\.\//, '');
+
+/** Parses the changed-files entry ConsolidationService logs before its success marker. */
+export function parseChangedFiles(content: string): string[] | null {
+    if (!content.startsWith(CONSOLIDATION_CHANGED_FILES_PREFIX)) return null;
+    return content.split('\n').slice(1)
+        .filter(line => line.startsWith('- '))
+        .map(line => normalize(line.slice(2).trim()));
+}
+
+/**
+ * One case per user turn that was followed by a consolidation which changed files. Turns
+ * ended by a consolidation that logged no changed files (older logs) have no ground truth.
+ */
+export function casesFromConversation(name: string, entries: JsonlLogEntry[]): EvalCase[] {
+    const cases: EvalCase[] = [];
+    const history: Message[] = [];
+    let pending: EvalCase[] = [];
+    for (const message of Conversation.fromJsonlData(entries).getMessages()) {
+        if (message.role === 'system') {
+            const changed = parseChangedFiles(message.content);
+            if (changed && changed.length > 0) {
+                cases.push(...pending.map(c => ({ ...c, changed })));
+                pending = [];
+            } else if (message.content === CONSOLIDATION_SUCCESS_MARKER) {
+                pending = [];
+            }
+            continue;
+        }
+        if (message.role === 'user' && !message.content.startsWith('/')) {
+            pending.push({ source: name, query: message.content, historySummary: summarizeHistory(history), changed: [] });
+        }
+        history.push(message);
+    }
+    return cases;
+}
+
+/** Dynamic selections recorded with their consolidation outcome (covers older conversations). */
+export function casesFromFeedback(records: FeedbackRecord[]): EvalCase[] {
+    return records
+        .filter(r => r.query && Array.isArray(r.changed) && r.changed.length > 0)
+        .map(r => ({ source: 'feedback', query: r.query, historySummary: null, changed: r.changed.map(normalize) }));
+}
+
+/** Keeps the first case for each query and changed-file set. */
+export function dedupeCases(cases: EvalCase[]): EvalCase[] {
+    const seen = new Set<string>();
+    return cases.filter(c => {
+        const key = `${c.query}\0${[...c.changed].sort().join('\0')}`;
+        if (seen.has(key)) return false;
+        seen.add(key);
+        return true;
+    });
+}
+
+/**
+ * Files in a context string: `withCode` when the block carries code (whole file, symbol or
+ * chunk), `named` for any block, including analysis-cache summaries.
+ */
+export function contextFiles(context: string): { withCode: Set<string>; named: Set<string> } {
+    const withCode = new Set<string>();
+    const named = new Set<string>();
+    for (const [key, body] of ContextDeltaTracker.parse(context).blocks) {
+        const filePath = normalize(key.split(/ [([]/)[0].trim());
+        named.add(filePath);
+        if (body.includes('```')) withCode.add(filePath);
+    }
+    return { withCode, named };
+}
+
+const round = (value: number, digits = 4) => Math.round(value * 10 ** digits) / 10 ** digits;
+
+/**
+ * Builds context for every case with each strategy at each budget and scores it. The config
+ * is the builder's own (mode and prompt budget are switched per run and restored afterwards).
+ */
+export async function evaluateStrategies(
+    cases: EvalCase[],
+    builder: Pick<ProjectContextBuilder, 'buildContext'>,
+    config: Config,
+    strategies: ContextStrategy[],
+    budgets: number[]
+): Promise<StrategyScore[]> {
+    const saved = { mode: config.context.mode, budget: config.gemini.max_prompt_tokens };
+    const scores: StrategyScore[] = [];
+    try {
+        for (const strategy of strategies) {
+            for (const budget of budgets) {
+                config.context.mode = strategy;
+                config.gemini.max_prompt_tokens = budget;
+                let recall = 0;
+                let coverage = 0;
+                let overBudget = 0;
+                let errors = 0;
+                const tokens: number[] = [];
+                const latencies: number[] = [];
+                for (const testCase of cases) {
+                    const start = performance.now();
+                    let result: { context: string; tokenCount: number };
+                    try {
+                        // No relevance feedback: the outcome being scored must not train the selection
+                        result = await builder.buildContext(testCase.query, testCase.historySummary, null);
+                    } catch {
+                        errors++;
+                        continue;
+                    }
+                    latencies.push(performance.now() - start);
+                    tokens.push(result.tokenCount);
+                    if (result.tokenCount > budget) {
+                        overBudget++;
+                        continue;
+                    }
+                    const files = contextFiles(result.context);
+                    recall += testCase.changed.filter(f => files.withCode.has(f)).length / testCase.changed.length;
+                    coverage += testCase.changed.filter(f => files.named.has(f)).length / testCase.changed.length;
+                }
+                const scored = cases.length - errors;
+                const meanTokens = tokens.length ? tokens.reduce((a, b) => a + b, 0) / tokens.length : 0;
+                const meanRecall = scored > 0 ? recall / scored : 0;
+                scores.push({
+                    strategy,
+                    budget,
+                    cases: cases.length,
+                    recall: round(meanRecall),
+                    coverage: round(scored > 0 ? coverage / scored : 0),
+                    overBudget,
+                    errors,
+                    meanTokens: Math.round(meanTokens),
+                    recallPer1kTokens: round(meanTokens > 0 ? meanRecall / (meanTokens / 1000) : 0),
+                    medianMs: round(latencies.length ? median(latencies) : 0, 2),
+                    p95Ms: round(percentile([...latencies].sort((a, b) => a - b), 95), 2),
+                });
+            }
+        }
+    } finally {
+        config.context.mode = saved.mode;
+        config.gemini.max_prompt_tokens = saved.budget;
+    }
+    return scores;
+}
@@ -0,0 +1,252 @@
+// src/bench/DiffCorpus.ts
+// Regression corpus of real failed model diffs (from .kai/logs/diff_failures.jsonl) and a
+// replay that runs each one through the patching stages, recording whether it applied and
+// how long it took. Cases can be anonymised so a corpus can be shared outside the project.
+import crypto from 'crypto';
+import path from 'path';
+import os from 'os';
+import { promises as fsPromises } from 'fs';
+import { performance } from 'perf_hooks';
+import { applyPatch, parsePatch } from 'diff';
+import { FileSystem, DiffFailureInfo, fuzzyApplyPatch, stripDiffFences } from '../lib/FileSystem';
+import { percentile } from '../lib/telemetry/Metrics';
+import { median } from './runBench';
+
+export interface DiffCorpusCase {
+    id: string;            // Hash of the original content and diff (stable across rebuilds)
+    file: string;
+    original: string;
+    diff: string;
+    error?: string;        // Why it failed when it was logged
+    anonymized: boolean;
+}
+
+export interface DiffStageOutcome {
+    applied: boolean;
+    ms: number;            // Median over the replay iterations
+    error?: string;
+}
+
+export interface DiffStageSummary {
+    stage: string;
+    applied: number;
+    total: number;
+    successRate: number;
+    medianMs: number;
+    p95Ms: number;
+    maxMs: number;
+}
+
+export interface DiffReplayReport {
+    stages: DiffStageSummary[];
+    cases: Array<{ id: string; file: string; outcomes: Record<string, DiffStageOutcome> }>;
+}
+
+/**
+ * A way of applying a diff. `prepare` runs untimed before every attempt (e.g. to reset a file
+ * on disk); `apply` returns the patched content, or throws/returns null when it fails.
+ */
+export interface DiffStage {
+    name: string;
+    prepare?: (testCase: DiffCorpusCase) => Promise<void>;
+    apply: (testCase: DiffCorpusCase) => Promise<string | null>;
+}
+
+// Words kept as-is when anonymising: language keywords and common built-ins keep the code's
+// shape (and therefore how patches match) recognisable without revealing project names.
+const KEPT_WORDS = new Set(`
+    abstract and as assert async await boolean break case catch class const constructor continue
+    debugger declare def default del delete do elif else enum except export extends false final
+    finally for from func function get go if implements import in instanceof interface is lambda
+    let new nil none None not null number object of or package pass private protected public raise
+    readonly return self set static string struct super switch this throw throws true True False
+    try type typeof undefined var void while with yield any never unknown require module exports
+    console log error string int float bool map range chan defer select fmt print len str dict list
+    tuple Promise Array Map Set Object String Number Boolean Error JSON Math Date
+`.split(/\s+/).filter(Boolean));
+const WORD = /[A-Za-z_$][\w$]*/g;
+const HUNK_HEADER = /^(@@ -\d+(?:,\d+)? \+\d+(?:,\d+)? @@)(.*)$/;
+
+/**
+ * Consistently renames identifiers and words (keywords excepted) across a case's file content,
+ * diff, path and error, so the anonymised diff applies (or fails) exactly like the original:
+ * line structure, whitespace, punctuation and numbers are untouched, and equal lines stay equal.
+ */
+export class DiffAnonymizer {
+    private names = new Map<string, string>();
+
+    word(original: string): string {
+        if (KEPT_WORDS.has(original)) return original;
+        let renamed = this.names.get(original);
+        if (!renamed) {
+            renamed = `w${this.names.size + 1}_`; // Trailing underscore: never collides with a kept word
+            this.names.set(original, renamed);
+        }
+        return renamed;
+    }
+
+    text(text: string): string {
+        return text.replace(WORD, w => this.word(w));
+    }
+
+    /** Renames path segments but keeps the extension (patch behaviour doesn't depend on it). */
+    path(filePath: string): string {
+        if (filePath === '/dev/null') return filePath;
+        return filePath.split(/([\\/])/).map((segment, i, all) => {
+            if (segment === '/' || segment === '\\' || segment === '' || segment === '.' || segment === '..') return segment;
+            const isLast = i === all.length - 1;
+            const ext = isLast ? path.extname(segment) : '';
+            return this.text(segment.slice(0, segment.length - ext.length)) + ext;
+        }).join('');
+    }
+
+    /** Anonymises a unified diff, keeping its headers and hunk ranges intact. */
+    diff(diff: string): string {
+        const lines = diff.split('\n');
+        // A '--- x' line inside a hunk is a removed '-- x' line; headers come as ---/+++ pairs
+        const isHeader = (i: number) =>
+            (lines[i].startsWith('--- ') && (lines[i + 1] ?? '').startsWith('+++ ')) ||
+            (lines[i].startsWith('+++ ') && (lines[i - 1] ?? '').startsWith('--- '));
+        return lines.map((line, i) => {
+            const header = isHeader(i) ? line.match(/^(---|\+\+\+) (\S+)(.*)$/) : null;
+            if (header) return `${header[1]} ${this.path(header[2])}${this.text(header[3])}`;
+            if (line.startsWith('\\')) return line; // "\ No newline at end of file"
+            const hunk = line.match(HUNK_HEADER);
+            if (hunk) return hunk[1] + this.text(hunk[2]);
+            if (line.startsWith('diff --git ')) return `diff --git ${line.slice(11).split(' ').map(p => this.path(p)).join(' ')}`;
+            if (line.startsWith('index ')) return line;
+            if (line.startsWith('Index: ')) return `Index: ${this.path(line.slice(7))}`;
+            return this.text(line);
+        }).join('\n');
+    }
+
+    /** Renames only words already renamed elsewhere in the case (error messages are ours). */
+    error(message: string): string {
+        return message.replace(WORD, w => this.names.get(w) ?? w);
+    }
+}
+
+/**
+ * Turns logged diff failures into corpus cases: entries without a diff are skipped and
+ * repeats of the same diff against the same content are kept once.
+ */
+export function buildDiffCorpus(entries: Array<Partial<DiffFailureInfo>>, options: { anonymize?: boolean } = {}): DiffCorpusCase[] {
+    const cases = new Map<string, DiffCorpusCase>();
+    for (const entry of entries) {
+        if (typeof entry.diff !== 'string' || entry.diff.trim().length === 0) continue;
+        const original = typeof entry.fileContent === 'string' ? entry.fileContent : '';
+        const id = crypto.createHash('sha1').update(original).update('\0').update(entry.diff).digest('hex').slice(0, 12);
+        if (cases.has(id)) continue;
+        const file = entry.file ?? 'unknown';
+        let testCase: DiffCorpusCase = { id, file, original, diff: entry.diff, error: entry.error, anonymized: false };
+        if (options.anonymize) {
+            const anonymizer = new DiffAnonymizer();
+            testCase = {
+                id,
+                original: anonymizer.text(original),
+                diff: anonymizer.diff(entry.diff),
+                file: anonymizer.path(path.isAbsolute(file) ? path.basename(file) : file),
+                error: entry.error === undefined ? undefined : anonymizer.error(entry.error),
+                anonymized: true,
+            };
+        }
+        cases.set(id, testCase);
+    }
+    return [...cases.values()];
+}
+
+/** Parses the first patch of a diff the way `applyDiffToFile` does. */
+function firstPatch(diff: string) {
+    const patches = parsePatch(diff);
+    if (patches.length === 0 || patches.every(p => p.hunks.length === 0)) throw new Error('No patch data');
+    return patches[0];
+}
+
+function strictApply(testCase: DiffCorpusCase): string | null {
+    const diff = stripDiffFences(testCase.diff);
+    firstPatch(diff);
+    const result = applyPatch(testCase.original, diff);
+    return result === false ? null : result;
+}
+
+/**
+ * The patching stages replayed by default: the strict `applyPatch`, strict plus the
+ * `fuzzyApplyPatch` fallback, and the full `FileSystem.applyDiffToFile` path on a scratch file
+ * (including its empty-result check and the write). Local repair stages added to the patch
+ * pipeline belong here too, so their effect shows up in the success rate.
+ */
+export function defaultDiffStages(scratchDir: string, fs: FileSystem = new FileSystem()): DiffStage[] {
+    const scratchFile = (testCase: DiffCorpusCase) => path.join(scratchDir, `${testCase.id}${path.extname(testCase.file)}`);
+    return [
+        { name: 'applyPatch', apply: async testCase => strictApply(testCase) },
+        {
+            name: 'fuzzyApplyPatch',
+            apply: async testCase => strictApply(testCase)
+                ?? fuzzyApplyPatch(testCase.original, firstPatch(stripDiffFences(testCase.diff))),
+        },
+        {
+            name: 'applyDiffToFile',
+            prepare: async testCase => fsPromises.writeFile(scratchFile(testCase), testCase.original),
+            apply: async testCase => {
+                const target = scratchFile(testCase);
+                if (!await fs.applyDiffToFile(target, testCase.diff)) {
+                    throw new Error(fs.lastDiffFailure?.error ?? 'applyDiffToFile failed');
+                }
+                return fsPromises.readFile(target, 'utf8').catch(() => ''); // Deleted by the diff
+            },
+        },
+    ];
+}
+
+const round = (ms: number) => Math.round(ms * 1000) / 1000;
+
+/** Replays every case through every stage `iterations` times. */
+export async function replayDiffCorpus(cases: DiffCorpusCase[], stages: DiffStage[], iterations = 1): Promise<DiffReplayReport> {
+    const report: DiffReplayReport = { stages: [], cases: cases.map(c => ({ id: c.id, file: c.file, outcomes: {} })) };
+    for (const stage of stages) {
+        const latencies: number[] = [];
+        let applied = 0;
+        for (let i = 0; i < cases.length; i++) {
+            const samples: number[] = [];
+            let outcome: DiffStageOutcome = { applied: false, ms: 0 };
+            for (let n = 0; n < Math.max(1, iterations); n++) {
+                if (stage.prepare) await stage.prepare(cases[i]);
+                const start = performance.now();
+                try {
+                    const result = await stage.apply(cases[i]);
+                    outcome = result === null ? { applied: false, ms: 0, error: 'Patch did not apply' } : { applied: true, ms: 0 };
+                } catch (error) {
+                    outcome = { applied: false, ms: 0, error: error instanceof Error ? error.message : String(error) };
+                }
+                samples.push(performance.now() - start);
+            }
+            outcome.ms = round(median(samples));
+            latencies.push(outcome.ms);
+            if (outcome.applied) applied++;
+            report.cases[i].outcomes[stage.name] = outcome;
+        }
+        report.stages.push({
+            stage: stage.name,
+            applied,
+            total: cases.length,
+            successRate: cases.length === 0 ? 0 : Math.round((applied / cases.length) * 10000) / 10000,
+            medianMs: latencies.length === 0 ? 0 : round(median(latencies)),
+            p95Ms: round(percentile([...latencies].sort((a, b) => a - b), 95)),
+            maxMs: latencies.length === 0 ? 0 : round(Math.max(...latencies)),
+        });
+    }
+    return report;
+}
+
+/** Stages whose success rate fell more than `tolerance` (absolute) below a previous replay. */
+export function findSuccessRegressions(current: DiffStageSummary[], baseline: DiffStageSummary[], tolerance = 0): DiffStageSummary[] {
+    return current.filter(stage => {
+        const previous = baseline.find(b => b.stage === stage.stage);
+        return previous !== undefined && stage.successRate < previous.successRate - tolerance;
+    });
+}
+
+/** Creates a scratch directory for stages that patch files on disk. */
+export function createScratchDir(): Promise<string> {
+    return fsPromises.mkdtemp(path.join(os.tmpdir(), 'kai-diff-bench-'));
+}
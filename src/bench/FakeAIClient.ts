@@ -0,0 +1,155 @@
+// src/bench/FakeAIClient.ts
+import type { GenerateContentRequest, GenerateContentResult } from '@google/generative-ai';
+import type { AIClient, LogEntryData } from '../lib/AIClient';
+import type Conversation from '../lib/models/Conversation';
+import type { Message } from '../lib/models/Conversation';
+import { SyntaxChunker } from '../lib/analysis/SyntaxChunker';
+
+export interface FakeAIClientOptions {
+    latencyMs?: number;           // Simulated per-call model latency
+    relevantFileCount?: number;   // How many files the dynamic relevance step "selects"
+    relevance?: 'hash' | 'lexical'; // Pick files by prompt hash (default) or by query-term overlap
+    operations?: Array<{ filePath: string; action: 'CREATE' | 'MODIFY' | 'DELETE' }>; // Consolidation analysis answer
+    groups?: string[][];          // Related files the analysis asks to generate together
+    apiKeys?: number;             // Simulated key pool size (calls worth running at once)
+}
+
+/** FNV-1a, used to make every answer a pure function of the prompt. */
+function hash(text: string): number {
+    let h = 0x811c9dc5;
+    for (let i = 0; i < text.length; i++) {
+        h ^= text.charCodeAt(i);
+        h = Math.imul(h, 0x01000193);
+    }
+    return h >>> 0;
+}
+
+/**
+ * Deterministic stand-in for AIClient used by the benchmark suite.
+ * It recognises Kai's own prompts (batch summaries, relevance selection, consolidation
+ * analysis and per-file or grouped generation) and answers them from the prompt text alone, so a
+ * benchmark run measures Kai's work and never the network.
+ */
+export class FakeAIClient {
+    calls = 0;
+    promptChars = 0;
+    private options: FakeAIClientOptions;
+
+    constructor(options: FakeAIClientOptions = {}) {
+        this.options = options;
+    }
+
+    /** Returns this stub typed as the real client so it can be injected anywhere. */
+    asAIClient(): AIClient {
+        return this as unknown as AIClient;
+    }
+
+    modelParallelism(): number {
+        return this.options.apiKeys ?? 1;
+    }
+
+    async logConversation(_conversationFilePath: string, _entryData: LogEntryData): Promise<void> {
+        // Benchmarks do not persist conversation logs.
+    }
+
+    async getResponseFromAI(conversation: Conversation, _conversationFilePath: string, contextString?: string): Promise<string> {
+        const last = conversation.getMessages().slice(-1)[0]?.content ?? '';
+        await this._simulateCall(last + (contextString ?? ''));
+        return `Acknowledged (${hash(last).toString(16)}).`;
+    }
+
+    async getResponseTextFromAI(messages: Message[], _useFlashModel: boolean = false): Promise<string> {
+        const prompt = messages.map(m => m.content).join('\n');
+        await this._simulateCall(prompt);
+        return this.answer(prompt);
+    }
+
+    async generateContent(request: GenerateContentRequest): Promise<GenerateContentResult> {
+        const prompt = JSON.stringify(request.contents ?? []);
+        await this._simulateCall(prompt);
+        const text = this.answer(prompt);
+        return { response: { text: () => text, candidates: [{ index: 0, content: { role: 'model', parts: [{ text }] } }] } } as unknown as GenerateContentResult;
+    }
+
+    /** Produces the deterministic answer for a prompt. Exposed for tests. */
+    answer(prompt: string): string {
+        if (prompt.includes('SYMBOLS IN BATCH:')) {
+            const summaries: Record<string, string> = {};
+            for (const match of prompt.matchAll(/^Symbol: (.+)$/gm)) {
+                const id = match[1].trim();
+                summaries[id] = `Synthetic symbol ${id} (#${(hash(id) % 997)}).`;
+            }
+            return JSON.stringify({ summaries });
+        }
+        if (prompt.includes('FILES IN BATCH:')) {
+            const summaries: Record<string, string> = {};
+            for (const match of prompt.matchAll(/^File: (.+)$/gm)) {
+                const filePath = match[1].trim();
+                summaries[filePath] = `Synthetic module ${filePath} (#${(hash(filePath) % 997)}).`;
+            }
+            return JSON.stringify({ summaries });
+        }
+        if (prompt.includes('Available Files Overview:')) {
+            const paths = Array.from(prompt.matchAll(/^- (\S+) \[/gm), m => m[1]);
+            if (paths.length === 0) return 'NONE';
+            if (this.options.relevance === 'lexical') return this._lexicalSelection(prompt);
+            const seed = hash(prompt.split('PROJECT ANALYSIS SUMMARY:')[0]);
+            const count = Math.min(paths.length, this.options.relevantFileCount ?? 10);
+            const picked: string[] = [];
+            for (let i = 0; i < count; i++) {
+                picked.push(paths[(seed + i * 7919) % paths.length]);
+            }
+            return Array.from(new Set(picked)).join('\n');
+        }
+        if (prompt.includes('containing the key "operations"')) {
+            return JSON.stringify({ operations: this.options.operations ?? [], groups: this.options.groups });
+        }
+        if (prompt.includes('=== FILE: <file path> ===')) {
+            const tail = prompt.slice(prompt.lastIndexOf('keeping them consistent with each other:'));
+            const filePaths = Array.from(tail.matchAll(/^- '([^']+)'$/gm), m => m[1]);
+            return filePaths.map(filePath => `=== FILE: ${filePath} ===\n${this._generatedFile(filePath, prompt)}\n=== END FILE ===`).join('\n');
+        }
+        const generation = prompt.match(/File Path: '([^']+)'/);
+        if (generation) {
+            return this._generatedFile(generation[1], prompt);
+        }
+        return `OK ${hash(prompt).toString(16)}`;
+    }
+
+    /**
+     * Stand-in for a model's judgement: ranks overview lines (path, type, summary) by how many
+     * query and history terms they share, so better overviews and budgeting score better.
+     */
+    private _lexicalSelection(prompt: string): string {
+        const queryStart = prompt.indexOf('USER QUERY:');
+        const overviewStart = prompt.indexOf('PROJECT ANALYSIS SUMMARY:');
+        const query = prompt.slice(queryStart === -1 ? 0 : queryStart + 'USER QUERY:'.length, overviewStart)
+            .replace(/^(RECENT CONVERSATION SUMMARY|Recent conversation highlights):$/gm, '')
+            .replace(/^\s*(user|assistant|system): /gm, '');
+        const terms = new Set(SyntaxChunker.queryTerms(query));
+        const scored: Array<{ filePath: string; score: number }> = [];
+        for (const match of prompt.slice(overviewStart).matchAll(/^- (\S+) \[([^\]]*)\](.*)$/gm)) {
+            if (match[2] === 'binary') continue;
+            const summary = match[3].split(' - Summary: ')[1] ?? '';
+            const score = SyntaxChunker.queryTerms(`${match[1]} ${summary}`).filter(t => terms.has(t)).length;
+            if (score > 0) scored.push({ filePath: match[1], score });
+        }
+        scored.sort((a, b) => b.score - a.score || a.filePath.localeCompare(b.filePath));
+        const picked = scored.slice(0, this.options.relevantFileCount ?? 10).map(s => s.filePath);
+        return picked.length > 0 ? picked.join('\n') : 'NONE';
+    }
+
+    private _generatedFile(filePath: string, prompt: string): string {
+        const op = this.options.operations?.find(o => o.filePath === filePath);
+        if (op?.action === 'DELETE') return 'DELETE_FILE';
+        return `// ${filePath}\nexport const generated = ${hash(prompt) % 100000};\n`;
+    }
+
+    private async _simulateCall(prompt: string): Promise<void> {
+        this.calls++;
+        this.promptChars += prompt.length;
+        if (this.options.latencyMs) {
+            await new Promise(resolve => setTimeout(resolve, this.options.latencyMs));
+        }
+    }
+}
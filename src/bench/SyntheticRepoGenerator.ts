@@ -0,0 +1,202 @@
+// src/bench/SyntheticRepoGenerator.ts
+import path from 'path';
+import { promises as fsPromises } from 'fs';
+
+/**
+ * Options for a synthetic repository. Everything is derived from `seed`, so the same
+ * options always produce byte-identical trees (file names, sizes and contents).
+ */
+export interface SyntheticRepoOptions {
+    seed: number;
+    fileCount: number;                      // Total files written, all categories included
+    languageMix?: Record<string, number>;   // Source extension -> relative weight
+    meanFileBytes?: number;                 // Mean size of a source file (sizes are exponential)
+    maxFileBytes?: number;                  // Hard cap per file
+    filesPerDir?: number;                   // Directory fan-out for source files
+    generatedFraction?: number;             // Share of files under dist/ (build output)
+    vendoredFraction?: number;              // Share of files under node_modules/
+    binaryFraction?: number;                // Share of binary assets under assets/
+    gitignore?: string[];                   // Lines written to .gitignore
+    kaiignore?: string[];                   // Lines written to .kaiignore
+    writeConcurrency?: number;
+}
+
+export interface SyntheticRepoManifest {
+    root: string;
+    seed: number;
+    files: string[];        // Every written file, relative POSIX path
+    sourceFiles: string[];  // Hand-written-looking source files (the ones Kai should see)
+    totalBytes: number;
+}
+
+export const DEFAULT_LANGUAGE_MIX: Record<string, number> = {
+    '.ts': 45, '.js': 15, '.json': 8, '.md': 7, '.py': 10, '.go': 5, '.css': 5, '.yaml': 5,
+};
+
+/** mulberry32: tiny, fast, seedable PRNG. Returns floats in [0, 1). */
+export function createRng(seed: number): () => number {
+    let a = seed >>> 0;
+    return () => {
+        a = (a + 0x6D2B79F5) >>> 0;
+        let t = a;
+        t = Math.imul(t ^ (t >>> 15), t | 1);
+        t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+        return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    };
+}
+
+const WORDS = [
+    'user', 'order', 'cache', 'config', 'session', 'token', 'report', 'invoice', 'queue', 'worker',
+    'parser', 'render', 'filter', 'account', 'payment', 'search', 'index', 'metric', 'event', 'stream',
+];
+
+function pick<T>(rng: () => number, items: T[]): T {
+    return items[Math.floor(rng() * items.length)];
+}
+
+function pickWeighted(rng: () => number, weights: [string, number][], total: number): string {
+    let r = rng() * total;
+    for (const [key, w] of weights) {
+        r -= w;
+        if (r < 0) return key;
+    }
+    return weights[weights.length - 1][0];
+}
+
+function identifier(rng: () => number): string {
+    const a = pick(rng, WORDS);
+    const b = pick(rng, WORDS);
+    return a + b.charAt(0).toUpperCase() + b.slice(1);
+}
+
+/** Produces plausible-looking source text of roughly `targetBytes` for the given extension. */
+function sourceContent(rng: () => number, ext: string, targetBytes: number): string {
+    const lines: string[] = [];
+    let size = 0;
+    const push = (line: string) => { lines.push(line); size += line.length + 1; };
+    while (size < targetBytes) {
+        const name = identifier(rng);
+        const n = Math.floor(rng() * 1000);
+        switch (ext) {
+            case '.ts':
+            case '.js':
+                push(`export function ${name}(input${ext === '.ts' ? ': number' : ''}) {`);
+                push(`    const ${name}Value = input * ${n};`);
+                push(`    return ${name}Value > ${n * 2} ? ${name}Value : ${n};`);
+                push('}');
+                push('');
+                break;
+            case '.py':
+                push(`def ${name}(value):`);
+                push(`    """Computes the ${name} score."""`);
+                push(`    return value * ${n}`);
+                push('');
+                break;
+            case '.go':
+                push(`func ${name.charAt(0).toUpperCase() + name.slice(1)}(v int) int {`);
+                push(`\treturn v * ${n}`);
+                push('}');
+                push('');
+                break;
+            case '.json':
+                push(`{"${name}": ${n}, "enabled": ${rng() < 0.5}}`);
+                break;
+            case '.yaml':
+                push(`${name}:`);
+                push(`  limit: ${n}`);
+                break;
+            case '.css':
+                push(`.${name} { margin: ${n % 32}px; color: #${(n * 4099).toString(16).padStart(6, '0').slice(0, 6)}; }`);
+                break;
+            default:
+                push(`The ${name} module handles ${pick(rng, WORDS)} processing (${n}).`);
+        }
+    }
+    return lines.join('\n') + '\n';
+}
+
+/** A file to write: generated source or binary bytes from its own seed, or fixed text. */
+type PlannedFile =
+    | { kind: 'source'; rel: string; ext: string; bytes: number; seed: number }
+    | { kind: 'binary'; rel: string; bytes: number; seed: number }
+    | { kind: 'text'; rel: string; text: string };
+
+function fileContent(file: PlannedFile): string | Buffer {
+    if (file.kind === 'text') return file.text;
+    const rng = createRng(file.seed);
+    if (file.kind === 'source') return sourceContent(rng, file.ext, file.bytes);
+    const buf = Buffer.alloc(file.bytes);
+    for (let b = 0; b < file.bytes; b++) buf[b] = Math.floor(rng() * 256);
+    buf[0] = 0; // Guarantees the null-byte sniff classifies it as binary
+    return buf;
+}
+
+/**
+ * Writes a deterministic synthetic repository for benchmarks.
+ * Layout: src/<pkg>/<dir>/ for source, dist/ for generated build output, node_modules/
+ * for vendored code and assets/ for binaries, plus .gitignore / .kaiignore.
+ */
+export async function generateSyntheticRepo(root: string, options: SyntheticRepoOptions): Promise<SyntheticRepoManifest> {
+    const rng = createRng(options.seed);
+    const mix = Object.entries(options.languageMix ?? DEFAULT_LANGUAGE_MIX).filter(([, w]) => w > 0);
+    const mixTotal = mix.reduce((sum, [, w]) => sum + w, 0);
+    const meanBytes = options.meanFileBytes ?? 2048;
+    const maxBytes = options.maxFileBytes ?? 64 * 1024;
+    const filesPerDir = Math.max(1, options.filesPerDir ?? 20);
+    const generatedCount = Math.floor(options.fileCount * (options.generatedFraction ?? 0.1));
+    const vendoredCount = Math.floor(options.fileCount * (options.vendoredFraction ?? 0.1));
+    const binaryCount = Math.floor(options.fileCount * (options.binaryFraction ?? 0.02));
+    const sourceCount = Math.max(0, options.fileCount - generatedCount - vendoredCount - binaryCount);
+    const gitignore = options.gitignore ?? ['node_modules/', '*.log'];
+    const kaiignore = options.kaiignore ?? ['/dist/', '/assets/'];
+
+    const fileSize = () => Math.min(maxBytes, Math.max(16, Math.round(-Math.log(1 - rng()) * meanBytes)));
+
+    // Plan paths, sizes and per-file seeds first (cheap); the write workers generate each
+    // file's content from its own seed, so at most `writeConcurrency` files are in memory.
+    const plan: PlannedFile[] = [];
+    const sourceFiles: string[] = [];
+    const fileSeed = () => Math.floor(rng() * 4294967296);
+    for (let i = 0; i < sourceCount; i++) {
+        const ext = pickWeighted(rng, mix, mixTotal);
+        const dirIndex = Math.floor(i / filesPerDir);
+        const rel = `src/pkg${dirIndex % 50}/mod${dirIndex}/${identifier(rng)}_${i}${ext}`;
+        plan.push({ kind: 'source', rel, ext, bytes: fileSize(), seed: fileSeed() });
+        sourceFiles.push(rel);
+    }
+    for (let i = 0; i < generatedCount; i++) {
+        const rel = `dist/chunk${Math.floor(i / filesPerDir)}/bundle_${i}.js`;
+        plan.push({ kind: 'source', rel, ext: '.js', bytes: fileSize(), seed: fileSeed() });
+    }
+    for (let i = 0; i < vendoredCount; i++) {
+        const rel = `node_modules/${pick(rng, WORDS)}-lib${Math.floor(i / filesPerDir)}/lib/file_${i}.js`;
+        plan.push({ kind: 'source', rel, ext: '.js', bytes: fileSize(), seed: fileSeed() });
+    }
+    for (let i = 0; i < binaryCount; i++) {
+        const bytes = Math.min(maxBytes, 64 + Math.floor(rng() * 4096));
+        plan.push({ kind: 'binary', rel: `assets/img${Math.floor(i / filesPerDir)}/asset_${i}.png`, bytes, seed: fileSeed() });
+    }
+    plan.push({ kind: 'text', rel: '.gitignore', text: gitignore.join('\n') + '\n' });
+    plan.push({ kind: 'text', rel: '.kaiignore', text: kaiignore.join('\n') + '\n' });
+
+    const dirs = new Set(plan.map(p => path.posix.dirname(p.rel)));
+    for (const dir of dirs) {
+        await fsPromises.mkdir(path.join(root, dir), { recursive: true });
+    }
+
+    let index = 0;
+    let totalBytes = 0;
+    const worker = async () => {
+        while (true) {
+            const i = index++;
+            if (i >= plan.length) break;
+            const content = fileContent(plan[i]);
+            await fsPromises.writeFile(path.join(root, plan[i].rel), content);
+            totalBytes += typeof content === 'string' ? Buffer.byteLength(content) : content.length;
+        }
+    };
+    const concurrency = Math.max(1, options.writeConcurrency ?? 32);
+    await Promise.all(Array.from({ length: Math.min(concurrency, plan.length) }, () => worker()));
+
+    return { root, seed: options.seed, files: plan.map(p => p.rel), sourceFiles, totalBytes };
+}
@@ -0,0 +1,85 @@
+import type { Config } from '../../lib/Config';
+import { CONSOLIDATION_CHANGED_FILES_PREFIX, CONSOLIDATION_SUCCESS_MARKER } from '../../lib/consolidation/constants';
+import { casesFromConversation, casesFromFeedback, contextFiles, dedupeCases, evaluateStrategies } from '../ContextEval';
+import { parseContextEvalArgs } from '../runContextEval';
+
+const entry = (role: string, content: string) => ({ type: role === 'user' ? 'request' : 'response', role, content, timestamp: '2024-01-01T00:00:00.000Z' });
+const system = (content: string) => entry('system', content);
+
+describe('ContextEval', () => {
+  it('turns the turns before a consolidation into cases with its changed files', () => {
+    const cases = casesFromConversation('chat', [
+      entry('user', 'Add retries to the invoice client'),
+      entry('assistant', 'Sure, here is the plan.'),
+      entry('user', '/scope packages/api'),
+      entry('user', 'Also log the attempts'),
+      system(`${CONSOLIDATION_CHANGED_FILES_PREFIX}\n- src\\billing\\client.ts\n- src/log.ts`),
+      system(CONSOLIDATION_SUCCESS_MARKER),
+      entry('user', 'Rename the module'), // Consolidated by an older version: no changed-files entry
+      system(CONSOLIDATION_SUCCESS_MARKER),
+      entry('user', 'Not consolidated yet'),
+    ] as any);
+    expect(cases.map(c => c.query)).toEqual(['Add retries to the invoice client', 'Also log the attempts']);
+    expect(cases[0].changed).toEqual(['src/billing/client.ts', 'src/log.ts']);
+    expect(cases[0].historySummary).toBeNull();
+    expect(cases[1].historySummary).toContain('assistant: Sure, here is the plan.');
+  });
+
+  it('adds feedback records with changes and dedupes repeated cases', () => {
+    const feedback = casesFromFeedback([
+      { query: 'Add retries to the invoice client', changed: ['src/log.ts', 'src/billing/client.ts'] },
+      { query: 'Explain the cache', changed: [] },
+    ] as any);
+    expect(feedback).toHaveLength(1);
+    const conversation = { source: 'chat', query: 'Add retries to the invoice client', historySummary: null, changed: ['src/billing/client.ts', 'src/log.ts'] };
+    expect(dedupeCases([conversation, ...feedback])).toEqual([conversation]);
+  });
+
+  it('separates files with code from files only summarised', () => {
+    const context = 'Code Context:\n---\nFile: src/a.ts\n```\na\n```\n' +
+      '\n---\nFile: src/b.ts (lines 1-3, function run)\n```\nb\n```\n' +
+      '\n---\nFile: src/c.ts (LOC: 10)\nSummary: C things\n' +
+      '\n---\nFile: logo.png [binary] (Size: 1.0 KB)\n';
+    const files = contextFiles(context);
+    expect([...files.withCode]).toEqual(['src/a.ts', 'src/b.ts']);
+    expect([...files.named]).toEqual(['src/a.ts', 'src/b.ts', 'src/c.ts', 'logo.png']);
+  });
+
+  it('scores recall and token cost per strategy and budget, and restores the config', async () => {
+    const config = { context: { mode: 'auto' }, gemini: { max_prompt_tokens: 32000 } } as unknown as Config;
+    const contexts: Record<string, { context: string; tokenCount: number }> = {
+      full: { context: 'x\n---\nFile: a.ts\n```\n```\n\n---\nFile: b.ts\n```\n```\n', tokenCount: 5000 },
+      analysis_cache: { context: 'x\n---\nFile: a.ts\nSummary: A\n\n---\nFile: b.ts\nSummary: B\n', tokenCount: 400 },
+    };
+    const builder = {
+      buildContext: jest.fn(async (_query?: string, _history?: string | null, feedbackConversation?: string | null) => {
+        expect(feedbackConversation).toBeNull();
+        return contexts[config.context.mode!];
+      }),
+    };
+    const cases = [
+      { source: 'chat', query: 'q1', historySummary: null, changed: ['a.ts'] },
+      { source: 'chat', query: 'q2', historySummary: null, changed: ['a.ts', 'c.ts'] },
+    ];
+    const scores = await evaluateStrategies(cases, builder as any, config, ['full', 'analysis_cache'], [4000, 8000]);
+    expect(scores.map(s => [s.strategy, s.budget, s.recall, s.coverage, s.overBudget, s.meanTokens])).toEqual([
+      ['full', 4000, 0, 0, 2, 5000],       // Over budget: nothing counts
+      ['full', 8000, 0.75, 0.75, 0, 5000],
+      ['analysis_cache', 4000, 0, 0.75, 0, 400],
+      ['analysis_cache', 8000, 0, 0.75, 0, 400],
+    ]);
+    expect(scores[1].recallPer1kTokens).toBe(0.15);
+    expect(builder.buildContext).toHaveBeenCalledTimes(8);
+    expect(config.context.mode).toBe('auto');
+    expect(config.gemini.max_prompt_tokens).toBe(32000);
+  });
+
+  it('parses arguments', () => {
+    const options = parseContextEvalArgs(['--budgets', '1000,2000', '--strategies', 'dynamic,full', '--limit', '5']);
+    expect(options.budgets).toEqual([1000, 2000]);
+    expect(options.strategies).toEqual(['dynamic', 'full']);
+    expect(options.limit).toBe(5);
+    expect(() => parseContextEvalArgs(['--strategies', 'magic'])).toThrow('Unknown strategy: magic');
+    expect(() => parseContextEvalArgs(['--budgets', 'abc'])).toThrow('Invalid --budgets');
+  });
+});
@@ -0,0 +1,81 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { createPatch } from 'diff';
+import { DiffAnonymizer, buildDiffCorpus, defaultDiffStages, findSuccessRegressions, replayDiffCorpus } from '../DiffCorpus';
+import { parseDiffBenchArgs } from '../runDiffBench';
+
+jest.spyOn(console, 'error').mockImplementation(() => {});
+
+const original = 'export function loadInvoice(id: string) {\n  return db.invoices.get(id);\n}\n';
+const edited = 'export function loadInvoice(id: string) {\n  if (!id) return null;\n  return db.invoices.get(id);\n}\n';
+const cleanDiff = createPatch('src/billing/invoice.ts', original, edited);
+// Model-style failure: context indentation drifted, so only the fuzzy fallback applies it
+const driftedDiff = cleanDiff.replace('   return db.invoices.get(id);', '     return db.invoices.get(id);');
+const brokenDiff = '--- a/src/billing/invoice.ts\n+++ b/src/billing/invoice.ts\n@@ -1,1 +1,1 @@\n-export function missingName() {\n+export function other() {\n';
+
+describe('DiffCorpus', () => {
+  let dir: string;
+  let cwd: string;
+
+  beforeEach(() => {
+    cwd = process.cwd();
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'diff-corpus-'));
+    process.chdir(dir); // applyDiffToFile logs failures under ./.kai/logs
+  });
+
+  afterEach(() => {
+    process.chdir(cwd);
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  it('dedupes logged failures and anonymises content, diff and path consistently', () => {
+    const entry = { file: '/home/me/project/src/billing/invoice.ts', diff: driftedDiff, fileContent: original, error: 'Fuzzy patch failed' };
+    const cases = buildDiffCorpus([entry, entry, { file: 'x.ts', diff: '' }], { anonymize: true });
+    expect(cases).toHaveLength(1);
+    const [testCase] = cases;
+    expect(testCase.file).toMatch(/^w\d+_\.ts$/);
+    expect(testCase.original).not.toMatch(/loadInvoice|invoices/);
+    expect(testCase.diff).not.toMatch(/loadInvoice|invoices|billing/);
+    expect(testCase.original).toContain('export function');
+    expect(testCase.error).toBe('Fuzzy patch failed');
+    expect(buildDiffCorpus([entry])[0]).toMatchObject({ id: testCase.id, original, anonymized: false });
+  });
+
+  it('keeps removed "-- x" lines as content, not as file headers', () => {
+    const anonymizer = new DiffAnonymizer();
+    const diff = anonymizer.diff('--- a/q.sql\n+++ b/q.sql\n@@ -1,1 +1,1 @@\n--- note.txt\n+-- other');
+    expect(diff.split('\n')[3]).toBe(`--- ${anonymizer.text('note.txt')}`);
+    expect(diff.split('\n')[0]).toMatch(/^--- w\d+_\/w\d+_\.sql$/);
+  });
+
+  it('replays each case through the patch stages and reports success rates', async () => {
+    const cases = buildDiffCorpus([
+      { file: 'a.ts', diff: cleanDiff, fileContent: original },
+      { file: 'b.ts', diff: driftedDiff, fileContent: original },
+      { file: 'c.ts', diff: brokenDiff, fileContent: original },
+    ], { anonymize: true });
+
+    const report = await replayDiffCorpus(cases, defaultDiffStages(dir), 2);
+
+    expect(report.stages.map(s => [s.stage, s.applied, s.total])).toEqual([
+      ['applyPatch', 1, 3],
+      ['fuzzyApplyPatch', 2, 3],
+      ['applyDiffToFile', 2, 3],
+    ]);
+    expect(report.stages[1].successRate).toBeCloseTo(2 / 3);
+    expect(report.cases[2].outcomes.applyDiffToFile).toMatchObject({ applied: false, error: 'Fuzzy patch failed' });
+    expect(report.stages.every(s => s.p95Ms >= s.medianMs)).toBe(true);
+    // Regression check against a previous replay
+    const better = report.stages.map(s => ({ ...s, successRate: 1 }));
+    expect(findSuccessRegressions(report.stages, better, 0.1).map(s => s.stage)).toEqual(['applyPatch', 'fuzzyApplyPatch', 'applyDiffToFile']);
+    expect(findSuccessRegressions(report.stages, report.stages)).toEqual([]);
+  });
+
+  it('parses the build and replay commands', () => {
+    expect(parseDiffBenchArgs(['build', '--anonymize', '--log', 'f.jsonl'])).toMatchObject({ command: 'build', anonymize: true, log: 'f.jsonl' });
+    expect(parseDiffBenchArgs(['replay', '--iterations', '5'])).toMatchObject({ command: 'replay', iterations: 5 });
+    expect(() => parseDiffBenchArgs(['replay', '--bogus'])).toThrow('Unknown argument');
+    expect(() => parseDiffBenchArgs([])).toThrow("Expected 'build' or 'replay'");
+  });
+});
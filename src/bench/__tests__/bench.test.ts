@@ -0,0 +1,137 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { generateSyntheticRepo, createRng } from '../SyntheticRepoGenerator';
+import { FakeAIClient } from '../FakeAIClient';
+import { findRegressions, median, parseBenchArgs } from '../runBench';
+
+describe('SyntheticRepoGenerator', () => {
+  let dirs: string[] = [];
+  const tmp = () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'synth-'));
+    dirs.push(dir);
+    return dir;
+  };
+
+  afterEach(() => {
+    dirs.forEach(d => fs.rmSync(d, { recursive: true, force: true }));
+    dirs = [];
+  });
+
+  it('produces identical trees for the same seed', async () => {
+    const a = await generateSyntheticRepo(tmp(), { seed: 7, fileCount: 60 });
+    const b = await generateSyntheticRepo(tmp(), { seed: 7, fileCount: 60 });
+    expect(a.files).toEqual(b.files);
+    expect(a.totalBytes).toBe(b.totalBytes);
+    const sample = a.sourceFiles[3];
+    expect(fs.readFileSync(path.join(a.root, sample), 'utf8')).toBe(fs.readFileSync(path.join(b.root, sample), 'utf8'));
+
+    const c = await generateSyntheticRepo(tmp(), { seed: 8, fileCount: 60 });
+    expect(c.files).not.toEqual(a.files);
+  });
+
+  it('writes the same bytes whatever the write concurrency', async () => {
+    const serial = await generateSyntheticRepo(tmp(), { seed: 5, fileCount: 40, writeConcurrency: 1 });
+    const parallel = await generateSyntheticRepo(tmp(), { seed: 5, fileCount: 40, writeConcurrency: 16 });
+    expect(parallel.totalBytes).toBe(serial.totalBytes);
+    for (const rel of serial.files) {
+      expect(fs.readFileSync(path.join(parallel.root, rel))).toEqual(fs.readFileSync(path.join(serial.root, rel)));
+    }
+  });
+
+  it('honours the language mix, categories and ignore files', async () => {
+    const root = tmp();
+    const manifest = await generateSyntheticRepo(root, {
+      seed: 1, fileCount: 100, languageMix: { '.py': 1 },
+      generatedFraction: 0.2, vendoredFraction: 0.1, binaryFraction: 0.05,
+      gitignore: ['node_modules/'], kaiignore: ['/dist/'],
+    });
+    expect(manifest.files).toHaveLength(102); // + .gitignore and .kaiignore
+    expect(manifest.sourceFiles).toHaveLength(65);
+    expect(manifest.sourceFiles.every(f => f.endsWith('.py'))).toBe(true);
+    expect(manifest.files.filter(f => f.startsWith('dist/'))).toHaveLength(20);
+    expect(manifest.files.filter(f => f.startsWith('node_modules/'))).toHaveLength(10);
+    expect(fs.readFileSync(path.join(root, '.kaiignore'), 'utf8')).toBe('/dist/\n');
+    const asset = manifest.files.find(f => f.startsWith('assets/'))!;
+    expect(fs.readFileSync(path.join(root, asset))[0]).toBe(0);
+  });
+
+  it('seeds a reproducible PRNG', () => {
+    const r1 = createRng(3);
+    const r2 = createRng(3);
+    const values = [r1(), r1(), r1()];
+    expect([r2(), r2(), r2()]).toEqual(values);
+    values.forEach(v => expect(v).toBeGreaterThanOrEqual(0));
+    values.forEach(v => expect(v).toBeLessThan(1));
+  });
+});
+
+describe('FakeAIClient', () => {
+  it('answers batch summary prompts with JSON keyed by file path', () => {
+    const ai = new FakeAIClient();
+    const answer = ai.answer('FILES IN BATCH:\n---\nFile: src/a.ts\n```\nx\n```\n---\nFile: src/b.ts\n```\ny\n```');
+    expect(Object.keys(JSON.parse(answer).summaries)).toEqual(['src/a.ts', 'src/b.ts']);
+  });
+
+  it('answers symbol summary prompts keyed by symbol id', () => {
+    const ai = new FakeAIClient();
+    const answer = ai.answer('SYMBOLS IN BATCH:\n---\nSymbol: src/a.ts#run\nKind: function (lines 1-3)\n```\nx\n```');
+    expect(Object.keys(JSON.parse(answer).summaries)).toEqual(['src/a.ts#run']);
+  });
+
+  it('selects relevant files deterministically', () => {
+    const ai = new FakeAIClient({ relevantFileCount: 2 });
+    const prompt = 'USER QUERY:\nq\nPROJECT ANALYSIS SUMMARY:\nAvailable Files Overview:\n- a.ts [text analyze] (Size: 1.0 KB)\n- b.ts [binary] (Size: 1.0 KB)\n- c.ts [text analyze] (Size: 1.0 KB)\n';
+    const first = ai.answer(prompt);
+    expect(first.split('\n')).toHaveLength(2);
+    expect(ai.answer(prompt)).toBe(first);
+  });
+
+  it('selects files sharing terms with the query in lexical mode', () => {
+    const ai = new FakeAIClient({ relevance: 'lexical', relevantFileCount: 2 });
+    const overview = 'PROJECT ANALYSIS SUMMARY:\nAvailable Files Overview:\n' +
+      '- src/billing/invoice.ts [text analyze] (Size: 1.0 KB) - Summary: Invoice totals and retries\n' +
+      '- src/billing/invoice.png [binary] (Size: 1.0 KB)\n' +
+      '- src/http/client.ts [text analyze] (Size: 1.0 KB) - Summary: HTTP client with retries\n' +
+      '- src/ui/menu.ts [text analyze] (Size: 1.0 KB) - Summary: Menu rendering\n';
+    expect(ai.answer(`USER QUERY:\nAdd retries to invoice sending\n${overview}`)).toBe('src/billing/invoice.ts\nsrc/http/client.ts');
+    expect(ai.answer(`USER QUERY:\nUnrelated question\n${overview}`)).toBe('NONE');
+  });
+
+  it('answers consolidation analysis and generation prompts', async () => {
+    const ai = new FakeAIClient({ operations: [{ filePath: 'old.ts', action: 'DELETE' }] });
+    expect(JSON.parse(ai.answer('Respond ONLY with a JSON object containing the key "operations" and, optionally, "groups".')).operations).toHaveLength(1);
+    expect(ai.answer("File Path: 'old.ts'")).toBe('DELETE_FILE');
+    expect(await ai.getResponseTextFromAI([{ role: 'user', content: "File Path: 'new.ts'" }])).toContain('// new.ts');
+    expect(ai.calls).toBe(1);
+  });
+});
+
+describe('runBench helpers', () => {
+  it('parses arguments and computes medians', () => {
+    const options = parseBenchArgs(['--files', '1000', '--iterations', '5', '--no-thresholds']);
+    expect(options.files).toBe(1000);
+    expect(options.iterations).toBe(5);
+    expect(options.thresholds).toBeNull();
+    expect(() => parseBenchArgs(['--bogus'])).toThrow('Unknown argument');
+    expect(median([3, 1, 2])).toBe(2);
+    expect(median([4, 1, 2, 3])).toBe(2.5);
+  });
+
+  it('flags threshold and baseline regressions', () => {
+    const results = [
+      { name: 'a', samplesMs: [300], medianMs: 300, minMs: 300, maxMs: 300 },
+      { name: 'b', samplesMs: [50], medianMs: 50, minMs: 50, maxMs: 50 },
+    ];
+    const regressions = findRegressions(
+      results, 2000,
+      { a: { maxMsPer1kFiles: 100 }, b: { maxMs: 100 } },
+      [{ name: 'b', samplesMs: [30], medianMs: 30, minMs: 30, maxMs: 30 }],
+      0.2
+    );
+    expect(regressions).toEqual([
+      { name: 'a', medianMs: 300, limitMs: 200, reason: 'threshold' },
+      { name: 'b', medianMs: 50, limitMs: 36, reason: 'baseline' },
+    ]);
+  });
+});
@@ -0,0 +1,359 @@
+// src/bench/runBench.ts
+// Benchmark suite: generates a seeded synthetic repository, wires Kai's services to a
+// deterministic fake model, times the hot paths and writes results (with regression
+// checks) to JSON. Run with `npm run bench -- --files 5000`.
+import path from 'path';
+import os from 'os';
+import { promises as fsPromises } from 'fs';
+import { createPatch } from 'diff';
+import { FileSystem } from '../lib/FileSystem';
+import { CommandService } from '../lib/CommandService';
+import { GitService } from '../lib/GitService';
+import { ProjectContextBuilder } from '../lib/ProjectContextBuilder';
+import { ProjectAnalyzerService } from '../lib/analysis/ProjectAnalyzerService';
+import { ConsolidationService } from '../lib/consolidation/ConsolidationService';
+import { CommitMessageService } from '../lib/CommitMessageService';
+import type { UserInterface } from '../lib/UserInterface';
+import type { Config } from '../lib/Config';
+import Conversation from '../lib/models/Conversation';
+import { generateSyntheticRepo, SyntheticRepoManifest } from './SyntheticRepoGenerator';
+import { FakeAIClient, FakeAIClientOptions } from './FakeAIClient';
+
+export interface BenchOptions {
+    files: number;
+    seed: number;
+    iterations: number;
+    out: string;
+    thresholds: string | null;   // JSON file with absolute/per-1k-file limits
+    baseline: string | null;     // Previous results file to compare medians against
+    tolerance: number;           // Allowed slowdown vs. baseline (0.2 = +20%)
+    latencyMs: number;           // Simulated model latency per call
+    apiKeys: number;             // Simulated API key pool size (concurrent analysis batches)
+    keep: boolean;               // Keep the synthetic repo on disk
+    verbose: boolean;            // Do not silence Kai's console output during runs
+}
+
+export interface BenchResult {
+    name: string;
+    samplesMs: number[];
+    medianMs: number;
+    minMs: number;
+    maxMs: number;
+}
+
+export interface BenchThreshold {
+    maxMs?: number;             // Absolute ceiling for the median
+    maxMsPer1kFiles?: number;   // Ceiling scaled by repository size
+}
+
+export interface BenchRegression {
+    name: string;
+    medianMs: number;
+    limitMs: number;
+    reason: 'threshold' | 'baseline';
+}
+
+interface BenchCase {
+    name: string;
+    setup?: () => Promise<void>;   // Untimed, runs before every sample
+    run: () => Promise<unknown>;
+}
+
+export function parseBenchArgs(argv: string[]): BenchOptions {
+    const options: BenchOptions = {
+        files: 2000,
+        seed: 42,
+        iterations: 3,
+        out: 'bench-results.json',
+        thresholds: path.join('bench', 'thresholds.json'),
+        baseline: null,
+        tolerance: 0.2,
+        latencyMs: 0,
+        apiKeys: 1,
+        keep: false,
+        verbose: false,
+    };
+    for (let i = 0; i < argv.length; i++) {
+        const arg = argv[i];
+        const next = () => {
+            const value = argv[++i];
+            if (value === undefined) throw new Error(`Missing value for ${arg}`);
+            return value;
+        };
+        switch (arg) {
+            case '--files': options.files = parseInt(next(), 10); break;
+            case '--seed': options.seed = parseInt(next(), 10); break;
+            case '--iterations': options.iterations = Math.max(1, parseInt(next(), 10)); break;
+            case '--out': options.out = next(); break;
+            case '--thresholds': options.thresholds = next(); break;
+            case '--no-thresholds': options.thresholds = null; break;
+            case '--baseline': options.baseline = next(); break;
+            case '--tolerance': options.tolerance = parseFloat(next()); break;
+            case '--latency': options.latencyMs = parseInt(next(), 10); break;
+            case '--api-keys': options.apiKeys = Math.max(1, parseInt(next(), 10)); break;
+            case '--keep': options.keep = true; break;
+            case '--verbose': options.verbose = true; break;
+            default: throw new Error(`Unknown argument: ${arg}`);
+        }
+    }
+    if (!Number.isFinite(options.files) || options.files < 1) {
+        throw new Error(`--files must be a positive integer (got ${options.files}).`);
+    }
+    return options;
+}
+
+export function median(samples: number[]): number {
+    const sorted = [...samples].sort((a, b) => a - b);
+    const mid = Math.floor(sorted.length / 2);
+    return sorted.length % 2 ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) / 2;
+}
+
+/** Compares results to per-benchmark thresholds and to a previous run. */
+export function findRegressions(
+    results: BenchResult[],
+    fileCount: number,
+    thresholds: Record<string, BenchThreshold>,
+    baseline: BenchResult[] | null,
+    tolerance: number
+): BenchRegression[] {
+    const regressions: BenchRegression[] = [];
+    for (const result of results) {
+        const threshold = thresholds[result.name];
+        if (threshold) {
+            const limits = [
+                threshold.maxMs,
+                threshold.maxMsPer1kFiles !== undefined ? threshold.maxMsPer1kFiles * Math.max(1, fileCount / 1000) : undefined,
+            ].filter((v): v is number => v !== undefined);
+            if (limits.length > 0) {
+                const limitMs = Math.min(...limits);
+                if (result.medianMs > limitMs) {
+                    regressions.push({ name: result.name, medianMs: result.medianMs, limitMs, reason: 'threshold' });
+                }
+            }
+        }
+        const previous = baseline?.find(b => b.name === result.name);
+        if (previous) {
+            const limitMs = previous.medianMs * (1 + tolerance);
+            if (result.medianMs > limitMs) {
+                regressions.push({ name: result.name, medianMs: result.medianMs, limitMs, reason: 'baseline' });
+            }
+        }
+    }
+    return regressions;
+}
+
+/** Runs `fn` with console output silenced (Kai's services log heavily). */
+export async function quietly<T>(verbose: boolean, fn: () => Promise<T>): Promise<T> {
+    if (verbose) return fn();
+    const saved = { log: console.log, warn: console.warn, info: console.info, error: console.error };
+    const noop = () => {};
+    console.log = console.warn = console.info = console.error = noop;
+    try {
+        return await fn();
+    } finally {
+        Object.assign(console, saved);
+    }
+}
+
+async function readJson<T>(filePath: string): Promise<T | null> {
+    try {
+        return JSON.parse(await fsPromises.readFile(filePath, 'utf8')) as T;
+    } catch (error: any) {
+        if (error.code === 'ENOENT') return null;
+        throw new Error(`Failed to read ${filePath}: ${error.message}`);
+    }
+}
+
+function createBenchConfig(): Config {
+    return {
+        gemini: {
+            api_key: 'bench', model_name: 'bench-pro', subsequent_chat_model_name: 'bench-flash',
+            max_output_tokens: 8192, max_prompt_tokens: 32000, max_retries: 0, retry_delay: 0,
+            generation_max_retries: 0, generation_retry_base_delay_ms: 0, interactive_prompt_review: false,
+        },
+        project: {
+            root_dir: '.', prompts_dir: 'prompts', prompt_template: '', chats_dir: '.kai/logs',
+            typescript_autofix: false, autofix_iterations: 1, coverage_iterations: 0,
+        },
+        analysis: { cache_file_path: '.kai/project_analysis.json', shared_summary_cache: false },
+        context: { mode: 'full' },
+        memory: {},
+        chatsDir: '.kai/logs',
+    } as unknown as Config;
+}
+
+const CREATED_FILE = 'src/bench_generated/NewFeature.ts';
+
+function pickCodeFiles(manifest: SyntheticRepoManifest): string[] {
+    const codeFiles = manifest.sourceFiles.filter(f => /\.(ts|js|py|go)$/.test(f));
+    return codeFiles.length > 0 ? codeFiles : manifest.sourceFiles;
+}
+
+/** The edit the fake model "asks for" during the consolidation benchmark. */
+function consolidationOperations(manifest: SyntheticRepoManifest): NonNullable<FakeAIClientOptions['operations']> {
+    return [
+        ...pickCodeFiles(manifest).slice(1, 4).map(filePath => ({ filePath, action: 'MODIFY' as const })),
+        { filePath: CREATED_FILE, action: 'CREATE' as const },
+    ];
+}
+
+function buildCases(root: string, manifest: SyntheticRepoManifest, ai: FakeAIClient, config: Config): BenchCase[] {
+    const fsUtil = new FileSystem();
+    const commandService = new CommandService();
+    const gitService = new GitService(commandService, fsUtil);
+    // The synthetic repo is not a git repository; consolidation only needs the clean-tree check to pass.
+    gitService.checkCleanStatus = async () => {};
+    const aiClient = ai.asAIClient();
+    const contextBuilder = new ProjectContextBuilder(fsUtil, gitService, root, config, aiClient);
+    const analyzer = new ProjectAnalyzerService(config, fsUtil, commandService, gitService, aiClient);
+    const noUi = {} as UserInterface; // Never reached: the git check cannot fail here
+    const consolidation = new ConsolidationService(
+        config, fsUtil, aiClient, root, gitService, noUi, new CommitMessageService(aiClient, gitService, 0)
+    );
+
+    const diffTarget = path.join(root, pickCodeFiles(manifest)[0]);
+    const operations = consolidationOperations(manifest);
+    const consolidationTargets = operations.filter(op => op.action === 'MODIFY').map(op => op.filePath);
+
+    let originalDiffTarget = '';
+    let diffPatch = '';
+    const originals = new Map<string, string>();
+    let conversation = new Conversation();
+    let consolidationContext = '';
+    const query = 'Where is the payment session cache invalidated?';
+
+    const setMode = (mode: 'full' | 'analysis_cache' | 'dynamic') => async () => { config.context.mode = mode; };
+
+    return [
+        {
+            name: 'getProjectFiles',
+            run: async () => fsUtil.getProjectFiles(root, root, await gitService.getIgnoreRules(root)),
+        },
+        { name: 'estimateFullContextTokens', run: () => contextBuilder.estimateFullContextTokens() },
+        { name: 'buildContext:full', setup: setMode('full'), run: () => contextBuilder.buildContext(query) },
+        { name: 'analyzeProject', run: () => analyzer.analyzeProject() },
+        { name: 'buildContext:analysis_cache', setup: setMode('analysis_cache'), run: () => contextBuilder.buildContext(query) },
+        { name: 'buildContext:dynamic', setup: setMode('dynamic'), run: () => contextBuilder.buildContext(query, null) },
+        {
+            name: 'applyDiffToFile',
+            setup: async () => {
+                if (!diffPatch) {
+                    originalDiffTarget = await fsPromises.readFile(diffTarget, 'utf8');
+                    const lines = originalDiffTarget.split('\n');
+                    lines.splice(Math.floor(lines.length / 2), 0, '// bench: inserted line');
+                    const rel = path.relative(root, diffTarget);
+                    diffPatch = createPatch(rel, originalDiffTarget, lines.join('\n'));
+                }
+                await fsPromises.writeFile(diffTarget, originalDiffTarget);
+            },
+            run: async () => {
+                if (!await fsUtil.applyDiffToFile(diffTarget, diffPatch)) {
+                    throw new Error(`applyDiffToFile failed: ${fsUtil.lastDiffFailure?.error}`);
+                }
+            },
+        },
+        {
+            name: 'consolidation',
+            setup: async () => {
+                config.context.mode = 'full';
+                for (const rel of consolidationTargets) {
+                    const abs = path.join(root, rel);
+                    if (!originals.has(rel)) originals.set(rel, await fsPromises.readFile(abs, 'utf8'));
+                    await fsPromises.writeFile(abs, originals.get(rel)!);
+                }
+                await fsPromises.rm(path.join(root, CREATED_FILE), { force: true });
+                // A fresh conversation each sample: a successful run appends the success marker.
+                conversation = new Conversation();
+                conversation.addMessage('user', `Refactor ${consolidationTargets.join(', ')} and add ${CREATED_FILE}.`);
+                conversation.addMessage('assistant', 'Here is the plan for the refactor.');
+                consolidationContext = (await contextBuilder.buildContext(query)).context;
+            },
+            run: async () => {
+                await consolidation.process('bench', conversation, consolidationContext, path.join(root, '.kai', 'logs', 'bench.jsonl'));
+                if (!await fsUtil.stat(path.join(root, CREATED_FILE))) {
+                    throw new Error('Consolidation did not apply the generated changes.');
+                }
+            },
+        },
+    ];
+}
+
+export async function runBench(options: BenchOptions): Promise<{ results: BenchResult[]; regressions: BenchRegression[] }> {
+    const outPath = path.resolve(options.out);
+    const thresholdsPath = options.thresholds ? path.resolve(options.thresholds) : null;
+    const baselinePath = options.baseline ? path.resolve(options.baseline) : null;
+    const originalCwd = process.cwd();
+    const root = await fsPromises.mkdtemp(path.join(os.tmpdir(), 'kai-bench-'));
+
+    console.log(`Generating synthetic repository (${options.files} files, seed ${options.seed}) in ${root}...`);
+    const genStart = performance.now();
+    const manifest = await generateSyntheticRepo(root, { seed: options.seed, fileCount: options.files });
+    console.log(`  ${manifest.files.length} files, ${(manifest.totalBytes / 1024 / 1024).toFixed(1)} MB in ${(performance.now() - genStart).toFixed(0)} ms`);
+
+    const ai = new FakeAIClient({ latencyMs: options.latencyMs, apiKeys: options.apiKeys, operations: consolidationOperations(manifest) });
+    const config = createBenchConfig();
+    const results: BenchResult[] = [];
+    try {
+        // ProjectAnalyzerService and the relative config paths resolve against the cwd.
+        process.chdir(root);
+        for (const benchCase of buildCases(root, manifest, ai, config)) {
+            const samplesMs: number[] = [];
+            for (let i = 0; i < options.iterations; i++) {
+                await quietly(options.verbose, async () => { if (benchCase.setup) await benchCase.setup(); });
+                const start = performance.now();
+                await quietly(options.verbose, benchCase.run);
+                samplesMs.push(Math.round((performance.now() - start) * 100) / 100);
+            }
+            const result: BenchResult = {
+                name: benchCase.name,
+                samplesMs,
+                medianMs: median(samplesMs),
+                minMs: Math.min(...samplesMs),
+                maxMs: Math.max(...samplesMs),
+            };
+            results.push(result);
+            console.log(`  ${result.name.padEnd(28)} median ${result.medianMs.toFixed(1).padStart(9)} ms  (min ${result.minMs.toFixed(1)}, max ${result.maxMs.toFixed(1)})`);
+        }
+    } finally {
+        process.chdir(originalCwd);
+        if (!options.keep) await fsPromises.rm(root, { recursive: true, force: true });
+    }
+
+    const thresholds = thresholdsPath ? (await readJson<Record<string, BenchThreshold>>(thresholdsPath)) ?? {} : {};
+    const baseline = baselinePath ? (await readJson<{ results: BenchResult[] }>(baselinePath))?.results ?? null : null;
+    const regressions = findRegressions(results, options.files, thresholds, baseline, options.tolerance);
+
+    const report = {
+        meta: {
+            date: new Date().toISOString(),
+            node: process.version,
+            platform: `${process.platform}-${process.arch}`,
+            files: options.files,
+            seed: options.seed,
+            iterations: options.iterations,
+            totalBytes: manifest.totalBytes,
+            modelCalls: ai.calls,
+            modelPromptChars: ai.promptChars,
+        },
+        results,
+        regressions,
+    };
+    await fsPromises.writeFile(outPath, JSON.stringify(report, null, 2) + '\n');
+    console.log(`Results written to ${outPath}`);
+    return { results, regressions };
+}
+
+if (require.main === module) {
+    (async () => {
+        try {
+            const { regressions } = await runBench(parseBenchArgs(process.argv.slice(2)));
+            for (const r of regressions) {
+                console.error(`REGRESSION ${r.name}: median ${r.medianMs.toFixed(1)} ms > ${r.limitMs.toFixed(1)} ms (${r.reason})`);
+            }
+            process.exit(regressions.length > 0 ? 1 : 0);
+        } catch (error) {
+            console.error('Benchmark failed:', error instanceof Error ? error.message : error);
+            process.exit(2);
+        }
+    })();
+}
@@ -0,0 +1,158 @@
+// src/bench/runContextEval.ts
+// Retrieval quality vs. token cost for the context modes, measured offline on this project's
+// own history: each past turn whose consolidation changed files is rebuilt with every strategy
+// at every budget, with the deterministic fake model standing in for dynamic selection. Run
+// with `npm run bench:context -- --budgets 8000,32000,128000`.
+import path from 'path';
+import { promises as fsPromises } from 'fs';
+import { Config } from '../lib/Config';
+import { FileSystem } from '../lib/FileSystem';
+import { CommandService } from '../lib/CommandService';
+import { GitService } from '../lib/GitService';
+import { ProjectContextBuilder } from '../lib/ProjectContextBuilder';
+import { RelevanceFeedback } from '../lib/analysis/RelevanceFeedback';
+import type { JsonlLogEntry } from '../lib/models/Conversation';
+import { FakeAIClient } from './FakeAIClient';
+import { quietly } from './runBench';
+import {
+    ContextStrategy, EvalCase, StrategyScore, casesFromConversation, casesFromFeedback, dedupeCases, evaluateStrategies,
+} from './ContextEval';
+
+const STRATEGIES: ContextStrategy[] = ['full', 'analysis_cache', 'dynamic', 'auto'];
+
+export interface ContextEvalOptions {
+    budgets: number[];
+    strategies: ContextStrategy[];
+    limit: number | null;        // Evaluate only the most recent N cases
+    relevantFiles: number;       // How many files the fake dynamic selection picks
+    out: string;
+    verbose: boolean;
+}
+
+export function parseContextEvalArgs(argv: string[]): ContextEvalOptions {
+    const options: ContextEvalOptions = {
+        budgets: [8000, 32000, 128000],
+        strategies: [...STRATEGIES],
+        limit: null,
+        relevantFiles: 10,
+        out: 'context-eval-results.json',
+        verbose: false,
+    };
+    for (let i = 0; i < argv.length; i++) {
+        const arg = argv[i];
+        const next = () => {
+            const value = argv[++i];
+            if (value === undefined) throw new Error(`Missing value for ${arg}`);
+            return value;
+        };
+        switch (arg) {
+            case '--budgets':
+                options.budgets = next().split(',').map(b => parseInt(b, 10));
+                if (options.budgets.some(b => !(b > 0))) throw new Error(`Invalid --budgets: ${argv[i]}`);
+                break;
+            case '--strategies': {
+                const strategies = next().split(',').map(s => s.trim());
+                const unknown = strategies.filter(s => !STRATEGIES.includes(s as ContextStrategy));
+                if (unknown.length > 0) throw new Error(`Unknown strategy: ${unknown.join(', ')} (expected ${STRATEGIES.join(', ')})`);
+                options.strategies = strategies as ContextStrategy[];
+                break;
+            }
+            case '--limit': options.limit = Math.max(1, parseInt(next(), 10)); break;
+            case '--relevant-files': options.relevantFiles = Math.max(1, parseInt(next(), 10)); break;
+            case '--out': options.out = next(); break;
+            case '--verbose': options.verbose = true; break;
+            default: throw new Error(`Unknown argument: ${arg}`);
+        }
+    }
+    return options;
+}
+
+/** Cases from every conversation log plus the relevance feedback records, oldest first. */
+async function collectCases(fs: FileSystem, config: Config, projectRoot: string): Promise<EvalCase[]> {
+    const cases: EvalCase[] = [];
+    const logs = (await fsPromises.readdir(config.chatsDir).catch(() => [] as string[]))
+        .filter(name => name.endsWith('.jsonl'))
+        .sort();
+    for (const name of logs) {
+        const entries = await fs.readJsonlFile(path.join(config.chatsDir, name)) as JsonlLogEntry[];
+        cases.push(...casesFromConversation(name.replace(/\.jsonl$/, ''), entries));
+    }
+    cases.push(...casesFromFeedback(await RelevanceFeedback.readRecords(projectRoot, Number.MAX_SAFE_INTEGER)));
+    return dedupeCases(cases);
+}
+
+/**
+ * Drops ground-truth files that no longer exist (deleted or renamed since): the current tree is
+ * what gets retrieved from, so they can never be found. Cases left with none are dropped.
+ */
+async function keepExistingFiles(fs: FileSystem, projectRoot: string, cases: EvalCase[]): Promise<{ cases: EvalCase[]; missing: number }> {
+    const exists = new Map<string, boolean>();
+    let missing = 0;
+    const kept: EvalCase[] = [];
+    for (const testCase of cases) {
+        const changed: string[] = [];
+        for (const file of testCase.changed) {
+            if (!exists.has(file)) exists.set(file, !!await fs.stat(path.join(projectRoot, file)));
+            if (exists.get(file)) changed.push(file);
+            else missing++;
+        }
+        if (changed.length > 0) kept.push({ ...testCase, changed });
+    }
+    return { cases: kept, missing };
+}
+
+export async function runContextEval(options: ContextEvalOptions): Promise<StrategyScore[]> {
+    const projectRoot = process.cwd();
+    // Config insists on a key; nothing here calls a real model
+    process.env.GEMINI_API_KEY ??= 'context-eval';
+    const config = await Config.load();
+    const fs = new FileSystem();
+    const gitService = new GitService(new CommandService(), fs);
+    const ai = new FakeAIClient({ relevance: 'lexical', relevantFileCount: options.relevantFiles });
+    // An empty feedback model: learned hints come from the very outcomes being scored
+    const builder = new ProjectContextBuilder(fs, gitService, projectRoot, config, ai.asAIClient(), undefined, new RelevanceFeedback());
+
+    const collected = await collectCases(fs, config, projectRoot);
+    const { cases: existing, missing } = await keepExistingFiles(fs, projectRoot, collected);
+    const cases = options.limit ? existing.slice(-options.limit) : existing;
+    console.log(`${cases.length} case(s) from ${config.chatsDir} and relevance feedback (${missing} changed file reference(s) no longer in the tree)`);
+    if (cases.length === 0) {
+        throw new Error('No turns with recorded consolidation changes yet. Consolidate a few conversations first.');
+    }
+
+    const scores = await quietly(options.verbose, () => evaluateStrategies(cases, builder, config, options.strategies, options.budgets))
+        .finally(() => builder.dispose());
+    console.log(`  ${'strategy'.padEnd(15)}${'budget'.padStart(8)}${'recall'.padStart(8)}${'named'.padStart(8)}${'tokens'.padStart(9)}${'r/1k'.padStart(8)}${'median'.padStart(10)}${'p95'.padStart(10)}  over`);
+    for (const s of scores) {
+        console.log(`  ${s.strategy.padEnd(15)}${String(s.budget).padStart(8)}${s.recall.toFixed(3).padStart(8)}${s.coverage.toFixed(3).padStart(8)}${String(s.meanTokens).padStart(9)}${s.recallPer1kTokens.toFixed(3).padStart(8)}${`${s.medianMs.toFixed(1)} ms`.padStart(10)}${`${s.p95Ms.toFixed(1)} ms`.padStart(10)}  ${s.overBudget}${s.errors ? ` (${s.errors} errors)` : ''}`);
+    }
+
+    const outPath = path.resolve(options.out);
+    const results = {
+        meta: {
+            date: new Date().toISOString(),
+            node: process.version,
+            platform: `${process.platform}-${process.arch}`,
+            projectRoot,
+            cases: cases.length,
+            fromConversations: cases.filter(c => c.source !== 'feedback').length,
+            missingFiles: missing,
+            relevantFiles: options.relevantFiles,
+        },
+        scores,
+    };
+    await fsPromises.writeFile(outPath, JSON.stringify(results, null, 2) + '\n');
+    console.log(`Results written to ${outPath}`);
+    return scores;
+}
+
+if (require.main === module) {
+    (async () => {
+        try {
+            await runContextEval(parseContextEvalArgs(process.argv.slice(2)));
+        } catch (error) {
+            console.error('Context evaluation failed:', error instanceof Error ? error.message : error);
+            process.exit(2);
+        }
+    })();
+}
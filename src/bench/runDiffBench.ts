@@ -0,0 +1,148 @@
+// src/bench/runDiffBench.ts
+// Diff-application benchmark over real model output. `build` turns the project's logged diff
+// failures into a corpus (optionally anonymised); `replay` runs the corpus through the patching
+// stages and reports per-stage success rate and per-diff latency. Run with
+// `npm run bench:diff -- build --anonymize` then `npm run bench:diff -- replay`.
+import path from 'path';
+import { promises as fsPromises } from 'fs';
+import { FileSystem } from '../lib/FileSystem';
+import {
+    DiffCorpusCase, DiffReplayReport, DiffStageSummary, buildDiffCorpus, createScratchDir, defaultDiffStages,
+    findSuccessRegressions, replayDiffCorpus,
+} from './DiffCorpus';
+
+export interface DiffBenchOptions {
+    command: 'build' | 'replay';
+    log: string;            // build: diff failure log to read
+    corpus: string;         // build: output; replay: input
+    anonymize: boolean;
+    iterations: number;
+    out: string;
+    baseline: string | null; // Previous replay results to compare success rates against
+    tolerance: number;       // Allowed drop in success rate vs. baseline (0.01 = 1 point)
+    verbose: boolean;
+}
+
+export function parseDiffBenchArgs(argv: string[]): DiffBenchOptions {
+    const [command, ...rest] = argv;
+    if (command !== 'build' && command !== 'replay') {
+        throw new Error(`Expected 'build' or 'replay' (got ${command ?? 'nothing'}).`);
+    }
+    const options: DiffBenchOptions = {
+        command,
+        log: path.join('.kai', 'logs', 'diff_failures.jsonl'),
+        corpus: path.join('bench', 'diff-corpus.jsonl'),
+        anonymize: false,
+        iterations: 3,
+        out: 'diff-bench-results.json',
+        baseline: null,
+        tolerance: 0,
+        verbose: false,
+    };
+    for (let i = 0; i < rest.length; i++) {
+        const arg = rest[i];
+        const next = () => {
+            const value = rest[++i];
+            if (value === undefined) throw new Error(`Missing value for ${arg}`);
+            return value;
+        };
+        switch (arg) {
+            case '--log': options.log = next(); break;
+            case '--corpus': options.corpus = next(); break;
+            case '--anonymize': options.anonymize = true; break;
+            case '--iterations': options.iterations = Math.max(1, parseInt(next(), 10)); break;
+            case '--out': options.out = next(); break;
+            case '--baseline': options.baseline = next(); break;
+            case '--tolerance': options.tolerance = parseFloat(next()); break;
+            case '--verbose': options.verbose = true; break;
+            default: throw new Error(`Unknown argument: ${arg}`);
+        }
+    }
+    return options;
+}
+
+async function buildCorpus(options: DiffBenchOptions): Promise<DiffCorpusCase[]> {
+    const fs = new FileSystem();
+    const entries = await fs.readJsonlFile(path.resolve(options.log));
+    const cases = buildDiffCorpus(entries, { anonymize: options.anonymize });
+    const corpusPath = path.resolve(options.corpus);
+    await fs.ensureDirExists(path.dirname(corpusPath));
+    await fsPromises.writeFile(corpusPath, cases.map(c => JSON.stringify(c)).join('\n') + (cases.length ? '\n' : ''));
+    console.log(`${cases.length} case(s) from ${entries.length} logged failure(s) written to ${corpusPath}${options.anonymize ? ' (anonymised)' : ''}`);
+    return cases;
+}
+
+/** Replays in a scratch working directory: applyDiffToFile logs failures under ./.kai/logs. */
+async function replayInScratchDir(cases: DiffCorpusCase[], options: DiffBenchOptions): Promise<DiffReplayReport> {
+    const originalCwd = process.cwd();
+    const scratch = await createScratchDir();
+    const saved = { log: console.log, warn: console.warn, error: console.error };
+    try {
+        process.chdir(scratch);
+        if (!options.verbose) console.log = console.warn = console.error = () => {};
+        return await replayDiffCorpus(cases, defaultDiffStages(scratch), options.iterations);
+    } finally {
+        Object.assign(console, saved);
+        process.chdir(originalCwd);
+        await fsPromises.rm(scratch, { recursive: true, force: true });
+    }
+}
+
+export async function runDiffReplay(options: DiffBenchOptions): Promise<{ stages: DiffStageSummary[]; regressions: DiffStageSummary[] }> {
+    const fs = new FileSystem();
+    const corpusPath = path.resolve(options.corpus);
+    const outPath = path.resolve(options.out);
+    const baselinePath = options.baseline ? path.resolve(options.baseline) : null;
+    const cases: DiffCorpusCase[] = await fs.readJsonlFile(corpusPath);
+    if (cases.length === 0) throw new Error(`No cases in ${corpusPath}. Build one with: build --log <diff_failures.jsonl>`);
+
+    const report = await replayInScratchDir(cases, options);
+    for (const s of report.stages) {
+        console.log(`  ${s.stage.padEnd(18)} ${String(s.applied).padStart(5)}/${s.total} applied (${(s.successRate * 100).toFixed(1)}%)  median ${s.medianMs.toFixed(3)} ms  p95 ${s.p95Ms.toFixed(3)} ms  max ${s.maxMs.toFixed(3)} ms`);
+    }
+    let baseline: DiffStageSummary[] = [];
+    if (baselinePath) {
+        try {
+            baseline = JSON.parse(await fsPromises.readFile(baselinePath, 'utf8')).stages ?? [];
+        } catch (error: any) {
+            throw new Error(`Failed to read ${baselinePath}: ${error.message}`);
+        }
+    }
+    const regressions = findSuccessRegressions(report.stages, baseline, options.tolerance);
+    const results = {
+        meta: {
+            date: new Date().toISOString(),
+            node: process.version,
+            platform: `${process.platform}-${process.arch}`,
+            corpus: corpusPath,
+            cases: cases.length,
+            anonymized: cases.every(c => c.anonymized),
+            iterations: options.iterations,
+        },
+        ...report,
+        regressions: regressions.map(r => r.stage),
+    };
+    await fsPromises.writeFile(outPath, JSON.stringify(results, null, 2) + '\n');
+    console.log(`Results written to ${outPath}`);
+    return { stages: report.stages, regressions };
+}
+
+if (require.main === module) {
+    (async () => {
+        try {
+            const options = parseDiffBenchArgs(process.argv.slice(2));
+            if (options.command === 'build') {
+                await buildCorpus(options);
+                return;
+            }
+            const { regressions } = await runDiffReplay(options);
+            for (const r of regressions) {
+                console.error(`REGRESSION ${r.stage}: success rate ${(r.successRate * 100).toFixed(1)}% fell below the baseline`);
+            }
+            process.exit(regressions.length > 0 ? 1 : 0);
+        } catch (error) {
+            console.error('Diff benchmark failed:', error instanceof Error ? error.message : error);
+            process.exit(2);
+        }
+    })();
+}
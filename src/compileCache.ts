@@ -0,0 +1,15 @@
+// src/compileCache.ts
+// Side-effect module imported first by kai.ts. Enables Node's on-disk compile cache
+// (module.enableCompileCache, Node >= 22.1) so repeat launches skip re-parsing Kai and
+// its dependencies. A no-op on older Node versions or when NODE_DISABLE_COMPILE_CACHE is set.
+import * as nodeModule from 'module';
+
+const enableCompileCache = (nodeModule as any).enableCompileCache as ((cacheDir?: string) => unknown) | undefined;
+
+if (typeof enableCompileCache === 'function') {
+    try {
+        enableCompileCache();
+    } catch {
+        // The cache is only an optimisation; never block startup on it.
+    }
+}
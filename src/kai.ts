@@ -1,12 +1,12 @@
 #!/usr/bin/env node
 // src/kai.ts // Note: Reverting changes from Kanban JSON migration
-import * as fsSync from 'fs'; // Keep sync fs for config defaults
-// REMOVED: fsPromises import
+import './compileCache'; // MUST stay first: enables Node's compile cache before anything else loads
+import fsPromises from 'fs/promises'; // Async only: startup must not block the event loop
 import { DEFAULT_CONFIG_YAML } from './lib/config_defaults'; // Keep config defaults import
 
 import path from 'path';
 import inquirer from 'inquirer';
-import { Config } from './lib/Config';
+import { Config, MissingApiKeyError } from './lib/Config';
 // Ensure UserInteractionResult and any new specific result types are imported
 import {
     UserInterface,
@@ -30,6 +30,12 @@ import { ProjectAnalyzerService } from './lib/analysis/ProjectAnalyzerService';
 import { AIClient } from './lib/AIClient'; // Needed for Analyzer instantiation
 // REMOVED: uuid import
 import { WebService } from './lib/WebService'; // <-- ADDED WebService import
+import { tracer, TRACES_DIR } from './lib/telemetry/Tracer';
+import { metrics, MetricsRegistry } from './lib/telemetry/Metrics';
+import { profiler, Profiler, PROFILES_DIR } from './lib/telemetry/Profiler';
+import { memoryGovernor } from './lib/memory/MemoryGovernor';
+import { relevanceFeedback, RelevanceFeedback } from './lib/analysis/RelevanceFeedback';
+import { taskScheduler, DEFAULT_MODEL_CONCURRENCY } from './lib/scheduling/TaskScheduler';
 // *** END Imports for Analysis Feature ***
 
 // performStartupChecks adjusted signature, Config is instantiated later now
@@ -43,12 +49,15 @@ export async function performStartupChecks(
     console.log(chalk.cyan("\nPerforming startup environment checks..."));
     try {
         // --- Git Repository Check ---
-        let isRepo = await gitService.isGitRepository(projectRoot);
+        // The repo probe and the directory-safety probe are independent; run them together.
+        let [isRepo, isSafeDir] = await Promise.all([
+            gitService.isGitRepository(projectRoot),
+            fs.isDirectoryEmptyOrSafe(projectRoot),
+        ]);
         let proceedWithSetup = true; // Assume we proceed unless user denies
 
         if (!isRepo) {
             console.log(chalk.yellow("  This directory is not currently a Git repository."));
-            const isSafeDir = await fs.isDirectoryEmptyOrSafe(projectRoot);
 
             if (!isSafeDir) {
                 console.log(chalk.yellow("  The directory is not empty and may contain important files."));
@@ -70,58 +79,60 @@ export async function performStartupChecks(
             } else {
                  console.log(chalk.cyan("  Directory is empty or safe. Proceeding with automatic initialization..."));
             }
-
-            // Initialize Git repo only if needed and confirmed/safe
-            if (proceedWithSetup) {
-                 await gitService.initializeRepository(projectRoot);
-                 isRepo = true; // Mark as repo after successful init
-                 // Ensure gitignore rules after successful init
-                 await gitService.ensureGitignoreRules(projectRoot);
-            }
         } else {
             console.log(chalk.green("  ✓ Git repository detected."));
-            // Ensure gitignore rules even if repo exists
-            await gitService.ensureGitignoreRules(projectRoot);
         }
 
-        // --- Ensure .kai directory and Scaffold config.yaml if missing ---
+        // --- Git setup and .kai scaffolding touch different files; run them concurrently ---
+        const gitSetup = async () => {
+            if (!isRepo) {
+                // Initialize Git repo only if needed and confirmed/safe
+                await gitService.initializeRepository(projectRoot);
+                isRepo = true; // Mark as repo after successful init
+            }
+            // Ensure gitignore rules after init, or even if repo exists
+            await gitService.ensureGitignoreRules(projectRoot);
+        };
+
         const configDir = path.resolve(projectRoot, '.kai');
-        const configPath = path.resolve(configDir, 'config.yaml');
-        await fs.ensureDirExists(configDir); // Ensure .kai directory exists FIRST
+        const kaiScaffolding = async () => {
+            // --- Ensure .kai directory and Scaffold config.yaml if missing ---
+            const configPath = path.resolve(configDir, 'config.yaml');
+            await fs.ensureDirExists(configDir); // Ensure .kai directory exists FIRST
 
-        if (!fsSync.existsSync(configPath)) {
-            console.log(chalk.yellow(`  'config.yaml' not found in '.kai/'. Creating a default one...`));
+            // 'wx' creates only if missing, so a concurrently starting Kai process can't be clobbered
             try {
-                // Use the imported constant
-                fsSync.writeFileSync(configPath, DEFAULT_CONFIG_YAML, 'utf8');
-                console.log(chalk.green(`  Successfully created default config.yaml in '.kai/'.`));
+                await fsPromises.writeFile(configPath, DEFAULT_CONFIG_YAML, { encoding: 'utf8', flag: 'wx' });
+                console.log(chalk.yellow(`  'config.yaml' not found in '.kai/'. Created a default one.`));
             } catch (writeError) {
-                console.error(chalk.red(`  ❌ Error creating default config.yaml at ${configPath}:`), writeError);
-                console.warn(chalk.yellow("  Continuing startup despite config creation error..."));
+                if ((writeError as NodeJS.ErrnoException).code === 'EEXIST') {
+                    console.log(chalk.dim(`  Found existing config.yaml in '.kai/'. Skipping default creation.`));
+                } else {
+                    console.error(chalk.red(`  ❌ Error creating default config.yaml at ${configPath}:`), writeError);
+                    console.warn(chalk.yellow("  Continuing startup despite config creation error..."));
+                }
             }
-        } else {
-            console.log(chalk.dim(`  Found existing config.yaml in '.kai/'. Skipping default creation.`));
-        }
 
-        // --- Ensure .kaiignore exists at project root ---
-        const kaiignorePath = path.resolve(projectRoot, '.kaiignore');
-        if (!fsSync.existsSync(kaiignorePath)) {
-            console.log(chalk.yellow(`  '.kaiignore' not found at project root. Creating a default one...`));
+            // --- Ensure .kaiignore exists at project root ---
+            const kaiignorePath = path.resolve(projectRoot, '.kaiignore');
             try {
                 const defaultKaiignoreContent = `# Add patterns here to exclude files/directories from Kai's context (e.g., build/, *.log)\n`;
-                fsSync.writeFileSync(kaiignorePath, defaultKaiignoreContent, 'utf8');
-                console.log(chalk.green(`  Successfully created default .kaiignore.`));
+                await fsPromises.writeFile(kaiignorePath, defaultKaiignoreContent, { encoding: 'utf8', flag: 'wx' });
+                console.log(chalk.green(`  '.kaiignore' not found at project root. Created a default one.`));
             } catch (writeError) {
-                console.error(chalk.red(`  ❌ Error creating default .kaiignore at ${kaiignorePath}:`), writeError);
+                if ((writeError as NodeJS.ErrnoException).code !== 'EEXIST') {
+                    console.error(chalk.red(`  ❌ Error creating default .kaiignore at ${kaiignorePath}:`), writeError);
+                }
             }
-        }
-        // --- End Scaffold config.yaml ---
+            // --- End Scaffold config.yaml ---
 
+            // --- Ensure .kai/logs exists (using path potentially read from config later) ---
+            // Now that .kai exists, ensure logs exists within it
+            const defaultLogsDir = path.resolve(configDir, "logs"); // Assume default inside .kai
+            await fs.ensureKaiDirectoryExists(defaultLogsDir);
+        };
 
-        // --- Ensure .kai/logs exists (using path potentially read from config later) ---
-        // Now that .kai exists, ensure logs exists within it
-        const defaultLogsDir = path.resolve(configDir, "logs"); // Assume default inside .kai
-        await fs.ensureKaiDirectoryExists(defaultLogsDir);
+        await Promise.all([gitSetup(), kaiScaffolding()]);
 
         // --- REMOVED Kanban.md / kanban.json check/migration logic ---
 
@@ -140,6 +151,18 @@ export async function performStartupChecks(
 // REMOVED: createDefaultKanbanJson
 // --- END REMOVED Kanban Logic ---
 
+/** Loads config.yaml; without a Gemini API key the CLI can't do anything, so it says so and exits. */
+async function loadConfigOrExit(projectRoot: string): Promise<Config> {
+    try {
+        return await Config.load(projectRoot);
+    } catch (error) {
+        if (!(error instanceof MissingApiKeyError)) throw error;
+        console.error(chalk.red('Error: GEMINI_API_KEY environment variable is not set.'));
+        console.log(chalk.yellow('Please set the GEMINI_API_KEY environment variable with your API key (or GEMINI_API_KEYS with several, comma-separated).'));
+        process.exit(1);
+    }
+}
+
 async function main() {
 
     let codeProcessor: CodeProcessor | null = null;
@@ -171,8 +194,43 @@ async function main() {
             process.exit(1); // Exit if standalone server fails
         }
     }
+
+    // --- Special Case: 'kai stats' prints the latest saved metrics snapshot, its trend and context selection quality ---
+    if (args[0] === 'stats') {
+        const snapshots = await MetricsRegistry.readSnapshots(projectRoot);
+        if (snapshots.length === 0) {
+            console.log(chalk.yellow('No metrics snapshots found yet. They are written to .kai/metrics/ when a Kai session ends.'));
+        } else {
+            console.log(MetricsRegistry.formatReport(snapshots[snapshots.length - 1]));
+            console.log(MetricsRegistry.formatTrend(snapshots));
+        }
+        console.log(RelevanceFeedback.formatReport(await RelevanceFeedback.readRecords(projectRoot)));
+        return;
+    }
     // --- End Special Case Handling ---
 
+    // --- Tracing: `--trace` (or KAI_TRACE=1) records spans to .kai/traces/ ---
+    if (args.includes('--trace')) {
+        tracer.setEnabled(true);
+    }
+    if (tracer.isEnabled) {
+        console.log(chalk.dim(`Tracing enabled. Chrome trace files will be written to ${TRACES_DIR}/.`));
+    }
+
+    // --- Profiling: `--profile[=context,analysis,consolidation]` / `--profile-heap` write to .kai/profiles/ ---
+    try {
+        const profileArgs = Profiler.parseArgs(args);
+        profiler.configure(projectRoot, profileArgs.options);
+        profiler.setEnabled(profileArgs.enabled);
+    } catch (argError) {
+        console.error(chalk.red((argError as Error).message));
+        process.exitCode = 1;
+        return;
+    }
+    if (profiler.isEnabled) {
+        console.log(chalk.dim(`Profiling enabled. CPU profiles will be written to ${PROFILES_DIR}/.`));
+    }
+
     try {
         // --- Instantiate Core Services Needed Early (before config determination) ---
         const fs = new FileSystem();
@@ -180,17 +238,26 @@ async function main() {
         const gitService = new GitService(commandService, fs);
 
         // --- Perform Startup Checks ---
-        const placeholderUI = new UserInterface(new Config()); // Create a placeholder config
+        const placeholderUI = new UserInterface(await loadConfigOrExit(projectRoot)); // Create a placeholder config
         const startupOk = await performStartupChecks(projectRoot, fs, gitService, placeholderUI);
         if (!startupOk) {
             process.exit(1);
         }
 
         // Instantiate Config *after* potentially creating default config.yaml
-        config = new Config();
+        config = await loadConfigOrExit(projectRoot);
+        memoryGovernor.configure(config.memory);
+        relevanceFeedback.configure(projectRoot);
         // Instantiate UI *after* config is ready
         ui = new UserInterface(config); // <-- Assign to declared variable
         const aiClient = new AIClient(config);
+        // Each key in the active model's pool brings its own request budget, so the shared limits scale with that pool
+        const keyPoolSize = aiClient.modelParallelism();
+        const requestsPerMinute = aiClient.rateLimit().requests_per_minute;
+        taskScheduler.configure({
+            requestsPerMinute: requestsPerMinute ? requestsPerMinute * keyPoolSize : null,
+            modelConcurrency: DEFAULT_MODEL_CONCURRENCY * keyPoolSize,
+        });
         const contextBuilder = new ProjectContextBuilder(fs, gitService, projectRoot, config, aiClient);
 
         analyzerService = new ProjectAnalyzerService(
@@ -216,7 +283,7 @@ async function main() {
         } else {
              const currentMode = config.context.mode;
              console.log(chalk.blue(`\n🔧 Context mode already set to '${currentMode}'.`));
-             if ((currentMode === 'analysis_cache' || currentMode === 'dynamic')) {
+             if ((currentMode === 'analysis_cache' || currentMode === 'dynamic' || currentMode === 'auto')) {
                   const cachePath = path.resolve(projectRoot, config.analysis.cache_file_path);
                   const cacheExists = await fs.readAnalysisCache(cachePath) !== null;
                   if (!cacheExists) {
@@ -251,10 +318,17 @@ async function main() {
             commandService,
             gitService,
             ui, // Pass the UI instance
-            contextBuilder // Pass the ContextBuilder instance
+            contextBuilder, // Pass the ContextBuilder instance
+            aiClient // Share the single AIClient instead of constructing a second one
         );
         // --- End CodeProcessor Instantiation ---
 
+        // --- Startup benchmark hook: report time-to-menu and exit before prompting ---
+        if (process.env.KAI_STARTUP_BENCH) {
+            console.log(`KAI_STARTUP_BENCH ${JSON.stringify({ timeToMenuMs: Math.round(performance.now()) })}`);
+            return;
+        }
+
         // --- Main Interaction Loop ---
         while (true) {
             // Get user interaction INSIDE the loop
@@ -342,6 +416,16 @@ async function main() {
                  await codeProcessor.generateKaiignore();
                  console.log(chalk.magenta('🏁 .kaiignore generation completed.'));
 
+            } else if (mode === 'View Stats') {
+                 console.log(chalk.cyan('\n📊 Session metrics:'));
+                 console.log(MetricsRegistry.formatReport(metrics.snapshot()));
+
+            } else if (mode === 'Toggle Profiling') {
+                 profiler.setEnabled(!profiler.isEnabled);
+                 console.log(profiler.isEnabled
+                     ? chalk.green(`Profiling enabled. The next context build, analysis or consolidation will be captured to ${PROFILES_DIR}/.`)
+                     : chalk.yellow('Profiling disabled.'));
+
             } else if (mode === 'Scaffold Kai Guidelines') {
                  if (!codeProcessor) throw new Error("CodeProcessor not initialized.");
                  await codeProcessor.scaffoldKaiGuidelines();
@@ -425,6 +509,15 @@ async function main() {
                  await analyzerService.analyzeProject(); // Call analysis
                  console.log(chalk.cyan("Analysis complete."));
 
+            } else if (mode === 'Analyze Workspace Packages') {
+                 if (!analyzerService) {
+                      console.error(chalk.red("Internal Error: Analyzer service not initialized."));
+                      continue; // Go back to menu
+                 }
+                 const { packages } = interactionResult as Extract<UserInteractionResult, { mode: 'Analyze Workspace Packages' }>;
+                 await analyzerService.analyzeWorkspacePackages(packages);
+                 console.log(chalk.cyan("Use '/scope <package...>' in a conversation to limit its context to these packages."));
+
             } else if (mode === 'Change Context Mode') { // Needs config
                  if (!config) throw new Error("Config not initialized."); // Guard
                  const changeModeResult = interactionResult as ChangeModeInteractionResult;
@@ -434,8 +527,10 @@ async function main() {
                  await config.saveConfig(); // Persist the change
                  console.log(chalk.green(`Context mode set to '${newMode}' and saved to ${config.getConfigFilePath()}.`)); // Use public getter
 
-                 // If switching to analysis_cache, prepare .kaiignore and run analysis now
-                 if (newMode === 'analysis_cache') {
+                 // If switching to analysis_cache (or to auto without a cache), prepare .kaiignore and run analysis now
+                 const needsCache = newMode === 'analysis_cache'
+                     || (newMode === 'auto' && await fs.readAnalysisCache(path.resolve(projectRoot, config.analysis.cache_file_path)) === null);
+                 if (needsCache) {
                      if (!codeProcessor) throw new Error('CodeProcessor not initialized.');
                      console.log(chalk.cyan(`\nPreparing .kaiignore from current file list before analysis...`));
                      await codeProcessor.generateKaiignore();
@@ -494,9 +589,13 @@ async function main() {
                 console.error(chalk.red('Error during server shutdown:'), stopError);
             }
         }
+        await tracer.flush(projectRoot, 'session');
+        await metrics.writeSnapshot(projectRoot);
         console.log(chalk.dim("\nKai finished execution."));
     }
 }
 
-// Execute the main function
-main();
+// Execute the main function (only when run as the CLI, so tests can import this module)
+if (require.main === module) {
+    main();
+}
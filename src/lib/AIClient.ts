@@ -1,23 +1,31 @@
 // File: src/lib/AIClient.ts
 import path from 'path';
+import { performance } from 'perf_hooks';
 import { FileSystem } from './FileSystem';
-// Import BOTH model classes
-import Gemini2ProModel from "./models/Gemini2ProModel";
-import Gemini2FlashModel from "./models/Gemini2FlashModel"; // Added Flash model
-import AnthropicClaudeModel from "./models/AnthropicClaudeModel";
-import OpenAIChatModel from "./models/OpenAIChatModel";
+// Model classes are type-only imports: each model (and its provider SDK) is
+// required on first use so startup does not pay for SDKs a session never touches.
+import type Gemini2ProModel from "./models/Gemini2ProModel";
+import type Gemini2FlashModel from "./models/Gemini2FlashModel"; // Added Flash model
+import type AnthropicClaudeModel from "./models/AnthropicClaudeModel";
+import type OpenAIChatModel from "./models/OpenAIChatModel";
 // Import Config class itself
-import { Config } from "./Config";
+import { Config, RateLimitConfig } from "./Config";
 import Conversation, { Message } from "./models/Conversation";
 import chalk from 'chalk';
-import { encode as gpt3Encode } from 'gpt-3-encoder';
+import { countTokens } from './utils';
+import { tracer } from './telemetry/Tracer';
+import { metrics } from './telemetry/Metrics';
+import { taskScheduler } from './scheduling/TaskScheduler';
+import { ApiKeyPool } from './scheduling/ApiKeyPool';
 // *** ADDED Import ***
 import { HIDDEN_CONVERSATION_INSTRUCTION } from './internal_prompts'; // <-- Import the hidden prompt
+import type { RetrievalTools } from './retrieval/RetrievalTools';
 
 // --- Import necessary types from @google/generative-ai ---
-import {
+import type {
     GenerateContentRequest,
     GenerateContentResult,
+    Content,
     Tool,
     FunctionDeclaration, // To help type the tool definition
     // Content is also used internally by models
@@ -33,32 +41,191 @@ interface ErrorLogEntry extends LogEntryBase { type: 'error'; error: string; rol
 export type LogEntry = RequestLogEntry | ResponseLogEntry | ErrorLogEntry | SystemLogEntry; // Exported type
 export type LogEntryData = Omit<RequestLogEntry, 'timestamp'> | Omit<ResponseLogEntry, 'timestamp'> | Omit<ErrorLogEntry, 'timestamp'> | Omit<SystemLogEntry, 'timestamp'>; // Exported type
 
+const OPENAI_MODEL_NAMES = ['gpt-4', 'gpt-5', 'gpt-4o', 'o3'];
+
+type ChatModel = Gemini2ProModel | Gemini2FlashModel | AnthropicClaudeModel | OpenAIChatModel;
+type Provider = 'openai' | 'anthropic' | 'gemini';
+
 class AIClient {
     fs: FileSystem;
-    private proModel: Gemini2ProModel;
-    private flashModel: Gemini2FlashModel;
-    private anthropicModel?: AnthropicClaudeModel;
+    private _proModel?: Gemini2ProModel;
+    private _flashModel?: Gemini2FlashModel;
+    private _anthropicModel?: AnthropicClaudeModel;
     private openAIModels: Record<string, OpenAIChatModel> = {};
+    private pooledModels = new Map<string, ChatModel>(); // Models for pooled keys after the first
+    private keyPools: Partial<Record<Provider, ApiKeyPool | null>> = {};
     config: Config;
+    private projectRoot: string;
 
-    constructor(config: Config) {
+    /** @param projectRoot Where Kai.md and the diff failure log are found; the working directory by default. */
+    constructor(config: Config, projectRoot: string = process.cwd()) {
         this.config = config;
-        this.proModel = new Gemini2ProModel(config);
-        this.flashModel = new Gemini2FlashModel(config);
-        if ((config as any).anthropic?.api_key) {
-            this.anthropicModel = new AnthropicClaudeModel(config);
+        this.projectRoot = projectRoot;
+        this.fs = new FileSystem(projectRoot);
+    }
+
+    // --- Lazily constructed models ---
+    private get proModel(): Gemini2ProModel {
+        if (!this._proModel) {
+            const Model: typeof Gemini2ProModel = require('./models/Gemini2ProModel').default;
+            this._proModel = new Model(this.config, undefined, this._hasSpareKeys('gemini'));
+        }
+        return this._proModel;
+    }
+
+    private get flashModel(): Gemini2FlashModel {
+        if (!this._flashModel) {
+            const Model: typeof Gemini2FlashModel = require('./models/Gemini2FlashModel').default;
+            this._flashModel = new Model(this.config, undefined, this._hasSpareKeys('gemini'));
+        }
+        return this._flashModel;
+    }
+
+    private get anthropicModel(): AnthropicClaudeModel | undefined {
+        if (!this._anthropicModel && (this.config as any).anthropic?.api_key) {
+            const Model: typeof AnthropicClaudeModel = require('./models/AnthropicClaudeModel').default;
+            this._anthropicModel = new Model(this.config);
+        }
+        return this._anthropicModel;
+    }
+
+    private _getOpenAIModel(name: string): OpenAIChatModel | undefined {
+        if (!OPENAI_MODEL_NAMES.includes(name) || !(this.config as any).openai?.api_key) return undefined;
+        if (!this.openAIModels[name]) {
+            const Model: typeof OpenAIChatModel = require('./models/OpenAIChatModel').default;
+            this.openAIModels[name] = new Model(this.config, name);
+        }
+        return this.openAIModels[name];
+    }
+
+    /** Provider label used for metrics (per-provider latency, call and rate-limit counts). */
+    static providerFor(modelName: string): Provider {
+        const name = modelName.toLowerCase();
+        if (OPENAI_MODEL_NAMES.includes(name)) return 'openai';
+        if (name.startsWith('claude')) return 'anthropic';
+        return 'gemini';
+    }
+
+    /**
+     * Whether the provider bills a repeated request prefix at a cached rate without explicit
+     * cache markers: OpenAI caches prompts automatically and Gemini 2.5 and later cache
+     * implicitly. Kai sends Anthropic no cache_control breakpoints, so Claude requests are not cached.
+     */
+    static cachesPromptPrefix(modelName: string): boolean {
+        const provider = AIClient.providerFor(modelName);
+        if (provider === 'openai') return true;
+        if (provider === 'anthropic') return false;
+        return /^gemini-(2\.5|[3-9])/.test(modelName.toLowerCase());
+    }
+
+    /** Model calls worth having in flight at once for the current model: one per pooled key. */
+    modelParallelism(): number {
+        return this._keyPool(AIClient.providerFor(this.config.gemini.model_name))?.size ?? 1;
+    }
+
+    /** The provider's per-key rate limit from its own config section (the current model's provider by default). */
+    rateLimit(provider: Provider = AIClient.providerFor(this.config.gemini.model_name)): RateLimitConfig {
+        const section = provider === 'gemini' ? this.config.gemini : this.config[provider];
+        return section?.rate_limit ?? {};
+    }
+
+    /**
+     * The provider's key pool (null when it has no key), built on first use. Each key gets the
+     * per-minute request budget and quarantine configured for that provider.
+     */
+    private _keyPool(provider: Provider): ApiKeyPool | null {
+        if (!(provider in this.keyPools)) {
+            const section = provider === 'gemini' ? this.config.gemini : this.config[provider];
+            const keys = section?.api_keys ?? (section?.api_key ? [section.api_key] : []);
+            const rateLimit = this.rateLimit(provider);
+            this.keyPools[provider] = keys.length > 0
+                ? new ApiKeyPool(provider, keys, {
+                    requestsPerMinute: rateLimit.requests_per_minute ?? null,
+                    quarantineMs: rateLimit.key_quarantine_ms,
+                })
+                : null;
         }
-        if ((config as any).openai?.api_key) {
-            this.openAIModels['gpt-4'] = new OpenAIChatModel(config, 'gpt-4');
-            this.openAIModels['gpt-5'] = new OpenAIChatModel(config, 'gpt-5');
-            this.openAIModels['gpt-4o'] = new OpenAIChatModel(config, 'gpt-4o');
-            this.openAIModels['o3'] = new OpenAIChatModel(config, 'o3');
+        return this.keyPools[provider] ?? null;
+    }
+
+    /** Whether the provider's pool has keys to fail over to (models then leave 429s and auth errors to it). */
+    private _hasSpareKeys(provider: Provider): boolean {
+        return (this._keyPool(provider)?.size ?? 1) > 1;
+    }
+
+    /**
+     * Wraps a model call with a trace span plus latency, call, error and 429 metrics. The call
+     * waits its turn in the task scheduler at the caller's priority (interactive by default),
+     * then runs on the least-loaded key of the provider's key pool; `fn` gets that key's index.
+     * Every rate-limited attempt is counted, including those the pool retries on another key.
+     * @param canRetry See ApiKeyPool.run: whether a failed call may be retried on another key.
+     */
+    private async _callModel<T>(op: string, modelName: string, fn: (keyIndex: number) => Promise<T>, canRetry?: () => boolean): Promise<T> {
+        const provider = AIClient.providerFor(modelName);
+        const pool = this._keyPool(provider);
+        const attempt = (keyIndex: number) => fn(keyIndex).catch((error: unknown) => {
+            if (ApiKeyPool.classify(error) === 'rate_limited') metrics.increment('model.rate_limited', { provider });
+            throw error;
+        });
+        const call = () => (pool ? pool.run(attempt, canRetry) : attempt(0));
+        metrics.increment('model.calls', { provider, op });
+        try {
+            return await taskScheduler.run(
+                () => tracer.span(`model.${op}`, 'model', () => metrics.time('model.latency_ms', { provider, op }, call), { model: modelName }),
+                { kind: 'model', label: `${provider}.${op}` });
+        } catch (error: any) {
+            metrics.increment('model.errors', { provider });
+            throw error;
+        }
+    }
+
+    /**
+     * Picks the model for the currently configured model name, constructing it on first use.
+     * @param keyIndex Index in the provider's key pool; keys after the first get their own instances.
+     */
+    private _selectModel(keyIndex: number = 0): ChatModel {
+        if (keyIndex > 0) return this._pooledModel(keyIndex);
+        const currentModelName = this.config.gemini.model_name.toLowerCase();
+        const flashModelName = (this.config.gemini.subsequent_chat_model_name ?? '').toLowerCase();
+        return (
+            this._getOpenAIModel(currentModelName) ??
+            (currentModelName.startsWith('claude') && this.anthropicModel
+                ? this.anthropicModel
+                : currentModelName === flashModelName
+                ? this.flashModel
+                : this.proModel)
+        );
+    }
+
+    /** The model `_selectModel()` picks, built with another key from the provider's pool. */
+    private _pooledModel(keyIndex: number): ChatModel {
+        const base = this._selectModel();
+        const kind = base === this._proModel ? 'pro' : base === this._flashModel ? 'flash' : base === this._anthropicModel ? 'anthropic' : 'openai';
+        const cacheKey = `${kind}:${base.modelName}:${keyIndex}`;
+        let model = this.pooledModels.get(cacheKey);
+        if (!model) {
+            const apiKey = this._keyPool(AIClient.providerFor(base.modelName))!.key(keyIndex);
+            if (kind === 'pro') {
+                const Model: typeof Gemini2ProModel = require('./models/Gemini2ProModel').default;
+                model = new Model(this.config, apiKey, true);
+            } else if (kind === 'flash') {
+                const Model: typeof Gemini2FlashModel = require('./models/Gemini2FlashModel').default;
+                model = new Model(this.config, apiKey, true);
+            } else if (kind === 'anthropic') {
+                const Model: typeof AnthropicClaudeModel = require('./models/AnthropicClaudeModel').default;
+                model = new Model(this.config, apiKey);
+            } else {
+                const Model: typeof OpenAIChatModel = require('./models/OpenAIChatModel').default;
+                model = new Model(this.config, base.modelName, apiKey);
+            }
+            this.pooledModels.set(cacheKey, model);
         }
-        this.fs = new FileSystem();
+        return model;
     }
+    // --- End lazily constructed models ---
 
     private countTokens(text: string): number {
-        return gpt3Encode(text).length;
+        return tracer.spanSync('tokenize', 'tokenize', () => countTokens(text), { chars: text.length });
     }
 
     async logConversation(conversationFilePath: string, entryData: LogEntryData): Promise<void> {
@@ -69,26 +236,22 @@ class AIClient {
         catch (err) { console.error(chalk.red(`Error writing log file ${conversationFilePath}:`), err); }
     }
 
-    // --- getResponseFromAI (for standard chat) --- MODIFIED ---
-    async getResponseFromAI(
-        conversation: Conversation,
-        conversationFilePath: string,
-        contextString?: string,
-        useFlashModel: boolean = false, // This parameter is now ignored but kept for compatibility
-        useAnthropicModel: boolean = false // This parameter is now ignored but kept for compatibility
-    ): Promise<string> { // Adjusted: This method ONLY returns string for chat
-        const messages = conversation.getMessages();
+    /**
+     * Prepares the messages sent for a chat turn: the last user message gets the context,
+     * Kai.md guidelines and hidden instruction prepended (none of which is logged), and the
+     * prompt token breakdown is printed.
+     * @param earlierContext Context that went with earlier user messages (delta mode); it is
+     *   replayed with them unchanged so the model sees the anchor the latest delta builds on.
+     */
+    private async _buildChatMessages(messages: Message[], contextString?: string, earlierContext?: Map<Message, string>): Promise<Message[]> {
         const lastMessage = messages[messages.length - 1];
-
-        if (!lastMessage || lastMessage.role !== 'user') {
-            console.error(chalk.red("Conversation history doesn't end with a user message. Aborting AI call."));
-            await this.logConversation(conversationFilePath, { type: 'error', error: "Internal error: Conversation history doesn't end with a user message." });
-            throw new Error("Conversation history must end with a user message to get AI response.");
+        if (earlierContext && earlierContext.size > 0) {
+            messages = messages.map(m => {
+                const context = m === lastMessage ? undefined : earlierContext.get(m);
+                return context ? { ...m, content: `This is the code base context:\n${context}\n\n---\nUser Question:\n${m.content}` } : m;
+            });
         }
 
-        // --- IMPORTANT: Log the ORIGINAL user message BEFORE modifying for the AI call ---
-        await this.logConversation(conversationFilePath, { type: 'request', role: 'user', content: lastMessage.content });
-
         // --- Prepare messages for the AI, including the hidden prompt ---
         let finalUserPromptText = lastMessage.content; // Start with original prompt
 
@@ -105,7 +268,7 @@ class AIClient {
         let kaiGuidelinesTokens = 0;
         let kaiGuidelinesChars = 0;
         try {
-            const kaiPath = path.resolve(process.cwd(), 'Kai.md');
+            const kaiPath = path.resolve(this.projectRoot, 'Kai.md');
             const kaiGuidelines = await this.fs.readFile(kaiPath);
             if (kaiGuidelines && kaiGuidelines.trim()) {
                 const guideBlock = `Kai Project Conversation Guidelines:\n${kaiGuidelines.trim()}\n\n---\n`;
@@ -163,27 +326,43 @@ class AIClient {
         console.log(chalk.cyan(`Total conversation size sent: ${finalPromptTokens + historyTokens} tokens, ${finalUserPromptText.length + historyChars} characters`));
 
         // Create the message structure for the model, replacing the last user message content
-        const messagesForModel: Message[] = [
+        return [
             ...messages.slice(0, -1),
             { ...lastMessage, content: finalUserPromptText } // Use the modified final prompt
         ];
-        // --- End AI message preparation ---
+    }
 
-        const currentModelName = this.config.gemini.model_name.toLowerCase();
-        const modelToCall =
-            this.openAIModels[currentModelName] ??
-            (currentModelName.startsWith('claude') && this.anthropicModel
-                ? this.anthropicModel
-                : currentModelName === this.flashModel.modelName.toLowerCase()
-                ? this.flashModel
-                : this.proModel);
+    // --- getResponseFromAI (for standard chat) --- MODIFIED ---
+    async getResponseFromAI(
+        conversation: Conversation,
+        conversationFilePath: string,
+        contextString?: string,
+        useFlashModel: boolean = false, // This parameter is now ignored but kept for compatibility
+        useAnthropicModel: boolean = false, // This parameter is now ignored but kept for compatibility
+        earlierContext?: Map<Message, string> // Anchor/deltas sent with earlier turns (context delta mode)
+    ): Promise<string> { // Adjusted: This method ONLY returns string for chat
+        const messages = conversation.getMessages();
+        const lastMessage = messages[messages.length - 1];
+
+        if (!lastMessage || lastMessage.role !== 'user') {
+            console.error(chalk.red("Conversation history doesn't end with a user message. Aborting AI call."));
+            await this.logConversation(conversationFilePath, { type: 'error', error: "Internal error: Conversation history doesn't end with a user message." });
+            throw new Error("Conversation history must end with a user message to get AI response.");
+        }
+
+        // --- IMPORTANT: Log the ORIGINAL user message BEFORE modifying for the AI call ---
+        await this.logConversation(conversationFilePath, { type: 'request', role: 'user', content: lastMessage.content });
+
+        const messagesForModel = await this._buildChatMessages(messages, contextString, earlierContext);
+
+        const modelToCall = this._selectModel();
 
         const modelLogName = modelToCall.modelName;
         console.log(chalk.blue(`Selecting model instance for chat: ${modelLogName}`));
 
         try {
             // Pass the modified messages (with hidden prompt baked in) to the model
-            const responseText = await modelToCall.getResponseFromAI(messagesForModel);
+            const responseText = await this._callModel('chat', modelLogName, key => this._selectModel(key).getResponseFromAI(messagesForModel));
 
             // Log the actual AI response and add it to the conversation *without* the hidden prompt
             await this.logConversation(conversationFilePath, { type: 'response', role: 'assistant', content: responseText });
@@ -198,6 +377,133 @@ class AIClient {
         }
     }
 
+    // --- streamResponseFromAI (chat with incremental output, e.g. Kai Desktop) ---
+    /**
+     * Chat turn whose answer is passed to `onDelta` as it is generated. Aborting `signal`
+     * stops the stream; the partial answer is still logged (marked as cancelled) and added to
+     * the conversation so the next turn sees what the user saw.
+     */
+    async streamResponseFromAI(
+        conversation: Conversation,
+        conversationFilePath: string,
+        contextString: string | undefined,
+        onDelta: (text: string) => void,
+        signal?: AbortSignal
+    ): Promise<{ text: string; cancelled: boolean }> {
+        const messages = conversation.getMessages();
+        const lastMessage = messages[messages.length - 1];
+
+        if (!lastMessage || lastMessage.role !== 'user') {
+            console.error(chalk.red("Conversation history doesn't end with a user message. Aborting AI call."));
+            await this.logConversation(conversationFilePath, { type: 'error', error: "Internal error: Conversation history doesn't end with a user message." });
+            throw new Error("Conversation history must end with a user message to get AI response.");
+        }
+
+        await this.logConversation(conversationFilePath, { type: 'request', role: 'user', content: lastMessage.content });
+        const messagesForModel = await this._buildChatMessages(messages, contextString);
+        const modelToCall = this._selectModel();
+        const modelLogName = modelToCall.modelName;
+        const provider = AIClient.providerFor(modelLogName);
+        console.log(chalk.blue(`Selecting model instance for streamed chat: ${modelLogName}`));
+
+        const start = performance.now();
+        let firstDelta = true;
+        const forward = (text: string) => {
+            if (firstDelta) {
+                firstDelta = false;
+                metrics.observe('model.first_delta_ms', performance.now() - start, { provider });
+            }
+            onDelta(text);
+        };
+
+        try {
+            // Once a delta reached the caller a retry would repeat it, so only a silent failure moves to another key
+            const responseText = await this._callModel('chat_stream', modelLogName,
+                key => this._selectModel(key).streamResponseFromAI(messagesForModel, forward, signal), () => firstDelta);
+            const cancelled = signal?.aborted ?? false;
+            if (cancelled) metrics.increment('model.stream_cancelled', { provider });
+            await this.logConversation(conversationFilePath, {
+                type: 'response',
+                role: 'assistant',
+                content: cancelled ? `${responseText}\n\n[Response cancelled]` : responseText,
+            });
+            conversation.addMessage('assistant', responseText);
+            return { text: responseText, cancelled };
+        } catch (error) {
+            const errorMessage = error instanceof Error ? error.message : String(error);
+            console.error(chalk.red(`Error streaming response from AI model (${modelLogName}):`), errorMessage);
+            await this.logConversation(conversationFilePath, { type: 'error', error: `AI Model Error (${modelLogName}): ${errorMessage}` });
+            throw error;
+        }
+    }
+
+    // --- getResponseWithTools (chat with on-demand retrieval via function calling) ---
+    /**
+     * Chat turn where the model pulls code through retrieval tools instead of receiving it all
+     * up front. Each round, every function call the model makes is executed concurrently and
+     * the results are sent back; the last round disables tools so the turn ends with text.
+     * Only the final answer is logged and added to the conversation.
+     */
+    async getResponseWithTools(
+        conversation: Conversation,
+        conversationFilePath: string,
+        contextString: string,
+        tools: RetrievalTools,
+        maxRounds: number = 6
+    ): Promise<string> {
+        const messages = conversation.getMessages();
+        const lastMessage = messages[messages.length - 1];
+        if (!lastMessage || lastMessage.role !== 'user') {
+            throw new Error("Conversation history must end with a user message to get AI response.");
+        }
+        await this.logConversation(conversationFilePath, { type: 'request', role: 'user', content: lastMessage.content });
+
+        // Same prompt as a plain chat turn, in the provider's content format
+        const contents: Content[] = [];
+        for (const msg of await this._buildChatMessages(messages, contextString)) {
+            if (msg.role === 'system' || !msg.content) continue;
+            const role = msg.role === 'assistant' ? 'model' : 'user';
+            const previous = contents[contents.length - 1];
+            if (previous?.role === role) previous.parts.push({ text: msg.content });
+            else contents.push({ role, parts: [{ text: msg.content }] });
+        }
+
+        let responseText = '';
+        let toolCalls = 0;
+        try {
+            for (let round = 1; round <= maxRounds; round++) {
+                const finalRound = round === maxRounds;
+                const result = await this.generateContent({
+                    contents,
+                    tools: [{ functionDeclarations: tools.declarations }],
+                    // The last round may only answer, so a turn cannot loop on tool calls forever
+                    ...(finalRound ? { toolConfig: tools.answerOnlyConfig } : {}),
+                });
+                const parts = result.response?.candidates?.[0]?.content?.parts ?? [];
+                const calls = parts.filter(p => p.functionCall).map(p => ({ name: p.functionCall!.name, args: (p.functionCall!.args ?? {}) as Record<string, any> }));
+                if (calls.length === 0 || finalRound) {
+                    responseText = parts.map(p => p.text ?? '').join('');
+                    break;
+                }
+                console.log(chalk.dim(`  Round ${round}: running ${calls.length} tool call(s) concurrently: ${calls.map(c => c.name).join(', ')}`));
+                toolCalls += calls.length;
+                const results = await tools.executeAll(calls);
+                contents.push({ role: 'model', parts });
+                contents.push({ role: 'function', parts: results.map(r => ({ functionResponse: { name: r.name, response: r.response } })) });
+            }
+        } catch (error) {
+            const errorMessage = error instanceof Error ? error.message : String(error);
+            await this.logConversation(conversationFilePath, { type: 'error', error: `AI Model Error (tool retrieval): ${errorMessage}` });
+            throw error;
+        }
+        metrics.observe('retrieval.tool_calls_per_turn', toolCalls, undefined, 'count');
+        if (!responseText.trim()) throw new Error('AI returned no answer after tool retrieval.');
+
+        await this.logConversation(conversationFilePath, { type: 'response', role: 'assistant', content: responseText });
+        conversation.addMessage('assistant', responseText);
+        return responseText;
+    }
+
     // --- getResponseTextFromAI (for simple text generation like consolidation analysis/generation) ---
     // This does NOT automatically prepend the hidden conversation instruction,
     // as it's meant for specific tasks where the prompt is fully constructed by the caller.
@@ -212,21 +518,14 @@ class AIClient {
             throw new Error("Cannot get raw AI response with empty message history.");
         }
 
-        const currentModelName = this.config.gemini.model_name.toLowerCase();
-        const modelToCall =
-            this.openAIModels[currentModelName] ??
-            (currentModelName.startsWith('claude') && this.anthropicModel
-                ? this.anthropicModel
-                : currentModelName === this.flashModel.modelName.toLowerCase()
-                ? this.flashModel
-                : this.proModel);
+        const modelToCall = this._selectModel();
         
         const modelLogName = modelToCall.modelName;
         console.log(chalk.blue(`Querying AI for simple text (using ${modelLogName})...`));
 
         try {
             // Use the chat-focused method of the model, assuming it handles simple text gen too
-            const responseText = await modelToCall.getResponseFromAI(messages);
+            const responseText = await this._callModel('text', modelLogName, key => this._selectModel(key).getResponseFromAI(messages));
 
         console.log(chalk.blue(`Received simple text response (${responseText.length} characters)`));
             return responseText;
@@ -247,21 +546,14 @@ class AIClient {
         useAnthropicModel: boolean = false // This parameter is now ignored but kept for compatibility
     ): Promise<GenerateContentResult> { // Return the SDK's result type
         // ... (Implementation remains the same - no hidden prompt added here) ...
-        const currentModelName = this.config.gemini.model_name.toLowerCase();
-        const modelToCall =
-            this.openAIModels[currentModelName] ??
-            (currentModelName.startsWith('claude') && this.anthropicModel
-                ? this.anthropicModel
-                : currentModelName === this.flashModel.modelName.toLowerCase()
-                ? this.flashModel
-                : this.proModel);
+        const modelToCall = this._selectModel();
 
         const modelLogName = modelToCall.modelName;
         console.log(chalk.blue(`Generating content (potentially with function calls) using ${modelLogName}...`));
 
         try {
             // Delegate to the model's new generateContent method
-            const result = await modelToCall.generateContent(request);
+            const result = await this._callModel('generateContent', modelLogName, key => this._selectModel(key).generateContent(request));
 
             // Optional: Log details about the response (text vs function call)
             const response = result.response;
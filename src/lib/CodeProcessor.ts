@@ -5,7 +5,7 @@ import { FileSystem } from './FileSystem';
 import { AIClient, LogEntryData } from './AIClient';
 import { Config } from "./Config";
 import { UserInterface } from './UserInterface'; // <-- ADDED Import
-import Conversation, { Message, JsonlLogEntry } from './models/Conversation';
+import Conversation, { Message, JsonlLogEntry, summarizeHistory } from './models/Conversation';
 import { ProjectContextBuilder } from './ProjectContextBuilder'; // <-- ADDED Import
 import { ConsolidationService } from './consolidation/ConsolidationService';
 import { CommandService } from './CommandService';
@@ -16,6 +16,8 @@ import { TypeScriptLoop } from './consolidation/feedback/TypeScriptLoop';
 import { CONSOLIDATION_SUCCESS_MARKER } from './consolidation/constants';
 import { CommitMessageService } from './CommitMessageService';
 import { TestCoverageRaiser } from './hardening/TestCoverageRaiser';
+import { TokenBudgetProfiler } from './analysis/TokenBudgetProfiler';
+import { AnalysisPrompts } from './analysis/prompts';
 
 
 class CodeProcessor {
@@ -38,7 +40,8 @@ class CodeProcessor {
         commandService: CommandService,
         gitService: GitService,
         ui: UserInterface,
-        contextBuilder: ProjectContextBuilder
+        contextBuilder: ProjectContextBuilder,
+        aiClient?: AIClient
     ): Promise<CodeProcessor> {
         const projectRoot = await gitService.getRepositoryRoot(process.cwd());
         return new CodeProcessor(
@@ -48,7 +51,8 @@ class CodeProcessor {
             gitService,
             ui,
             contextBuilder,
-            projectRoot
+            projectRoot,
+            aiClient
         );
     }
 
@@ -60,7 +64,8 @@ class CodeProcessor {
         gitService: GitService,
         ui: UserInterface,
         contextBuilder: ProjectContextBuilder,
-        projectRoot: string
+        projectRoot: string,
+        aiClient?: AIClient
     ) {
         this.config = config;
         this.fs = fs;
@@ -68,7 +73,7 @@ class CodeProcessor {
         this.gitService = gitService;
         this.ui = ui; // <-- Assign injected instance
         this.contextBuilder = contextBuilder; // <-- Assign injected instance
-        this.aiClient = new AIClient(config); // AIClient only needs config (and fs internally)
+        this.aiClient = aiClient ?? new AIClient(config); // Reuse the caller's client when given
         this.projectRoot = projectRoot;
 
         this.commitMessageService = new CommitMessageService(
@@ -164,12 +169,17 @@ class CodeProcessor {
             let currentContextString: string;
             if (this.config.context.mode === 'dynamic') {
                 const historySlice = this._findRelevantHistorySlice(conversation);
-                const historySummary = this._summarizeHistory(historySlice);
+                const historySummary = summarizeHistory(historySlice);
                 const ctx = await this.contextBuilder.buildDynamicContext(
                     'Consolidate recent conversation changes',
-                    historySummary
+                    historySummary,
+                    null // Not a user turn: keep it out of relevance feedback
                 );
                 currentContextString = ctx.context;
+            } else if (this.config.context.mode === 'auto') {
+                const historySummary = summarizeHistory(this._findRelevantHistorySlice(conversation));
+                const { context } = await this.contextBuilder.buildContext('Consolidate recent conversation changes', historySummary, null);
+                currentContextString = context;
             } else {
                 const { context } = await this.contextBuilder.buildContext();
                 currentContextString = context;
@@ -197,35 +207,54 @@ class CodeProcessor {
         await this.hardenService.process(tool);
     }
 
-    async generateKaiignore(): Promise<void> {
-        console.log(chalk.cyan('\nGenerating .kaiignore using AI suggestions...'));
-        let fileList: string[] = [];
+    /**
+     * Writes a .kaiignore based on a local token budget profile of the project.
+     * Rules are ranked by estimated tokens cut; when `refineWithAI` is set, only the
+     * compact histogram (not the raw file list) is sent to the AI for refinement.
+     * Falls back to the local rules if the AI call fails.
+     */
+    async generateKaiignore(options: { refineWithAI?: boolean } = {}): Promise<void> {
+        const refineWithAI = options.refineWithAI ?? true;
+        console.log(chalk.cyan('\nProfiling project token budget to generate .kaiignore...'));
+
+        let histogram: string;
+        let localKaiignore: string;
         try {
-            const { stdout } = await this.commandService.run('find . -type f', { cwd: this.projectRoot });
-            fileList = stdout.split('\n')
-                .map(l => l.trim())
-                .filter(l => l && l !== '.' && !l.startsWith('./.git/') && !l.startsWith('./.kai/'))
-                .map(p => p.replace(/^\.\/?/, '').replace(/\\/g, '/'))
-                .sort();
+            // Only .gitignore applies: the existing .kaiignore is what we are regenerating.
+            const ignoreRules = await this.gitService.getIgnoreRules(this.projectRoot, { includeKaiignore: false });
+            const profiler = new TokenBudgetProfiler(this.fs, this.projectRoot);
+            const profile = await profiler.profile(ignoreRules);
+            const suggestions = TokenBudgetProfiler.suggestIgnoreRules(profile);
+            histogram = TokenBudgetProfiler.formatHistogram(profile);
+            localKaiignore = TokenBudgetProfiler.formatKaiignore(suggestions);
+
+            console.log(chalk.dim(histogram));
+            const saved = suggestions.reduce((sum, s) => sum + s.tokens, 0);
+            console.log(chalk.blue(`Proposed ${suggestions.length} rule(s) cutting ~${saved} of ~${profile.totals.tokens} estimated tokens.`));
         } catch (err) {
-            console.error(chalk.red('Failed to list project files:'), err);
+            console.error(chalk.red('Failed to profile project files:'), err);
             return;
         }
 
-        const listForPrompt = fileList.map(f => `- ${f}`).join('\n');
-        const prompt = `Here is the list of files in my project:\n${listForPrompt}\n\nGenerate a recommended .kaiignore file to exclude unnecessary files from Kai's context. Respond ONLY with the file contents.`;
-        const messages: Message[] = [ { role: 'user', content: prompt } ];
-        let response: string;
-        try {
-            response = await this.aiClient.getResponseTextFromAI(messages, true);
-        } catch (error) {
-            console.error(chalk.red('AI generation failed:'), error);
-            return;
+        let content = localKaiignore;
+        if (refineWithAI) {
+            const prompt = AnalysisPrompts.refineKaiignorePrompt(histogram, localKaiignore);
+            const messages: Message[] = [ { role: 'user', content: prompt } ];
+            try {
+                const response = await this.aiClient.getResponseTextFromAI(messages, true);
+                if (response && response.trim()) {
+                    content = response.trim() + '\n';
+                } else {
+                    console.warn(chalk.yellow('AI returned an empty .kaiignore; using local suggestions.'));
+                }
+            } catch (error) {
+                console.error(chalk.red('AI refinement failed; using local suggestions:'), error);
+            }
         }
 
         const kaiignorePath = path.join(this.projectRoot, '.kaiignore');
         try {
-            await this.fs.writeFile(kaiignorePath, response.trim() + '\n');
+            await this.fs.writeFile(kaiignorePath, content);
             console.log(chalk.green(`.kaiignore written to ${kaiignorePath}`));
         } catch (err) {
             console.error(chalk.red('Failed to write .kaiignore:'), err);
@@ -290,20 +319,6 @@ class CodeProcessor {
         return allMessages.slice(lastSuccessIndex + 1);
     }
 
-    /** Creates a simple summary of conversation history for dynamic context */
-    private _summarizeHistory(history: Message[]): string | null {
-        if (!history || history.length === 0) return null;
-        const recentMessages = history.slice(-4);
-        let summary = 'Recent conversation highlights:\n';
-        recentMessages.forEach((msg: Message) => {
-            const contentPreview = typeof msg.content === 'string'
-                ? `${msg.content.substring(0, 100)}${msg.content.length > 100 ? '...' : ''}`
-                : '[Non-text content]';
-            summary += `  ${msg.role}: ${contentPreview}\n`;
-        });
-        return summary;
-    }
-
      // Keep optimizeWhitespace if it's potentially used by other methods or could be useful
      // If not, it can be removed as well. Currently not used within this class.
      optimizeWhitespace(code: string): string {
@@ -1,6 +1,7 @@
 // File: src/lib/CommandService.ts
 import { exec as execCb, ExecOptions } from 'child_process';
 import chalk from 'chalk';
+import { tracer } from './telemetry/Tracer';
 
 // Define the result type for successful command execution
 export interface CommandResult {
@@ -33,7 +34,7 @@ export class CommandService {
         console.log(chalk.dim(`🔩 Executing command: ${logCommand}${effectiveOptions.cwd ? ` in ${effectiveOptions.cwd}` : ''}`));
 
         try {
-            const { stdout, stderr } = await new Promise<CommandResult>((resolve, reject) => {
+            const { stdout, stderr } = await tracer.span('command', 'command', () => new Promise<CommandResult>((resolve, reject) => {
                 execCb(command, effectiveOptions as ExecOptions, (error, stdout, stderr) => {
                     if (error) {
                         (error as any).stdout = stdout;
@@ -42,7 +43,7 @@ export class CommandService {
                     }
                     resolve({ stdout, stderr });
                 });
-            });
+            }), { command: logCommand.slice(0, 200) });
 
             if (stderr) {
                 // Log stderr even on success, as some commands use it for warnings/info
@@ -1,22 +1,25 @@
 // File: src/lib/Config.ts
-import * as fsSync from 'fs'; // Use synchronous fs for config loading/saving
+import * as fsSync from 'fs'; // Async reads via Config.load(); sync fallback for `new Config()`
 import path from 'path';
 import yaml from 'js-yaml';
 import chalk from 'chalk';
+import { FileLock, writeFileAtomic } from './FileLock';
 
 // --- Interfaces ---
 
-interface GeminiRateLimitConfig {
-    requests_per_minute?: number;
+interface RateLimitConfig {
+    requests_per_minute?: number; // Per API key when a provider has a key pool
+    key_quarantine_ms?: number; // First cooldown for a rate-limited pool key; doubles on each repeat
 }
 
 interface GeminiConfig {
     api_key: string; // Loaded from ENV
+    api_keys?: string[]; // Key pool: GEMINI_API_KEY plus GEMINI_API_KEYS (from ENV, never saved)
     model_name: string; // Primary model (e.g., Pro) - Will be required after loading
     subsequent_chat_model_name: string; // Secondary model (e.g., Flash) - Will be required after loading
     max_output_tokens?: number; // Max tokens for model response
     max_prompt_tokens?: number; // Max tokens for input (used for context building limit)
-    rate_limit?: GeminiRateLimitConfig;
+    rate_limit?: RateLimitConfig;
     max_retries?: number; // General retries (might deprecate if specific ones are better)
     retry_delay?: number; // General retry delay (might deprecate)
     generation_max_retries?: number; // Max retries specifically for the generation step (Step B)
@@ -39,33 +42,48 @@ interface ProjectConfig {
 // *** ADDED: Analysis Config Interface ***
 interface AnalysisConfig {
     cache_file_path?: string;
+    shared_summary_cache?: boolean; // Reuse summaries across clones/worktrees via ~/.cache/kai/summaries (default: true)
     // phind_command?: string; // REMOVED - Determined automatically
 }
 
 // *** ADDED: Context Config Interface ***
 interface ContextConfig {
-    mode?: 'full' | 'analysis_cache' | 'dynamic'; // Added 'dynamic' mode
+    mode?: 'full' | 'analysis_cache' | 'dynamic' | 'auto'; // 'auto' picks one of the others per turn
+    retrieval_tools?: boolean; // Let the model fetch code via read_file/grep/list_dir/get_symbol instead of preloading it
+    max_tool_rounds?: number; // Model round trips per chat turn when retrieval tools are on
+    delta_mode?: boolean; // After the first full context, send only what changed since it (models with prompt caching only)
+    delta_reanchor_turns?: number; // Delta turns before the full context is sent again
+}
+
+interface MemoryConfig {
+    heap_budget_mb?: number; // Heap budget for caches and context building (default: 80% of the V8 heap limit)
+    shed_ratio?: number; // Fraction of the budget above which caches are shed (default: 0.85)
 }
 
 // *** ADDED: Anthropic Claude Config Interface ***
 interface AnthropicConfig {
     api_key: string;
+    api_keys?: string[]; // Key pool: api_key plus ANTHROPIC_API_KEYS
     model_name: string;
     max_output_tokens?: number;
+    rate_limit?: RateLimitConfig; // Per Anthropic key; defaults as for Gemini
 }
 
 interface OpenAIConfig {
     api_key: string;
+    api_keys?: string[]; // Key pool: api_key plus OPENAI_API_KEYS
     max_output_tokens?: number;
     max_prompt_tokens?: number;
+    rate_limit?: RateLimitConfig; // Per OpenAI key; defaults as for Gemini
 }
 
 // Main Config structure used internally (interfaces, not class for simpler structure)
 interface IConfig { // Renamed to IConfig to avoid conflict with Config class name
-    gemini: Required<Omit<GeminiConfig, 'rate_limit'>> & { rate_limit?: GeminiRateLimitConfig }; // Most fields are required, rate_limit is optional object
+    gemini: Required<Omit<GeminiConfig, 'rate_limit'>> & { rate_limit?: RateLimitConfig }; // Most fields are required, rate_limit is optional object
     project: Required<ProjectConfig>; // Make project settings required internally after defaults
     analysis: Required<AnalysisConfig>; // Add analysis section
     context: ContextConfig; // Add context section (mode is optional until resolved)
+    memory: MemoryConfig; // Unset values fall back to MemoryGovernor defaults
     /** Optional configuration for Anthropic Claude model */
     anthropic?: Required<AnthropicConfig>;
     /** Optional configuration for OpenAI models */
@@ -79,16 +97,40 @@ type YamlConfigData = {
     project?: Partial<ProjectConfig>;
     analysis?: Partial<AnalysisConfig>; // phind_command is removed from AnalysisConfig itself
     context?: Partial<ContextConfig>; // Added context
+    memory?: Partial<MemoryConfig>;
     anthropic?: Partial<AnthropicConfig>;
     openai?: Partial<OpenAIConfig>;
 };
 
+/** A provider's rate limit from config.yaml, with unset values defaulted. */
+function rateLimitWithDefaults(rateLimit: Partial<RateLimitConfig> | undefined): RateLimitConfig {
+    return {
+        requests_per_minute: rateLimit?.requests_per_minute || 60,
+        key_quarantine_ms: rateLimit?.key_quarantine_ms || 60000,
+    };
+}
+
+/** Thrown when no Gemini API key is set; the CLI reports it and exits, the desktop app returns it to the window. */
+export class MissingApiKeyError extends Error {
+    constructor() {
+        super('GEMINI_API_KEY environment variable is not set. Please set it with your API key (or GEMINI_API_KEYS with several, comma-separated).');
+        this.name = 'MissingApiKeyError';
+    }
+}
+
+/** Distinct keys, in order, from single-key values plus a comma- or space-separated list. */
+function keyList(keys: Array<string | undefined>, list: string | undefined): string[] {
+    const all = [...keys, ...(list ?? '').split(/[\s,]+/)];
+    return [...new Set(all.filter((key): key is string => !!key && !!key.trim()).map(key => key.trim()))];
+}
+
 // --- Config Class ---
 class ConfigLoader /* implements IConfig */ { // Let TS infer implementation details
-    gemini: Required<Omit<GeminiConfig, 'rate_limit'>> & { rate_limit?: GeminiRateLimitConfig };
+    gemini: Required<Omit<GeminiConfig, 'rate_limit'>> & { rate_limit?: RateLimitConfig };
     project: Required<ProjectConfig>; // Use Required utility type
     analysis: Required<AnalysisConfig>; // Add analysis property
     context: ContextConfig; // Add context property (mode is optional until resolved)
+    memory: MemoryConfig;
     /** Optional configuration for Anthropic Claude model */
     anthropic?: Required<AnthropicConfig>;
     /** Optional configuration for OpenAI models */
@@ -96,39 +138,62 @@ class ConfigLoader /* implements IConfig */ { // Let TS infer implementation det
     chatsDir: string; // Absolute path
     private configFilePath: string; // Store path for saving
 
-    constructor() {
+    /**
+     * @param configText Contents of config.yaml already read by `Config.load()` (null if missing).
+     *   When omitted the file is read synchronously, which is fine for tests and scripts but
+     *   blocks the event loop; interactive startup uses `Config.load()`.
+     * @param projectRoot Directory holding `.kai/`; the working directory unless a caller (the
+     *   desktop app) serves several projects from one process.
+     * @throws MissingApiKeyError when no Gemini API key is set.
+     */
+    constructor(configText?: string | null, projectRoot: string = process.cwd()) {
         // Resolve path relative to project root inside .kai directory
-        this.configFilePath = path.resolve(process.cwd(), '.kai', 'config.yaml'); // Store path
-        const loadedConfig = this.loadConfig();
+        this.configFilePath = path.resolve(projectRoot, '.kai', 'config.yaml'); // Store path
+        const loadedConfig = this.loadConfig(configText, projectRoot);
         this.gemini = loadedConfig.gemini;
         this.project = loadedConfig.project;
         this.analysis = loadedConfig.analysis; // Assign loaded analysis config
         // 'context' is loaded as potentially undefined here
         this.context = loadedConfig.context;   // Assign loaded context config
+        this.memory = loadedConfig.memory;
         this.anthropic = loadedConfig.anthropic; // Assign loaded anthropic config
         this.openai = loadedConfig.openai; // Assign loaded openai config
         this.chatsDir = loadedConfig.chatsDir; // Use pre-calculated absolute path
     }
 
-    private loadConfig(): IConfig {
+    /** Reads config.yaml without blocking the event loop and builds the config from it. */
+    static async load(projectRoot: string = process.cwd()): Promise<ConfigLoader> {
+        const configPath = path.resolve(projectRoot, '.kai', 'config.yaml');
+        let configText: string | null | undefined;
+        try {
+            configText = await fsSync.promises.readFile(configPath, 'utf8');
+        } catch (e) {
+            // Missing file: defaults. Other read errors: let the synchronous path report them.
+            configText = (e as NodeJS.ErrnoException).code === 'ENOENT' ? null : undefined;
+        }
+        return new ConfigLoader(configText, projectRoot);
+    }
+
+    private loadConfig(configText: string | null | undefined, projectRoot: string): IConfig {
         // Load from .kai directory
-        const configPath = path.resolve(process.cwd(), '.kai', 'config.yaml');
+        const configPath = this.configFilePath;
         let yamlConfig: YamlConfigData = {};
 
-        // 1. Load API Key from Environment Variable
-        const apiKey = process.env.GEMINI_API_KEY;
+        // 1. Load API Key(s) from Environment Variables
+        const geminiApiKeys = keyList([process.env.GEMINI_API_KEY], process.env.GEMINI_API_KEYS);
+        const apiKey = geminiApiKeys[0];
         if (!apiKey) {
-            console.error(chalk.red('Error: GEMINI_API_KEY environment variable is not set.'));
-            console.log(chalk.yellow('Please set the GEMINI_API_KEY environment variable with your API key.'));
-            process.exit(1); // Exit if API key is missing
+            throw new MissingApiKeyError();
         }
 
         // 2. Load config.yaml
         try {
-            // Use synchronous existsSync for initial check during config load
-            if (fsSync.existsSync(configPath)) {
-                const fileContents = fsSync.readFileSync(configPath, 'utf8');
-                const loadedYaml = yaml.load(fileContents);
+            if (configText === undefined) {
+                // Synchronous fallback for `new Config()` without preloaded contents
+                configText = fsSync.existsSync(configPath) ? fsSync.readFileSync(configPath, 'utf8') : null;
+            }
+            if (configText !== null) {
+                const loadedYaml = yaml.load(configText);
                 if (loadedYaml && typeof loadedYaml === 'object') {
                     yamlConfig = loadedYaml as YamlConfigData;
                 } else {
@@ -151,15 +216,14 @@ class ConfigLoader /* implements IConfig */ { // Let TS infer implementation det
         const defaultGenerationRetryBaseDelayMs = 2000; // 2 seconds base
         const defaultInteractivePromptReview = false;
 
-        const finalGeminiConfig: Required<Omit<GeminiConfig, 'rate_limit'>> & { rate_limit?: GeminiRateLimitConfig } = {
+        const finalGeminiConfig: Required<Omit<GeminiConfig, 'rate_limit'>> & { rate_limit?: RateLimitConfig } = {
             api_key: apiKey, // Mandatory, loaded from env
+            api_keys: geminiApiKeys,
             model_name: yamlConfig.gemini?.model_name || DEFAULT_PRIMARY_MODEL,
             subsequent_chat_model_name: yamlConfig.gemini?.subsequent_chat_model_name || DEFAULT_SECONDARY_MODEL,
             max_output_tokens: yamlConfig.gemini?.max_output_tokens || 8192,
             max_prompt_tokens: yamlConfig.gemini?.max_prompt_tokens || 32000, // Default context limit for context building
-            rate_limit: {
-                requests_per_minute: yamlConfig.gemini?.rate_limit?.requests_per_minute || 60
-            },
+            rate_limit: rateLimitWithDefaults(yamlConfig.gemini?.rate_limit),
             max_retries: yamlConfig.gemini?.max_retries || 3,
             retry_delay: yamlConfig.gemini?.retry_delay || 60000,
             generation_max_retries: yamlConfig.gemini?.generation_max_retries ?? defaultGenerationMaxRetries,
@@ -180,48 +244,68 @@ class ConfigLoader /* implements IConfig */ { // Let TS infer implementation det
         // *** ADDED: Default and Loading for Analysis Config ***
         const finalAnalysisConfig: Required<AnalysisConfig> = {
             cache_file_path: yamlConfig.analysis?.cache_file_path || ".kai/project_analysis.json",
+            shared_summary_cache: yamlConfig.analysis?.shared_summary_cache ?? true,
             // phind_command removed
         };
 
         // *** ADDED: Default and Loading for Context Config ***
         const finalContextConfig: ContextConfig = {
-            // Default to undefined if not explicitly 'full', 'analysis_cache', or 'dynamic'
-            mode: ['full', 'analysis_cache', 'dynamic'].includes(yamlConfig.context?.mode ?? '')
-                  ? yamlConfig.context!.mode! as 'full' | 'analysis_cache' | 'dynamic' // Use validated value if present
-                  : undefined // Default to undefined signal
-
+            // Default to undefined if not explicitly 'full', 'analysis_cache', 'dynamic' or 'auto'
+            mode: ['full', 'analysis_cache', 'dynamic', 'auto'].includes(yamlConfig.context?.mode ?? '')
+                  ? yamlConfig.context!.mode! as 'full' | 'analysis_cache' | 'dynamic' | 'auto' // Use validated value if present
+                  : undefined, // Default to undefined signal
+            retrieval_tools: yamlConfig.context?.retrieval_tools ?? false,
+            max_tool_rounds: yamlConfig.context?.max_tool_rounds || 6,
+            delta_mode: yamlConfig.context?.delta_mode ?? false,
+            delta_reanchor_turns: yamlConfig.context?.delta_reanchor_turns || 20,
         };
         // *** END ADDED ***
 
+        // Memory budget: keep only valid positive values; MemoryGovernor supplies the defaults
+        const positive = (value: unknown): number | undefined =>
+            typeof value === 'number' && value > 0 ? value : undefined;
+        const shedRatio = positive(yamlConfig.memory?.shed_ratio);
+        const finalMemoryConfig: MemoryConfig = {
+            heap_budget_mb: positive(yamlConfig.memory?.heap_budget_mb),
+            shed_ratio: shedRatio !== undefined && shedRatio <= 1 ? shedRatio : undefined,
+        };
+
         // *** ADDED: Default and Loading for Anthropic Config ***
         // Load API key from environment if not in YAML
         const anthropicApiKey = process.env.ANTHROPIC_API_KEY;
         const DEFAULT_CLAUDE_MODEL = 'claude-opus-4-20250514';
+        const anthropicApiKeys = keyList([anthropicApiKey || yamlConfig.anthropic?.api_key, ...(yamlConfig.anthropic?.api_keys ?? [])], process.env.ANTHROPIC_API_KEYS);
         const finalAnthropicConfig: Required<AnthropicConfig> = {
-            api_key: anthropicApiKey || yamlConfig.anthropic?.api_key || '',
+            api_key: anthropicApiKeys[0] || '',
+            api_keys: anthropicApiKeys,
             model_name: yamlConfig.anthropic?.model_name || DEFAULT_CLAUDE_MODEL,
             max_output_tokens: yamlConfig.anthropic?.max_output_tokens || finalGeminiConfig.max_output_tokens,
+            rate_limit: rateLimitWithDefaults(yamlConfig.anthropic?.rate_limit),
         };
         // If no API key available, skip anthropic section
         const anthropicSection = finalAnthropicConfig.api_key ? finalAnthropicConfig : undefined;
 
         const openaiApiKey = process.env.OPENAI_API_KEY;
+        const openaiApiKeys = keyList([openaiApiKey || yamlConfig.openai?.api_key, ...(yamlConfig.openai?.api_keys ?? [])], process.env.OPENAI_API_KEYS);
         const finalOpenAIConfig: Required<OpenAIConfig> = {
-            api_key: openaiApiKey || yamlConfig.openai?.api_key || '',
+            api_key: openaiApiKeys[0] || '',
+            api_keys: openaiApiKeys,
             max_output_tokens: yamlConfig.openai?.max_output_tokens || finalGeminiConfig.max_output_tokens,
             max_prompt_tokens: yamlConfig.openai?.max_prompt_tokens || 128000,
+            rate_limit: rateLimitWithDefaults(yamlConfig.openai?.rate_limit),
         };
         const openaiSection = finalOpenAIConfig.api_key ? finalOpenAIConfig : undefined;
         // *** END ADDED ***
 
         // Calculate absolute chats directory path (DO NOT CREATE IT HERE)
-        const absoluteChatsDir = path.resolve(process.cwd(), finalProjectConfig.chats_dir);
+        const absoluteChatsDir = path.resolve(projectRoot, finalProjectConfig.chats_dir);
 
         return {
             gemini: finalGeminiConfig,
             project: finalProjectConfig,
             analysis: finalAnalysisConfig,
             context: finalContextConfig,
+            memory: finalMemoryConfig,
             anthropic: anthropicSection,
             openai: openaiSection,
             chatsDir: absoluteChatsDir,
@@ -231,7 +315,7 @@ class ConfigLoader /* implements IConfig */ { // Let TS infer implementation det
     /**
      * Saves the current configuration state back to config.yaml (in .kai/).
      * Note: This will overwrite the existing file and might lose comments.
-     * The context mode will be either 'full', 'analysis_cache', or 'dynamic' after determination/selection.
+     * The context mode will be either 'full', 'analysis_cache', 'dynamic' or 'auto' after determination/selection.
      */
     async saveConfig(): Promise<void> {
         console.log(chalk.dim(`Attempting to save configuration to ${this.configFilePath}...`));
@@ -249,10 +333,19 @@ class ConfigLoader /* implements IConfig */ { // Let TS infer implementation det
             },
             analysis: {
                 cache_file_path: this.analysis.cache_file_path,
+                shared_summary_cache: this.analysis.shared_summary_cache,
             },
             context: {
-                // Save the mode if it's defined (will be 'full', 'analysis_cache', or 'dynamic' after determination/selection)
+                // Save the mode if it's defined (will be 'full', 'analysis_cache', 'dynamic' or 'auto' after determination/selection)
                 mode: this.context.mode,
+                retrieval_tools: this.context.retrieval_tools,
+                max_tool_rounds: this.context.max_tool_rounds,
+                delta_mode: this.context.delta_mode,
+                delta_reanchor_turns: this.context.delta_reanchor_turns,
+            },
+            memory: {
+                heap_budget_mb: this.memory.heap_budget_mb,
+                shed_ratio: this.memory.shed_ratio,
             },
             gemini: { // Only save non-sensitive, configurable Gemini settings
                 model_name: this.gemini.model_name,
@@ -269,11 +362,13 @@ class ConfigLoader /* implements IConfig */ { // Let TS infer implementation det
                 // Do NOT persist API keys here; they are read from env
                 model_name: this.anthropic.model_name,
                 max_output_tokens: this.anthropic.max_output_tokens,
+                rate_limit: this.anthropic.rate_limit,
             } : undefined,
             openai: this.openai ? {
                 // Do NOT persist API keys here; they are read from env
                 max_output_tokens: this.openai.max_output_tokens,
                 max_prompt_tokens: this.openai.max_prompt_tokens,
+                rate_limit: this.openai.rate_limit,
             } : undefined,
         };
 
@@ -306,8 +401,8 @@ class ConfigLoader /* implements IConfig */ { // Let TS infer implementation det
             }, {} as Record<string, any>);
 
             const yamlString = yaml.dump(filteredConfig, { indent: 2, skipInvalid: true });
-            // Use synchronous write for simplicity during this critical update phase
-            fsSync.writeFileSync(this.configFilePath, yamlString, 'utf8');
+            // Locked temp-file-and-rename: a CLI or Desktop process loading config never sees a partial file
+            await FileLock.withLock(this.configFilePath, () => writeFileAtomic(this.configFilePath, yamlString));
             console.log(chalk.green(`Configuration successfully saved to ${this.configFilePath}.`));
         } catch (error) {
             console.error(chalk.red(`Error saving configuration to ${this.configFilePath}:`), error);
@@ -327,4 +422,4 @@ class ConfigLoader /* implements IConfig */ { // Let TS infer implementation det
 // Export the class implementation as 'Config'
 export { ConfigLoader as Config };
 // Export the interface type separately if needed for type hinting elsewhere
-export type { IConfig, GeminiConfig, ProjectConfig, AnalysisConfig, ContextConfig, OpenAIConfig };
\ No newline at end of file
+export type { IConfig, RateLimitConfig, GeminiConfig, ProjectConfig, AnalysisConfig, ContextConfig, MemoryConfig, OpenAIConfig };
\ No newline at end of file
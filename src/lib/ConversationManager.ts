@@ -6,11 +6,14 @@ import { Config } from './Config';
 import { FileSystem, DiffFailureInfo } from './FileSystem';
 import { AIClient, LogEntryData } from './AIClient';
 import { UserInterface } from './UserInterface';
-import Conversation, { Message, JsonlLogEntry } from './models/Conversation';
+import Conversation, { Message, JsonlLogEntry, summarizeHistory } from './models/Conversation';
 import { ProjectContextBuilder } from './ProjectContextBuilder';
 import { ConsolidationService } from './consolidation/ConsolidationService';
 import { CONSOLIDATION_SUCCESS_MARKER } from './consolidation/constants';
 import { toSnakeCase } from './utils';
+import { WorkspaceDetector } from './workspace/WorkspaceDetector';
+import { ContextDeltaTracker } from './context/ContextDeltaTracker';
+import { metrics } from './telemetry/Metrics';
 
 // Interface for paths managed within the conversation session
 interface ConversationPaths {
@@ -25,8 +28,11 @@ export class ConversationManager {
     private ui: UserInterface;
     private contextBuilder: ProjectContextBuilder;
     private consolidationService: ConsolidationService; // Keep for /consolidate command
+    private contextDeltas = new WeakMap<Conversation, ContextDeltaTracker>(); // context.delta_mode state per conversation
 
     private readonly CONSOLIDATE_COMMAND = '/consolidate';
+    private readonly SCOPE_COMMAND = '/scope';
+    private readonly SCOPE_MARKER = '[Workspace Scope]';
 
     constructor(
         config: Config,
@@ -64,6 +70,7 @@ export class ConversationManager {
         try {
             conversation = await this._loadOrCreateConversation(conversationName, isNew, paths.conversationFilePath);
             editorFilePathForCleanup = paths.editorFilePath; // Assign path for potential cleanup
+            await this._restoreScope(conversation);
 
             // Start the main interaction loop
             await this._handleUserInputLoop(conversationName, conversation, paths);
@@ -153,12 +160,71 @@ export class ConversationManager {
         if (userPrompt.trim().toLowerCase() === this.CONSOLIDATE_COMMAND) {
             await this._handleConsolidateCommand(conversation, conversationFilePath);
             // No 'continue' needed here as it's the last step in this iteration path
+        } else if (userPrompt.trim().split(/\s+/)[0].toLowerCase() === this.SCOPE_COMMAND) {
+            await this._handleScopeCommand(conversation, userPrompt.trim().split(/\s+/).slice(1), conversationFilePath);
         } else {
             // Handle normal AI interaction
             await this._callAIWithContext(conversation, userPrompt, conversationFilePath);
         }
     }
 
+    /**
+     * Handles '/scope <package...>': limits this conversation's context to the named workspace
+     * packages plus the workspace packages they depend on. '/scope' alone clears the scope.
+     * The scope is logged to the conversation so it is restored when the conversation is resumed.
+     */
+    private async _handleScopeCommand(
+        conversation: Conversation,
+        packageNames: string[],
+        conversationFilePath: string
+    ): Promise<void> {
+        let content: string;
+        if (packageNames.length === 0) {
+            this.contextBuilder.setScope(null);
+            content = `${this.SCOPE_MARKER} (whole project)`;
+            console.log(chalk.blue('Workspace scope cleared; context covers the whole project.'));
+        } else {
+            const info = await WorkspaceDetector.detect(process.cwd());
+            if (!info) {
+                console.log(chalk.yellow('No npm/yarn/pnpm workspaces found in this project; /scope has no effect.'));
+                return;
+            }
+            try {
+                const scope = WorkspaceDetector.resolveScope(info, packageNames);
+                this.contextBuilder.setScope(scope);
+                content = `${this.SCOPE_MARKER} ${scope.map(p => p.name).join(', ')}`;
+                console.log(chalk.blue(`Context scoped to ${scope.length} workspace package(s): ${scope.map(p => `${p.name} (${p.dir})`).join(', ')}`));
+            } catch (error) {
+                console.log(chalk.yellow((error as Error).message));
+                return;
+            }
+        }
+        conversation.addMessage('system', content);
+        try {
+            await this.aiClient.logConversation(conversationFilePath, { type: 'system', role: 'system', content });
+        } catch (err) {
+            console.error(chalk.red('Failed to log workspace scope:'), err);
+        }
+    }
+
+    /** Re-applies the last '/scope' of a resumed conversation (and clears any scope left by another one). */
+    private async _restoreScope(conversation: Conversation): Promise<void> {
+        const last = [...conversation.getMessages()].reverse()
+            .find(m => m.role === 'system' && m.content.startsWith(this.SCOPE_MARKER));
+        const names = last ? last.content.slice(this.SCOPE_MARKER.length).split(',').map(n => n.trim()).filter(n => n && n !== '(whole project)') : [];
+        this.contextBuilder.setScope(null);
+        if (names.length === 0) return;
+        const info = await WorkspaceDetector.detect(process.cwd());
+        try {
+            if (info) {
+                this.contextBuilder.setScope(WorkspaceDetector.resolveScope(info, names));
+                console.log(chalk.blue(`Restored workspace scope: ${names.join(', ')}`));
+            }
+        } catch (error) {
+            console.warn(chalk.yellow(`Could not restore workspace scope: ${(error as Error).message}`));
+        }
+    }
+
     /** Handles the '/consolidate' command within the chat loop. */
     private async _handleConsolidateCommand(
         conversation: Conversation,
@@ -179,12 +245,17 @@ export class ConversationManager {
             let currentContextString: string;
             if (this.config.context.mode === 'dynamic') {
                 const relevantHistory = this._findRelevantHistorySlice(conversation);
-                const historySummary = this._summarizeHistory(relevantHistory);
+                const historySummary = summarizeHistory(relevantHistory);
                 const ctx = await this.contextBuilder.buildDynamicContext(
                     'Consolidate recent conversation changes',
-                    historySummary
+                    historySummary,
+                    null // Not a user turn: keep it out of relevance feedback
                 );
                 currentContextString = ctx.context;
+            } else if (this.config.context.mode === 'auto') {
+                const historySummary = summarizeHistory(this._findRelevantHistorySlice(conversation));
+                const { context } = await this.contextBuilder.buildContext('Consolidate recent conversation changes', historySummary, null);
+                currentContextString = context;
             } else {
                 const { context } = await this.contextBuilder.buildContext();
                 currentContextString = context;
@@ -233,12 +304,28 @@ export class ConversationManager {
 
         try {
             // --- Select Context Building Strategy ---
+            // Tool calling is only implemented for Gemini; other providers get the configured mode
+            const retrievalModel = this.config.context.retrieval_tools && AIClient.providerFor(this.config.gemini.model_name) === 'gemini';
+            if (this.config.context.retrieval_tools && !retrievalModel) {
+                console.warn(chalk.yellow(`context.retrieval_tools needs a Gemini model; '${this.config.gemini.model_name}' gets '${currentMode}' context instead.`));
+            }
+            if (retrievalModel) {
+                // The model retrieves code itself; only the file overview is sent up front
+                console.log(chalk.blue('\nBuilding file overview for on-demand retrieval...'));
+                contextResult = await this.contextBuilder.buildRetrievalContext();
+                const tools = await this.contextBuilder.createRetrievalTools();
+                await this.aiClient.getResponseWithTools(conversation, conversationFilePath, contextResult.context, tools, this.config.context.max_tool_rounds);
+                return;
+            }
             console.log(chalk.blue(`\nBuilding context using mode: ${currentMode}...`));
             if (currentMode === 'dynamic') {
                  const history = conversation.getMessages(); // Get current history
                  // --- FIX: Summarize history before passing ---
-                 const historySummary = this._summarizeHistory(history);
-                 contextResult = await this.contextBuilder.buildDynamicContext(userPrompt, historySummary);
+                 const historySummary = summarizeHistory(history);
+                 contextResult = await this.contextBuilder.buildDynamicContext(userPrompt, historySummary, conversationFilePath);
+            } else if (currentMode === 'auto') {
+                 // The builder picks full, summaries or dynamic selection for this prompt
+                 contextResult = await this.contextBuilder.buildContext(userPrompt, summarizeHistory(conversation.getMessages()), conversationFilePath);
             } else {
                  // Use standard context building for 'full' or 'analysis_cache' modes
                  // buildContext() internally checks mode again and fetches appropriate context
@@ -252,13 +339,25 @@ export class ConversationManager {
                 this.config.anthropic?.model_name !== undefined
                 && this.config.gemini.model_name === this.config.anthropic.model_name;
 
+            let contextToSend = contextResult.context;
+            let earlierContext: Map<Message, string> | undefined;
+            // Replaying the anchor costs more than the full context unless the provider caches it
+            const deltaModel = this.config.context.delta_mode && AIClient.cachesPromptPrefix(this.config.gemini.model_name);
+            if (this.config.context.delta_mode && !deltaModel) {
+                console.warn(chalk.yellow(`context.delta_mode needs a model with prompt caching; '${this.config.gemini.model_name}' gets the full context each turn.`));
+            }
+            if (deltaModel) {
+                ({ contextToSend, earlierContext } = this._applyContextDelta(conversation, contextResult.context, currentMode));
+            }
+
             // Use the injected aiClient instance, passing Anthropic flag when selected
             await this.aiClient.getResponseFromAI(
                 conversation,
                 conversationFilePath,
-                contextResult.context,
+                contextToSend,
                 useFlashModel,
-                useAnthropicModel
+                useAnthropicModel,
+                earlierContext
             );
             // AIClient internally adds the assistant response to the conversation object
 
@@ -284,6 +383,34 @@ export class ConversationManager {
         }
     }
 
+    /**
+     * Delta mode: replaces this turn's context with what changed since the anchor (or the
+     * full context when re-anchoring) and returns the anchor to replay with its turn.
+     */
+    private _applyContextDelta(
+        conversation: Conversation,
+        context: string,
+        mode: string | undefined
+    ): { contextToSend: string; earlierContext: Map<Message, string> } {
+        let tracker = this.contextDeltas.get(conversation);
+        if (!tracker) {
+            tracker = new ContextDeltaTracker({ reanchorTurns: this.config.context.delta_reanchor_turns });
+            this.contextDeltas.set(conversation, tracker);
+        }
+        const history = conversation.getMessages();
+        // Full and summary contexts list every file; a dynamic selection leaving a file out says nothing about it
+        const exhaustive = mode === 'full' || mode === 'analysis_cache';
+        const plan = tracker.plan(history[history.length - 1], history, context, exhaustive);
+        if (plan.kind === 'anchor') {
+            console.log(chalk.dim(`Sending full context (${plan.tokenCount} tokens): ${plan.reason}.`));
+        } else {
+            // No "saved" figure: the replayed anchor is cheaper only because the provider caches it
+            console.log(chalk.dim(`Sending context delta (${plan.tokenCount} tokens, ${plan.changed} changed, ${plan.added} added, ${plan.removed} removed; ${plan.requestTokens} context tokens in the request with the cached anchor vs ${plan.fullTokens} full).`));
+        }
+        metrics.increment('context.delta_turns', { kind: plan.kind });
+        return { contextToSend: plan.context, earlierContext: tracker.earlierContext(history) };
+    }
+
     /** Handles errors occurring during the main conversation loop. */
     private async _handleConversationError(
         error: unknown,
@@ -360,19 +487,4 @@ export class ConversationManager {
         }
         return allMessages.slice(lastSuccessIndex + 1);
     }
-
-    /** Creates a simple summary of conversation history for dynamic context */
-    private _summarizeHistory(history: Message[]): string | null {
-         // Placeholder: Implement actual history summarization based on your Message structure
-         if (!history || history.length === 0) return null;
-         const recentMessages = history.slice(-4); // Take last 4 messages? Needs tuning.
-         let summary = "Recent conversation highlights:\n";
-         recentMessages.forEach((msg: Message) => {
-              const contentPreview = typeof msg.content === 'string'
-                   ? `${msg.content.substring(0, 100)}${msg.content.length > 100 ? '...' : ''}`
-                   : '[Non-text content]';
-              summary += `  ${msg.role}: ${contentPreview}\n`;
-         });
-         return summary;
-    }
 }
@@ -0,0 +1,72 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { FileLock, FileLockTimeoutError, writeFileAtomic, appendLinesLocked } from './FileLock';
+
+describe('FileLock', () => {
+  let tmpDir: string;
+  let target: string;
+
+  beforeEach(() => {
+    tmpDir = fs.mkdtempSync(path.join(os.tmpdir(), 'filelock-'));
+    target = path.join(tmpDir, 'state.json');
+  });
+
+  afterEach(() => {
+    fs.rmSync(tmpDir, { recursive: true, force: true });
+  });
+
+  const writeForeignLock = (pid: number, ageMs: number = 0) => {
+    const lockPath = FileLock.lockPathFor(target);
+    fs.writeFileSync(lockPath, JSON.stringify({ pid, host: os.hostname(), token: 'foreign', acquiredAt: new Date().toISOString() }));
+    const time = new Date(Date.now() - ageMs);
+    fs.utimesSync(lockPath, time, time);
+    return lockPath;
+  };
+
+  it('serializes holders, re-enters nested locks and removes the lock file afterwards', async () => {
+    const events: string[] = [];
+    const holder = (name: string) => FileLock.withLock(target, async () => {
+      events.push(`${name}:start`);
+      await new Promise(resolve => setTimeout(resolve, 10));
+      await FileLock.withLock(target, async () => { events.push(`${name}:nested`); });
+      events.push(`${name}:end`);
+    });
+    await Promise.all([holder('a'), holder('b')]);
+    expect(events).toEqual(['a:start', 'a:nested', 'a:end', 'b:start', 'b:nested', 'b:end']);
+    expect(fs.existsSync(FileLock.lockPathFor(target))).toBe(false);
+  });
+
+  it('waits for a live holder and takes over locks of dead or silent holders', async () => {
+    const lockPath = writeForeignLock(process.ppid);
+    const onWait = jest.fn();
+    await expect(FileLock.withLock(target, async () => 'never', { timeoutMs: 60, retryMs: 5, onWait }))
+      .rejects.toBeInstanceOf(FileLockTimeoutError);
+    expect(onWait).toHaveBeenCalledWith(`pid ${process.ppid} on ${os.hostname()}`);
+    expect(fs.existsSync(lockPath)).toBe(true); // Someone else's lock is left alone
+
+    writeForeignLock(999999999);
+    await expect(FileLock.withLock(target, async () => 'dead owner', { timeoutMs: 60 })).resolves.toBe('dead owner');
+
+    writeForeignLock(process.ppid, 60000);
+    await expect(FileLock.withLock(target, async () => 'not refreshed', { timeoutMs: 60, staleMs: 30000 })).resolves.toBe('not refreshed');
+  });
+
+  it('replaces files atomically and appends whole lines', async () => {
+    await writeFileAtomic(target, 'first');
+    await writeFileAtomic(target, 'second');
+    expect(fs.readFileSync(target, 'utf8')).toBe('second');
+    expect(fs.readdirSync(tmpDir)).toEqual(['state.json']); // No temp files left behind
+
+    const log = path.join(tmpDir, 'nested', 'log.jsonl');
+    const big = 'x'.repeat(100000);
+    await Promise.all(Array.from({ length: 5 }, (_, i) => appendLinesLocked(log, [JSON.stringify({ i, big }), JSON.stringify({ i, tail: true })])));
+    const lines = fs.readFileSync(log, 'utf8').split('\n');
+    expect(lines.pop()).toBe('');
+    expect(lines).toHaveLength(10);
+    for (let n = 0; n < lines.length; n += 2) {
+      const head = JSON.parse(lines[n]);
+      expect(JSON.parse(lines[n + 1])).toEqual({ i: head.i, tail: true }); // Each call's lines stay together
+    }
+  });
+});
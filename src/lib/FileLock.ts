@@ -0,0 +1,206 @@
+// File: src/lib/FileLock.ts
+import fsPromises from 'fs/promises';
+import { AsyncLocalStorage } from 'async_hooks';
+import os from 'os';
+import path from 'path';
+import crypto from 'crypto';
+import { metrics } from './telemetry/Metrics';
+
+export interface FileLockOptions {
+    timeoutMs?: number; // How long to wait for another holder before giving up
+    staleMs?: number;   // A lock not refreshed for this long is considered abandoned
+    retryMs?: number;   // Initial poll interval; doubles up to 8x
+    onWait?: (holder: string) => void; // Called once if the lock is held elsewhere
+}
+
+const DEFAULT_TIMEOUT_MS = 10000;
+const DEFAULT_STALE_MS = 30000;
+const DEFAULT_RETRY_MS = 25;
+const LOCK_SUFFIX = '.lock';
+
+export class FileLockTimeoutError extends Error {
+    constructor(filePath: string, holder: string) {
+        super(`Timed out waiting for the lock on ${filePath} (held by ${holder}). If no other Kai process is running, delete ${filePath}${LOCK_SUFFIX}.`);
+        this.name = 'FileLockTimeoutError';
+    }
+}
+
+interface LockInfo {
+    pid: number;
+    host: string;
+    token: string;
+    acquiredAt: string;
+}
+
+interface LockHolder {
+    info: LockInfo | null;
+    mtimeMs: number;
+}
+
+/**
+ * Advisory cross-process locks for `.kai` state files, so the CLI, Kai Desktop and other CLI
+ * sessions on one project never interleave writes. The lock is a sibling `<file>.lock` created
+ * with O_EXCL; the holder refreshes its mtime while working, and a lock whose owner process is
+ * gone (same host) or that has not been refreshed for `staleMs` is taken over. Within one
+ * process callers queue in memory, and nested `withLock` calls for a file already held by the
+ * calling async context re-enter instead of deadlocking.
+ */
+export class FileLock {
+    private static held = new AsyncLocalStorage<Set<string>>();
+    private static queues = new Map<string, Promise<void>>();
+
+    static async withLock<T>(filePath: string, fn: () => Promise<T>, options: FileLockOptions = {}): Promise<T> {
+        const target = path.resolve(filePath);
+        const held = FileLock.held.getStore();
+        if (held?.has(target)) return fn();
+
+        // In-process queue first, so only one caller per file polls the lock file
+        const previous = FileLock.queues.get(target) ?? Promise.resolve();
+        let release!: () => void;
+        const current = new Promise<void>(resolve => { release = resolve; });
+        const tail = previous.then(() => current);
+        FileLock.queues.set(target, tail);
+        await previous;
+        try {
+            const lock = await FileLock._acquire(target, options);
+            try {
+                return await FileLock.held.run(new Set([...(held ?? []), target]), fn);
+            } finally {
+                await lock.release();
+            }
+        } finally {
+            release();
+            if (FileLock.queues.get(target) === tail) FileLock.queues.delete(target);
+        }
+    }
+
+    /** Lock file path for a state file. */
+    static lockPathFor(filePath: string): string {
+        return `${path.resolve(filePath)}${LOCK_SUFFIX}`;
+    }
+
+    // --- Lock file handling ---
+
+    private static async _acquire(target: string, options: FileLockOptions): Promise<{ release: () => Promise<void> }> {
+        const timeoutMs = options.timeoutMs ?? DEFAULT_TIMEOUT_MS;
+        const staleMs = options.staleMs ?? DEFAULT_STALE_MS;
+        const lockPath = FileLock.lockPathFor(target);
+        const info: LockInfo = { pid: process.pid, host: os.hostname(), token: crypto.randomBytes(8).toString('hex'), acquiredAt: new Date().toISOString() };
+        const started = Date.now();
+        let delay = options.retryMs ?? DEFAULT_RETRY_MS;
+        let contended = false;
+        let notified = false;
+
+        await fsPromises.mkdir(path.dirname(lockPath), { recursive: true });
+        for (;;) {
+            try {
+                await fsPromises.writeFile(lockPath, JSON.stringify(info), { flag: 'wx' });
+                break;
+            } catch (error) {
+                if ((error as NodeJS.ErrnoException).code !== 'EEXIST') throw error;
+            }
+            const holder = await FileLock._readHolder(lockPath);
+            contended = true;
+            if (holder && FileLock._isStale(holder, staleMs)) {
+                // Re-check the token right before removing so a fresh lock is never deleted
+                const again = await FileLock._readHolder(lockPath);
+                if (again && again.info?.token === holder.info?.token && again.mtimeMs === holder.mtimeMs) {
+                    await fsPromises.rm(lockPath, { force: true });
+                }
+                metrics.increment('lock.stale_taken_over');
+                continue;
+            }
+            const holderName = holder?.info ? `pid ${holder.info.pid} on ${holder.info.host}` : 'another process';
+            if (!notified) options.onWait?.(holderName);
+            notified = true;
+            if (Date.now() - started >= timeoutMs) {
+                metrics.increment('lock.timeouts');
+                throw new FileLockTimeoutError(target, holderName);
+            }
+            await new Promise(resolve => setTimeout(resolve, delay + Math.random() * delay));
+            delay = Math.min(delay * 2, (options.retryMs ?? DEFAULT_RETRY_MS) * 8);
+        }
+        if (contended) metrics.observe('lock.wait_ms', Date.now() - started);
+
+        // Heartbeat: keeps a long-held lock from looking abandoned
+        const heartbeat = setInterval(() => {
+            const now = new Date();
+            fsPromises.utimes(lockPath, now, now).catch(() => {});
+        }, Math.max(1000, Math.floor(staleMs / 3)));
+        heartbeat.unref?.();
+
+        return {
+            release: async () => {
+                clearInterval(heartbeat);
+                const holder = await FileLock._readHolder(lockPath);
+                if (holder?.info?.token === info.token) await fsPromises.rm(lockPath, { force: true });
+            },
+        };
+    }
+
+    /** Null when the lock is gone; `info` is null while a new holder is still writing its details. */
+    private static async _readHolder(lockPath: string): Promise<LockHolder | null> {
+        try {
+            const [content, stats] = await Promise.all([fsPromises.readFile(lockPath, 'utf-8'), fsPromises.stat(lockPath)]);
+            let info: LockInfo | null = null;
+            try {
+                info = JSON.parse(content) as LockInfo;
+            } catch {
+                // Partially written
+            }
+            return { info, mtimeMs: stats.mtimeMs };
+        } catch {
+            return null;
+        }
+    }
+
+    private static _isStale(holder: LockHolder, staleMs: number): boolean {
+        const { info } = holder;
+        if (info && info.host === os.hostname() && info.pid !== process.pid && !FileLock._isAlive(info.pid)) return true;
+        return Date.now() - holder.mtimeMs > staleMs;
+    }
+
+    private static _isAlive(pid: number): boolean {
+        try {
+            process.kill(pid, 0);
+            return true;
+        } catch (error) {
+            return (error as NodeJS.ErrnoException).code === 'EPERM'; // Exists but owned by another user
+        }
+    }
+}
+
+/**
+ * Replaces a file's content atomically: readers see either the old or the new file, never a
+ * partial write, even if this process dies mid-write. Writes a temp file next to the target,
+ * flushes it and renames it over the target.
+ */
+export async function writeFileAtomic(filePath: string, content: string): Promise<void> {
+    const tmpPath = `${filePath}.${process.pid}.${crypto.randomBytes(4).toString('hex')}.tmp`;
+    await fsPromises.mkdir(path.dirname(filePath), { recursive: true });
+    try {
+        const handle = await fsPromises.open(tmpPath, 'w');
+        try {
+            await handle.writeFile(content, 'utf-8');
+            await handle.sync();
+        } finally {
+            await handle.close();
+        }
+        await fsPromises.rename(tmpPath, filePath);
+    } catch (error) {
+        await fsPromises.rm(tmpPath, { force: true }).catch(() => {});
+        throw error;
+    }
+}
+
+/**
+ * Appends complete lines under the file's lock with a single O_APPEND write, so concurrent
+ * writers never interleave records and readers only ever see a partial line at the very end
+ * (which JSONL readers skip until it is complete).
+ */
+export async function appendLinesLocked(filePath: string, lines: string[], options?: FileLockOptions): Promise<void> {
+    if (lines.length === 0) return;
+    const text = lines.map(line => line.replace(/\n+$/, '')).join('\n') + '\n';
+    await fsPromises.mkdir(path.dirname(filePath), { recursive: true });
+    await FileLock.withLock(filePath, () => fsPromises.appendFile(filePath, text, 'utf-8'), options);
+}
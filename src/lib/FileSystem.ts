@@ -1,7 +1,7 @@
 // File: src/lib/FileSystem.ts
 import fs from 'fs';
 import fsPromises from 'fs/promises'; // Use promises API
-import { Stats } from 'fs'; // Import Stats type from base 'fs'
+import { Stats, Dirent } from 'fs'; // Import Stats and Dirent types from base 'fs'
 import os from 'os';
 import path from 'path';
 import ignore, { Ignore } from 'ignore'; // Import ignore type as well
@@ -13,6 +13,9 @@ import type { ParsedDiff, Hunk } from 'diff';
 // Import M2 structure
 import { ProjectAnalysisCache, AnalysisCacheEntry } from './analysis/types'; // Adjust path if needed
 import { JsonlFile } from './JsonlFile';
+import { FileLock, FileLockOptions, writeFileAtomic } from './FileLock';
+import { tracer } from './telemetry/Tracer';
+import { metrics } from './telemetry/Metrics';
 
 // Define items typically ignored when checking for "emptiness"
 const SAFE_TO_IGNORE_FOR_EMPTY_CHECK = new Set([
@@ -28,6 +31,12 @@ const SAFE_TO_IGNORE_FOR_EMPTY_CHECK = new Set([
 ]);
 
 class FileSystem {
+    /** Project whose `.kai/logs` receives diff failure logs. */
+    readonly projectRoot: string;
+
+    constructor(projectRoot: string = process.cwd()) {
+        this.projectRoot = projectRoot;
+    }
 
     // Synchronous wrappers for backward compatibility
     static existsSync(p: string): boolean {
@@ -69,9 +78,24 @@ class FileSystem {
     }
 
     async writeFile(filePath: string, content: string): Promise<void> {
-        const dir = path.dirname(filePath);
-        await this.ensureDirExists(dir);
-        await fsPromises.writeFile(filePath, content, 'utf-8');
+        await tracer.span('fs.writeFile', 'fs', async () => {
+            const dir = path.dirname(filePath);
+            await this.ensureDirExists(dir);
+            await fsPromises.writeFile(filePath, content, 'utf-8');
+        }, { file: filePath, bytes: content.length });
+    }
+
+    /**
+     * Writes via temp file and rename so other Kai processes never read a half-written file.
+     * Use for `.kai` state; project files keep the in-place `writeFile`.
+     */
+    async writeFileAtomic(filePath: string, content: string): Promise<void> {
+        await tracer.span('fs.writeFileAtomic', 'fs', () => writeFileAtomic(filePath, content), { file: filePath, bytes: content.length });
+    }
+
+    /** Runs `fn` holding the advisory cross-process lock for `filePath` (see FileLock). */
+    async withLock<T>(filePath: string, fn: () => Promise<T>, options?: FileLockOptions): Promise<T> {
+        return FileLock.withLock(filePath, fn, options);
     }
 
     async readFile(filePath: string): Promise<string | null> {
@@ -106,6 +130,11 @@ class FileSystem {
              throw error; // Rethrow other errors
         }
     }
+
+    /** Entries of a directory with their types (files, directories, links). */
+    async readDir(dirPath: string): Promise<Dirent[]> {
+        return fsPromises.readdir(dirPath, { withFileTypes: true });
+    }
     // --- End common FS methods ---
 
     /**
@@ -193,7 +222,17 @@ class FileSystem {
              // If no ignore object is passed, we cannot respect .gitignore rules.
              throw new Error("getProjectFiles requires an Ignore object from GitService.getIgnoreRules() to be passed by the caller.");
         }
+        const rules = ig;
+        const root = projectRoot;
+        return tracer.span('fs.getProjectFiles', 'fs', async () => {
+            const files = await metrics.time('fs.scan_ms', undefined, () => this._collectProjectFiles(dirPath, root, rules));
+            metrics.increment('fs.files_scanned', undefined, files.length);
+            return files;
+        }, { dir: dirPath });
+    }
 
+    /** Recursive worker for getProjectFiles (kept separate so tracing records one span per scan). */
+    private async _collectProjectFiles(dirPath: string, projectRoot: string, ig: Ignore): Promise<string[]> {
         let files: string[] = [];
         const entries = await fsPromises.readdir(dirPath, { withFileTypes: true });
 
@@ -209,7 +248,7 @@ class FileSystem {
 
             if (entry.isDirectory()) {
                 // Recursively call with the same projectRoot and ig object
-                files = files.concat(await this.getProjectFiles(fullPath, projectRoot, ig));
+                files = files.concat(await this._collectProjectFiles(fullPath, projectRoot, ig));
             } else if (await this.isTextFile(fullPath)) {
                 files.push(fullPath);
             }
@@ -223,6 +262,14 @@ class FileSystem {
     ): Promise<{ [filePath: string]: string }> {
         const contents: { [filePath: string]: string } = {};
         if (!Array.isArray(filePaths) || filePaths.length === 0) return contents;
+        return tracer.span('fs.readFileContents', 'fs', () => this._readFileContents(filePaths, concurrency, contents), { files: filePaths.length, concurrency });
+    }
+
+    private async _readFileContents(
+        filePaths: string[],
+        concurrency: number,
+        contents: { [filePath: string]: string }
+    ): Promise<{ [filePath: string]: string }> {
 
         const limit = Math.max(1, Math.floor(concurrency));
         let index = 0;
@@ -266,6 +313,26 @@ class FileSystem {
         return contents;
     }
 
+    /**
+     * Sums the on-disk sizes of `filePaths` from stat alone (no contents are read), with bounded
+     * concurrency. Missing files count as 0. Lets callers check a memory budget before reading.
+     * @returns The total size in bytes.
+     */
+    async totalFileSize(filePaths: string[], concurrency: number = 12): Promise<number> {
+        let total = 0;
+        let index = 0;
+        const worker = async () => {
+            while (true) {
+                const i = index++;
+                if (i >= filePaths.length) break;
+                total += (await this.stat(filePaths[i]))?.size ?? 0;
+            }
+        };
+        const limit = Math.max(1, Math.floor(concurrency));
+        await Promise.all(Array.from({ length: Math.min(limit, filePaths.length) }, () => worker()));
+        return total;
+    }
+
      async isTextFile(filePath: string): Promise<boolean> {
         const textExtensions = ['.ts', '.js', '.json', '.yaml', '.yml', '.txt', '.md', '.html', '.css', '.py', '.java', '.c', '.cpp', '.h', '.hpp', '.sh', '.rb', '.php', '.go', '.rs', '.swift', '.kt', '.kts', '.gitignore', '.npmignore', 'LICENSE', '.env', '.xml', '.svg', '.jsx', '.tsx'];
         const ext = path.extname(filePath).toLowerCase();
@@ -373,7 +440,7 @@ class FileSystem {
         try {
              console.log(chalk.dim(`Writing analysis cache to: ${cachePath} (${cacheData.entries.length} entries)`));
              const content = JSON.stringify(cacheData, null, 2); // Pretty-print JSON
-             await this.writeFile(cachePath, content);
+             await this.withLock(cachePath, () => this.writeFileAtomic(cachePath, content));
              console.log(chalk.dim(`Successfully wrote analysis cache.`));
         } catch (error) {
              console.error(chalk.red(`Error writing analysis cache file ${cachePath}:`), error);
@@ -392,13 +459,12 @@ class FileSystem {
     lastDiffFailure: DiffFailureInfo | null = null;
 
     async applyDiffToFile(filePath: string, diffContent: string): Promise<boolean> {
+        return tracer.span('fs.applyDiffToFile', 'fs', () => this._applyDiffToFile(filePath, diffContent), { file: filePath });
+    }
 
-        let cleanedDiff = diffContent;
-        const start = cleanedDiff.match(/^```(?:diff)?\s*\n/);
-        const end = cleanedDiff.match(/\n```$/);
-        if (start && end) {
-            cleanedDiff = cleanedDiff.slice(start[0].length, cleanedDiff.length - end[0].length).trim();
-        }
+    private async _applyDiffToFile(filePath: string, diffContent: string): Promise<boolean> {
+
+        const cleanedDiff = stripDiffFences(diffContent);
 
         if (cleanedDiff.trim().length === 0) {
             this.lastDiffFailure = {
@@ -483,6 +549,16 @@ class FileSystem {
 
 export { FileSystem };
 
+/** Removes a Markdown code fence (```diff ... ```) wrapped around a whole diff. */
+export function stripDiffFences(diffContent: string): string {
+    const start = diffContent.match(/^```(?:diff)?\s*\n/);
+    const end = diffContent.match(/\n```$/);
+    if (start && end) {
+        return diffContent.slice(start[0].length, diffContent.length - end[0].length).trim();
+    }
+    return diffContent;
+}
+
 /**
  * Attempts a fuzzier patch application when `applyPatch` fails. It looks for
  * each hunk's context lines within ±3 lines of the original start position,
@@ -493,7 +569,7 @@ export { FileSystem };
  * @param patch    Parsed patch object from `parsePatch`.
  * @returns The patched contents or `null` if no suitable match was found.
  */
-function fuzzyApplyPatch(original: string, patch: ParsedDiff): string | null {
+export function fuzzyApplyPatch(original: string, patch: ParsedDiff): string | null {
     const lines = original.split(/\n/);
     for (const hunk of patch.hunks) {
         const expected = hunk.lines
@@ -544,7 +620,7 @@ export async function logDiffFailure(
     fileContent?: string,
     error?: string
 ): Promise<void> {
-    const logsDir = path.resolve('.kai/logs');
+    const logsDir = path.resolve(fs.projectRoot, '.kai/logs');
     const logFile = path.join(logsDir, 'diff_failures.jsonl');
     const entry: DiffFailureInfo & { timestamp: string } = {
         file: filePath,
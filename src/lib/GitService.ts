@@ -223,9 +223,11 @@ export class GitService {
      * Does NOT create or modify the files. Always includes default in-memory ignores.
      * Uses the injected FileSystem service to read the files.
      * @param projectRoot The root directory of the project.
+     * @param options.includeKaiignore Set to false to apply only .gitignore (used when regenerating .kaiignore).
      * @returns An `ignore` instance populated with rules from both files and defaults.
      */
-    async getIgnoreRules(projectRoot: string): Promise<Ignore> { // Renamed
+    async getIgnoreRules(projectRoot: string, options: { includeKaiignore?: boolean } = {}): Promise<Ignore> { // Renamed
+        const includeKaiignore = options.includeKaiignore ?? true;
         const ig = ignore();
         const gitignorePath = path.resolve(projectRoot, '.gitignore'); // Use resolve for consistency
         const kaiignorePath = path.resolve(projectRoot, '.kaiignore'); // Path to .kaiignore at root
@@ -251,18 +253,20 @@ export class GitService {
         }
 
         // --- Step 2b: Read .kaiignore IF it exists using injected fs ---
-        try {
-             // Use injected fs instance
-            const kaiignoreContent = await this.fs.readFile(kaiignorePath); // Returns null if ENOENT
-            if (kaiignoreContent !== null) {
-                console.log(chalk.dim(`  Applying rules from existing .kaiignore for context building.`));
-                ig.add(kaiignoreContent); // Add rules from .kaiignore
-            } else {
-                 console.log(chalk.dim(`  No .kaiignore file found, skipping additional rules.`));
+        if (includeKaiignore) {
+            try {
+                 // Use injected fs instance
+                const kaiignoreContent = await this.fs.readFile(kaiignorePath); // Returns null if ENOENT
+                if (kaiignoreContent !== null) {
+                    console.log(chalk.dim(`  Applying rules from existing .kaiignore for context building.`));
+                    ig.add(kaiignoreContent); // Add rules from .kaiignore
+                } else {
+                     console.log(chalk.dim(`  No .kaiignore file found, skipping additional rules.`));
+                }
+            } catch (readError) {
+                // Catch errors from readFile *other* than ENOENT
+                 console.error(chalk.red(`  Warning: Error reading .kaiignore file at ${kaiignorePath} for context building:`), readError);
             }
-        } catch (readError) {
-            // Catch errors from readFile *other* than ENOENT
-             console.error(chalk.red(`  Warning: Error reading .kaiignore file at ${kaiignorePath} for context building:`), readError);
         }
         // --- Step 3: Return the in-memory ignore object ---
         return ig;
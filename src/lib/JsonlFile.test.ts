@@ -44,6 +44,15 @@ describe('JsonlFile', () => {
     expect(entries).toEqual([{ a: 1 }, { b: 2 }]);
   });
 
+  it('skips a partial last record that another process is still appending', async () => {
+    const file = path.join(tmpDir, 'live.jsonl');
+    fs.writeFileSync(file, '{"a":1}\n{"b":2}\n{"c":');
+    const jsonl = new JsonlFile(fsUtil, file);
+    await expect(jsonl.read()).resolves.toEqual([{ a: 1 }, { b: 2 }]);
+    fs.writeFileSync(file, '{"a":1}\n{"b":2}'); // A complete record without its newline still counts
+    await expect(jsonl.read()).resolves.toEqual([{ a: 1 }, { b: 2 }]);
+  });
+
   it('read returns empty array when file does not exist', async () => {
     const file = path.join(tmpDir, 'nonexistent.jsonl');
     const jsonl = new JsonlFile(fsUtil, file);
@@ -2,6 +2,7 @@ import path from 'path';
 import fsPromises from 'fs/promises';
 import chalk from 'chalk';
 import { FileSystem } from './FileSystem';
+import { appendLinesLocked } from './FileLock';
 
 /**
  * Helper for JSONL files: listing, reading, and appending newline-delimited JSON entries.
@@ -25,6 +26,7 @@ export class JsonlFile {
 
   /**
    * Reads and parses all JSON objects from a .jsonl file. Returns an empty array if missing.
+   * An unterminated last line is a record another process is still appending and is skipped.
    */
   async read(): Promise<any[]> {
     try {
@@ -37,7 +39,17 @@ export class JsonlFile {
     try {
       const content = await this.fs.readFile(this.filePath);
       if (!content?.trim()) return [];
-      return content.trim().split('\n').map(line => JSON.parse(line));
+      const lines = content.split('\n');
+      const pending = lines.pop()!; // '' when the file ends with a newline
+      const entries = lines.filter(line => line.trim()).map(line => JSON.parse(line));
+      if (pending.trim()) {
+        try {
+          entries.push(JSON.parse(pending));
+        } catch {
+          // Partial record from a concurrent writer
+        }
+      }
+      return entries;
     } catch (err) {
       console.error(`Error reading or parsing JSONL file ${this.filePath}:`, err);
       throw new Error(`Failed to parse ${this.filePath}. Check its format.`);
@@ -46,13 +58,13 @@ export class JsonlFile {
 
   /**
    * Appends a JSON object as a newline-delimited entry to the file, creating directories as needed.
+   * The entry is written whole under the file's lock, so concurrent Kai processes never interleave.
    */
   async append(data: object): Promise<void> {
-    const entry = JSON.stringify(data) + '\n';
     try {
       const dir = path.dirname(this.filePath);
       await this.fs.ensureDirExists(dir);
-      await fsPromises.appendFile(this.filePath, entry, 'utf-8');
+      await appendLinesLocked(this.filePath, [JSON.stringify(data)]);
     } catch (err) {
       console.error(`Error appending to JSONL file ${this.filePath}:`, err);
       throw err;
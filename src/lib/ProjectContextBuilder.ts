@@ -1,23 +1,71 @@
 // src/lib/ProjectContextBuilder.ts
 import path from 'path';
+import crypto from 'crypto';
 import chalk from 'chalk';
 import { AIClient } from './AIClient'; // <-- ADDED: Import AIClient
 import { FileSystem } from './FileSystem';
 import { Config } from './Config';
 import { countTokens } from './utils';
 import { GitService } from './GitService';
+import { tracer } from './telemetry/Tracer';
+import { metrics } from './telemetry/Metrics';
+import { profiler } from './telemetry/Profiler';
+import { ESTIMATED_TOKENS_PER_BYTE } from './analysis/TokenBudgetProfiler';
+import { MemoryGovernor, memoryGovernor } from './memory/MemoryGovernor';
+import { BoundedCache } from './memory/BoundedCache';
+import { SyntaxChunker, CodeChunk } from './analysis/SyntaxChunker';
+import { RelevanceFeedback, RelevanceModel, relevanceFeedback } from './analysis/RelevanceFeedback';
+import { WorkspaceDetector, WorkspacePackage } from './workspace/WorkspaceDetector';
+import { RetrievalTools } from './retrieval/RetrievalTools';
+import { ContextModeSelector, ContextDecision, ConcreteContextMode } from './context/ContextModeSelector';
 // --- ADDED: Import Analysis Cache Types ---
 // Import ProjectAnalysisCache, AnalysisCacheEntry depends on the M1 or M2 structure being targeted
-import { ProjectAnalysisCache, AnalysisCacheEntry } from './analysis/types'; // Adjust path if needed
+import { ProjectAnalysisCache, SymbolEntry } from './analysis/types'; // Adjust path if needed
+import { AnalysisIndex } from './analysis/AnalysisIndex';
+import { PathTable } from './memory/PathTable';
 import { AnalysisPrompts } from './analysis/prompts'; // Import prompts for dynamic context
 import { Message } from './models/Conversation'; // Import Message type
 
+/** A built context. `fullTokenEstimate` is what full context would have cost, when the build read the analysis cache. */
+export interface ContextResult {
+    context: string;
+    tokenCount: number;
+    fullTokenEstimate?: number | null;
+}
+
+/**
+ * What the token estimate learned about a file's context block, keyed by path and content hash.
+ * Only the counts are kept, never the content or the rendered block.
+ */
+interface BlockEstimate {
+    empty: boolean; // Whitespace-only files are left out of the context
+    tokens: number;
+}
+
+/** An analysis index kept across builds while the cache file(s) it came from are unchanged. */
+interface StampedIndex {
+    stamp: string;               // mtime and size of the source cache file(s)
+    index: AnalysisIndex | null; // null when there was no usable cache
+}
+
+const BLOCK_ESTIMATE_CACHE_BYTES = 8 * 1024 * 1024;
+const ANALYSIS_INDEX_CACHE_BYTES = 256 * 1024 * 1024;
+// Full mode holds every file's content plus the concatenated context (both UTF-16 strings).
+const FULL_CONTEXT_BYTES_PER_CHAR = 4;
+
 export class ProjectContextBuilder {
     private fs: FileSystem;
     private gitService: GitService; // Already injected
     private aiClient: AIClient; // <-- ADDED: AIClient instance variable
     private projectRoot: string;
     config: Config; // Made public in a previous step? Keep public or use getter.
+    private governor: MemoryGovernor;
+    private blockCache: BoundedCache<BlockEstimate>;
+    private indexCache: BoundedCache<StampedIndex>; // Keyed by cache path, or by scope for merged workspace caches
+    private unregisterCaches: Array<() => void>;
+    private chunker: SyntaxChunker;
+    private feedback: RelevanceFeedback;
+    private scope: WorkspacePackage[] | null = null; // Workspace packages (with dependency closure) this conversation is limited to
 
     // Update constructor to accept AIClient
     constructor(
@@ -25,13 +73,116 @@ export class ProjectContextBuilder {
         gitService: GitService, // <-- Add gitService parameter
         projectRoot: string,
         config: Config,
-        aiClient: AIClient // <-- ADDED: Inject AIClient
+        aiClient: AIClient, // <-- ADDED: Inject AIClient
+        governor: MemoryGovernor = memoryGovernor,
+        feedback: RelevanceFeedback = relevanceFeedback
     ) {
         this.fs = fileSystem;
         this.gitService = gitService; // <-- Assign injected GitService
         this.aiClient = aiClient; // <-- Assign injected AIClient
         this.projectRoot = projectRoot;
         this.config = config;
+        this.governor = governor;
+        this.blockCache = new BoundedCache<BlockEstimate>('context.blocks', BLOCK_ESTIMATE_CACHE_BYTES, () => 160);
+        // Rebuilding an index means re-parsing its JSON, so it is shed after the block estimates
+        this.indexCache = new BoundedCache<StampedIndex>('analysis.index', ANALYSIS_INDEX_CACHE_BYTES,
+            e => (e.index?.sizeBytes() ?? 0) + e.stamp.length * 2 + 64);
+        this.unregisterCaches = [this.governor.register(this.blockCache, 0), this.governor.register(this.indexCache, 1)];
+        this.chunker = new SyntaxChunker(projectRoot);
+        this.feedback = feedback;
+    }
+
+    /**
+     * Unregisters this builder's caches from the memory governor and drops them. Call when the
+     * builder is discarded before the process ends, or the governor keeps it alive.
+     */
+    dispose(): void {
+        for (const unregister of this.unregisterCaches.splice(0)) unregister();
+        this.blockCache.clear();
+        this.indexCache.clear();
+    }
+
+    /**
+     * Limits context building to the given workspace packages (pass the dependency closure from
+     * WorkspaceDetector.resolveScope). null or an empty list restores the whole project.
+     */
+    setScope(packages: WorkspacePackage[] | null): void {
+        this.scope = packages && packages.length > 0 ? packages : null;
+    }
+
+    getScope(): WorkspacePackage[] | null {
+        return this.scope;
+    }
+
+    /**
+     * Reads the analysis cache for the current scope. Unscoped, this is the project cache. Scoped,
+     * each package's own cache (from per-package analysis) is merged; a package without one
+     * falls back to its entries from the project cache. The parsed entries are packed into an
+     * AnalysisIndex, which is kept until one of the files it was built from changes (by mtime
+     * or size), so a turn that reads the cache more than once parses it once.
+     * @returns The index (null if nothing was found) and a description of where it came from.
+     */
+    private async _readAnalysisCache(): Promise<{ index: AnalysisIndex | null; cachePath: string }> {
+        const rootCachePath = path.resolve(this.projectRoot, this.config.analysis.cache_file_path);
+        if (!this.scope) {
+            const index = await this._loadIndex(rootCachePath, [rootCachePath], () => this._parseIndex(rootCachePath));
+            return { index, cachePath: rootCachePath };
+        }
+
+        const scope = this.scope;
+        const packageCachePaths = scope.map(pkg => path.resolve(this.projectRoot, WorkspaceDetector.cachePathFor(pkg)));
+        const cachePath = `analysis caches of workspace packages ${scope.map(p => p.name).join(', ')}`;
+        const index = await this._loadIndex(`scope:${scope.map(p => p.name).join(',')}`, [...packageCachePaths, rootCachePath], async () => {
+            let rootCache: Promise<ProjectAnalysisCache | null> | null = null;
+            const merged = new AnalysisIndex();
+            const summaries: string[] = [];
+            for (let i = 0; i < scope.length; i++) {
+                const packageCache = await this.fs.readAnalysisCache(packageCachePaths[i]);
+                if (packageCache?.entries?.length) {
+                    for (const entry of packageCache.entries) merged.add(entry);
+                    if (packageCache.overallSummary) summaries.push(packageCache.overallSummary);
+                    continue;
+                }
+                rootCache ??= this.fs.readAnalysisCache(rootCachePath);
+                for (const entry of (await rootCache)?.entries ?? []) {
+                    if (WorkspaceDetector.contains([scope[i]], entry.filePath)) merged.add(entry);
+                }
+            }
+            if (merged.length === 0) return null;
+            merged.overallSummary = summaries.join('\n') || null;
+            return merged;
+        });
+        return { index, cachePath };
+    }
+
+    /**
+     * Returns the index cached under `key` if none of `sources` changed since it was built,
+     * otherwise builds it again and keeps it (the cache is shed under memory pressure).
+     */
+    private async _loadIndex(key: string, sources: string[], build: () => Promise<AnalysisIndex | null>): Promise<AnalysisIndex | null> {
+        const stamp = (await Promise.all(sources.map(async source => {
+            const stats = await this.fs.stat(source);
+            return stats ? `${stats.mtimeMs}:${stats.size}` : '-';
+        }))).join('|');
+        const cached = this.indexCache.get(key);
+        if (cached && cached.stamp === stamp) return cached.index;
+        const index = await build();
+        this.indexCache.set(key, { stamp, index });
+        return index;
+    }
+
+    private async _parseIndex(cachePath: string): Promise<AnalysisIndex | null> {
+        const cacheData = await this.fs.readAnalysisCache(cachePath);
+        return cacheData ? AnalysisIndex.fromCache(cacheData) : null;
+    }
+
+    /** Text files to include in full context: the whole project, or only the scoped package directories. */
+    private async _scopedProjectFiles(): Promise<string[]> {
+        const ignoreRules = await this.gitService.getIgnoreRules(this.projectRoot);
+        if (!this.scope) return this.fs.getProjectFiles(this.projectRoot, this.projectRoot, ignoreRules);
+        const perPackage = await Promise.all(this.scope.map(pkg =>
+            this.fs.getProjectFiles(path.join(this.projectRoot, pkg.dir), this.projectRoot, ignoreRules).catch(() => [] as string[])));
+        return [...new Set(perPackage.flat())];
     }
 
     /**
@@ -47,29 +198,92 @@ export class ProjectContextBuilder {
 
     /**
      * Builds the project context string based on the *final determined* context mode from config.
-     * This expects config.context.mode to be 'full', 'analysis_cache', or 'dynamic'.
+     * This expects config.context.mode to be 'full', 'analysis_cache', 'dynamic' or 'auto'
+     * ('auto' picks one of the others for this call, see ContextModeSelector).
      * It should NOT be called when mode is still undefined.
      * @param userQuery Optional user query (needed for dynamic mode).
      * @param historySummary Optional conversation history summary (needed for dynamic mode).
-     * @returns An object containing the context string and its token count.
+     * @param feedbackConversation Conversation a dynamic selection is recorded under for relevance
+     *   feedback (its log file path); null for internal queries, which are not user turns.
+     * @returns The context string, its token count and, when the analysis cache was read, `fullTokenEstimate`.
      * @throws Error if config.context.mode is still undefined or cache is missing when required.
      * @throws Error if required arguments for dynamic mode are missing.
      */
     async buildContext(
         userQuery?: string,
-        historySummary?: string | null // Corrected: Expects string | null, not Message[]
-    ): Promise<{ context: string; tokenCount: number }> {
-        const contextMode = this.config.context.mode;
+        historySummary?: string | null, // Corrected: Expects string | null, not Message[]
+        feedbackConversation: string | null = null
+    ): Promise<ContextResult> {
+        const configuredMode = this.config.context.mode ?? 'undetermined';
+        return tracer.span('context.build', 'context', async () => {
+            const decision = configuredMode === 'auto' ? await this._chooseAutoMode(userQuery, historySummary) : null;
+            const mode = decision?.mode ?? configuredMode;
+            const result = await metrics.time('context.build_ms', { mode },
+                () => profiler.around('context', () => this._buildContextForMode(mode, userQuery, historySummary, feedbackConversation)));
+            metrics.increment('context.tokens_sent', { mode }, result.tokenCount);
+            if (result.fullTokenEstimate != null) {
+                metrics.increment('context.tokens_saved', { mode }, Math.max(0, result.fullTokenEstimate - result.tokenCount));
+            }
+            if (decision && decision.predictedTokens > 0) {
+                metrics.observe('context.auto_prediction_error_pct',
+                    Math.round((Math.abs(result.tokenCount - decision.predictedTokens) / decision.predictedTokens) * 100), { mode }, '%');
+            }
+            return result;
+        }, { mode: configuredMode });
+    }
+
+    /**
+     * Resolves 'auto' for one call from analysis-cache statistics, the query and the prompt
+     * budget left after the query and history, and logs the choice with its predicted cost.
+     */
+    private async _chooseAutoMode(userQuery?: string, historySummary?: string | null): Promise<ContextDecision> {
+        const { index } = await this._readAnalysisCache();
+        const maxTotalTokens = this.config.gemini.max_prompt_tokens || 32000;
+        // Same base estimate as buildDynamicContext: query, history summary and instructions
+        const budget = maxTotalTokens - ((userQuery ? countTokens(userQuery) : 0) + (historySummary ? countTokens(historySummary) : 0) + 500);
+        const decision = ContextModeSelector.choose(
+            ContextModeSelector.indexStats(index),
+            budget,
+            userQuery,
+            userQuery ? ContextModeSelector.specificMatches(index, userQuery) : 0);
+        const extra = decision.extraModelCalls > 0 ? ` + ${decision.extraModelCalls} selection call (~${decision.extraTokens} tokens)` : '';
+        const predicted = decision.predictedTokens > 0 ? `~${decision.predictedTokens} context tokens${extra}` : 'size unknown until files are read';
+        console.log(chalk.cyan(`\nAuto context: using '${decision.mode}' (${decision.reason}); predicted ${predicted}.`));
+        metrics.increment('context.auto_choice', { mode: decision.mode });
+        return decision;
+    }
+
+    /**
+     * Records an analysis-cache lookup and returns what the full context would have cost
+     * (null on a miss), for the build result's `fullTokenEstimate`.
+     */
+    private _noteCacheRead(index: AnalysisIndex | null): number | null {
+        const hit = !!index && index.length > 0;
+        metrics.recordCacheAccess('analysis', hit);
+        if (!hit) return null;
+        let bytes = 0;
+        for (let row = 0; row < index!.length; row++) {
+            if (index!.type(row) !== 'binary') bytes += index!.size(row);
+        }
+        return Math.ceil(bytes * ESTIMATED_TOKENS_PER_BYTE);
+    }
+
+    private async _buildContextForMode(
+        contextMode: ConcreteContextMode | string,
+        userQuery?: string,
+        historySummary?: string | null,
+        feedbackConversation: string | null = null
+    ): Promise<ContextResult> {
 
         if (contextMode === 'analysis_cache') {
             console.log(chalk.blue('\nBuilding project context using analysis cache...'));
-            const cachePath = path.resolve(this.projectRoot, this.config.analysis.cache_file_path);
-            const cacheData = await this.fs.readAnalysisCache(cachePath);
+            const { index, cachePath } = await this._readAnalysisCache();
+            const fullTokenEstimate = this._noteCacheRead(index);
 
             // Check if cache exists and has entries (M2 check)
-            if (cacheData && cacheData.entries && cacheData.entries.length > 0) { // M2 check: object exists, entries array exists and is not empty
-                return this._formatCacheAsContext(cacheData); // Pass object for M2 formatting
-            } else if (cacheData && cacheData.entries && cacheData.entries.length === 0) { // M2 check: cache object exists but entries are empty
+            if (index && index.length > 0) { // M2 check: cache exists and is not empty
+                return { ...this._formatCacheAsContext(index), fullTokenEstimate }; // Pass index for M2 formatting
+            } else if (index && index.length === 0) { // M2 check: cache exists but entries are empty
                  // Handle case where cache exists but is empty
                  console.log(chalk.yellow(`Analysis cache is empty at ${cachePath}. Building empty context.`));
                  return { context: 'Project Analysis Cache is empty.', tokenCount: 5 }; // Return minimal context
@@ -81,7 +295,7 @@ export class ProjectContextBuilder {
                 throw new Error(`Cannot build context: Analysis cache required but missing/invalid/empty at ${cachePath}.`);
             }
         } else if (contextMode === 'full') {
-            return this._buildFullContext();
+            return this._buildFullContext(userQuery, historySummary, feedbackConversation);
         } else if (contextMode === 'dynamic') {
             if (!userQuery) {
                  throw new Error("User query is required for 'dynamic' context mode.");
@@ -89,46 +303,54 @@ export class ProjectContextBuilder {
             console.log(chalk.blue('\nBuilding dynamic project context...'));
             // Pass the already summarized history
              // Ensure we pass string | null, not undefined, using nullish coalescing on the parameter
-             return this.buildDynamicContext(userQuery, historySummary ?? null);
+             return this.buildDynamicContext(userQuery, historySummary ?? null, feedbackConversation);
         } else {
              // This should not happen if startup logic works correctly
             throw new Error(`Internal Error: Invalid or undetermined context mode '${contextMode}' encountered during context building. Mode determination failed or was skipped.`);
         }
     }
 
-    /** Builds context by reading all project files. */
-    private async _buildFullContext(): Promise<{ context: string; tokenCount: number }> {
+    /**
+     * Builds context by reading all project files. The memory governor is asked first, with a
+     * size estimate from stat; if it cannot fit the result in the heap budget, nothing is read
+     * and a lower tier (dynamic, then analysis cache) is used instead.
+     */
+    private async _buildFullContext(
+        userQuery?: string,
+        historySummary?: string | null,
+        feedbackConversation: string | null = null
+    ): Promise<ContextResult> {
         console.log(chalk.blue('\nBuilding project context (reading all text files)...')); // Updated log message
-        const ignoreRules = await this.gitService.getIgnoreRules(this.projectRoot);
-        const filePaths = await this.fs.getProjectFiles(this.projectRoot, this.projectRoot, ignoreRules);
+        const filePaths = await this._scopedProjectFiles();
+        // Sizes are in bytes, contents UTF-16 chars: for mostly-ASCII source one char per byte
+        const totalBytes = await this.fs.totalFileSize(filePaths, 12);
+        if (!this.governor.canAfford(totalBytes * FULL_CONTEXT_BYTES_PER_CHAR, 'context.full')) {
+            const lower = await this._buildLowerTierContext(userQuery, historySummary, feedbackConversation);
+            if (lower) return lower;
+            console.warn(chalk.yellow('  No analysis cache available for a lower context tier; continuing with full context.'));
+        }
         // Read with limited concurrency to avoid too many open files
         const fileContents = await this.fs.readFileContents(filePaths, 12);
 
-        let contextString = "Code Base Context:\n";
-        let includedFiles = 0;
+        const blocks: string[] = ["Code Base Context:\n"];
         const sortedFilePaths = Object.keys(fileContents).sort();
 
         for (const filePath of sortedFilePaths) {
             const relativePath = path.relative(this.projectRoot, filePath);
-            let content = fileContents[filePath];
             // No need to check for empty content here, readFileContents handles missing files
             // isTextFile check is done within getProjectFiles
-            content = this.optimizeWhitespace(content);
-            if (!content) {
+            const block = this._renderBlock(relativePath, fileContents[filePath]);
+            if (!block) {
                 console.log(chalk.gray(`  Skipping file with only whitespace: ${relativePath}`));
                 continue;
             }
-
-            const fileHeader = `\n---\nFile: ${relativePath}\n\`\`\`\n`;
-            const fileFooter = "\n```\n";
-            const fileBlock = fileHeader + content + fileFooter;
-             // Add token counting for the block if needed for limits later
-            contextString += fileBlock;
-            includedFiles++;
+            blocks.push(block);
             console.log(chalk.dim(`  Included ${relativePath}`));
         }
+        const includedFiles = blocks.length - 1;
+        const contextString = blocks.join('');
 
-        const finalTokenCount = countTokens(contextString);
+        const finalTokenCount = tracer.spanSync('tokenize', 'tokenize', () => countTokens(contextString), { chars: contextString.length });
 
         console.log(chalk.blue(`Full context built with ${includedFiles} files.`));
         console.log(chalk.blue(`Final calculated context token count: ${finalTokenCount}`));
@@ -143,59 +365,97 @@ export class ProjectContextBuilder {
      * @returns The estimated total token count.
      */
     async estimateFullContextTokens(): Promise<number> {
+        return tracer.span('context.estimateFullTokens', 'context', () => this._estimateFullContextTokens());
+    }
+
+    private async _estimateFullContextTokens(): Promise<number> {
         console.log(chalk.dim('\nEstimating full project context token count...'));
-        const ignoreRules = await this.gitService.getIgnoreRules(this.projectRoot);
-        const filePaths = await this.fs.getProjectFiles(this.projectRoot, this.projectRoot, ignoreRules);
+        const filePaths = await this._scopedProjectFiles();
 
         let totalTokenCount = countTokens("Code Base Context:\n"); // Base token count
         let includedFiles = 0;
 
         // Read contents with bounded concurrency, then compute token estimates
         const contents = await this.fs.readFileContents(filePaths, 12);
-        for (const filePath of Object.keys(contents)) {
-            const relativePath = path.relative(this.projectRoot, filePath);
-            const content = contents[filePath];
-            if (!content || !content.trim()) continue;
-            const optimizedContent = this.optimizeWhitespace(content);
-            if (!optimizedContent) continue;
-            const fileHeader = `\n---\nFile: ${relativePath}\n\`\`\`\n`;
-            const fileFooter = "\n```\n";
-            totalTokenCount += countTokens(fileHeader) + countTokens(optimizedContent) + countTokens(fileFooter);
-            includedFiles++;
-        }
+        tracer.spanSync('tokenize', 'tokenize', () => {
+            for (const filePath of Object.keys(contents)) {
+                const relativePath = path.relative(this.projectRoot, filePath);
+                const content = contents[filePath];
+                if (!content || !content.trim()) continue;
+                const estimate = this._estimateBlock(relativePath, content);
+                if (estimate.empty) continue;
+                totalTokenCount += estimate.tokens;
+                includedFiles++;
+            }
+        }, { files: filePaths.length });
 
         console.log(chalk.dim(`Estimated token count for ${includedFiles} files: ${totalTokenCount}`));
         return totalTokenCount;
     }
 
-    /** Formats the loaded analysis cache data (M2 object structure) into a context string. */
-    private _formatCacheAsContext(cacheData: ProjectAnalysisCache): { context: string; tokenCount: number } {
+    /** Renders a file as a context block, or null when it is whitespace-only. */
+    private _renderBlock(relativePath: string, content: string): string | null {
+        const optimized = this.optimizeWhitespace(content);
+        return optimized ? `\n---\nFile: ${relativePath}\n\`\`\`\n${optimized}\n\`\`\`\n` : null;
+    }
+
+    /**
+     * Token count of a file's context block, reused while the file's content hash is unchanged.
+     * The cache holds counts only and is registered with the memory governor.
+     */
+    private _estimateBlock(relativePath: string, content: string): BlockEstimate {
+        const key = `${relativePath}:${crypto.createHash('sha1').update(content).digest('hex')}`;
+        const cached = this.blockCache.get(key);
+        if (cached) return cached;
+        const optimized = this.optimizeWhitespace(content);
+        const estimate: BlockEstimate = optimized
+            ? { empty: false, tokens: countTokens(`\n---\nFile: ${relativePath}\n\`\`\`\n`) + countTokens(optimized) + countTokens("\n```\n") }
+            : { empty: true, tokens: 0 };
+        this.blockCache.set(key, estimate);
+        return estimate;
+    }
+
+    /**
+     * Builds the next-cheapest context when full context does not fit the memory budget:
+     * dynamic selection if there is a query, otherwise the analysis cache summaries.
+     * @returns null if no analysis cache exists to fall back on.
+     */
+    private async _buildLowerTierContext(
+        userQuery?: string,
+        historySummary?: string | null,
+        feedbackConversation: string | null = null
+    ): Promise<ContextResult | null> {
+        const { index } = await this._readAnalysisCache();
+        if (!index || index.length === 0) return null;
+        const tier = userQuery ? 'dynamic' : 'analysis_cache';
+        console.warn(chalk.yellow(`  Full context exceeds the memory budget; using '${tier}' context for this request.`));
+        metrics.increment('context.downgraded', { from: 'full', to: tier });
+        if (userQuery) return this.buildDynamicContext(userQuery, historySummary ?? null, feedbackConversation);
+        return { ...this._formatCacheAsContext(index), fullTokenEstimate: this._noteCacheRead(index) };
+    }
+
+    /** Formats the loaded analysis cache (M2 structure) into a context string. */
+    private _formatCacheAsContext(index: AnalysisIndex): { context: string; tokenCount: number } {
         // --- M2 Formatting ---
-        let contextString = `Project Analysis Overview:\n${cacheData.overallSummary || "(No overall summary provided)"}\n\nFile Details:\n`;
-        // Filter out entries that shouldn't clutter the context? Or keep all? Keep all for now.
-        const entries = cacheData.entries;
-
-        for (const entry of entries) {
-            contextString += `\n---\nFile: ${entry.filePath}`;
-            // Add type/size info, especially if no summary exists
-            if (entry.type !== 'text_analyze' && entry.summary === null) { // Show details only if NOT analyzed text
-                  contextString += ` [${entry.type.replace('_', ' ')}] (Size: ${(entry.size / 1024).toFixed(1)} KB`;
-                  if (entry.loc !== null) contextString += `, LOC: ${entry.loc}`;
-                  contextString += `)`;
-            } else if (entry.loc !== null) { // Add LOC for analyzed files too
-                 contextString += ` (LOC: ${entry.loc})`;
-            }
-            // Only include summary if it exists
-            if (entry.summary) {
-                 contextString += `\nSummary: ${entry.summary}\n`;
-            } else {
-                 contextString += `\nSummary: (Not summarized)\n`; // Indicate it wasn't summarized
+        // Read column by column and joined once; no entry objects or repeated string copies
+        const parts: string[] = [`Project Analysis Overview:\n${index.overallSummary || "(No overall summary provided)"}\n\nFile Details:\n`];
+        for (let row = 0; row < index.length; row++) {
+            const type = index.type(row);
+            const loc = index.loc(row);
+            const summary = index.summary(row);
+            let details = '';
+            if (type !== 'text_analyze' && summary === null) { // Show type/size only if NOT analyzed text
+                details = ` [${type.replace('_', ' ')}] (Size: ${(index.size(row) / 1024).toFixed(1)} KB${loc !== null ? `, LOC: ${loc}` : ''})`;
+            } else if (loc !== null) { // Add LOC for analyzed files too
+                details = ` (LOC: ${loc})`;
             }
+            parts.push(`\n---\nFile: ${index.filePath(row)}${details}\nSummary: ${summary || '(Not summarized)'}\n`);
         }
+        const contextString = parts.join('');
         // --- End M2 formatting ---
 
         const finalTokenCount = countTokens(contextString); // Count tokens of the formatted string
-        console.log(chalk.blue(`Analysis cache context built with ${entries.length} entries.`));
+        console.log(chalk.blue(`Analysis cache context built with ${index.length} entries.`));
         console.log(chalk.blue(`Final calculated context token count: ${finalTokenCount}`));
         return { context: contextString, tokenCount: finalTokenCount };
     }
@@ -203,32 +463,86 @@ export class ProjectContextBuilder {
     /**
      * Creates a concise string summary of the analysis cache for the relevance check prompt.
      */
-    private _formatCacheForRelevance(cacheData: ProjectAnalysisCache): string {
-         let summaryString = "Available Files Overview:\n";
-         for (const entry of cacheData.entries) {
-              // Include essential info: path, type, size, and summary if available
-              summaryString += `- ${entry.filePath} [${entry.type.replace('_', ' ')}] (Size: ${(entry.size / 1024).toFixed(1)} KB)`;
-              if (entry.summary) {
-                   summaryString += ` - Summary: ${entry.summary.substring(0, 100)}${entry.summary.length > 100 ? '...' : ''}`; // Truncate summary
+    private _formatCacheForRelevance(index: AnalysisIndex): string {
+         const parts: string[] = ["Available Files Overview:\n"];
+         for (let row = 0; row < index.length; row++) {
+              // Include essential info: path, type, size, and summary if available (truncated)
+              const filePath = index.filePath(row);
+              const summaryLength = index.summaryLength(row);
+              const summary = summaryLength > 0
+                  ? ` - Summary: ${index.summary(row)!.substring(0, 100)}${summaryLength > 100 ? '...' : ''}`
+                  : '';
+              parts.push(`- ${filePath} [${index.type(row).replace('_', ' ')}] (Size: ${(index.size(row) / 1024).toFixed(1)} KB)${summary}\n`);
+              // Symbols of larger files can be selected individually as path#Symbol
+              for (const symbol of index.symbols(row) ?? []) {
+                   parts.push(`    - ${filePath}#${symbol.name} [${symbol.kind} L${symbol.startLine}-${symbol.endLine}]${symbol.summary ? `: ${symbol.summary.substring(0, 100)}` : ''}\n`);
               }
-              summaryString += "\n";
          }
-         return summaryString;
+         return parts.join('');
+    }
+
+    /**
+     * Retrieval tools over this project (and the current workspace scope). The file index and
+     * analysis cache are loaded once per tool set, on the first call that needs them.
+     */
+    async createRetrievalTools(): Promise<RetrievalTools> {
+        const ignoreRules = await this.gitService.getIgnoreRules(this.projectRoot);
+        let files: Promise<PathTable> | null = null;
+        let cache: Promise<AnalysisIndex | null> | null = null;
+        const roots = this._scopeRoots();
+        return new RetrievalTools(this.fs, this.projectRoot, ignoreRules, {
+            files: () => files ??= this._scopedProjectFiles()
+                .then(paths => PathTable.from(paths.map(p => path.relative(this.projectRoot, p).replace(/\\/g, '/')).sort())),
+            cache: () => cache ??= this._readAnalysisCache().then(r => r.index),
+            roots: () => roots,
+        }, this.chunker);
+    }
+
+    /** Relative directories of the scoped packages, or null for the whole project. */
+    private _scopeRoots(): string[] | null {
+        return this.scope?.map(pkg => path.posix.normalize(pkg.dir.replace(/\\/g, '/')).replace(/^\.$|\/+$/g, '')) ?? null;
+    }
+
+    /**
+     * Compact context for tool-based retrieval: the file overview from the analysis cache
+     * (paths, summaries, symbols) without any file contents, which the model fetches itself.
+     */
+    async buildRetrievalContext(): Promise<{ context: string; tokenCount: number }> {
+        const { index } = await this._readAnalysisCache();
+        this._noteCacheRead(index);
+        const overview = index?.length
+            ? this._formatCacheForRelevance(index)
+            : 'No project analysis is available; use list_dir and grep to explore the project.\n';
+        const context = `Code Base Context (retrieved on demand):\nUse the read_file, grep, list_dir and get_symbol tools to load the code you need.\n\n${overview}`;
+        const tokenCount = countTokens(context);
+        metrics.increment('context.tokens_sent', { mode: 'retrieval' }, tokenCount);
+        return { context, tokenCount };
     }
 
     /**
      * Builds context dynamically by selecting relevant files based on summaries. (Milestone 3)
      * @param userQuery The user's current query.
      * @param historySummary Optional summary of recent conversation history.
+     * @param feedbackConversation Conversation the selection is recorded under for relevance feedback;
+     *   null for internal queries such as consolidation's own context.
      */
     async buildDynamicContext(
         userQuery: string,
-        historySummary: string | null
-    ): Promise<{ context: string; tokenCount: number }> {
-        const cachePath = path.resolve(this.projectRoot, this.config.analysis.cache_file_path);
-        const cacheData = await this.fs.readAnalysisCache(cachePath);
+        historySummary: string | null,
+        feedbackConversation: string | null = null
+    ): Promise<ContextResult> {
+        const { index } = await this._readAnalysisCache();
+        const fullTokenEstimate = this._noteCacheRead(index);
+        return { ...(await this._selectDynamicContext(index, userQuery, historySummary, feedbackConversation)), fullTokenEstimate };
+    }
 
-        if (!cacheData || !cacheData.entries || cacheData.entries.length === 0) {
+    private async _selectDynamicContext(
+        index: AnalysisIndex | null,
+        userQuery: string,
+        historySummary: string | null,
+        feedbackConversation: string | null
+    ): Promise<{ context: string; tokenCount: number }> {
+        if (!index || index.length === 0) {
             console.warn(chalk.yellow("Dynamic mode requires analysis cache, but it's missing or empty. Falling back to empty context."));
             // Or potentially fall back to _buildFullContext if small enough? For now, empty.
             return { context: "CONTEXT: Project analysis cache is missing or empty.", tokenCount: 10 };
@@ -242,15 +556,20 @@ export class ProjectContextBuilder {
         if (fileContentBudget <= 0) {
              console.warn(chalk.yellow(`Warning: Base prompt estimate (${basePromptEstimate}) exceeds max tokens (${maxTotalTokens}). Dynamic context cannot include file content.`));
              // Return just the query/history/cache summary? Or error? Return cache summary for now.
-              return this._formatCacheAsContext(cacheData); // Fallback to cache summary context
+              return this._formatCacheAsContext(index); // Fallback to cache summary context
         }
         console.log(chalk.dim(`  Dynamic Context: Calculated file content budget: ~${fileContentBudget} tokens.`));
 
         // 2. Format cache for relevance check
-        const cacheSummaryForPrompt = this._formatCacheForRelevance(cacheData);
+        const cacheSummaryForPrompt = this._formatCacheForRelevance(index);
+
+        // Files that proved relevant for similar past queries (learned from consolidation outcomes)
+        const queryTerms = SyntaxChunker.queryTerms(userQuery);
+        const relevanceModel = await this.feedback.getModel();
+        const learnedHints = relevanceModel.suggest(queryTerms).map(s => s.file).filter(f => index.paths.has(f));
 
         // 3. AI Relevance Check (Call 1 - Flash)
-        const relevancePrompt = AnalysisPrompts.selectRelevantFilesPrompt(userQuery, historySummary, cacheSummaryForPrompt, fileContentBudget);
+        const relevancePrompt = AnalysisPrompts.selectRelevantFilesPrompt(userQuery, historySummary, cacheSummaryForPrompt, fileContentBudget, learnedHints);
         // Optionally prepend dynamic mode guidelines from Kai-dynamic.md if present
         let relevancePromptFinal = relevancePrompt;
         try {
@@ -275,13 +594,14 @@ export class ProjectContextBuilder {
             console.error(chalk.red("  Error during AI relevance check:"), error);
             // Decide how to proceed: empty context? fallback to cache summary? Fallback for now.
             console.warn(chalk.yellow("  Falling back to analysis cache context due to relevance check error."));
-             return this._formatCacheAsContext(cacheData);
+             return this._formatCacheAsContext(index);
         }
 
         if (selectedPaths.length === 0) {
              console.log(chalk.yellow("  AI did not select any relevant files. Using analysis cache context."));
-              return this._formatCacheAsContext(cacheData);
+              return this._formatCacheAsContext(index);
         }
+        selectedPaths = this._orderByLearnedRelevance(selectedPaths, relevanceModel, queryTerms);
 
         // 4. Load Full Files & Assemble Final Context (respecting actual token limit)
         // Start with base prompt elements that MUST be included
@@ -290,24 +610,34 @@ export class ProjectContextBuilder {
         let currentTokenCount = countTokens(finalContext);
         const includedFiles: string[] = [];
 
-        // Prefetch selected files with limited concurrency
+        // Prefetch selected files with limited concurrency. Selections may name a symbol as path#Symbol.
         const normalizedToAbs = new Map<string, string>();
         const absPaths: string[] = [];
+        const wholeFiles = new Set<string>();
+        const scopeRoots = this._scopeRoots();
         for (const p of selectedPaths) {
-            const normalizedPath = path.normalize(p).replace(/\\/g, '/');
+            const { normalizedPath, symbolName } = this._parseSelection(p);
             if (!normalizedPath || normalizedPath.startsWith('..')) {
                 console.warn(chalk.yellow(`    Skipping invalid/suspicious path from AI: ${p}`));
                 continue;
             }
+            if (RetrievalTools.scopePlacement(scopeRoots, normalizedPath) !== 'inside') {
+                console.warn(chalk.yellow(`    Skipping path outside the workspace scope: ${normalizedPath}`));
+                continue;
+            }
+            if (!symbolName) wholeFiles.add(normalizedPath);
+            if (normalizedToAbs.has(normalizedPath)) continue;
             const absolutePath = path.resolve(this.projectRoot, normalizedPath);
             normalizedToAbs.set(normalizedPath, absolutePath);
             absPaths.push(absolutePath);
         }
 
         const contentsMap = await this.fs.readFileContents(absPaths, 12);
+        const includedKeys = new Set<string>();
+        const currentSymbols = new Map<string, Promise<SymbolEntry[]>>();
 
         for (const sel of selectedPaths) {
-            const normalizedPath = path.normalize(sel).replace(/\\/g, '/');
+            const { normalizedPath, symbolName } = this._parseSelection(sel);
             const absolutePath = normalizedToAbs.get(normalizedPath);
             if (!absolutePath) continue;
             const content = contentsMap[absolutePath];
@@ -315,26 +645,103 @@ export class ProjectContextBuilder {
                 console.warn(chalk.yellow(`    Skipping selected file (not found/readable): ${normalizedPath}`));
                 continue;
             }
-            const fileBlock = `\n---\nFile: ${normalizedPath}\n\`\`\`\n${content}\n\`\`\`\n`;
+            // A whole-file selection already covers its symbols; an unknown symbol falls back to the whole file.
+            // The cached line range may predate edits, so the symbol is located again in the content just read.
+            const known = symbolName && !wholeFiles.has(normalizedPath)
+                && index.symbols(index.rowOf(normalizedPath))?.some(s => s.name === symbolName);
+            let symbol: SymbolEntry | undefined;
+            if (known) {
+                if (!currentSymbols.has(normalizedPath)) currentSymbols.set(normalizedPath, this.chunker.extractSymbols(normalizedPath, content));
+                symbol = (await currentSymbols.get(normalizedPath)!).find(s => s.name === symbolName);
+                if (!symbol) console.warn(chalk.yellow(`    Symbol ${symbolName} is no longer in ${normalizedPath}; including the whole file.`));
+            }
+            const key = symbol ? `${normalizedPath}#${symbol.name}` : normalizedPath;
+            if (includedKeys.has(key)) continue;
+
+            const fileBlock = symbol
+                ? `\n---\nFile: ${normalizedPath} (lines ${symbol.startLine}-${symbol.endLine}, ${symbol.kind} ${symbol.name})\n\`\`\`\n${content.split('\n').slice(symbol.startLine - 1, symbol.endLine).join('\n')}\n\`\`\`\n`
+                : `\n---\nFile: ${normalizedPath}\n\`\`\`\n${content}\n\`\`\`\n`;
             const blockTokens = countTokens(fileBlock);
 
             if ((currentTokenCount + blockTokens) > maxTotalTokens) {
-                console.warn(chalk.yellow(`    Skipping selected file (exceeds total token limit): ${normalizedPath}`));
+                // Too big as a whole: fall back to the file's chunks that best match the query.
+                const chunkBlock = symbol ? null : await this._buildChunkBlock(normalizedPath, content, userQuery, maxTotalTokens - currentTokenCount);
+                if (!chunkBlock) {
+                    console.warn(chalk.yellow(`    Skipping selected ${symbol ? 'symbol' : 'file'} (exceeds total token limit): ${key}`));
+                    continue;
+                }
+                finalContext += chunkBlock.block;
+                currentTokenCount += chunkBlock.tokens;
+                includedKeys.add(key);
+                includedFiles.push(key);
+                console.log(chalk.dim(`    Included ${chunkBlock.chunkCount} chunk(s) of ${key} (+${chunkBlock.tokens} tokens). Total: ${currentTokenCount}`));
                 continue;
             }
 
             finalContext += fileBlock;
             currentTokenCount += blockTokens;
-            includedFiles.push(normalizedPath);
-            console.log(chalk.dim(`    Included: ${normalizedPath} (+${blockTokens} tokens). Total: ${currentTokenCount}`));
+            includedKeys.add(key);
+            includedFiles.push(key);
+            console.log(chalk.dim(`    Included: ${key} (+${blockTokens} tokens). Total: ${currentTokenCount}`));
         }
 
         console.log(chalk.blue(`Dynamic context built with ${includedFiles.length} files. Final token count: ${currentTokenCount}`));
+        if (feedbackConversation && includedFiles.length > 0) {
+            this.feedback.recordSelection(feedbackConversation, userQuery, includedFiles.map(k => this._parseSelection(k).normalizedPath), currentTokenCount);
+        }
         return { context: finalContext, tokenCount: currentTokenCount };
     }
 
+    /**
+     * Chunk-level retrieval for a selected file that does not fit the remaining budget: the
+     * file's syntax chunks are ranked against the query and the best ones that fit are
+     * included in file order. Returns null when no chunk matches or fits.
+     */
+    private async _buildChunkBlock(
+        relativePath: string,
+        content: string,
+        userQuery: string,
+        budgetTokens: number
+    ): Promise<{ block: string; tokens: number; chunkCount: number } | null> {
+        if (!SyntaxChunker.supports(relativePath)) return null;
+        const chunks = await this.chunker.chunk(relativePath, content);
+        const ranked = SyntaxChunker.rankChunks(chunks, content, userQuery);
+        const picked: { chunk: CodeChunk; block: string }[] = [];
+        let tokens = 0;
+        for (const { chunk } of ranked) {
+            const block = `\n---\nFile: ${relativePath} (lines ${chunk.startLine}-${chunk.endLine}, chunk ${chunk.name})\n\`\`\`\n${SyntaxChunker.chunkText(content, chunk)}\n\`\`\`\n`;
+            const blockTokens = countTokens(block);
+            if (tokens + blockTokens > budgetTokens) continue;
+            picked.push({ chunk, block });
+            tokens += blockTokens;
+        }
+        if (picked.length === 0) return null;
+        picked.sort((a, b) => a.chunk.startLine - b.chunk.startLine);
+        return { block: picked.map(p => p.block).join(''), tokens, chunkCount: picked.length };
+    }
+
      // REMOVED: _summarizeHistory method (moved to ConversationManager)
 
+    /**
+     * Stable-sorts AI selections so files with a better learned hit rate claim the token budget
+     * first; files that were repeatedly selected but never used drift to the end.
+     */
+    private _orderByLearnedRelevance(selections: string[], model: RelevanceModel, terms: string[]): string[] {
+        if (model.isEmpty) return selections;
+        return selections
+            .map((sel, index) => ({ sel, index, score: model.score(this._parseSelection(sel).normalizedPath, terms) }))
+            .sort((a, b) => b.score - a.score || a.index - b.index)
+            .map(r => r.sel);
+    }
+
+    /** Splits an AI selection of the form `path` or `path#Symbol` into a normalized path and symbol name. */
+    private _parseSelection(selection: string): { normalizedPath: string; symbolName: string | null } {
+        const hashIndex = selection.indexOf('#');
+        const rawPath = hashIndex === -1 ? selection : selection.slice(0, hashIndex);
+        const symbolName = hashIndex === -1 ? null : selection.slice(hashIndex + 1).trim() || null;
+        return { normalizedPath: path.normalize(rawPath.trim()).replace(/\\/g, '/'), symbolName };
+    }
+
     /**
      * Optimizes whitespace in a code string.
      * @param code The code string.
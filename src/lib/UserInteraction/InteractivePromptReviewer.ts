@@ -1,8 +1,8 @@
 // src/lib/UserInteraction/InteractivePromptReviewer.ts
 import inquirer from 'inquirer';
-import { execSync } from 'child_process';
+import { spawn } from 'child_process';
 import path from 'path';
-import fs from 'fs'; // Use synchronous fs for writeFileSync and existsSync
+import fs from 'fs/promises'; // Async only: in-flight requests and background work keep running while the editor is open
 import os from 'os';
 import chalk from 'chalk';
 import { Config } from '../Config'; // Import Config to check the interactive_prompt_review flag
@@ -38,7 +38,7 @@ export class InteractivePromptReviewer {
             // 1. Create a temporary file
             const tempDir = os.tmpdir();
             tempFilePath = path.join(tempDir, `kai-prompt-review-${Date.now()}.txt`);
-            fs.writeFileSync(tempFilePath, initialPrompt, 'utf8');
+            await fs.writeFile(tempFilePath, initialPrompt, 'utf8');
             console.log(chalk.grey(`Prompt saved to temporary file: ${tempFilePath}`));
 
             // Assign editorArgs AFTER tempFilePath is set
@@ -48,11 +48,11 @@ export class InteractivePromptReviewer {
             // TODO: Enhance editor detection/configuration (similar to UserInterface's editor logic)
 
             console.log(chalk.yellow(`Opening prompt in ${editorName}. Please review/edit, save, and close the editor to continue...`));
-            execSync(`${editorCommand} ${editorArgs.map(arg => `"${arg}"`).join(' ')}`); // Execute command synchronously
+            await this._waitForEditor(editorCommand, editorArgs);
             console.log(chalk.yellow(`${editorName} closed. Reading modified prompt...`));
 
             // 3. Read back the potentially edited content
-            const modifiedPrompt = fs.readFileSync(tempFilePath, 'utf8');
+            const modifiedPrompt = await fs.readFile(tempFilePath, 'utf8');
 
             // 4. Ask for confirmation using inquirer
             const { confirmSend } = await inquirer.prompt([
@@ -97,14 +97,31 @@ export class InteractivePromptReviewer {
             return initialPrompt; // Fallback to original prompt if user proceeds
         } finally {
             // Cleanup: Delete the temporary file
-            if (tempFilePath && fs.existsSync(tempFilePath)) {
+            if (tempFilePath) {
                 try {
-                    fs.unlinkSync(tempFilePath);
+                    await fs.unlink(tempFilePath);
                     console.log(chalk.grey(`Temporary prompt file deleted: ${tempFilePath}`));
                 } catch (cleanupError) {
-                    console.error(chalk.red(`Failed to delete temporary file: ${tempFilePath}`), cleanupError);
+                    if ((cleanupError as NodeJS.ErrnoException).code !== 'ENOENT') {
+                        console.error(chalk.red(`Failed to delete temporary file: ${tempFilePath}`), cleanupError);
+                    }
                 }
             }
         }
     }
+
+    /**
+     * Spawns the editor and resolves when it exits, without blocking the event loop.
+     * Rejects with the spawn error (e.g. ENOENT) or on a non-zero exit code.
+     */
+    private _waitForEditor(command: string, args: string[]): Promise<void> {
+        return new Promise<void>((resolve, reject) => {
+            const editorProcess = spawn(command, args, { stdio: 'inherit' });
+            editorProcess.on('error', reject);
+            editorProcess.on('close', code => {
+                if (code === 0) resolve();
+                else reject(new Error(`'${command}' exited with code ${code}.`));
+            });
+        });
+    }
 }
\ No newline at end of file
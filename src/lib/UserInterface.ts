@@ -8,6 +8,7 @@ import { Config } from './Config'; // Import Config
 import Conversation, { Message } from './models/Conversation'; // Import Conversation types
 import chalk from 'chalk'; // Import chalk for logging
 import { PromptEditor, HISTORY_SEPARATOR } from './UserInteraction/PromptEditor';
+import { WorkspaceDetector, WorkspacePackage } from './workspace/WorkspaceDetector';
 
 // Define the expected return type for getUserInteraction
 interface UserInteractionResultBase {
@@ -30,7 +31,7 @@ interface DeleteInteractionResult {
 // Added specific result type for changing mode
 interface ChangeModeInteractionResult {
     mode: 'Change Context Mode';
-    newMode: 'full' | 'analysis_cache' | 'dynamic'; // Added dynamic mode
+    newMode: 'full' | 'analysis_cache' | 'dynamic' | 'auto'; // Added dynamic and auto modes
 }
 
 interface ScaffoldProjectInteractionResult {
@@ -54,6 +55,19 @@ interface ScaffoldKaiGuidelinesResult {
     mode: 'Scaffold Kai Guidelines';
 }
 
+interface ViewStatsResult {
+    mode: 'View Stats';
+}
+
+interface ToggleProfilingResult {
+    mode: 'Toggle Profiling';
+}
+
+interface AnalyzeWorkspaceResult {
+    mode: 'Analyze Workspace Packages';
+    packages: WorkspacePackage[]; // Selected packages plus their workspace dependencies
+}
+
 // Define the structure for the fallback error
 interface FallbackError {
     type: 'fallback';
@@ -69,7 +83,10 @@ type UserInteractionResult =
     | ScaffoldProjectInteractionResult
     | HardenInteractionResult
     | GenerateKaiignoreResult
-    | ScaffoldKaiGuidelinesResult;
+    | ScaffoldKaiGuidelinesResult
+    | ViewStatsResult
+    | ToggleProfilingResult
+    | AnalyzeWorkspaceResult;
 
 class UserInterface {
     fs: FileSystem;
@@ -231,6 +248,28 @@ class UserInterface {
         }
     }
 
+    private async _handleWorkspaceSelection(): Promise<AnalyzeWorkspaceResult | null> {
+        const info = await WorkspaceDetector.detect(process.cwd());
+        if (!info) {
+            console.log(chalk.yellow('No npm/yarn/pnpm workspaces found in this project.'));
+            return null;
+        }
+        const { selected } = await inquirer.prompt<{ selected: string[] }>([
+            {
+                type: 'checkbox',
+                name: 'selected',
+                message: `Select ${info.tool} workspace packages to analyse (their workspace dependencies are included):`,
+                choices: info.packages.map(p => ({ name: `${p.name} (${p.dir})`, value: p.name })),
+                loop: false,
+            },
+        ]);
+        if (!selected || selected.length === 0) {
+            console.log(chalk.yellow('No packages selected.'));
+            return null;
+        }
+        return { mode: 'Analyze Workspace Packages', packages: WorkspaceDetector.resolveScope(info, selected) };
+    }
+
     private async _handleScaffold(): Promise<ScaffoldProjectInteractionResult> {
         const { directoryName } = await inquirer.prompt([
             {
@@ -353,11 +392,14 @@ class UserInterface {
                         'Consolidate Changes...',
                         'Harden',
                         'Re-run Project Analysis',
+                        'Analyze Workspace Packages',
                         'Change Context Mode',
                         'Scaffold New Project',
                         'Delete Conversation...',
                         'Generate .kaiignore',
                         'Scaffold Kai Guidelines',
+                        'View Stats',
+                        'Toggle Profiling',
                         'Exit Kai', // <-- ADDED Exit option
                         // REMOVED: 'View Kanban Board' option
                     ],
@@ -379,10 +421,22 @@ class UserInterface {
                 return { mode: 'Scaffold Kai Guidelines' };
             }
 
+            if (mode === 'View Stats') {
+                return { mode: 'View Stats' };
+            }
+
+            if (mode === 'Toggle Profiling') {
+                return { mode: 'Toggle Profiling' };
+            }
+
             if (mode === 'Delete Conversation...') {
                 return await this._handleDeletion();
             }
 
+            if (mode === 'Analyze Workspace Packages') {
+                return await this._handleWorkspaceSelection();
+            }
+
             // --- Handle Re-run Project Analysis Mode ---
             if (mode === 'Re-run Project Analysis') {
                 // No conversation name or model needed for analysis
@@ -401,13 +455,14 @@ class UserInterface {
                             { name: 'Full Codebase (reads all files)', value: 'full' },
                             { name: 'Analysis Cache (uses summaries)', value: 'analysis_cache' },
                             { name: 'Dynamic (AI selects relevant files)', value: 'dynamic' }, // <-- ADDED Dynamic option
+                            { name: 'Auto (chooses per prompt from project size, query and budget)', value: 'auto' },
                         ],
                     },
                 ]);
                 // Return specific result type for changing mode
                 return {
                     mode: 'Change Context Mode',
-                    newMode: newModeChoice as 'full' | 'analysis_cache' | 'dynamic',
+                    newMode: newModeChoice as 'full' | 'analysis_cache' | 'dynamic' | 'auto',
                 };
             }
 
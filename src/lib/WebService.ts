@@ -2,8 +2,7 @@
 import * as http from 'http';
 import * as fs from 'fs/promises';
 import path from 'path';
-import { marked } from 'marked';
-import open from 'open'; // Use import for v8
+// 'marked' is loaded when the board is first rendered (see showKanban) to keep it off the startup path.
 import chalk from 'chalk';
 import { FileSystem } from './FileSystem'; // Reuse FileSystem for reading
 
@@ -161,6 +160,7 @@ export class WebService {
         }
 
         console.log(chalk.blue('Converting Markdown to HTML...'));
+        const { marked } = await import('marked');
         let htmlContent: string;
         let kanbanBoardHtml = ''; // HTML for the Kanban Board columns
         let principlesHtml = ''; // HTML for the Guiding Principles section
@@ -1,3 +1,4 @@
+import path from 'path';
 import { AIClient, LogEntryData } from '../AIClient';
 import { FileSystem } from '../FileSystem';
 import { Config } from '../Config';
@@ -7,6 +8,7 @@ import Gemini2FlashModel from '../models/Gemini2FlashModel';
 import AnthropicClaudeModel from '../models/AnthropicClaudeModel';
 import OpenAIChatModel from '../models/OpenAIChatModel';
 import { HIDDEN_CONVERSATION_INSTRUCTION } from '../internal_prompts';
+import { metrics } from '../telemetry/Metrics';
 
 // Mock dependencies
 jest.mock('../FileSystem');
@@ -43,6 +45,7 @@ const createMockConfig = (model_name: string) => ({
 
 const mockProModelInstance = {
     getResponseFromAI: jest.fn(),
+    streamResponseFromAI: jest.fn(),
     generateContent: jest.fn(),
     modelName: 'gemini-test-pro'
 };
@@ -80,18 +83,90 @@ describe('AIClient', () => {
         mockConfig = createMockConfig('gemini-test-pro');
         aiClient = new AIClient(mockConfig);
         // Ensure the internal instances are the mocked ones
-        (aiClient as any).proModel = mockProModelInstance;
-        (aiClient as any).flashModel = mockFlashModelInstance;
-        (aiClient as any).anthropicModel = mockAnthropicModelInstance;
+        (aiClient as any)._proModel = mockProModelInstance;
+        (aiClient as any)._flashModel = mockFlashModelInstance;
+        (aiClient as any)._anthropicModel = mockAnthropicModelInstance;
         (aiClient as any).openAIModels = { 'gpt-4o': mockOpenAIModelInstance, 'o3': mockOpenAIModelInstance };
         (aiClient as any).fs = mockFs;
     });
 
-    it('should be created and initialize models', () => {
+    it('should be created without initializing any model', () => {
         expect(aiClient).toBeDefined();
-        expect(Gemini2ProModel).toHaveBeenCalledWith(mockConfig);
-        expect(Gemini2FlashModel).toHaveBeenCalledWith(mockConfig);
-        expect(AnthropicClaudeModel).toHaveBeenCalledWith(mockConfig);
+        expect(Gemini2ProModel).not.toHaveBeenCalled();
+        expect(Gemini2FlashModel).not.toHaveBeenCalled();
+        expect(AnthropicClaudeModel).not.toHaveBeenCalled();
+        expect(OpenAIChatModel).not.toHaveBeenCalled();
+    });
+
+    it('reports which models cache a repeated prompt prefix', () => {
+        expect(AIClient.cachesPromptPrefix('gemini-2.5-pro')).toBe(true);
+        expect(AIClient.cachesPromptPrefix('gpt-4o')).toBe(true);
+        expect(AIClient.cachesPromptPrefix('gemini-1.5-pro')).toBe(false);
+        expect(AIClient.cachesPromptPrefix('claude-opus-4-20250514')).toBe(false);
+    });
+
+    it('constructs only the selected model on first use', async () => {
+        const fresh = new AIClient(createMockConfig('gemini-test-pro'));
+        (fresh as any).fs = mockFs;
+        mockProModelInstance.getResponseFromAI.mockResolvedValue('ok');
+        await fresh.getResponseTextFromAI([{ role: 'user', content: 'hi' }]);
+        await fresh.getResponseTextFromAI([{ role: 'user', content: 'again' }]);
+        expect(Gemini2ProModel).toHaveBeenCalledTimes(1);
+        expect(Gemini2FlashModel).not.toHaveBeenCalled();
+        expect(OpenAIChatModel).not.toHaveBeenCalled();
+    });
+
+    it('retries a rate-limited call on another pooled key with its own model instance', async () => {
+        const config = createMockConfig('gemini-test-pro');
+        (config.gemini as any).api_keys = ['test-key', 'second-key'];
+        const pooled = new AIClient(config);
+        (pooled as any).fs = mockFs;
+        const exhausted = { ...mockProModelInstance, getResponseFromAI: jest.fn().mockRejectedValue(Object.assign(new Error('quota'), { code: 'RATE_LIMIT' })) };
+        const secondKeyModel = { ...mockProModelInstance, getResponseFromAI: jest.fn().mockResolvedValue('from second key') };
+        (Gemini2ProModel as jest.Mock).mockImplementationOnce(() => exhausted).mockImplementationOnce(() => secondKeyModel);
+        metrics.reset();
+
+        await expect(pooled.getResponseTextFromAI([{ role: 'user', content: 'hi' }])).resolves.toBe('from second key');
+        expect(exhausted.getResponseFromAI).toHaveBeenCalledTimes(1);
+        expect(metrics.counter('model.rate_limited', { provider: 'gemini' })).toBe(1);
+        expect(metrics.counter('model.retries', { provider: 'gemini' })).toBe(1);
+        expect(Gemini2ProModel).toHaveBeenNthCalledWith(1, config, undefined, true); // Leaves 429s to the pool
+        expect(Gemini2ProModel).toHaveBeenLastCalledWith(config, 'second-key', true);
+        expect(pooled.modelParallelism()).toBe(2);
+    });
+
+    it('builds each provider pool with that provider\'s own rate limit', () => {
+        const config = createMockConfig('gpt-4o');
+        (config.gemini as any).rate_limit = { requests_per_minute: 60, key_quarantine_ms: 60000 };
+        (config.openai as any).api_keys = ['oa-key', 'oa-2', 'oa-3'];
+        (config.openai as any).rate_limit = { requests_per_minute: 5, key_quarantine_ms: 1000 };
+        const client = new AIClient(config);
+        const openaiPool = (client as any)._keyPool('openai');
+        const geminiPool = (client as any)._keyPool('gemini');
+
+        expect(openaiPool.requestsPerMinute).toBe(5);
+        expect(openaiPool.quarantineMs).toBe(1000);
+        expect(geminiPool.requestsPerMinute).toBe(60);
+        expect(client.modelParallelism()).toBe(3);
+        expect(client.rateLimit().requests_per_minute).toBe(5); // The active model's provider
+    });
+
+    it('does not retry a stream on another key once a delta was forwarded', async () => {
+        const config = createMockConfig('gemini-test-pro');
+        (config.gemini as any).api_keys = ['test-key', 'second-key'];
+        const pooled = new AIClient(config);
+        (pooled as any).fs = mockFs;
+        const rateLimited = Object.assign(new Error('quota'), { code: 'RATE_LIMIT' });
+        const cutOff = { ...mockProModelInstance, streamResponseFromAI: jest.fn(async (_m: any, onDelta: (t: string) => void) => { onDelta('Half'); throw rateLimited; }) };
+        const secondKeyModel = { ...mockProModelInstance, streamResponseFromAI: jest.fn().mockResolvedValue('again') };
+        (Gemini2ProModel as jest.Mock).mockImplementationOnce(() => cutOff).mockImplementationOnce(() => secondKeyModel);
+        const conversation = new Conversation();
+        conversation.addMessage('user', 'Explain');
+        const deltas: string[] = [];
+
+        await expect(pooled.streamResponseFromAI(conversation, '/c.jsonl', 'ctx', d => deltas.push(d))).rejects.toBe(rateLimited);
+        expect(deltas).toEqual(['Half']);
+        expect(secondKeyModel.streamResponseFromAI).not.toHaveBeenCalled();
     });
 
     it('should log conversation entries', async () => {
@@ -105,6 +180,60 @@ describe('AIClient', () => {
         expect(loggedData).toHaveProperty('timestamp');
     });
 
+    describe('streamResponseFromAI', () => {
+        const conversationFilePath = '/test/chats/conv.jsonl';
+
+        it('forwards deltas and records the full answer', async () => {
+            const conversation = new Conversation();
+            conversation.addMessage('user', 'Explain');
+            mockProModelInstance.streamResponseFromAI.mockImplementation(async (_messages: any, onDelta: (t: string) => void) => {
+                onDelta('Par');
+                onDelta('tial');
+                return 'Partial';
+            });
+            const deltas: string[] = [];
+
+            const result = await aiClient.streamResponseFromAI(conversation, conversationFilePath, 'ctx', d => deltas.push(d));
+
+            expect(result).toEqual({ text: 'Partial', cancelled: false });
+            expect(deltas).toEqual(['Par', 'tial']);
+            expect(mockProModelInstance.streamResponseFromAI.mock.calls[0][0][0].content).toContain('This is the code base context:\nctx');
+            expect(conversation.getLastMessage()).toEqual({ role: 'assistant', content: 'Partial' });
+        });
+
+        it('reads Kai.md from the project root it was given', async () => {
+            const rooted = new AIClient(mockConfig, '/projects/other');
+            (rooted as any)._proModel = mockProModelInstance;
+            (rooted as any).fs = mockFs;
+            mockFs.readFile.mockResolvedValueOnce('Prefer small diffs.');
+            mockProModelInstance.streamResponseFromAI.mockResolvedValueOnce('ok');
+            const conversation = new Conversation();
+            conversation.addMessage('user', 'Explain');
+
+            await rooted.streamResponseFromAI(conversation, conversationFilePath, 'ctx', () => {});
+
+            expect(mockFs.readFile).toHaveBeenCalledWith(path.resolve('/projects/other', 'Kai.md'));
+            expect(mockProModelInstance.streamResponseFromAI.mock.calls[0][0][0].content).toContain('Prefer small diffs.');
+        });
+
+        it('keeps and marks the partial answer when cancelled', async () => {
+            const conversation = new Conversation();
+            conversation.addMessage('user', 'Explain');
+            const controller = new AbortController();
+            mockProModelInstance.streamResponseFromAI.mockImplementation(async (_messages: any, onDelta: (t: string) => void) => {
+                onDelta('So far');
+                controller.abort();
+                return 'So far';
+            });
+
+            const result = await aiClient.streamResponseFromAI(conversation, conversationFilePath, 'ctx', () => {}, controller.signal);
+
+            expect(result).toEqual({ text: 'So far', cancelled: true });
+            expect(mockFs.appendJsonlFile).toHaveBeenCalledWith(conversationFilePath, expect.objectContaining({ type: 'response', content: 'So far\n\n[Response cancelled]' }));
+            expect(conversation.getLastMessage()?.content).toBe('So far');
+        });
+    });
+
     describe('getResponseFromAI (Chat Method)', () => {
         const conversationFilePath = '/test/chats/conv.jsonl';
         const userMessageContent = 'User query';
@@ -129,6 +258,19 @@ describe('AIClient', () => {
             expect(sentMessages[sentMessages.length - 1].content).toBe(expectedUserPrompt);
         });
 
+        it('replays context sent with earlier turns on those messages (delta mode)', async () => {
+            const firstTurn = mockConversation.getMessages()[0];
+            mockConversation.addMessage('assistant', 'First answer');
+            mockConversation.addMessage('user', 'Follow-up');
+            await aiClient.getResponseFromAI(mockConversation, conversationFilePath, 'Only the delta', false, false, new Map([[firstTurn, 'Full anchor']]));
+
+            const sentMessages = mockProModelInstance.getResponseFromAI.mock.calls[0][0];
+            expect(sentMessages[0].content).toBe(`This is the code base context:\nFull anchor\n\n---\nUser Question:\n${userMessageContent}`);
+            expect(sentMessages[1].content).toBe('First answer');
+            expect(sentMessages[2].content).toContain('This is the code base context:\nOnly the delta\n\n---\nUser Question:\nFollow-up');
+            expect(firstTurn.content).toBe(userMessageContent); // The conversation itself is untouched
+        });
+
         it('should use the Pro model by default', async () => {
             await aiClient.getResponseFromAI(mockConversation, conversationFilePath, 'context');
             expect(mockProModelInstance.getResponseFromAI).toHaveBeenCalled();
@@ -267,4 +409,50 @@ describe('AIClient', () => {
             await expect(aiClient.generateContent(mockRequest)).rejects.toThrow('FC Model Error');
         });
     });
+
+    describe('getResponseWithTools (On-demand Retrieval)', () => {
+        it('runs each round of tool calls together and returns the final answer', async () => {
+            const conversation = new Conversation();
+            conversation.addMessage('user', 'Where is the config parsed?');
+            const callPart = (name: string, args: object) => ({ functionCall: { name, args } });
+            mockProModelInstance.generateContent
+                .mockResolvedValueOnce({ response: { candidates: [{ content: { role: 'model', parts: [callPart('grep', { pattern: 'parseConfig' }), callPart('list_dir', {})] } }] } })
+                .mockResolvedValueOnce({ response: { candidates: [{ content: { role: 'model', parts: [{ text: 'In src/config.ts.' }] } }] } });
+            const tools: any = {
+                declarations: [{ name: 'grep' }],
+                answerOnlyConfig: { functionCallingConfig: { mode: 'NONE' } },
+                executeAll: jest.fn().mockResolvedValue([
+                    { name: 'grep', response: { matches: [] } },
+                    { name: 'list_dir', response: { entries: ['src/'] } },
+                ]),
+            };
+
+            const answer = await aiClient.getResponseWithTools(conversation, '/test/chats/conv.jsonl', 'overview', tools, 3);
+
+            expect(answer).toBe('In src/config.ts.');
+            expect(tools.executeAll).toHaveBeenCalledWith([{ name: 'grep', args: { pattern: 'parseConfig' } }, { name: 'list_dir', args: {} }]);
+            const secondRequest = mockProModelInstance.generateContent.mock.calls[1][0];
+            expect(secondRequest.tools).toEqual([{ functionDeclarations: tools.declarations }]);
+            expect(secondRequest.contents.slice(-1)[0]).toEqual({
+                role: 'function',
+                parts: [
+                    { functionResponse: { name: 'grep', response: { matches: [] } } },
+                    { functionResponse: { name: 'list_dir', response: { entries: ['src/'] } } },
+                ],
+            });
+            expect(conversation.getMessages().slice(-1)[0]).toMatchObject({ role: 'assistant', content: 'In src/config.ts.' });
+        });
+
+        it('disables tools on the last round', async () => {
+            const conversation = new Conversation();
+            conversation.addMessage('user', 'q');
+            mockProModelInstance.generateContent.mockResolvedValue({ response: { candidates: [{ content: { role: 'model', parts: [{ text: 'done' }] } }] } });
+            const tools: any = { declarations: [], answerOnlyConfig: { functionCallingConfig: { mode: 'NONE' } }, executeAll: jest.fn() };
+
+            await aiClient.getResponseWithTools(conversation, '/c.jsonl', 'overview', tools, 1);
+
+            expect(mockProModelInstance.generateContent.mock.calls[0][0].toolConfig).toEqual(tools.answerOnlyConfig);
+            expect(tools.executeAll).not.toHaveBeenCalled();
+        });
+    });
 });
\ No newline at end of file
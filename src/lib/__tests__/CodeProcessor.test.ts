@@ -166,7 +166,8 @@ describe('CodeProcessor', () => {
             await codeProcessor.processConsolidationRequest(convName);
             expect(mockContextBuilder.buildDynamicContext).toHaveBeenCalledWith(
                 'Consolidate recent conversation changes',
-                expect.stringContaining('initial prompt') // Should contain summary of relevant history
+                expect.stringContaining('initial prompt'), // Should contain summary of relevant history
+                false
             );
             expect(mockConsolidationService.process).toHaveBeenCalledWith(convName, expect.any(Conversation), 'dynamic_context', expect.stringContaining('testconv'));
         });
@@ -212,28 +213,6 @@ describe('CodeProcessor', () => {
         });
     });
 
-    describe('_summarizeHistory', () => {
-        it('should return null for empty history', () => {
-            expect((codeProcessor as any)._summarizeHistory([])).toBeNull();
-        });
-
-        it('should summarize recent messages', () => {
-            const history: Message[] = [
-                { role: 'user', content: 'old 1', timestamp: '' },
-                { role: 'assistant', content: 'old 2', timestamp: '', },
-                { role: 'user', content: 'recent 1', timestamp: '' },
-                { role: 'assistant', content: 'recent 2', timestamp: '' },
-                { role: 'user', content: 'recent 3', timestamp: '' },
-                { role: 'assistant', content: 'recent 4', timestamp: '' },
-            ];
-            const summary = (codeProcessor as any)._summarizeHistory(history);
-            expect(summary).toContain('Recent conversation highlights:');
-            expect(summary).toContain('user: recent 1');
-            expect(summary).toContain('assistant: recent 4');
-            expect(summary).not.toContain('old 1'); // Should only take last 4
-        });
-    });
-
     describe('optimizeWhitespace', () => {
         it('should remove trailing whitespace', () => {
             expect(codeProcessor.optimizeWhitespace('line1   \nline2\t\n')).toBe('line1\nline2');
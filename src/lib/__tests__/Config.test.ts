@@ -8,9 +8,15 @@ jest.mock('fs', () => {
     promises: realFs.promises,
   };
 });
+jest.mock('../FileLock', () => ({
+  FileLock: { withLock: jest.fn((_path: string, fn: () => Promise<unknown>) => fn()) },
+  writeFileAtomic: jest.fn().mockResolvedValue(undefined),
+}));
+import path from 'path';
 import * as fsSync from 'fs';
+import { FileLock, writeFileAtomic } from '../FileLock';
 import yaml from 'js-yaml';
-import { Config } from '../Config';
+import { Config, MissingApiKeyError } from '../Config';
 
 describe('Config defaults and loading', () => {
   it('uses default values when config.yaml is missing', () => {
@@ -26,6 +32,18 @@ describe('Config defaults and loading', () => {
     expect(cfg.openai?.api_key).toBe('ok');
   });
 
+  it('reads a rate limit per provider', () => {
+    process.env.GEMINI_API_KEY = 'okey';
+    process.env.OPENAI_API_KEY = 'ok';
+    (fsSync.existsSync as jest.Mock).mockReturnValue(true);
+    (fsSync.readFileSync as jest.Mock).mockReturnValue(
+      `gemini:\n  rate_limit:\n    requests_per_minute: 60\nopenai:\n  rate_limit:\n    requests_per_minute: 500\n    key_quarantine_ms: 5000\n`
+    );
+    const cfg = new Config();
+    expect(cfg.gemini.rate_limit?.requests_per_minute).toBe(60);
+    expect(cfg.openai?.rate_limit).toEqual({ requests_per_minute: 500, key_quarantine_ms: 5000 });
+  });
+
   it('loads values from config.yaml when present', () => {
     process.env.GEMINI_API_KEY = 'okey';
     (fsSync.existsSync as jest.Mock).mockReturnValue(true);
@@ -38,6 +56,63 @@ describe('Config defaults and loading', () => {
     expect(cfg.analysis.cache_file_path).toBe('bar');
     expect(cfg.context.mode).toBe('dynamic');
   });
+
+  it('collects pooled API keys from the environment, single key first', () => {
+    process.env.GEMINI_API_KEY = 'k1';
+    process.env.GEMINI_API_KEYS = 'k2, k1 ,k3';
+    process.env.OPENAI_API_KEYS = 'o2';
+    (fsSync.existsSync as jest.Mock).mockReturnValue(false);
+    try {
+      const cfg = new Config();
+      expect(cfg.gemini.api_key).toBe('k1');
+      expect(cfg.gemini.api_keys).toEqual(['k1', 'k2', 'k3']);
+      expect(cfg.openai?.api_keys).toEqual(['ok', 'o2']);
+      expect(cfg.gemini.rate_limit?.key_quarantine_ms).toBe(60000);
+      expect(cfg.openai?.rate_limit).toEqual({ requests_per_minute: 60, key_quarantine_ms: 60000 });
+    } finally {
+      delete process.env.GEMINI_API_KEYS;
+      delete process.env.OPENAI_API_KEYS;
+    }
+  });
+});
+
+describe('Config.load', () => {
+  beforeEach(() => {
+    process.env.GEMINI_API_KEY = 'key';
+    jest.spyOn(console, 'warn').mockImplementation(() => {});
+  });
+
+  afterEach(() => jest.restoreAllMocks());
+
+  it('reads config.yaml asynchronously', async () => {
+    jest.spyOn(fsSync.promises, 'readFile').mockResolvedValue('gemini:\n  model_name: async-model\n' as any);
+    const cfg = await Config.load();
+    expect(cfg.gemini.model_name).toBe('async-model');
+    expect(fsSync.readFileSync).not.toHaveBeenCalled();
+    expect(fsSync.existsSync).not.toHaveBeenCalled();
+  });
+
+  it('uses defaults when config.yaml is missing', async () => {
+    jest.spyOn(fsSync.promises, 'readFile').mockRejectedValue(Object.assign(new Error('missing'), { code: 'ENOENT' }));
+    const cfg = await Config.load();
+    expect(cfg.gemini.model_name).toBe('gemini-2.5-pro');
+    expect(fsSync.readFileSync).not.toHaveBeenCalled();
+  });
+
+  it('rejects with MissingApiKeyError instead of exiting when no Gemini key is set', async () => {
+    delete process.env.GEMINI_API_KEY;
+    const exit = jest.spyOn(process, 'exit').mockImplementation((() => undefined) as any);
+    jest.spyOn(fsSync.promises, 'readFile').mockResolvedValue('' as any);
+    await expect(Config.load()).rejects.toBeInstanceOf(MissingApiKeyError);
+    expect(exit).not.toHaveBeenCalled();
+  });
+
+  it('resolves .kai paths from the project root it is given', async () => {
+    const readFile = jest.spyOn(fsSync.promises, 'readFile').mockResolvedValue('' as any);
+    const cfg = await Config.load('/projects/other');
+    expect(readFile).toHaveBeenCalledWith(path.resolve('/projects/other', '.kai', 'config.yaml'), 'utf8');
+    expect(cfg.chatsDir).toBe(path.resolve('/projects/other', '.kai/logs'));
+  });
 });
 
 describe('Config saveConfig and path', () => {
@@ -50,17 +125,31 @@ describe('Config saveConfig and path', () => {
   it('writes config file successfully', async () => {
     const cfg = new Config();
     jest.spyOn(fsSync.promises, 'mkdir').mockResolvedValue(undefined as any);
-    jest.spyOn(fsSync, 'writeFileSync').mockImplementation(() => {});
     jest.spyOn(console, 'log').mockImplementation(() => {});
     await expect(cfg.saveConfig()).resolves.toBeUndefined();
     expect(fsSync.promises.mkdir).toHaveBeenCalled();
-    expect(fsSync.writeFileSync).toHaveBeenCalledWith(
+    expect(FileLock.withLock).toHaveBeenCalledWith(expect.stringContaining('.kai/config.yaml'), expect.any(Function));
+    expect(writeFileAtomic).toHaveBeenCalledWith(
       expect.stringContaining('.kai/config.yaml'),
-      expect.any(String),
-      'utf8'
+      expect.any(String)
     );
   });
 
+  it('never writes API keys', async () => {
+    process.env.GEMINI_API_KEYS = 'pooled-secret';
+    try {
+      const cfg = new Config();
+      jest.spyOn(fsSync.promises, 'mkdir').mockResolvedValue(undefined as any);
+      jest.spyOn(console, 'log').mockImplementation(() => {});
+      await cfg.saveConfig();
+      const written = (writeFileAtomic as jest.Mock).mock.calls.slice(-1)[0][1];
+      expect(written).not.toContain('pooled-secret');
+      expect(written).not.toContain('api_key');
+    } finally {
+      delete process.env.GEMINI_API_KEYS;
+    }
+  });
+
   it('getConfigFilePath returns correct path', () => {
     const cfg = new Config();
     expect(cfg.getConfigFilePath()).toMatch(/\.kai\/config\.yaml$/);
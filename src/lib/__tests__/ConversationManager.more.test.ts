@@ -31,6 +31,32 @@ describe('ConversationManager additional coverage', () => {
     expect(newAI.getResponseFromAI).toHaveBeenCalledWith(convo, '/c.jsonl', 'ctx', false, false);
   });
 
+  it('uses retrieval tools only when the chat model is a Gemini model', async () => {
+    config.context.retrieval_tools = true;
+    config.gemini = { model_name: 'gemini-2.5-pro' };
+    builder.buildRetrievalContext = jest.fn().mockResolvedValue({ context: 'overview', tokenCount: 1 });
+    builder.createRetrievalTools = jest.fn().mockResolvedValue({});
+    aiClient.getResponseWithTools = jest.fn().mockResolvedValue('answer');
+    await (manager as any)._callAIWithContext(new Conversation(), 'hi', '/c.jsonl');
+    expect(aiClient.getResponseWithTools).toHaveBeenCalledWith(expect.any(Conversation), '/c.jsonl', 'overview', {}, undefined);
+    expect(aiClient.getResponseFromAI).not.toHaveBeenCalled();
+  });
+
+  it('warns and falls back to the configured mode when retrieval tools meet a non-Gemini model', async () => {
+    config.context.retrieval_tools = true;
+    config.gemini = { model_name: 'claude-3-7-sonnet-latest' };
+    builder.buildRetrievalContext = jest.fn();
+    aiClient.getResponseWithTools = jest.fn();
+    builder.buildContext.mockResolvedValue({ context: 'ctx', tokenCount: 1 });
+    const warnSpy = jest.spyOn(console, 'warn').mockImplementation(() => {});
+    await (manager as any)._callAIWithContext(new Conversation(), 'hi', '/c.jsonl');
+    expect(warnSpy).toHaveBeenCalledWith(expect.stringContaining('needs a Gemini model'));
+    expect(builder.buildRetrievalContext).not.toHaveBeenCalled();
+    expect(aiClient.getResponseWithTools).not.toHaveBeenCalled();
+    expect(aiClient.getResponseFromAI).toHaveBeenCalledWith(expect.any(Conversation), '/c.jsonl', 'ctx', false, false);
+    warnSpy.mockRestore();
+  });
+
   it('handles user loop until null prompt', async () => {
     const convo = new Conversation();
     ui.getPromptViaSublimeLoop
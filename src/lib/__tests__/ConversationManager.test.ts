@@ -1,5 +1,5 @@
 import path from 'path';
-import Conversation from '../models/Conversation';
+import Conversation, { summarizeHistory } from '../models/Conversation';
 import { ConversationManager } from '../ConversationManager';
 
 describe('ConversationManager private flows', () => {
@@ -7,7 +7,7 @@ describe('ConversationManager private flows', () => {
   const fs = {} as any;
   const aiClient = {} as any;
   const ui = {} as any;
-  const builder = {} as any;
+  const builder = { setScope: jest.fn() } as any;
   const consolidation = {} as any;
   let manager: ConversationManager;
 
@@ -27,6 +27,17 @@ describe('ConversationManager private flows', () => {
       expect(spyAI).not.toHaveBeenCalled();
     });
 
+    it('routes /scope with its package arguments', async () => {
+      const convo = new Conversation();
+      const spyScope = jest.spyOn<any, any>(manager as any, '_handleScopeCommand').mockResolvedValue(undefined);
+      const spyAI = jest.spyOn<any, any>(manager as any, '_callAIWithContext').mockResolvedValue(undefined);
+
+      await (manager as any)._processLoopIteration(convo, '/scope @acme/web  api', '/c');
+
+      expect(spyScope).toHaveBeenCalledWith(convo, ['@acme/web', 'api'], '/c');
+      expect(spyAI).not.toHaveBeenCalled();
+    });
+
     it('handles regular prompt', async () => {
       const convo = new Conversation();
       const spyCons = jest.spyOn<any, any>(manager as any, '_handleConsolidateCommand').mockResolvedValue(undefined);
@@ -188,7 +199,7 @@ describe('ConversationManager private flows', () => {
       });
     });
 
-    describe('_findRelevantHistorySlice and _summarizeHistory', () => {
+    describe('_findRelevantHistorySlice and summarizeHistory', () => {
       it('returns slice after last success marker', () => {
         const convo = new Conversation();
         convo.addMessage('user', 'a');
@@ -196,12 +207,12 @@ describe('ConversationManager private flows', () => {
         convo.addMessage('assistant', 'b');
         const slice = (manager as any)._findRelevantHistorySlice(convo);
         expect(slice).toHaveLength(1);
-        const summary = (manager as any)._summarizeHistory(slice);
+        const summary = summarizeHistory(slice);
         expect(summary).toContain('assistant');
       });
 
       it('returns null summary for empty history', () => {
-        expect((manager as any)._summarizeHistory([])).toBeNull();
+        expect(summarizeHistory([])).toBeNull();
       });
     });
   });
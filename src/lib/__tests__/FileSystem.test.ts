@@ -32,6 +32,21 @@ describe('FileSystem', () => {
     expect(await fsUtil.stat(missing)).toBeNull();
   });
 
+  it('totalFileSize sums sizes from stat and counts missing files as 0', async () => {
+    fs.writeFileSync(path.join(tempDir, 'a.txt'), 'hello');
+    fs.writeFileSync(path.join(tempDir, 'b.txt'), 'abc');
+    const paths = ['a.txt', 'b.txt', 'nope.txt'].map(f => path.join(tempDir, f));
+    expect(await fsUtil.totalFileSize(paths, 2)).toBe(8);
+    expect(await fsUtil.totalFileSize([])).toBe(0);
+  });
+
+  it('readDir lists entries with their types', async () => {
+    fs.mkdirSync(path.join(tempDir, 'sub'));
+    fs.writeFileSync(path.join(tempDir, 'a.txt'), 'hello');
+    const entries = (await fsUtil.readDir(tempDir)).sort((x, y) => x.name.localeCompare(y.name));
+    expect(entries.map(e => [e.name, e.isDirectory()])).toEqual([['a.txt', false], ['sub', true]]);
+  });
+
   it('isDirectoryEmptyOrSafe handles non-existent, safe-only, and unsafe dirs', async () => {
     // non-existent dir
     const dirA = path.join(tempDir, 'A');
@@ -205,29 +220,24 @@ describe('FileSystem', () => {
       expect(fs.readFileSync(filePath, 'utf8')).toBe('hi\n');
     });
 
-    it('returns false when patch fails', async () => {
-      const cwd = process.cwd();
-      process.chdir(tempDir);
-      try {
-        const filePath = path.join(tempDir, 'fail.txt');
-        fs.writeFileSync(filePath, 'original\n');
-        const base = require('diff').createTwoFilesPatch('fail.txt', 'fail.txt', 'hello\n', 'hi\n');
-        const fenced = '```diff\n' + base.trim() + '\n```';
-        const result = await fsUtil.applyDiffToFile(filePath, fenced);
-        expect(result).toBe(false);
-
-        const logFile = path.join(tempDir, '.kai/logs/diff_failures.jsonl');
-        expect(fs.existsSync(logFile)).toBe(true);
-        const line = fs.readFileSync(logFile, 'utf8').trim().split('\n')[0];
-        const entry = JSON.parse(line);
-        expect(entry.file).toBe(filePath);
-        expect(entry.diff.includes('```')).toBe(false);
-        expect(entry.fileContent).toBe('original\n');
-        expect(entry.error).toBe('Fuzzy patch failed');
-        expect(fs.readFileSync(filePath, 'utf8')).toBe('original\n');
-      } finally {
-        process.chdir(cwd);
-      }
+    it('returns false when patch fails and logs under its project root', async () => {
+      const projectFs = new FileSystem(tempDir);
+      const filePath = path.join(tempDir, 'fail.txt');
+      fs.writeFileSync(filePath, 'original\n');
+      const base = require('diff').createTwoFilesPatch('fail.txt', 'fail.txt', 'hello\n', 'hi\n');
+      const fenced = '```diff\n' + base.trim() + '\n```';
+      const result = await projectFs.applyDiffToFile(filePath, fenced);
+      expect(result).toBe(false);
+
+      const logFile = path.join(tempDir, '.kai/logs/diff_failures.jsonl');
+      expect(fs.existsSync(logFile)).toBe(true);
+      const line = fs.readFileSync(logFile, 'utf8').trim().split('\n')[0];
+      const entry = JSON.parse(line);
+      expect(entry.file).toBe(filePath);
+      expect(entry.diff.includes('```')).toBe(false);
+      expect(entry.fileContent).toBe('original\n');
+      expect(entry.error).toBe('Fuzzy patch failed');
+      expect(fs.readFileSync(filePath, 'utf8')).toBe('original\n');
     });
 
     it('logs failure when patch fails', async () => {
@@ -463,15 +473,17 @@ describe('FileSystem', () => {
     });
 
     it('writeAnalysisCache ignores invalid data and logs errors', async () => {
-      const spy = jest.spyOn(fsUtil, 'writeFile').mockResolvedValue();
+      const spy = jest.spyOn(fsUtil, 'writeFileAtomic').mockResolvedValue();
       const bad: any = null;
       await fsUtil.writeAnalysisCache(tmpc, bad);
       expect(spy).not.toHaveBeenCalled();
     });
 
     it('writeAnalysisCache logs error on failure', async () => {
-      jest.spyOn(fsUtil, 'writeFile').mockRejectedValue(new Error('fail'));
+      jest.spyOn(fsUtil, 'writeFileAtomic').mockRejectedValue(new Error('fail'));
       await fsUtil.writeAnalysisCache(tmpc, { overallSummary: '', entries: [] });
+      expect(fs.existsSync(tmpc)).toBe(false);
+      expect(fs.existsSync(`${tmpc}.lock`)).toBe(false); // Lock released after the failed write
     });
 
     it('logDiffFailure handles logging errors', async () => {
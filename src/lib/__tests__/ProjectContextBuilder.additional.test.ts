@@ -1,7 +1,12 @@
 import path from 'path';
 import { ProjectContextBuilder } from '../ProjectContextBuilder';
 import { ProjectAnalysisCache } from '../analysis/types';
+import { AnalysisIndex } from '../analysis/AnalysisIndex';
 import { countTokens } from '../utils';
+import { metrics } from '../telemetry/Metrics';
+import { ESTIMATED_TOKENS_PER_BYTE } from '../analysis/TokenBudgetProfiler';
+import { MemoryGovernor } from '../memory/MemoryGovernor';
+import { RelevanceFeedback, RelevanceModel } from '../analysis/RelevanceFeedback';
 
 describe('ProjectContextBuilder extra coverage', () => {
   const silence = () => {};
@@ -47,7 +52,7 @@ describe('ProjectContextBuilder extra coverage', () => {
         { filePath: 'b.bin', type: 'binary', size: 2048, loc: null, summary: null, lastAnalyzed: 'n' }
       ]
     };
-    const res = (builder as any)._formatCacheAsContext(cache);
+    const res = (builder as any)._formatCacheAsContext(AnalysisIndex.fromCache(cache));
     expect(res.context).toContain('summary');
     expect(res.context).toContain('File: a.ts');
     expect(res.context).toContain('(LOC: 10)');
@@ -57,9 +62,27 @@ describe('ProjectContextBuilder extra coverage', () => {
     expect(res.context).toContain('Summary: (Not summarized)');
   });
 
+  test('auto mode picks a concrete mode per call and passes the query through', async () => {
+    const cache: ProjectAnalysisCache = {
+      overallSummary: 'o',
+      entries: [{ filePath: 'src/big.ts', type: 'text_analyze', size: 200000, loc: 5000, summary: 'big module', lastAnalyzed: 'n' }],
+    };
+    const fsMock: any = { stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn().mockResolvedValue(cache) };
+    const builder = new ProjectContextBuilder(fsMock, {} as any, '/r', {
+      analysis: { cache_file_path: 'c.json' }, context: { mode: 'auto' }, gemini: { max_prompt_tokens: 32000 }, project: {},
+    } as any, {} as any);
+    const dynamic = jest.spyOn(builder, 'buildDynamicContext').mockResolvedValue({ context: 'selected', tokenCount: 7 });
+
+    await expect(builder.buildContext('Summarize the architecture')).resolves.toMatchObject({ context: expect.stringContaining('big module') });
+    expect(dynamic).not.toHaveBeenCalled();
+    await expect(builder.buildContext('Fix the off-by-one in big', 'history', false)).resolves.toEqual({ context: 'selected', tokenCount: 7 });
+    expect(dynamic).toHaveBeenCalledWith('Fix the off-by-one in big', 'history', false);
+    expect(console.log).toHaveBeenCalledWith(expect.stringContaining("Auto context: using 'dynamic'"));
+  });
+
   test('dynamic context falls back when base prompt too large', async () => {
     const cache: ProjectAnalysisCache = { overallSummary: 'o', entries: [] };
-    const fsMock: any = { readAnalysisCache: jest.fn().mockResolvedValue(cache) };
+    const fsMock: any = { stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn().mockResolvedValue(cache) };
     const aiClient: any = { getResponseTextFromAI: jest.fn() };
     const builder = new ProjectContextBuilder(fsMock, {} as any, '/r', {
       analysis:{ cache_file_path:'c.json' },
@@ -75,7 +98,7 @@ describe('ProjectContextBuilder extra coverage', () => {
   test('dynamic context skips invalid and oversized files', async () => {
     const cache: ProjectAnalysisCache = { overallSummary: 'o', entries: [{ filePath: 'a.ts', type: 'text_analyze', size: 10, loc: 1, summary: 'sum', lastAnalyzed: 'n' }] };
     const fsMock: any = {
-      readAnalysisCache: jest.fn().mockResolvedValue(cache),
+      stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn().mockResolvedValue(cache),
       readFile: jest.fn().mockResolvedValue(null), // Kai-dynamic.md not present
       readFileContents: jest.fn().mockResolvedValue({ '/r/a.ts': 'x '.repeat(600) })
     };
@@ -95,7 +118,7 @@ describe('ProjectContextBuilder extra coverage', () => {
 });
 
   test('analysis cache empty branch', async () => {
-    const fsMock: any = { readAnalysisCache: jest.fn().mockResolvedValue({ overallSummary: 's', entries: [] }) };
+    const fsMock: any = { stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn().mockResolvedValue({ overallSummary: 's', entries: [] }) };
     const builder = new ProjectContextBuilder(fsMock, {} as any, '/r', {
       analysis:{ cache_file_path:'c.json' },
       context:{ mode:'analysis_cache' },
@@ -109,6 +132,7 @@ describe('ProjectContextBuilder extra coverage', () => {
   test('_buildFullContext skips whitespace files', async () => {
     const fsMock: any = {
       getProjectFiles: jest.fn().mockResolvedValue(['/r/a.ts','/r/b.ts']),
+      totalFileSize: jest.fn().mockResolvedValue(8),
       readFileContents: jest.fn().mockResolvedValue({ '/r/a.ts': 'code', '/r/b.ts': '  \n\n' })
     };
     const gitMock: any = { getIgnoreRules: jest.fn().mockResolvedValue({ ignores: () => false }) };
@@ -120,7 +144,7 @@ describe('ProjectContextBuilder extra coverage', () => {
 
   test('dynamic context no selections', async () => {
     const cache: ProjectAnalysisCache = { overallSummary: 'o', entries: [{ filePath: 'a.ts', type: 'text_analyze', size: 10, loc: 1, summary: 'sum', lastAnalyzed: 'n' }] };
-    const fsMock: any = { readAnalysisCache: jest.fn().mockResolvedValue(cache), readFile: jest.fn() };
+    const fsMock: any = { stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn().mockResolvedValue(cache), readFile: jest.fn() };
     const aiClient: any = { getResponseTextFromAI: jest.fn().mockResolvedValue('NONE') };
     const builder = new ProjectContextBuilder(fsMock, {} as any, '/r', {
       analysis:{ cache_file_path:'c.json' },
@@ -131,3 +155,282 @@ describe('ProjectContextBuilder extra coverage', () => {
     const res = await builder.buildContext('q','h');
     expect(res.context).toContain('Project Analysis Overview');
   });
+
+describe('ProjectContextBuilder symbol-level dynamic context', () => {
+  beforeAll(() => {
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+  });
+
+  // `export class Big` with its `run` method three lines long, after `before` comment lines
+  const bigSource = (before: number, method = 'run') => {
+    const lines = Array.from({ length: before }, (_, i) => `// line ${i + 1}`);
+    lines.push('export class Big {', `    ${method}() {`, '        return 1;', '    }', '}');
+    while (lines.length < before + 22) lines.push(`// line ${lines.length + 1}`);
+    return lines.join('\n');
+  };
+  const symbolCache = (): ProjectAnalysisCache => ({ overallSummary: 'o', entries: [{
+    filePath: 'big.ts', type: 'text_analyze', size: 10, loc: 30, summary: 'big', lastAnalyzed: 'n',
+    symbols: [{ name: 'Big.run', kind: 'method', startLine: 10, endLine: 12, signature: 'run()', summary: 'Runs it.' }],
+  }] });
+  const symbolBuilder = (content: string, aiClient: any) => new ProjectContextBuilder({
+    stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn().mockResolvedValue(symbolCache()),
+    readFile: jest.fn().mockResolvedValue(null),
+    readFileContents: jest.fn().mockResolvedValue({ '/r/big.ts': content }),
+  } as any, {} as any, '/r', {
+    analysis: { cache_file_path: 'c.json' }, context: { mode: 'dynamic' }, gemini: { max_prompt_tokens: 5000 }, project: {},
+  } as any, aiClient);
+
+  test('lists symbols for relevance and includes only the selected line range', async () => {
+    const aiClient: any = { getResponseTextFromAI: jest.fn().mockResolvedValue('big.ts#Big.run\nbig.ts#Big.run') };
+    const res = await symbolBuilder(bigSource(8), aiClient).buildContext('q', null);
+    expect(aiClient.getResponseTextFromAI.mock.calls[0][0][0].content).toContain('    - big.ts#Big.run [method L10-12]: Runs it.');
+    expect(res.context).toContain('File: big.ts (lines 10-12, method Big.run)\n```\n    run() {\n        return 1;\n    }\n```');
+    expect(res.context).not.toContain('export class Big');
+    expect(res.context.match(/File: big\.ts/g)).toHaveLength(1);
+  });
+
+  test('locates the symbol again when the file changed since the cache was written', async () => {
+    const aiClient: any = { getResponseTextFromAI: jest.fn().mockResolvedValue('big.ts#Big.run') };
+    const moved = await symbolBuilder(bigSource(13), aiClient).buildContext('q', null);
+    expect(moved.context).toContain('File: big.ts (lines 15-17, method Big.run)\n```\n    run() {\n        return 1;\n    }\n```');
+    expect(moved.context).not.toContain('// line 10');
+
+    jest.spyOn(console, 'warn').mockImplementation(() => {});
+    const renamed = await symbolBuilder(bigSource(8, 'execute'), aiClient).buildContext('q', null);
+    expect(renamed.context).toContain('File: big.ts\n```\n// line 1\n');
+    expect(renamed.context).toContain('    execute() {');
+  });
+
+  test('includes only the matching chunks of a selected file that exceeds the budget', async () => {
+    const fn = (name: string) => [`def ${name}(total):`, ...Array.from({ length: 60 }, () => '    total = total + 1'), '    return total', ''];
+    const content = ['alpha', 'beta', 'parse_header', 'gamma', 'delta'].flatMap(fn).join('\n');
+    const cache: ProjectAnalysisCache = { overallSummary: 'o', entries: [{ filePath: 'big.py', type: 'text_analyze', size: 10, loc: 315, summary: 'big', lastAnalyzed: 'n' }] };
+    const fsMock: any = {
+      stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn().mockResolvedValue(cache),
+      readFile: jest.fn().mockResolvedValue(null),
+      readFileContents: jest.fn().mockResolvedValue({ '/r/big.py': content }),
+    };
+    const aiClient: any = { getResponseTextFromAI: jest.fn().mockResolvedValue('big.py') };
+    const builder = new ProjectContextBuilder(fsMock, {} as any, '/r', {
+      analysis: { cache_file_path: 'c.json' }, context: { mode: 'dynamic' }, gemini: { max_prompt_tokens: 1200 }, project: {},
+    } as any, aiClient);
+
+    const res = await builder.buildContext('fix the parse_header bug', null);
+    expect(res.context).toContain('File: big.py (lines 127-188, chunk parse_header)\n```\ndef parse_header(total):');
+    expect(res.context).not.toContain('def alpha');
+    expect(res.tokenCount).toBeLessThanOrEqual(1200);
+  });
+});
+
+describe('ProjectContextBuilder under memory pressure', () => {
+  const MB = 1024 * 1024;
+  const cache: ProjectAnalysisCache = { overallSummary: 'o', entries: [{ filePath: 'a.ts', type: 'text_analyze', size: 10, loc: 1, summary: 'sum', lastAnalyzed: 'n' }] };
+  const config: any = { context: { mode: 'full' }, analysis: { cache_file_path: 'c.json' }, gemini: {}, project: {} };
+  const gitMock: any = { getIgnoreRules: jest.fn().mockResolvedValue({ ignores: () => false }) };
+
+  beforeAll(() => {
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+    jest.spyOn(console, 'warn').mockImplementation(() => {});
+  });
+
+  const fsWith = (cacheData: ProjectAnalysisCache | null): any => ({
+    getProjectFiles: jest.fn().mockResolvedValue(['/r/a.ts']),
+    totalFileSize: jest.fn().mockResolvedValue(4),
+    readFileContents: jest.fn().mockResolvedValue({ '/r/a.ts': 'code' }),
+    stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn().mockResolvedValue(cacheData),
+  });
+
+  test('falls back to the analysis cache without reading files when full context exceeds the budget', async () => {
+    const governor = new MemoryGovernor({ budgetBytes: 100 * MB, heapUsed: () => 100 * MB, quiet: true });
+    const fsMock = fsWith(cache);
+    const builder = new ProjectContextBuilder(fsMock, gitMock, '/r', config, {} as any, governor);
+    const res = await builder.buildContext();
+    expect(res.context).toContain('Project Analysis Overview');
+    expect(governor.getDecisions().map(d => d.action)).toEqual(['deny']);
+    expect(fsMock.readFileContents).not.toHaveBeenCalled();
+  });
+
+  test('keeps full context when no lower tier is available', async () => {
+    const governor = new MemoryGovernor({ budgetBytes: 100 * MB, heapUsed: () => 100 * MB, quiet: true });
+    const builder = new ProjectContextBuilder(fsWith(null), gitMock, '/r', config, {} as any, governor);
+    const res = await builder.buildContext();
+    expect(res.context).toContain('File: a.ts');
+  });
+
+  test('reuses block token counts, sheds them under pressure and unregisters on dispose', async () => {
+    let heapUsed = 10 * MB;
+    const governor = new MemoryGovernor({ budgetBytes: 100 * MB, heapUsed: () => heapUsed, quiet: true });
+    const builder = new ProjectContextBuilder(fsWith(cache), gitMock, '/r', config, {} as any, governor);
+    const expected = countTokens('Code Base Context:\n') + countTokens('\n---\nFile: a.ts\n```\ncode\n```\n');
+    expect(await builder.estimateFullContextTokens()).toBe(expected);
+    const cached = governor.cachedBytes();
+    expect(cached).toBeGreaterThan(0);
+    expect(await builder.estimateFullContextTokens()).toBe(expected);
+    expect(governor.cachedBytes()).toBe(cached); // Same path and content hash: no new entry
+    expect((await builder.buildContext()).context).toContain('File: a.ts\n```\ncode\n```');
+
+    heapUsed = 90 * MB; // Above the default 85% shed threshold
+    governor.relieve();
+    expect(governor.cachedBytes()).toBe(0);
+
+    await builder.estimateFullContextTokens();
+    builder.dispose();
+    expect(governor.cachedBytes()).toBe(0);
+  });
+});
+
+describe('ProjectContextBuilder analysis index reuse', () => {
+  beforeAll(() => {
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+  });
+
+  test('parses the cache file once until its mtime or size changes, and the index can be shed', async () => {
+    const cache: ProjectAnalysisCache = { overallSummary: 'o', entries: [{ filePath: 'a.ts', type: 'text_analyze', size: 10, loc: 1, summary: 'sum', lastAnalyzed: 'n' }] };
+    let stats = { mtimeMs: 1, size: 100 };
+    const fsMock: any = { stat: jest.fn(async () => stats), readAnalysisCache: jest.fn().mockResolvedValue(cache) };
+    let heapUsed = 0;
+    const governor = new MemoryGovernor({ budgetBytes: 100 * 1024 * 1024, heapUsed: () => heapUsed, quiet: true });
+    const builder = new ProjectContextBuilder(fsMock, {} as any, '/r', {
+      analysis: { cache_file_path: 'c.json' }, context: { mode: 'auto' }, gemini: { max_prompt_tokens: 32000 }, project: {},
+    } as any, {} as any, governor);
+
+    const first = await builder.buildContext('Summarize the architecture'); // Auto mode reads the cache twice
+    expect((await builder.buildContext('Summarize the architecture')).context).toBe(first.context);
+    expect(fsMock.readAnalysisCache).toHaveBeenCalledTimes(1);
+
+    stats = { mtimeMs: 2, size: 100 };
+    await builder.buildContext('Summarize the architecture');
+    expect(fsMock.readAnalysisCache).toHaveBeenCalledTimes(2);
+
+    heapUsed = 100 * 1024 * 1024;
+    governor.relieve();
+    expect(governor.cachedBytes()).toBe(0);
+    await builder.buildContext('Summarize the architecture');
+    expect(fsMock.readAnalysisCache).toHaveBeenCalledTimes(3);
+  });
+});
+
+describe('ProjectContextBuilder tokens saved', () => {
+  beforeAll(() => {
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+  });
+
+  test('reports each build against its own full-context estimate', async () => {
+    metrics.reset();
+    const cache: ProjectAnalysisCache = { overallSummary: 'o', entries: [
+      { filePath: 'a.ts', type: 'text_analyze', size: 40000, loc: 900, summary: 'sum', lastAnalyzed: 'n' },
+      { filePath: 'logo.png', type: 'binary', size: 90000, loc: null, summary: null, lastAnalyzed: 'n' },
+    ] };
+    const fsMock: any = { stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn().mockResolvedValue(cache) };
+    const builder = new ProjectContextBuilder(fsMock, {} as any, '/r', {
+      analysis: { cache_file_path: 'c.json' }, context: { mode: 'analysis_cache' }, gemini: {}, project: {},
+    } as any, {} as any);
+
+    const [first, second] = await Promise.all([builder.buildContext(), builder.buildContext()]);
+    const fullTokens = Math.ceil(40000 * ESTIMATED_TOKENS_PER_BYTE); // Binary files are never sent
+    expect(first.fullTokenEstimate).toBe(fullTokens);
+    expect(second.fullTokenEstimate).toBe(fullTokens);
+    expect(metrics.counter('context.tokens_saved', { mode: 'analysis_cache' })).toBe(2 * (fullTokens - first.tokenCount));
+  });
+});
+
+describe('ProjectContextBuilder relevance feedback', () => {
+  beforeAll(() => {
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+    jest.spyOn(console, 'warn').mockImplementation(() => {});
+  });
+
+  test('hints learned files, lets them claim the budget first and records the selection', async () => {
+    const entry = (filePath: string) => ({ filePath, type: 'text_analyze' as const, size: 10, loc: 1, summary: 's', lastAnalyzed: 'n' });
+    const cache: ProjectAnalysisCache = { overallSummary: 'o', entries: [entry('a.ts'), entry('b.ts')] };
+    const past = { timestamp: 't', query: 'parser', terms: ['parser'], tokens: 1, precision: 1, recall: 1, referenced: [] };
+    const feedback = new RelevanceFeedback();
+    jest.spyOn(feedback, 'getModel').mockResolvedValue(new RelevanceModel([
+      { ...past, selected: ['a.ts', 'b.ts'], changed: ['a.ts'] },
+      { ...past, selected: ['a.ts', 'b.ts'], changed: ['a.ts'] },
+    ]));
+    const big = 'token '.repeat(500);
+    const fsMock: any = {
+      stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn().mockResolvedValue(cache),
+      readFile: jest.fn().mockResolvedValue(null),
+      readFileContents: jest.fn().mockResolvedValue({ '/r/a.ts': big, '/r/b.ts': big }),
+    };
+    const aiClient: any = { getResponseTextFromAI: jest.fn().mockResolvedValue('b.ts\na.ts') };
+    const builder = new ProjectContextBuilder(fsMock, {} as any, '/r', {
+      analysis: { cache_file_path: 'c.json' }, context: { mode: 'dynamic' }, gemini: { max_prompt_tokens: 900 }, project: {},
+    } as any, aiClient, new MemoryGovernor({ quiet: true }), feedback);
+
+    const res = await builder.buildContext('fix the parser', null, 'chat.jsonl');
+    expect(aiClient.getResponseTextFromAI.mock.calls[0][0][0].content).toContain('FILES THAT WERE NEEDED FOR SIMILAR PAST REQUESTS (hints only; include them if they fit this query):\na.ts');
+    expect(res.context).toContain('File: a.ts');
+    expect(res.context).not.toContain('File: b.ts');
+    expect(feedback.pendingCount('chat.jsonl')).toBe(1);
+
+    await builder.buildDynamicContext('Consolidate recent conversation changes', null, null);
+    expect(feedback.pendingCount()).toBe(1);
+  });
+});
+
+describe('ProjectContextBuilder workspace scope', () => {
+  beforeAll(() => {
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+  });
+
+  test('a workspace scope merges package caches and only scans package directories', async () => {
+    const entry = (filePath: string) => ({ filePath, type: 'text_analyze' as const, size: 10, loc: 1, summary: 's', lastAnalyzed: 'n' });
+    const caches: Record<string, ProjectAnalysisCache> = {
+      [path.resolve('/r', '.kai/workspaces/acme__api/project_analysis.json')]: { overallSummary: 'api pkg', entries: [entry('packages/api/index.ts')] },
+      [path.resolve('/r', 'c.json')]: { overallSummary: 'root', entries: [entry('packages/core/util.ts'), entry('packages/web/app.ts')] },
+    };
+    const fsMock: any = {
+      stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn(async (p: string) => caches[p] ?? null),
+      getProjectFiles: jest.fn().mockResolvedValue([]),
+      readFileContents: jest.fn().mockResolvedValue({}),
+    };
+    const gitMock: any = { getIgnoreRules: jest.fn().mockResolvedValue({ ignores: () => false }) };
+    const builder = new ProjectContextBuilder(fsMock, gitMock, '/r', {
+      analysis: { cache_file_path: 'c.json' }, context: { mode: 'analysis_cache' }, gemini: {}, project: {},
+    } as any, {} as any);
+    builder.setScope([
+      { name: '@acme/api', dir: 'packages/api', dependencies: ['@acme/core'] },
+      { name: '@acme/core', dir: 'packages/core', dependencies: [] },
+    ]);
+
+    const res = await builder.buildContext();
+    expect(res.context).toContain('api pkg');
+    expect(res.context).toContain('File: packages/api/index.ts');
+    expect(res.context).toContain('File: packages/core/util.ts'); // From the root cache, no package cache yet
+    expect(res.context).not.toContain('packages/web');
+
+    await builder.estimateFullContextTokens();
+    expect(fsMock.getProjectFiles.mock.calls.map((c: any[]) => c[0])).toEqual([path.join('/r', 'packages/api'), path.join('/r', 'packages/core')]);
+    const tools = await builder.createRetrievalTools();
+    const [web] = await tools.executeAll([{ name: 'read_file', args: { path: 'packages/web/app.ts' } }]);
+    expect(web.response.error).toMatch(/outside the workspace scope/);
+    builder.setScope(null);
+    expect(builder.getScope()).toBeNull();
+  });
+
+  test('dynamic selections outside the workspace scope are not read into context', async () => {
+    const entry = (filePath: string) => ({ filePath, type: 'text_analyze' as const, size: 10, loc: 1, summary: 's', lastAnalyzed: 'n' });
+    const fsMock: any = {
+      stat: jest.fn().mockResolvedValue(null),
+      readAnalysisCache: jest.fn(async (p: string) => p === path.resolve('/r', 'c.json')
+        ? { overallSummary: 'root', entries: [entry('packages/api/index.ts'), entry('packages/web/app.ts')] }
+        : null),
+      readFile: jest.fn().mockResolvedValue(null), // Kai-dynamic.md not present
+      readFileContents: jest.fn().mockResolvedValue({ [path.resolve('/r', 'packages/api/index.ts')]: 'export const api = 1;' }),
+    };
+    const aiClient: any = { getResponseTextFromAI: jest.fn().mockResolvedValue('packages/web/app.ts\npackages/api/index.ts') };
+    const builder = new ProjectContextBuilder(fsMock, {} as any, '/r', {
+      analysis: { cache_file_path: 'c.json' }, context: { mode: 'dynamic' }, gemini: {}, project: {},
+    } as any, aiClient, undefined, new RelevanceFeedback());
+    builder.setScope([{ name: '@acme/api', dir: 'packages/api', dependencies: [] }]);
+    jest.spyOn(console, 'warn').mockImplementation(() => {});
+
+    const res = await builder.buildDynamicContext('q', null);
+    expect(fsMock.readFileContents).toHaveBeenCalledWith([path.resolve('/r', 'packages/api/index.ts')], expect.any(Number));
+    expect(res.context).toContain('File: packages/api/index.ts');
+    expect(res.context).not.toContain('packages/web/app.ts');
+  });
+});
@@ -1,9 +1,10 @@
 import path from 'path';
 import { ProjectContextBuilder } from '../ProjectContextBuilder';
 import { ProjectAnalysisCache } from '../analysis/types';
+import { AnalysisIndex } from '../analysis/AnalysisIndex';
 
 describe('ProjectContextBuilder.buildContext (analysis_cache mode)', () => {
-  const fsMock = { readAnalysisCache: jest.fn() } as any;
+  const fsMock = { stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn() } as any;
   const gitMock = {} as any;
   const aiClient = {} as any;
   const config: any = {
@@ -43,7 +44,7 @@ describe('ProjectContextBuilder.buildContext (analysis_cache mode)', () => {
 });
 
 describe('ProjectContextBuilder utilities', () => {
-  const fsMock = { readAnalysisCache: jest.fn() } as any;
+  const fsMock = { stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn() } as any;
   const gitMock = {} as any;
   const aiClient = { getResponseTextFromAI: jest.fn() } as any;
   const config: any = {
@@ -70,7 +71,7 @@ describe('ProjectContextBuilder utilities', () => {
         { filePath: 'a.ts', type: 'text_analyze', size: 2048, loc: 10, summary: 'details', lastAnalyzed: 'now' }
       ]
     };
-    const summary = (builder as any)._formatCacheForRelevance(cache);
+    const summary = (builder as any)._formatCacheForRelevance(AnalysisIndex.fromCache(cache));
     expect(summary).toContain('a.ts [text analyze]');
     expect(summary).toContain('Summary: details');
   });
@@ -83,8 +84,9 @@ describe('ProjectContextBuilder utilities', () => {
 
 describe('ProjectContextBuilder.buildContext other modes', () => {
   const fsMock: any = {
-    readAnalysisCache: jest.fn(),
+    stat: jest.fn().mockResolvedValue(null), readAnalysisCache: jest.fn(),
     getProjectFiles: jest.fn(),
+    totalFileSize: jest.fn().mockResolvedValue(4),
     readFileContents: jest.fn(),
   };
   const gitMock: any = { getIgnoreRules: jest.fn() };
@@ -278,6 +278,18 @@ describe('UserInterface', () => {
       expect(res).toBeNull();
     });
 
+    it('returns View Stats selection', async () => {
+      (inquirer.prompt as jest.Mock).mockResolvedValueOnce({ mode: 'View Stats' });
+      const res = await ui.getUserInteraction();
+      expect(res).toEqual({ mode: 'View Stats' });
+    });
+
+    it('returns Toggle Profiling selection', async () => {
+      (inquirer.prompt as jest.Mock).mockResolvedValueOnce({ mode: 'Toggle Profiling' });
+      const res = await ui.getUserInteraction();
+      expect(res).toEqual({ mode: 'Toggle Profiling' });
+    });
+
     it('handles Re-run Project Analysis', async () => {
       (inquirer.prompt as jest.Mock).mockResolvedValueOnce({ mode: 'Re-run Project Analysis' });
       const res = await ui.getUserInteraction();
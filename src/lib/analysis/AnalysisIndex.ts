@@ -0,0 +1,169 @@
+// File: src/lib/analysis/AnalysisIndex.ts
+import { AnalysisCacheEntry, ProjectAnalysisCache, SymbolEntry } from './types';
+import { PathTable } from '../memory/PathTable';
+import { StringPool, growArray } from '../memory/StringPool';
+
+const INITIAL_ROWS = 1024;
+const NO_LOC = -1;
+const NO_SUMMARY = -1;
+const BYTES_PER_SYMBOL = 200; // Rough heap cost of a SymbolEntry with its strings
+
+/**
+ * Column-oriented, read-only view of an analysis cache. Paths are interned in a PathTable;
+ * type codes, sizes, LOC and analysis times live in typed arrays; summaries are kept as UTF-8
+ * in a StringPool and only become strings when read. Symbols (large files only) stay objects.
+ * At a million entries this is tens of MB instead of the hundreds an entry array needs, so
+ * context building and retrieval can hold it, and `entry(row)` materialises one when needed.
+ */
+export class AnalysisIndex implements Iterable<AnalysisCacheEntry> {
+    overallSummary: string | null;
+    readonly paths = new PathTable();
+    private count = 0;
+    private pathIds = new Int32Array(INITIAL_ROWS);
+    private rowByPath = new Int32Array(INITIAL_ROWS);   // First row per path id
+    private typeCodes = new Uint8Array(INITIAL_ROWS);
+    private typeNames: AnalysisCacheEntry['type'][] = ['binary', 'text_large', 'text_analyze'];
+    private sizes = new Float64Array(INITIAL_ROWS);
+    private locs = new Int32Array(INITIAL_ROWS);
+    private analyzedAt = new Float64Array(INITIAL_ROWS); // Epoch ms; NaN when the stored text is not an ISO timestamp
+    private odd = new Map<number, string>();            // Those timestamps, verbatim
+    private summaries = new StringPool();
+    private summaryIds = new Int32Array(INITIAL_ROWS);
+    private summaryChars = new Int32Array(INITIAL_ROWS); // UTF-16 length, so size estimates need no decoding
+    private symbolsByRow = new Map<number, SymbolEntry[]>();
+
+    constructor(overallSummary: string | null = null) {
+        this.overallSummary = overallSummary;
+    }
+
+    static fromCache(cache: ProjectAnalysisCache): AnalysisIndex {
+        const index = new AnalysisIndex(cache.overallSummary);
+        for (const entry of cache.entries) index.add(entry);
+        return index;
+    }
+
+    get length(): number {
+        return this.count;
+    }
+
+    add(entry: AnalysisCacheEntry): number {
+        const row = this.count++;
+        this._reserve(this.count);
+        const knownPaths = this.paths.size;
+        const pathId = this.paths.add(entry.filePath);
+        this.pathIds[row] = pathId;
+        if (pathId === knownPaths) { // First entry for this path
+            this.rowByPath = growArray(this.rowByPath, this.paths.size);
+            this.rowByPath[pathId] = row;
+        }
+
+        let code = this.typeNames.indexOf(entry.type);
+        if (code === -1) code = this.typeNames.push(entry.type) - 1;
+        this.typeCodes[row] = code;
+        this.sizes[row] = entry.size;
+        this.locs[row] = entry.loc ?? NO_LOC;
+
+        const time = Date.parse(entry.lastAnalyzed);
+        if (!Number.isNaN(time) && new Date(time).toISOString() === entry.lastAnalyzed) {
+            this.analyzedAt[row] = time;
+        } else {
+            this.analyzedAt[row] = NaN;
+            this.odd.set(row, entry.lastAnalyzed);
+        }
+
+        if (entry.summary === null || entry.summary === undefined) {
+            this.summaryIds[row] = NO_SUMMARY;
+            this.summaryChars[row] = 0;
+        } else {
+            this.summaryIds[row] = this.summaries.add(entry.summary);
+            this.summaryChars[row] = entry.summary.length;
+        }
+        if (entry.symbols) this.symbolsByRow.set(row, entry.symbols);
+        return row;
+    }
+
+    /** Row of the first entry for `filePath`, or -1. */
+    rowOf(filePath: string): number {
+        const pathId = this.paths.indexOf(filePath);
+        return pathId === -1 ? -1 : this.rowByPath[pathId];
+    }
+
+    filePath(row: number): string {
+        return this.paths.get(this.pathIds[row]);
+    }
+
+    type(row: number): AnalysisCacheEntry['type'] {
+        return this.typeNames[this.typeCodes[row]];
+    }
+
+    size(row: number): number {
+        return this.sizes[row];
+    }
+
+    loc(row: number): number | null {
+        return this.locs[row] === NO_LOC ? null : this.locs[row];
+    }
+
+    summary(row: number): string | null {
+        const id = this.summaryIds[row];
+        return id === NO_SUMMARY ? null : this.summaries.get(id);
+    }
+
+    /** Length of the summary in characters (0 when there is none), without decoding it. */
+    summaryLength(row: number): number {
+        return this.summaryChars[row];
+    }
+
+    symbols(row: number): SymbolEntry[] | undefined {
+        return this.symbolsByRow.get(row);
+    }
+
+    lastAnalyzed(row: number): string {
+        const time = this.analyzedAt[row];
+        return Number.isNaN(time) ? this.odd.get(row)! : new Date(time).toISOString();
+    }
+
+    /** Materialises one entry as the cache file stores it. */
+    entry(row: number): AnalysisCacheEntry {
+        const entry: AnalysisCacheEntry = {
+            filePath: this.filePath(row),
+            type: this.type(row),
+            size: this.size(row),
+            loc: this.loc(row),
+            summary: this.summary(row),
+            lastAnalyzed: this.lastAnalyzed(row),
+        };
+        const symbols = this.symbols(row);
+        if (symbols) entry.symbols = symbols;
+        return entry;
+    }
+
+    *[Symbol.iterator](): Iterator<AnalysisCacheEntry> {
+        for (let row = 0; row < this.count; row++) yield this.entry(row);
+    }
+
+    /** Back to the cache file structure (materialises every entry). */
+    toCache(): ProjectAnalysisCache {
+        return { overallSummary: this.overallSummary, entries: [...this] };
+    }
+
+    /** Approximate bytes held. */
+    sizeBytes(): number {
+        let symbolCount = 0;
+        for (const symbols of this.symbolsByRow.values()) symbolCount += symbols.length;
+        return this.paths.sizeBytes() + this.summaries.sizeBytes()
+            + this.pathIds.byteLength + this.rowByPath.byteLength + this.typeCodes.byteLength + this.sizes.byteLength
+            + this.locs.byteLength + this.analyzedAt.byteLength + this.summaryIds.byteLength + this.summaryChars.byteLength
+            + symbolCount * BYTES_PER_SYMBOL;
+    }
+
+    private _reserve(rows: number): void {
+        this.pathIds = growArray(this.pathIds, rows);
+        this.typeCodes = growArray(this.typeCodes, rows);
+        this.sizes = growArray(this.sizes, rows);
+        this.locs = growArray(this.locs, rows);
+        this.analyzedAt = growArray(this.analyzedAt, rows);
+        this.summaryIds = growArray(this.summaryIds, rows);
+        this.summaryChars = growArray(this.summaryChars, rows);
+    }
+}
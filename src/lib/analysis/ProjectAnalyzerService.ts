@@ -1,14 +1,20 @@
 // src/lib/analysis/ProjectAnalyzerService.ts
 import path from 'path';
 import chalk from 'chalk';
+import { tracer } from '../telemetry/Tracer';
+import { profiler } from '../telemetry/Profiler';
 // import fs from 'fs/promises'; // Removed unused import
 import { Config } from '../Config';
 import { FileSystem } from '../FileSystem';
 import { CommandService } from '../CommandService';
 import { GitService } from '../GitService'; // <-- ADDED GitService Import
 import { AIClient } from '../AIClient';
-import { AnalysisCacheEntry, ProjectAnalysisCache } from './types';
+import { AnalysisCacheEntry, ProjectAnalysisCache, SymbolEntry } from './types';
 import { AnalysisPrompts } from './prompts'; // Use the new prompts file
+import { SyntaxChunker } from './SyntaxChunker';
+import { SummaryCache } from './SummaryCache';
+import { WorkspaceDetector, WorkspacePackage } from '../workspace/WorkspaceDetector';
+import { taskScheduler } from '../scheduling/TaskScheduler';
 import { countTokens } from '../utils'; // Needed if we add token limits later
 
 // Simple thresholds for this milestone (can be adjusted/made configurable later)
@@ -17,6 +23,18 @@ const LARGE_FILE_SIZE_THRESHOLD_BYTES = 100 * 1024; // 100 KB
 const LARGE_FILE_LOC_THRESHOLD = 5000; // 5000 lines
 const MAX_FILE_SIZE_FOR_BATCH_BYTES = 150 * 1024; // Max individual file size to include in batching (150KB) - Used in Phase 2
 const BATCH_TOKEN_TARGET_PERCENTAGE = 0.75; // Target 75% of max prompt tokens for safety buffer
+const SYMBOL_MIN_FILE_LOC = 200; // Smaller files are cheap enough to include whole
+const SYMBOL_SNIPPET_MAX_LINES = 40; // Lines of each symbol sent for its one-line summary
+const LARGE_FILE_SUMMARY_MAX_CHARS = 500;
+const WORKSPACE_ANALYSIS_CONCURRENCY = 3; // Packages analysed at once (each batches its own AI calls)
+const ANALYSIS_LOCK_TIMEOUT_MS = 30 * 60 * 1000; // Another process's full analysis pass can take a while
+
+/** Restricts a run to one directory and writes its own cache (per-package analysis). */
+interface AnalysisScope {
+    label: string;
+    dir: string; // Relative to the project root
+    cacheFilePath: string; // Relative to the project root
+}
 
 
 export class ProjectAnalyzerService {
@@ -26,13 +44,18 @@ export class ProjectAnalyzerService {
     private gitService: GitService; // <-- ADDED GitService instance variable
     private aiClient: AIClient;
     private projectRoot: string;
+    private chunker: SyntaxChunker;
+    private summaryCache: SummaryCache | null;
+    private blobHashes = new Map<string, string>(); // Relative path -> git blob hash (shared cache only)
+    private summaryVersions: { file: string; symbol: string } | null = null; // Set per run
 
     constructor(
         config: Config,
         fsUtil: FileSystem,
         commandService: CommandService,
         gitService: GitService, // <-- ADDED GitService parameter
-        aiClient: AIClient
+        aiClient: AIClient,
+        summaryCache?: SummaryCache | null // Defaults to the user-level cache when analysis.shared_summary_cache is on
     ) {
         this.config = config;
         this.fsUtil = fsUtil;
@@ -40,6 +63,10 @@ export class ProjectAnalyzerService {
         this.gitService = gitService; // <-- Assign GitService
         this.aiClient = aiClient;
         this.projectRoot = process.cwd();
+        this.chunker = new SyntaxChunker(this.projectRoot);
+        this.summaryCache = summaryCache !== undefined
+            ? summaryCache
+            : config.analysis?.shared_summary_cache === true ? new SummaryCache() : null;
     }
 
     /**
@@ -49,8 +76,50 @@ export class ProjectAnalyzerService {
      * Phase 3: Cache Assembly & Saving
      */
     async analyzeProject(): Promise<void> {
-        console.log(chalk.cyan("\n🚀 Starting project analysis (Milestone 2)..."));
-        const cacheFilePath = path.resolve(this.projectRoot, this.config.analysis.cache_file_path);
+        this.blobHashes.clear();
+        // Background priority: summaries and symbol parsing yield to chat turns and consolidation
+        return taskScheduler.withPriority('background', () => profiler.around('analysis', () => this._analyzeProject()));
+    }
+
+    /**
+     * Analyses workspace packages independently, each into its own cache under
+     * `.kai/workspaces/<package>/`, running a few packages in parallel. The root cache is untouched.
+     */
+    async analyzeWorkspacePackages(packages: WorkspacePackage[]): Promise<void> {
+        this.blobHashes.clear();
+        const scopes: AnalysisScope[] = packages.map(pkg => ({ label: pkg.name, dir: pkg.dir, cacheFilePath: WorkspaceDetector.cachePathFor(pkg) }));
+        console.log(chalk.cyan(`\n📦 Analysing ${scopes.length} workspace package(s), up to ${WORKSPACE_ANALYSIS_CONCURRENCY} at a time...`));
+        await taskScheduler.withPriority('background', () => profiler.around('analysis', async () => {
+            let next = 0;
+            const worker = async () => {
+                while (next < scopes.length) {
+                    const scope = scopes[next++];
+                    await tracer.span('analysis.package', 'analysis', () => this._analyzeProject(scope), { package: scope.label });
+                }
+            };
+            await Promise.all(Array.from({ length: Math.min(WORKSPACE_ANALYSIS_CONCURRENCY, scopes.length) }, worker));
+        }));
+        console.log(chalk.green(`✅ Workspace analysis finished for: ${scopes.map(s => s.label).join(', ')}`));
+    }
+
+    /**
+     * Holds the cache file's lock for the whole pass, so two Kai processes (CLI or Desktop)
+     * never analyse the same scope at once and overwrite each other's cache mid-pass.
+     */
+    private async _analyzeProject(scope?: AnalysisScope): Promise<void> {
+        const cacheFilePath = path.resolve(this.projectRoot, scope?.cacheFilePath ?? this.config.analysis.cache_file_path);
+        try {
+            await this.fsUtil.withLock(cacheFilePath, () => this._runAnalysis(cacheFilePath, scope), {
+                timeoutMs: ANALYSIS_LOCK_TIMEOUT_MS,
+                onWait: holder => console.log(chalk.yellow(`  Another Kai process (${holder}) is analysing ${scope?.label ?? 'this project'}; waiting for it to finish...`)),
+            });
+        } catch (error) {
+            console.error(chalk.red("\n❌ Could not start project analysis:"), error);
+        }
+    }
+
+    private async _runAnalysis(cacheFilePath: string, scope?: AnalysisScope): Promise<void> {
+        console.log(chalk.cyan(scope ? `\n🚀 Starting analysis of package ${scope.label} (${scope.dir})...` : "\n🚀 Starting project analysis (Milestone 2)..."));
         const allEntries: AnalysisCacheEntry[] = []; // Holds all entries (binary, large, analyzed)
         const timestamp = new Date().toISOString();
         let overallSummary: string | null = null; // Placeholder for M2
@@ -58,7 +127,7 @@ export class ProjectAnalyzerService {
         try {
             // === Phase 1: Inventory and Classification ===
             console.log(chalk.blue("  Phase 1: Inventorying and classifying files..."));
-            const initialInventory = await this._gatherInitialInventory(timestamp);
+            const initialInventory = await tracer.span('analysis.inventory', 'analysis', () => this._gatherInitialInventory(timestamp, scope?.dir));
             if (!initialInventory || initialInventory.length === 0) {
                 console.log(chalk.yellow("  No files found to analyze (after filtering). Creating empty cache."));
                 // Write empty cache if nothing found
@@ -66,6 +135,10 @@ export class ProjectAnalyzerService {
                 return;
             }
             allEntries.push(...initialInventory); // Add all classified entries
+            if (this.summaryCache) {
+                this.summaryVersions = await this._summaryVersions();
+                console.log(chalk.dim(`  Shared summary cache: ${this.summaryCache.dir}`));
+            }
 
             // Identify files needing summary
             const filesToSummarize = allEntries.filter(entry => entry.type === 'text_analyze');
@@ -75,9 +148,18 @@ export class ProjectAnalyzerService {
 
             // === Phase 2: Summary Generation using Batching (for 'text_analyze' files) ===
             console.log(chalk.blue("\n  Phase 2: Generating summaries for suitable files using batching..."));
-            let { analyzedCount, errorCount } = await this._runSummaryGeneration(filesToSummarize, allEntries);
+            let { analyzedCount, errorCount } = await tracer.span('analysis.summaries', 'analysis', () => this._runSummaryGeneration(filesToSummarize, allEntries), { files: filesToSummarize.length });
             console.log(chalk.blue(`\nSummary generation finished. Summarized: ${analyzedCount}, Errors during summary: ${errorCount}.`));
-            overallSummary = `Analysis Pass Completed: ${analyzedCount} files summarized, ${allEntries.length - filesToSummarize.length} binary/large files listed.`;
+
+            // === Phase 2b: One-line summaries for symbols of larger files ===
+            const symbolCount = allEntries.reduce((sum, e) => sum + (e.symbols?.length ?? 0), 0);
+            if (symbolCount > 0) {
+                console.log(chalk.blue(`\n  Phase 2b: Summarizing ${symbolCount} symbols from larger files...`));
+                const symbolResult = await tracer.span('analysis.symbolSummaries', 'analysis', () => this._runSymbolSummaries(allEntries), { symbols: symbolCount });
+                console.log(chalk.blue(`Symbol summaries finished. Summarized: ${symbolResult.analyzedCount}, Errors: ${symbolResult.errorCount}.`));
+                this._summarizeLargeFilesFromSymbols(allEntries);
+            }
+            overallSummary = `${scope ? `Package ${scope.label} (${scope.dir}): ` : ''}Analysis Pass Completed: ${analyzedCount} files summarized, ${allEntries.length - filesToSummarize.length} binary/large files listed.`;
 
             // === Phase 3: Cache Assembly & Saving ===
             console.log(chalk.blue("\n  Phase 3: Assembling and saving cache..."));
@@ -86,7 +168,7 @@ export class ProjectAnalyzerService {
                 entries: allEntries.sort((a, b) => a.filePath.localeCompare(b.filePath)) // Sort entries by path
             };
 
-            await this.fsUtil.writeAnalysisCache(cacheFilePath, finalCache);
+            await tracer.span('analysis.saveCache', 'analysis', () => this.fsUtil.writeAnalysisCache(cacheFilePath, finalCache), { entries: finalCache.entries.length });
             console.log(chalk.green(`✅ Project analysis complete. Cache saved to ${cacheFilePath}`));
 
         } catch (error) {
@@ -96,8 +178,8 @@ export class ProjectAnalyzerService {
     }
 
     /** Phase 1: Get file list, stats, and classify */
-    private async _gatherInitialInventory(timestamp: string): Promise<AnalysisCacheEntry[]> {
-        const rawFileList = await this._listFiles(); // Already filtered by ignore rules
+    private async _gatherInitialInventory(timestamp: string, subdir?: string): Promise<AnalysisCacheEntry[]> {
+        const rawFileList = await this._listFiles(subdir); // Already filtered by ignore rules
         if (!rawFileList || rawFileList.length === 0) return [];
 
         const inventory: AnalysisCacheEntry[] = [];
@@ -120,6 +202,7 @@ export class ProjectAnalyzerService {
         let fileType: AnalysisCacheEntry['type'] = 'binary'; // Default
         let size = 0;
         let loc: number | null = null;
+        let symbols: SymbolEntry[] | undefined;
 
         try {
             const stats = await this.fsUtil.stat(absolutePath);
@@ -140,6 +223,11 @@ export class ProjectAnalyzerService {
                 const content = await this.fsUtil.readFile(absolutePath);
                 if (content !== null) {
                     loc = content.split('\n').length;
+                    if (this.summaryCache) this.blobHashes.set(relativePath, SummaryCache.blobHash(content));
+                    if (loc >= SYMBOL_MIN_FILE_LOC && SyntaxChunker.supports(relativePath)) {
+                        const extracted = await taskScheduler.run(() => this.chunker.extractPublicSymbols(relativePath, content), { kind: 'cpu', label: 'analysis.symbols' });
+                        if (extracted.length > 0) symbols = extracted;
+                    }
                     if (size > LARGE_FILE_SIZE_THRESHOLD_BYTES || loc > LARGE_FILE_LOC_THRESHOLD) {
                         fileType = 'text_large';
                         console.log(chalk.grey(`    Classified as Large Text: ${relativePath} (Size: ${(size/1024).toFixed(1)}KB, LOC: ${loc})`));
@@ -179,6 +267,7 @@ export class ProjectAnalyzerService {
             loc: loc,
             summary: null, // Summary generated later in Phase 2
             lastAnalyzed: timestamp,
+            ...(symbols && fileType !== 'binary' ? { symbols } : {}),
         };
     }
 
@@ -199,7 +288,28 @@ export class ProjectAnalyzerService {
              return { analyzedCount, errorCount };
         }
 
+        // Summaries already produced by any checkout of this content skip the AI entirely
+        const sharedHits = await this._applySharedSummaries(filesToSummarize);
+        if (sharedHits > 0) {
+            analyzedCount += sharedHits;
+            filesToSummarize = filesToSummarize.filter(entry => entry.summary === null);
+            console.log(chalk.blue(`    Reused ${sharedHits} summaries from the shared cache; ${filesToSummarize.length} files left for the AI.`));
+        }
+
         // --- Batching Logic ---
+        // Batches are sent concurrently, up to one per pooled API key; with one key they run in turn
+        const maxInFlight = Math.max(1, this.aiClient.modelParallelism());
+        const inFlight = new Set<Promise<void>>();
+        const dispatchBatch = async (files: AnalysisCacheEntry[], content: string) => {
+            const batch = this._processBatch(files, content, allEntries, timestamp).then(result => {
+                analyzedCount += result.successCount;
+                errorCount += result.errorCount;
+            });
+            inFlight.add(batch);
+            batch.finally(() => inFlight.delete(batch)).catch(() => {}); // _processBatch reports its own failures
+            if (inFlight.size >= maxInFlight) await Promise.race(inFlight);
+        };
+
         let currentBatchFiles: AnalysisCacheEntry[] = [];
         let currentBatchContent = "";
         let currentBatchTokenEstimate = BASE_PROMPT_TOKEN_ESTIMATE; // Start with base prompt estimate
@@ -230,9 +340,7 @@ export class ProjectAnalyzerService {
             if (currentBatchFiles.length > 0 && (currentBatchTokenEstimate + estimatedTotalCost) > maxBatchTokens) {
                 // Process the current batch *before* adding the new file
                 console.log(chalk.cyan(`    Batch full (${currentBatchFiles.length} files, ~${currentBatchTokenEstimate.toFixed(0)} tokens). Processing...`));
-                const batchResult = await this._processBatch(currentBatchFiles, currentBatchContent, allEntries, timestamp);
-                analyzedCount += batchResult.successCount;
-                errorCount += batchResult.errorCount;
+                await dispatchBatch(currentBatchFiles, currentBatchContent);
 
                 // Reset for the next batch
                 currentBatchFiles = [];
@@ -262,9 +370,7 @@ export class ProjectAnalyzerService {
                 if (currentBatchFiles.length > 0 && (currentBatchTokenEstimate + actualFileBlockTokens) > maxBatchTokens) {
                      // Process the previous batch first if adding this specific file overflows
                      console.log(chalk.cyan(`    Batch full just before adding ${fileInfo.filePath} (${currentBatchFiles.length} files, ~${currentBatchTokenEstimate.toFixed(0)} tokens). Processing...`));
-                     const batchResult = await this._processBatch(currentBatchFiles, currentBatchContent, allEntries, timestamp);
-                     analyzedCount += batchResult.successCount;
-                     errorCount += batchResult.errorCount;
+                     await dispatchBatch(currentBatchFiles, currentBatchContent);
                      // Reset for the new batch starting with the current file
                      currentBatchFiles = [];
                      currentBatchContent = "";
@@ -302,10 +408,9 @@ export class ProjectAnalyzerService {
         // Process the final batch if it has files
         if (currentBatchFiles.length > 0) {
             console.log(chalk.cyan(`    Processing final batch (${currentBatchFiles.length} files, ~${currentBatchTokenEstimate.toFixed(0)} tokens)...`));
-            const batchResult = await this._processBatch(currentBatchFiles, currentBatchContent, allEntries, timestamp);
-            analyzedCount += batchResult.successCount;
-            errorCount += batchResult.errorCount;
+            await dispatchBatch(currentBatchFiles, currentBatchContent);
         }
+        await Promise.all(inFlight);
         // --- End Batching Logic ---
 
         return { analyzedCount, errorCount };
@@ -356,6 +461,7 @@ export class ProjectAnalyzerService {
                 if (summary) {
                      allEntries[entryIndex].summary = summary;
                      allEntries[entryIndex].lastAnalyzed = timestamp; // Update timestamp on successful summary
+                     await this._storeSharedSummary(fileInfo.filePath, 'file', summary);
                      successCount++;
                 } else {
                      // AI missed summary or parsing failed for this file
@@ -379,6 +485,155 @@ export class ProjectAnalyzerService {
         return { successCount, errorCount: batchErrorCount };
     }
 
+    /**
+     * Phase 2b: Summarizes extracted symbols in token-bounded batches. Each symbol is sent as its
+     * signature plus the first lines of its body, and keyed as `<filePath>#<symbolName>`.
+     */
+    private async _runSymbolSummaries(allEntries: AnalysisCacheEntry[]): Promise<{ analyzedCount: number; errorCount: number }> {
+        let analyzedCount = 0;
+        let errorCount = 0;
+        const maxBatchTokens = (this.config.gemini.max_prompt_tokens || 32000) * BATCH_TOKEN_TARGET_PERCENTAGE;
+        const BASE_PROMPT_TOKEN_ESTIMATE = 200;
+
+        let batch: Map<string, { filePath: string; symbol: SymbolEntry }> = new Map();
+        let batchContent = "";
+        let batchTokens = BASE_PROMPT_TOKEN_ESTIMATE;
+        const flush = async () => {
+            if (batch.size === 0) return;
+            const result = await this._processSymbolBatch(batch, batchContent);
+            analyzedCount += result.successCount;
+            errorCount += result.errorCount;
+            batch = new Map();
+            batchContent = "";
+            batchTokens = BASE_PROMPT_TOKEN_ESTIMATE;
+        };
+
+        for (const entry of allEntries) {
+            if (!entry.symbols || entry.symbols.length === 0) continue;
+            const content = await this.fsUtil.readFile(path.resolve(this.projectRoot, entry.filePath));
+            if (content === null) {
+                errorCount += entry.symbols.length;
+                continue;
+            }
+            const lines = content.split('\n');
+            for (const symbol of entry.symbols) {
+                const id = `${entry.filePath}#${symbol.name}`;
+                const shared = await this._sharedSummary(entry.filePath, `symbol:${symbol.name}`);
+                if (shared) {
+                    symbol.summary = shared;
+                    analyzedCount++;
+                    continue;
+                }
+                const snippetEnd = Math.min(symbol.endLine, symbol.startLine + SYMBOL_SNIPPET_MAX_LINES - 1);
+                const remaining = symbol.endLine - snippetEnd;
+                const snippet = lines.slice(symbol.startLine - 1, snippetEnd).join('\n') + (remaining > 0 ? `\n[... ${remaining} more lines]` : '');
+                const block = `\n---\nSymbol: ${id}\nKind: ${symbol.kind} (lines ${symbol.startLine}-${symbol.endLine})\n\`\`\`\n${snippet}\n\`\`\`\n`;
+                const blockTokens = countTokens(block);
+                if (batch.size > 0 && batchTokens + blockTokens > maxBatchTokens) await flush();
+                batch.set(id, { filePath: entry.filePath, symbol });
+                batchContent += block;
+                batchTokens += blockTokens;
+            }
+        }
+        await flush();
+        return { analyzedCount, errorCount };
+    }
+
+    /**
+     * Large files are too big for the file-level batches; describe them from their summarized
+     * symbols instead (chunked summarization, no extra AI call).
+     */
+    private _summarizeLargeFilesFromSymbols(allEntries: AnalysisCacheEntry[]): void {
+        for (const entry of allEntries) {
+            if (entry.type !== 'text_large' || entry.summary !== null) continue;
+            const described = (entry.symbols ?? []).filter(s => s.summary && s.kind !== 'method');
+            if (described.length === 0) continue;
+            const parts = described.map(s => `${s.name}: ${s.summary}`);
+            let summary = `Large file (${entry.loc ?? '?'} lines). Key symbols: ${parts.join(' ')}`;
+            if (summary.length > LARGE_FILE_SUMMARY_MAX_CHARS) summary = `${summary.slice(0, LARGE_FILE_SUMMARY_MAX_CHARS - 3)}...`;
+            entry.summary = summary;
+        }
+    }
+
+    /** Sends one batch of symbols to the AI and stores the parsed one-line summaries on the symbols. */
+    private async _processSymbolBatch(
+        batch: Map<string, { filePath: string; symbol: SymbolEntry }>,
+        batchContent: string
+    ): Promise<{ successCount: number, errorCount: number }> {
+        const ids = [...batch.keys()];
+        let successCount = 0;
+        try {
+            console.log(chalk.cyan(`    Summarizing batch of ${ids.length} symbols...`));
+            const response = await this.aiClient.getResponseTextFromAI(
+                [{ role: 'user', content: AnalysisPrompts.batchSummarizeSymbolsPrompt(batchContent, ids) }],
+                true // USE FLASH MODEL for batches
+            );
+            const parsed = this._parseBatchResponse(response, ids);
+            for (const [id, { filePath, symbol }] of batch) {
+                const summary = parsed[id];
+                if (summary) {
+                    symbol.summary = summary;
+                    await this._storeSharedSummary(filePath, `symbol:${symbol.name}`, summary);
+                    successCount++;
+                }
+            }
+        } catch (error) {
+            console.error(chalk.red(`    Error processing symbol batch: ${(error as Error).message}`));
+        }
+        return { successCount, errorCount: ids.length - successCount };
+    }
+
+    // --- Shared (user-level) summary cache ---
+
+    /** Versions covering everything besides content that shapes a summary: prompt template, guidelines, model. */
+    private async _summaryVersions(): Promise<{ file: string; symbol: string }> {
+        let guidelines = '';
+        try {
+            guidelines = (await this.fsUtil.readFile(path.resolve(this.projectRoot, 'Kai-cache.md')))?.trim() ?? '';
+        } catch {
+            // No guidelines file
+        }
+        const model = this.config.gemini.model_name ?? '';
+        return {
+            file: SummaryCache.version(AnalysisPrompts.batchSummarizePrompt('', []), guidelines, model),
+            symbol: SummaryCache.version(AnalysisPrompts.batchSummarizeSymbolsPrompt('', []), model),
+        };
+    }
+
+    private _sharedKey(filePath: string, subject: string): string | null {
+        const blobHash = this.blobHashes.get(filePath);
+        if (!this.summaryCache || !this.summaryVersions || !blobHash) return null;
+        const version = subject === 'file' ? this.summaryVersions.file : this.summaryVersions.symbol;
+        return SummaryCache.key(blobHash, version, subject);
+    }
+
+    private async _sharedSummary(filePath: string, subject: string): Promise<string | null> {
+        const key = this._sharedKey(filePath, subject);
+        return key && this.summaryCache ? this.summaryCache.get(key) : null;
+    }
+
+    private async _storeSharedSummary(filePath: string, subject: string, summary: string): Promise<void> {
+        const key = this._sharedKey(filePath, subject);
+        if (key && this.summaryCache) await this.summaryCache.set(key, summary);
+    }
+
+    /** Fills file summaries from the shared cache (with limited concurrency). Returns the number of hits. */
+    private async _applySharedSummaries(entries: AnalysisCacheEntry[]): Promise<number> {
+        if (!this.summaryCache) return 0;
+        let hits = 0;
+        const CONCURRENCY = 16;
+        for (let i = 0; i < entries.length; i += CONCURRENCY) {
+            await Promise.all(entries.slice(i, i + CONCURRENCY).map(async entry => {
+                const summary = await this._sharedSummary(entry.filePath, 'file');
+                if (summary) {
+                    entry.summary = summary;
+                    hits++;
+                }
+            }));
+        }
+        return hits;
+    }
+
     /** Parses the JSON response from the batch analysis prompt */
     private _parseBatchResponse(
         rawJsonText: string,
@@ -432,8 +687,10 @@ export class ProjectAnalyzerService {
      * Lists project files, prioritizing `phind`, falling back to `find`,
      * and then filtering the results using .gitignore rules.
      * Does NOT use configuration for the command.
+     * @param subdir Optional directory (relative to the project root) to list instead of the whole tree.
      */
-    private async _listFiles(): Promise<string[]> {
+    private async _listFiles(subdir?: string): Promise<string[]> {
+        const listRoot = subdir ? path.resolve(this.projectRoot, subdir) : this.projectRoot;
         let commandToRun: string;
         let commandName: string;
 
@@ -457,7 +714,7 @@ export class ProjectAnalyzerService {
         let rawFileList: string[] = [];
         try {
             console.log(chalk.dim(`    Executing file list command: ${commandToRun}`));
-            const { stdout } = await this.commandService.run(commandToRun, { cwd: this.projectRoot });
+            const { stdout } = await this.commandService.run(commandToRun, { cwd: listRoot });
             rawFileList = stdout.trim().split('\n').filter(line => line.trim() !== '' && line !== '.'); // Filter empty lines and '.'
         } catch (error) {
             console.error(chalk.red(`Error running file listing command "${commandToRun}":`), error);
@@ -468,15 +725,18 @@ export class ProjectAnalyzerService {
         console.log(chalk.dim(`    Filtering ${rawFileList.length} raw files using ignore rules...`));
         const ignoreRules = await this.gitService.getIgnoreRules(this.projectRoot); // Use correct method name
 
-        const filteredList = rawFileList.filter(rawPath => {
-            // Normalize path for consistency (remove leading ./, use POSIX separators)
-            const normalizedPath = path.normalize(rawPath).replace(/^[./\\]+/, '').replace(/\\/g, '/');
+        const prefix = subdir ? `${subdir.replace(/\\/g, '/').replace(/\/+$/, '')}/` : '';
+        const filteredList = rawFileList
+            // Normalize path for consistency (remove leading ./, use POSIX separators), relative to the project root
+            .map(rawPath => {
+                const normalizedPath = path.normalize(rawPath).replace(/^[./\\]+/, '').replace(/\\/g, '/');
+                return normalizedPath ? prefix + normalizedPath : '';
+            })
             // Ensure the path is not empty after normalization and is not ignored
-            return normalizedPath && !ignoreRules.ignores(normalizedPath);
-        });
+            .filter(normalizedPath => normalizedPath && !ignoreRules.ignores(normalizedPath));
 
         console.log(chalk.dim(`    Filtered list size: ${filteredList.length}`));
-        return filteredList.map(p => p.replace(/^[./\\]+/, '').replace(/\\/g, '/')); // Return clean relative paths
+        return filteredList; // Clean relative paths
         // --- End Filter ---
     }
 
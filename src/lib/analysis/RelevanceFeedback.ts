@@ -0,0 +1,247 @@
+// File: src/lib/analysis/RelevanceFeedback.ts
+import fsPromises from 'fs/promises';
+import path from 'path';
+import chalk from 'chalk';
+import { metrics } from '../telemetry/Metrics';
+import { SyntaxChunker } from './SyntaxChunker';
+import { appendLinesLocked } from '../FileLock';
+
+export const RELEVANCE_FEEDBACK_FILE = path.join('.kai', 'relevance_feedback.jsonl');
+const MAX_TRAINING_RECORDS = 1000;
+const MIN_TERM_OBSERVATIONS = 2; // A term must appear in this many turns before it suggests files
+const SUGGESTION_THRESHOLD = 0.5;
+const REPORT_WINDOW = 20;
+const MAX_PENDING_PER_CONVERSATION = 50; // Conversations that never consolidate keep only their latest turns
+
+/** What dynamic context selected for one turn, waiting for the consolidation that follows. */
+export interface SelectionRecord {
+    timestamp: string;
+    query: string;
+    terms: string[];
+    selected: string[]; // Relative file paths (symbol/chunk selections reduced to their file)
+    tokens: number;
+}
+
+/** A selection joined with its outcome; one line of `.kai/relevance_feedback.jsonl`. */
+export interface FeedbackRecord extends SelectionRecord {
+    changed: string[];    // Files the consolidation wrote or deleted
+    referenced: string[]; // Selected files named in the conversation without being changed
+    precision: number;    // Selected files that were changed or referenced
+    recall: number | null; // Changed files that were selected (null when nothing changed)
+}
+
+export interface RelevanceReport {
+    turns: number;
+    precision: number;
+    recall: number | null;
+    avgTokens: number;
+}
+
+/**
+ * Lightweight ranking model learned from feedback records: a smoothed per-file hit rate
+ * (selected and then used) plus per-term file associations (query term -> files that turned
+ * out to be relevant). Scores are in [0, 1]; 0.5 means "no evidence either way".
+ */
+export class RelevanceModel {
+    private fileHits = new Map<string, { selected: number; hits: number }>();
+    private termTurns = new Map<string, number>();
+    private termFiles = new Map<string, Map<string, number>>();
+
+    constructor(records: FeedbackRecord[] = []) {
+        for (const record of records) this.learn(record);
+    }
+
+    get isEmpty(): boolean {
+        return this.termTurns.size === 0 && this.fileHits.size === 0;
+    }
+
+    learn(record: FeedbackRecord): void {
+        const relevant = new Set([...record.changed, ...record.referenced]);
+        for (const file of record.selected) {
+            const stats = this.fileHits.get(file) ?? { selected: 0, hits: 0 };
+            stats.selected++;
+            if (relevant.has(file)) stats.hits++;
+            this.fileHits.set(file, stats);
+        }
+        for (const term of new Set(record.terms)) {
+            this.termTurns.set(term, (this.termTurns.get(term) ?? 0) + 1);
+            const files = this.termFiles.get(term) ?? new Map<string, number>();
+            for (const file of relevant) files.set(file, (files.get(file) ?? 0) + 1);
+            this.termFiles.set(term, files);
+        }
+    }
+
+    /** Blends the file's hit rate with its strongest association to any query term. */
+    score(file: string, terms: string[]): number {
+        const stats = this.fileHits.get(file);
+        const prior = stats ? (stats.hits + 1) / (stats.selected + 2) : 0.5;
+        let association = 0;
+        for (const term of terms) association = Math.max(association, this._association(term, file));
+        return association > 0 ? (prior + association) / 2 : prior;
+    }
+
+    /** Files that were relevant for most past turns sharing a query term, best first. */
+    suggest(terms: string[], limit: number = 5): { file: string; score: number }[] {
+        const best = new Map<string, number>();
+        for (const term of terms) {
+            if ((this.termTurns.get(term) ?? 0) < MIN_TERM_OBSERVATIONS) continue;
+            for (const file of this.termFiles.get(term)?.keys() ?? []) {
+                const association = this._association(term, file);
+                if (association >= SUGGESTION_THRESHOLD) best.set(file, Math.max(best.get(file) ?? 0, association));
+            }
+        }
+        return [...best.entries()]
+            .map(([file, score]) => ({ file, score }))
+            .sort((a, b) => b.score - a.score || a.file.localeCompare(b.file))
+            .slice(0, limit);
+    }
+
+    private _association(term: string, file: string): number {
+        const turns = this.termTurns.get(term);
+        if (!turns) return 0;
+        return (this.termFiles.get(term)?.get(file) ?? 0) / (turns + 1);
+    }
+}
+
+/**
+ * Closes the loop between dynamic context selection and consolidation: each turn's selection
+ * is held, per conversation, until that conversation's next consolidation, then joined with
+ * the files actually changed or referenced and appended to `.kai/relevance_feedback.jsonl`.
+ * The records train a RelevanceModel used to hint and order future selections, and give
+ * precision/recall over time. Conversations are keyed by their log file path. Nothing is
+ * persisted until `configure()` sets the project root.
+ */
+export class RelevanceFeedback {
+    private projectRoot: string | null = null;
+    private pending = new Map<string, SelectionRecord[]>();
+    private model: Promise<RelevanceModel> | null = null;
+
+    configure(projectRoot: string): void {
+        this.projectRoot = projectRoot;
+        this.model = null;
+    }
+
+    recordSelection(conversation: string, query: string, selected: string[], tokens: number): void {
+        const pending = this.pending.get(conversation) ?? [];
+        pending.push({
+            timestamp: new Date().toISOString(),
+            query,
+            terms: SyntaxChunker.queryTerms(query),
+            selected: [...new Set(selected)],
+            tokens,
+        });
+        if (pending.length > MAX_PENDING_PER_CONVERSATION) pending.shift();
+        this.pending.set(conversation, pending);
+    }
+
+    /** Selections waiting for a consolidation: of one conversation, or of all of them. */
+    pendingCount(conversation?: string): number {
+        if (conversation !== undefined) return this.pending.get(conversation)?.length ?? 0;
+        let count = 0;
+        for (const selections of this.pending.values()) count += selections.length;
+        return count;
+    }
+
+    /**
+     * Joins the conversation's pending selections with its consolidation outcome, persists them
+     * and updates the model; other conversations' selections keep waiting. `conversationText`
+     * is searched for mentions of selected files.
+     */
+    async recordOutcome(conversation: string, changedFiles: string[], conversationText: string): Promise<FeedbackRecord[]> {
+        const pending = this.pending.get(conversation);
+        if (!pending) return [];
+        this.pending.delete(conversation);
+        const changed = [...new Set(changedFiles.map(f => f.replace(/\\/g, '/')))];
+        const records = pending.map(selection => RelevanceFeedback.score(selection, changed, conversationText));
+
+        const model = await this.getModel();
+        for (const record of records) {
+            model.learn(record);
+            metrics.observe('context.selection_precision_pct', Math.round(record.precision * 100), undefined, '%');
+            if (record.recall !== null) metrics.observe('context.selection_recall_pct', Math.round(record.recall * 100), undefined, '%');
+        }
+        if (this.projectRoot) {
+            const filePath = path.join(this.projectRoot, RELEVANCE_FEEDBACK_FILE);
+            try {
+                await appendLinesLocked(filePath, records.map(r => JSON.stringify(r)));
+            } catch (error) {
+                console.error(chalk.red(`Failed to write relevance feedback ${filePath}:`), error);
+            }
+        }
+        return records;
+    }
+
+    /** The model trained on persisted records (empty until configured or when no records exist). */
+    getModel(): Promise<RelevanceModel> {
+        if (!this.model) {
+            const projectRoot = this.projectRoot;
+            this.model = (projectRoot ? RelevanceFeedback.readRecords(projectRoot, MAX_TRAINING_RECORDS) : Promise.resolve([]))
+                .then(records => new RelevanceModel(records))
+                .catch(error => {
+                    console.warn(chalk.yellow(`Could not load relevance feedback: ${(error as Error).message}`));
+                    return new RelevanceModel();
+                });
+        }
+        return this.model;
+    }
+
+    static score(selection: SelectionRecord, changed: string[], conversationText: string): FeedbackRecord {
+        const changedSet = new Set(changed);
+        const referenced = selection.selected.filter(f => !changedSet.has(f) && conversationText.includes(f));
+        const used = selection.selected.filter(f => changedSet.has(f) || referenced.includes(f)).length;
+        const found = changed.filter(f => selection.selected.includes(f)).length;
+        return {
+            ...selection,
+            changed,
+            referenced,
+            precision: selection.selected.length > 0 ? used / selection.selected.length : 0,
+            recall: changed.length > 0 ? found / changed.length : null,
+        };
+    }
+
+    /** Reads the most recent `limit` records (oldest first). Malformed lines are skipped. */
+    static async readRecords(projectRoot: string, limit: number = MAX_TRAINING_RECORDS): Promise<FeedbackRecord[]> {
+        let content: string;
+        try {
+            content = await fsPromises.readFile(path.join(projectRoot, RELEVANCE_FEEDBACK_FILE), 'utf-8');
+        } catch (error) {
+            if ((error as NodeJS.ErrnoException).code === 'ENOENT') return [];
+            throw error;
+        }
+        const records: FeedbackRecord[] = [];
+        for (const line of content.split('\n')) {
+            if (!line.trim()) continue;
+            try { records.push(JSON.parse(line)); } catch { /* skip partial line */ }
+        }
+        return records.slice(-limit);
+    }
+
+    static summarize(records: FeedbackRecord[]): RelevanceReport {
+        const withRecall = records.filter(r => r.recall !== null);
+        const mean = (values: number[]) => values.reduce((a, b) => a + b, 0) / values.length;
+        return {
+            turns: records.length,
+            precision: records.length ? mean(records.map(r => r.precision)) : 0,
+            recall: withRecall.length ? mean(withRecall.map(r => r.recall as number)) : null,
+            avgTokens: records.length ? Math.round(mean(records.map(r => r.tokens))) : 0,
+        };
+    }
+
+    /** Overall precision/recall plus the latest window compared with the one before it. */
+    static formatReport(records: FeedbackRecord[], window: number = REPORT_WINDOW): string {
+        if (records.length === 0) return 'Dynamic context selection: no feedback recorded yet.';
+        const pct = (v: number | null) => (v === null ? 'n/a' : `${(v * 100).toFixed(1)}%`);
+        const line = (label: string, r: RelevanceReport) =>
+            `  ${label}: precision ${pct(r.precision)}, recall ${pct(r.recall)}, ~${r.avgTokens} tokens/turn (${r.turns} turns)`;
+        const out = ['Dynamic context selection (vs. files changed/referenced at consolidation):'];
+        out.push(line('all', RelevanceFeedback.summarize(records)));
+        if (records.length > window) {
+            out.push(line(`last ${window}`, RelevanceFeedback.summarize(records.slice(-window))));
+            out.push(line(`previous ${window}`, RelevanceFeedback.summarize(records.slice(-2 * window, -window))));
+        }
+        return out.join('\n');
+    }
+}
+
+/** Process-wide feedback store; kai.ts points it at the project root. */
+export const relevanceFeedback = new RelevanceFeedback();
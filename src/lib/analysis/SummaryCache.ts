@@ -0,0 +1,73 @@
+// File: src/lib/analysis/SummaryCache.ts
+import fsPromises from 'fs/promises';
+import os from 'os';
+import path from 'path';
+import crypto from 'crypto';
+import { metrics } from '../telemetry/Metrics';
+
+/**
+ * User-level store of AI summaries shared by every clone, worktree and branch of a project.
+ * Entries are keyed by the content's git blob hash plus a version string covering the prompt
+ * template, guidelines and model, so any checkout with the same file content reuses the
+ * summary and a prompt or model change invalidates it. One small JSON file per key, written
+ * via rename so concurrent Kai processes never see partial entries.
+ */
+export class SummaryCache {
+    readonly dir: string;
+
+    constructor(dir: string = SummaryCache.defaultDir()) {
+        this.dir = dir;
+    }
+
+    /** `$KAI_CACHE_DIR`, else `$XDG_CACHE_HOME/kai/summaries`, else `~/.cache/kai/summaries`. */
+    static defaultDir(): string {
+        if (process.env.KAI_CACHE_DIR) return path.join(process.env.KAI_CACHE_DIR, 'summaries');
+        const base = process.env.XDG_CACHE_HOME || path.join(os.homedir(), '.cache');
+        return path.join(base, 'kai', 'summaries');
+    }
+
+    /** The id git gives this content (`git hash-object`), computed without spawning git. */
+    static blobHash(content: string): string {
+        const bytes = Buffer.from(content, 'utf8');
+        return crypto.createHash('sha1').update(`blob ${bytes.length}\0`).update(bytes).digest('hex');
+    }
+
+    /** Hashes whatever determines a summary besides the content (prompt template, guidelines, model). */
+    static version(...parts: string[]): string {
+        return crypto.createHash('sha1').update(parts.join('\0')).digest('hex').slice(0, 16);
+    }
+
+    /** `subject` distinguishes several summaries of one blob, e.g. `symbol:Class.method`. */
+    static key(blobHash: string, version: string, subject: string = 'file'): string {
+        return crypto.createHash('sha1').update(`${blobHash}\0${version}\0${subject}`).digest('hex');
+    }
+
+    async get(key: string): Promise<string | null> {
+        let summary: string | null = null;
+        try {
+            const parsed = JSON.parse(await fsPromises.readFile(this._pathFor(key), 'utf-8'));
+            if (typeof parsed?.summary === 'string') summary = parsed.summary;
+        } catch {
+            // Missing or unreadable entries are plain misses
+        }
+        metrics.recordCacheAccess('analysis.shared_summaries', summary !== null);
+        return summary;
+    }
+
+    /** Best effort: a failed write only costs a future cache miss. */
+    async set(key: string, summary: string): Promise<void> {
+        const filePath = this._pathFor(key);
+        const tmpPath = `${filePath}.${process.pid}.${crypto.randomBytes(4).toString('hex')}.tmp`;
+        try {
+            await fsPromises.mkdir(path.dirname(filePath), { recursive: true });
+            await fsPromises.writeFile(tmpPath, JSON.stringify({ summary, storedAt: new Date().toISOString() }), 'utf-8');
+            await fsPromises.rename(tmpPath, filePath);
+        } catch {
+            await fsPromises.rm(tmpPath, { force: true }).catch(() => {});
+        }
+    }
+
+    private _pathFor(key: string): string {
+        return path.join(this.dir, key.slice(0, 2), `${key}.json`);
+    }
+}
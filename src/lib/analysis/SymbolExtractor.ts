@@ -0,0 +1,185 @@
+// src/lib/analysis/SymbolExtractor.ts
+import path from 'path';
+import type * as TS from 'typescript';
+import { SymbolEntry } from './types';
+
+const MAX_SIGNATURE_CHARS = 200;
+
+const TS_EXTENSIONS = new Set(['.ts', '.tsx', '.mts', '.cts', '.js', '.jsx', '.mjs', '.cjs']);
+const BRACE_LANGUAGES = new Set(['.java', '.cs', '.kt', '.swift', '.rs', '.php', '.scala', '.c', '.cc', '.cpp', '.h', '.hpp']);
+
+let tsModule: typeof TS | null = null;
+function getTypeScript(): typeof TS {
+    // Loaded on first use: the compiler is large and only analysis needs it.
+    if (!tsModule) tsModule = require('typescript') as typeof TS;
+    return tsModule;
+}
+
+function collapse(text: string): string {
+    const oneLine = text.replace(/\s+/g, ' ').trim();
+    return oneLine.length > MAX_SIGNATURE_CHARS ? `${oneLine.slice(0, MAX_SIGNATURE_CHARS - 3)}...` : oneLine;
+}
+
+/**
+ * Extracts top-level symbols (exported classes, functions, React components and the public
+ * methods of exported classes) with 1-based inclusive line ranges and signatures.
+ * Purely local and synchronous; summaries are filled in later by the analyzer.
+ */
+export class SymbolExtractor {
+    static supports(filePath: string): boolean {
+        const ext = path.extname(filePath).toLowerCase();
+        return TS_EXTENSIONS.has(ext) || ext === '.py' || ext === '.go' || BRACE_LANGUAGES.has(ext);
+    }
+
+    static extract(filePath: string, content: string): SymbolEntry[] {
+        const ext = path.extname(filePath).toLowerCase();
+        try {
+            if (TS_EXTENSIONS.has(ext)) return SymbolExtractor._extractTypeScript(filePath, content, ext);
+            if (ext === '.py') return SymbolExtractor._extractPython(content);
+            if (ext === '.go') return SymbolExtractor._extractBraced(content, /^func\s+(?:\([^)]*\)\s*)?([A-Z]\w*)\s*\(|^type\s+([A-Z]\w*)\s+(struct|interface)\b/);
+            if (BRACE_LANGUAGES.has(ext)) {
+                return SymbolExtractor._extractBraced(content,
+                    /^(?:(?:public|export|pub(?:\([^)]*\))?|internal|open|abstract|final|sealed|static|data)\s+)*(?:class|interface|struct|enum|trait|impl|fn|fun|func|function)\s+([A-Za-z_]\w*)/);
+            }
+        } catch {
+            // A file the parser cannot handle simply gets no symbols.
+        }
+        return [];
+    }
+
+    // --- TypeScript / JavaScript (compiler API) ---
+
+    private static _extractTypeScript(filePath: string, content: string, ext: string): SymbolEntry[] {
+        const ts = getTypeScript();
+        const isJsx = ext === '.tsx' || ext === '.jsx';
+        const sf = ts.createSourceFile(filePath, content, ts.ScriptTarget.Latest, true,
+            isJsx ? ts.ScriptKind.TSX : ext.endsWith('js') ? ts.ScriptKind.JS : ts.ScriptKind.TS);
+        const symbols: SymbolEntry[] = [];
+        const line = (pos: number) => sf.getLineAndCharacterOfPosition(pos).line + 1;
+        const range = (node: TS.Node) => ({ startLine: line(node.getStart(sf, true)), endLine: line(node.getEnd()) });
+        const headerOf = (node: TS.Node, body: TS.Node | undefined) =>
+            collapse(content.slice(node.getStart(sf), body ? body.getStart(sf) : node.getEnd()));
+        const isExported = (node: TS.Node) =>
+            !!(ts.getCombinedModifierFlags(node as TS.Declaration) & ts.ModifierFlags.Export);
+        const kindFor = (name: string) => (isJsx && /^[A-Z]/.test(name) ? 'component' : 'function') as SymbolEntry['kind'];
+
+        for (const stmt of sf.statements) {
+            if (ts.isFunctionDeclaration(stmt) && isExported(stmt)) {
+                const name = stmt.name?.text ?? 'default';
+                symbols.push({ name, kind: kindFor(name), ...range(stmt), signature: headerOf(stmt, stmt.body), summary: null });
+            } else if (ts.isClassDeclaration(stmt) && isExported(stmt)) {
+                const className = stmt.name?.text ?? 'default';
+                const firstMember = stmt.members.length > 0 ? stmt.members[0] : undefined;
+                const header = collapse(content.slice(stmt.getStart(sf), firstMember ? firstMember.getFullStart() : stmt.getEnd()).replace(/\{\s*$/, ''));
+                symbols.push({ name: className, kind: 'class', ...range(stmt), signature: header, summary: null });
+                for (const member of stmt.members) {
+                    if (!(ts.isMethodDeclaration(member) || ts.isConstructorDeclaration(member)) || !member.body) continue;
+                    const flags = ts.getCombinedModifierFlags(member);
+                    if (flags & (ts.ModifierFlags.Private | ts.ModifierFlags.Protected)) continue;
+                    const memberName = ts.isConstructorDeclaration(member) ? 'constructor' : member.name.getText(sf);
+                    if (memberName.startsWith('#')) continue;
+                    symbols.push({
+                        name: `${className}.${memberName}`, kind: 'method', ...range(member),
+                        signature: headerOf(member, member.body), summary: null,
+                    });
+                }
+            } else if (ts.isVariableStatement(stmt) && isExported(stmt)) {
+                for (const decl of stmt.declarationList.declarations) {
+                    const init = decl.initializer;
+                    if (!ts.isIdentifier(decl.name) || !init || !(ts.isArrowFunction(init) || ts.isFunctionExpression(init))) continue;
+                    const name = decl.name.text;
+                    symbols.push({ name, kind: kindFor(name), ...range(stmt), signature: headerOf(stmt, init.body), summary: null });
+                }
+            } else if (ts.isExportAssignment(stmt) && (ts.isArrowFunction(stmt.expression) || ts.isFunctionExpression(stmt.expression))) {
+                symbols.push({ name: 'default', kind: kindFor('default'), ...range(stmt), signature: headerOf(stmt, stmt.expression.body), summary: null });
+            }
+        }
+        return symbols;
+    }
+
+    // --- Python (indentation) ---
+
+    private static _extractPython(content: string): SymbolEntry[] {
+        const lines = content.split('\n');
+        const symbols: SymbolEntry[] = [];
+        const indentOf = (l: string) => l.length - l.trimStart().length;
+        const blockEnd = (start: number, indent: number) => {
+            let end = start;
+            for (let i = start + 1; i < lines.length; i++) {
+                const text = lines[i];
+                if (!text.trim() || text.trimStart().startsWith('#')) continue;
+                if (indentOf(text) <= indent) break;
+                end = i;
+            }
+            return end;
+        };
+        let currentClass: { name: string; end: number; memberIndent: number | null } | null = null;
+        for (let i = 0; i < lines.length; i++) {
+            const match = lines[i].match(/^(\s*)(?:async\s+)?(def|class)\s+([A-Za-z_]\w*)/);
+            if (!match) continue;
+            const indent = match[1].length;
+            const name = match[3];
+            if (currentClass && i > currentClass.end) currentClass = null;
+            // Decorators belong to the symbol
+            let start = i;
+            while (start > 0 && lines[start - 1].trim().startsWith('@')) start--;
+            const end = blockEnd(i, indent);
+            if (indent === 0) {
+                if (name.startsWith('_')) continue;
+                symbols.push({
+                    name, kind: match[2] === 'class' ? 'class' : 'function', startLine: start + 1, endLine: end + 1,
+                    signature: collapse(lines[i].replace(/:\s*$/, '')), summary: null,
+                });
+                currentClass = match[2] === 'class' ? { name, end, memberIndent: null } : null;
+            } else if (currentClass && match[2] === 'def') {
+                // Only direct methods: the first def fixes the class body's indentation
+                currentClass.memberIndent ??= indent;
+                if (indent !== currentClass.memberIndent || (name.startsWith('_') && name !== '__init__')) continue;
+                symbols.push({
+                    name: `${currentClass.name}.${name}`, kind: 'method', startLine: start + 1, endLine: end + 1,
+                    signature: collapse(lines[i].trim().replace(/:\s*$/, '')), summary: null,
+                });
+            }
+        }
+        return symbols;
+    }
+
+    // --- Brace languages (Go, Java, C#, Rust, ...) ---
+
+    private static _extractBraced(content: string, declaration: RegExp): SymbolEntry[] {
+        const lines = content.split('\n');
+        const symbols: SymbolEntry[] = [];
+        for (let i = 0; i < lines.length; i++) {
+            // Top-level declarations only: nested members are covered by their parent's range.
+            if (/^\s/.test(lines[i])) continue;
+            const match = lines[i].match(declaration);
+            if (!match) continue;
+            const name = match[1] ?? match[2];
+            const end = SymbolExtractor._matchBraces(lines, i);
+            if (end === null) continue;
+            const keyword = lines[i].match(/\b(class|interface|struct|enum|trait|impl|type)\b/)?.[1];
+            symbols.push({
+                name, kind: keyword ? 'class' : 'function', startLine: i + 1, endLine: end + 1,
+                signature: collapse(lines[i].replace(/\{.*$/, '')), summary: null,
+            });
+            i = end;
+        }
+        return symbols;
+    }
+
+    /** Returns the index of the line closing the first `{` at or after `start`, skipping strings and line comments. */
+    private static _matchBraces(lines: string[], start: number): number | null {
+        let depth = 0;
+        let opened = false;
+        for (let i = start; i < lines.length && i < start + 5000; i++) {
+            const text = lines[i].replace(/\/\/.*$/, '').replace(/"(?:[^"\\]|\\.)*"|'(?:[^'\\]|\\.)*'|`[^`]*`/g, '""');
+            for (const ch of text) {
+                if (ch === '{') { depth++; opened = true; }
+                else if (ch === '}') depth--;
+            }
+            if (opened && depth <= 0) return i;
+            if (!opened && i > start + 3) return null; // Declaration without a body (e.g. a prototype)
+        }
+        return null;
+    }
+}
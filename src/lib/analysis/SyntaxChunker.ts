@@ -0,0 +1,177 @@
+// src/lib/analysis/SyntaxChunker.ts
+import path from 'path';
+import { SymbolEntry } from './types';
+import { SymbolExtractor } from './SymbolExtractor';
+import { TreeSitterBackend } from './TreeSitterBackend';
+
+/** A function/class-level slice of a file. IDs stay stable while the symbol keeps its name. */
+export interface CodeChunk {
+    id: string; // `<filePath>#<name>`, matching the analysis cache's symbol ids
+    filePath: string;
+    name: string;
+    kind: SymbolEntry['kind'] | 'preamble' | 'block';
+    startLine: number; // 1-based, inclusive
+    endLine: number; // 1-based, inclusive
+}
+
+export interface SymbolBackend {
+    readonly name: string;
+    /** Returns null when the backend cannot handle the file. */
+    extract(filePath: string, content: string): Promise<SymbolEntry[] | null>;
+}
+
+export interface SyntaxChunkerOptions {
+    maxChunkLines?: number; // Longer symbols are split into `<name>@2`, `<name>@3`, ...
+    backend?: SymbolBackend | null; // Defaults to tree-sitter when installed
+}
+
+const DEFAULT_MAX_CHUNK_LINES = 150;
+const MIN_QUERY_TERM_LENGTH = 3;
+const STOP_WORDS = new Set(['the', 'and', 'for', 'with', 'this', 'that', 'from', 'into', 'what', 'how', 'why', 'when', 'where', 'should', 'please', 'can', 'you', 'are', 'not', 'all']);
+
+/**
+ * Splits source files into syntax-aware chunks for chunk-level retrieval and chunked
+ * summarization. Symbols come from tree-sitter (WASM grammars) when available, falling back
+ * to SymbolExtractor's TypeScript-compiler and indentation/brace heuristics.
+ */
+export class SyntaxChunker {
+    private backend: SymbolBackend | null;
+    private maxChunkLines: number;
+
+    constructor(projectRoot: string, options: SyntaxChunkerOptions = {}) {
+        this.backend = options.backend !== undefined
+            ? options.backend
+            : TreeSitterBackend.isAvailable() ? new TreeSitterBackend(projectRoot) : null;
+        this.maxChunkLines = options.maxChunkLines ?? DEFAULT_MAX_CHUNK_LINES;
+    }
+
+    static supports(filePath: string): boolean {
+        return SymbolExtractor.supports(filePath) || TreeSitterBackend.grammarFor(filePath) !== null;
+    }
+
+    /** All symbols of a file (tree-sitter first, heuristics otherwise), ordered by start line. */
+    async extractSymbols(filePath: string, content: string): Promise<SymbolEntry[]> {
+        let symbols: SymbolEntry[] | null = null;
+        if (this.backend) {
+            try {
+                symbols = await this.backend.extract(filePath, content);
+            } catch {
+                symbols = null; // Fall back to the heuristic extractor
+            }
+        }
+        return (symbols ?? SymbolExtractor.extract(filePath, content)).sort((a, b) => a.startLine - b.startLine);
+    }
+
+    /**
+     * Symbols worth summarizing and listing in the analysis cache: public names only
+     * (no leading underscore; capitalised in Go).
+     */
+    async extractPublicSymbols(filePath: string, content: string): Promise<SymbolEntry[]> {
+        const isGo = path.extname(filePath).toLowerCase() === '.go';
+        return (await this.extractSymbols(filePath, content)).filter(s => {
+            const leaf = s.name.split('.').pop() ?? s.name;
+            if (leaf === '__init__' || leaf === 'constructor') return true;
+            return !leaf.startsWith('_') && !leaf.startsWith('#') && (!isGo || /^[A-Z]/.test(leaf));
+        });
+    }
+
+    /**
+     * Chunks a file into leaf symbols (methods rather than their whole class), a header chunk
+     * for each class with members, and `(preamble)` / `(after:<name>)` chunks for any other code
+     * between symbols, so every non-blank line belongs to exactly one chunk. Chunks longer than
+     * maxChunkLines are split.
+     */
+    async chunk(filePath: string, content: string): Promise<CodeChunk[]> {
+        const lines = content.split('\n');
+        const symbols = await this.extractSymbols(filePath, content);
+        const raw: Omit<CodeChunk, 'id' | 'filePath'>[] = [];
+        // Identical ranges (e.g. `export const a = ..., b = ...`) nest the later symbol in the earlier one.
+        const contains = (outer: SymbolEntry, inner: SymbolEntry) =>
+            outer !== inner && inner.startLine >= outer.startLine && inner.endLine <= outer.endLine
+            && (inner.startLine !== outer.startLine || inner.endLine !== outer.endLine || symbols.indexOf(outer) < symbols.indexOf(inner));
+        const directChildren = (within: SymbolEntry[]) => within.filter(s => !within.some(o => contains(o, s)));
+
+        const addRange = (start: number, end: number, children: SymbolEntry[], parent: SymbolEntry | null) => {
+            let cursor = start;
+            let previous: string | null = null;
+            const addGap = (from: number, to: number) => {
+                if (to < from || !lines.slice(from - 1, to).some(l => l.trim())) return;
+                if (previous) raw.push({ name: `(after:${previous})`, kind: 'block', startLine: from, endLine: to });
+                else if (parent) raw.push({ name: parent.name, kind: parent.kind, startLine: from, endLine: to }); // Class header
+                else raw.push({ name: '(preamble)', kind: 'preamble', startLine: from, endLine: to });
+            };
+            for (const symbol of children) {
+                addGap(cursor, symbol.startLine - 1);
+                const members = symbols.filter(s => contains(symbol, s));
+                if (members.length === 0) {
+                    raw.push({ name: symbol.name, kind: symbol.kind, startLine: symbol.startLine, endLine: symbol.endLine });
+                } else {
+                    addRange(symbol.startLine, symbol.endLine, directChildren(members), symbol);
+                }
+                cursor = Math.max(cursor, symbol.endLine + 1);
+                previous = symbol.name;
+            }
+            addGap(cursor, end);
+        };
+        addRange(1, lines.length, directChildren(symbols), null);
+
+        // Split oversized chunks and assign stable, unique ids
+        const chunks: CodeChunk[] = [];
+        const seen = new Map<string, number>();
+        raw.sort((a, b) => a.startLine - b.startLine);
+        for (const chunk of raw) {
+            for (let start = chunk.startLine, part = 1; start <= chunk.endLine; start += this.maxChunkLines, part++) {
+                let name = part === 1 ? chunk.name : `${chunk.name}@${part}`;
+                const count = (seen.get(name) ?? 0) + 1;
+                seen.set(name, count);
+                if (count > 1) name = `${name}~${count}`; // Overloads / duplicate names
+                chunks.push({
+                    id: `${filePath}#${name}`, filePath, name, kind: chunk.kind,
+                    startLine: start, endLine: Math.min(chunk.endLine, start + this.maxChunkLines - 1),
+                });
+            }
+        }
+        return chunks;
+    }
+
+    static chunkText(content: string, chunk: CodeChunk): string {
+        return content.split('\n').slice(chunk.startLine - 1, chunk.endLine).join('\n');
+    }
+
+    /**
+     * Ranks chunks by lexical overlap with a query: identifier-ish terms (3+ chars, split on
+     * camelCase/snake_case) counted in the chunk text, with a bonus when the chunk name matches.
+     * Chunks with no matching term are dropped.
+     */
+    static rankChunks(chunks: CodeChunk[], content: string, query: string): { chunk: CodeChunk; score: number }[] {
+        const terms = SyntaxChunker.queryTerms(query);
+        if (terms.length === 0) return [];
+        const lines = content.split('\n');
+        return chunks
+            .map(chunk => {
+                const text = lines.slice(chunk.startLine - 1, chunk.endLine).join('\n').toLowerCase();
+                const name = chunk.name.toLowerCase();
+                let score = 0;
+                for (const term of terms) {
+                    let idx = text.indexOf(term);
+                    while (idx !== -1) {
+                        score++;
+                        idx = text.indexOf(term, idx + term.length);
+                    }
+                    if (name.includes(term)) score += 5;
+                }
+                return { chunk, score };
+            })
+            .filter(r => r.score > 0)
+            .sort((a, b) => b.score - a.score || a.chunk.startLine - b.chunk.startLine);
+    }
+
+    static queryTerms(query: string): string[] {
+        const words = query
+            .replace(/([a-z0-9])([A-Z])/g, '$1 $2')
+            .split(/[^A-Za-z0-9]+/)
+            .map(w => w.toLowerCase())
+            .filter(w => w.length >= MIN_QUERY_TERM_LENGTH && !STOP_WORDS.has(w));
+        return [...new Set(words)];
+    }
+}
@@ -0,0 +1,330 @@
+// src/lib/analysis/TokenBudgetProfiler.ts
+import path from 'path';
+import { Ignore } from 'ignore';
+import { FileSystem } from '../FileSystem';
+
+// Same rough ratio the analyzer uses for batching (1 char ~= 0.3 tokens).
+export const ESTIMATED_TOKENS_PER_BYTE = 0.3;
+const PROFILE_CONCURRENCY = 12;
+
+export type FileBudgetClass = 'source' | 'generated' | 'vendored' | 'binary';
+
+export interface BudgetBucket {
+    files: number;
+    bytes: number;
+    tokens: number; // Estimated tokens this bucket would add to a full context
+}
+
+export interface ProfiledFile {
+    filePath: string; // Relative, POSIX separators
+    size: number;
+    tokens: number;
+    classification: FileBudgetClass;
+}
+
+export interface TokenBudgetProfile {
+    files: ProfiledFile[];
+    totals: BudgetBucket;
+    byDirectory: Map<string, BudgetBucket>; // Every ancestor directory of every file
+    byExtension: Map<string, BudgetBucket>;
+    byClassification: Map<FileBudgetClass, BudgetBucket>;
+}
+
+export interface KaiignoreSuggestion {
+    pattern: string; // .kaiignore rule
+    reason: string;
+    files: number;
+    bytes: number;
+    tokens: number; // Tokens removed by this rule beyond the rules ranked above it
+}
+
+// Directory names whose contents are third-party code.
+const VENDORED_DIRS = new Set([
+    'node_modules', 'bower_components', 'jspm_packages', 'vendor', 'third_party', 'third-party',
+    'external', 'Pods', '.venv', 'venv', 'site-packages', '.yarn',
+]);
+
+// Directory names whose contents are build or tool output.
+const GENERATED_DIRS = new Set([
+    'dist', 'build', 'out', 'coverage', '.next', '.nuxt', '.cache', '.parcel-cache', '.turbo',
+    'target', '__pycache__', '.pytest_cache', '.gradle', '.terraform', 'obj', 'DerivedData',
+]);
+
+// File names that are machine-written even when they live next to source.
+const GENERATED_FILE_NAMES = new Set([
+    'package-lock.json', 'yarn.lock', 'pnpm-lock.yaml', 'npm-shrinkwrap.json', 'Cargo.lock',
+    'Gemfile.lock', 'composer.lock', 'poetry.lock', 'Pipfile.lock', 'go.sum', 'bun.lockb',
+]);
+
+// Extensions that are safe to ignore wholesale when every such file is generated.
+const GENERATED_EXTENSIONS = new Set(['.map', '.snap']);
+
+const GENERATED_FILE_PATTERNS: RegExp[] = [
+    /\.min\.(js|css)$/i,
+    /\.map$/i,
+    /\.generated\.[^.]+$/i,
+    /\.pb\.go$/i,
+    /_pb2(_grpc)?\.py$/i,
+    /\.snap$/i,
+];
+
+function emptyBucket(): BudgetBucket {
+    return { files: 0, bytes: 0, tokens: 0 };
+}
+
+function addToBucket<K>(map: Map<K, BudgetBucket>, key: K, file: ProfiledFile): void {
+    let bucket = map.get(key);
+    if (!bucket) {
+        bucket = emptyBucket();
+        map.set(key, bucket);
+    }
+    bucket.files++;
+    bucket.bytes += file.size;
+    bucket.tokens += file.tokens;
+}
+
+function pushMember<K>(map: Map<K, number[]>, key: K, index: number): void {
+    const members = map.get(key);
+    if (members) members.push(index);
+    else map.set(key, [index]);
+}
+
+function extensionKey(filePath: string): string {
+    const ext = path.posix.extname(filePath).toLowerCase();
+    return ext || '(none)';
+}
+
+function formatCount(n: number): string {
+    if (n >= 1_000_000) return `${(n / 1_000_000).toFixed(1)}M`;
+    if (n >= 1_000) return `${(n / 1_000).toFixed(1)}k`;
+    return String(Math.round(n));
+}
+
+/**
+ * Profiles where the context token budget goes: token, byte and file counts per
+ * directory, extension and classification (source / generated / vendored / binary),
+ * plus ranked .kaiignore suggestions. Runs locally; no AI calls.
+ */
+export class TokenBudgetProfiler {
+    private fsUtil: FileSystem;
+    private projectRoot: string;
+
+    constructor(fsUtil: FileSystem, projectRoot: string) {
+        this.fsUtil = fsUtil;
+        this.projectRoot = projectRoot;
+    }
+
+    /** Classifies a relative path by name alone. Returns null if the content must decide (source vs binary). */
+    static classifyPath(relativePath: string): FileBudgetClass | null {
+        const segments = relativePath.split('/');
+        const dirs = segments.slice(0, -1);
+        const base = segments[segments.length - 1];
+        if (dirs.some(d => VENDORED_DIRS.has(d))) return 'vendored';
+        if (dirs.some(d => GENERATED_DIRS.has(d))) return 'generated';
+        if (GENERATED_FILE_NAMES.has(base)) return 'generated';
+        if (GENERATED_FILE_PATTERNS.some(re => re.test(base))) return 'generated';
+        return null;
+    }
+
+    /**
+     * Walks the project (respecting the given ignore rules) and builds the budget histogram.
+     * @param ig Ignore rules to respect, usually from GitService.getIgnoreRules().
+     */
+    async profile(ig: Ignore): Promise<TokenBudgetProfile> {
+        const relativePaths = await this._walk(this.projectRoot, ig);
+        const files: (ProfiledFile | null)[] = new Array(relativePaths.length).fill(null);
+
+        let index = 0;
+        const worker = async () => {
+            while (true) {
+                const i = index++;
+                if (i >= relativePaths.length) break;
+                files[i] = await this._profileFile(relativePaths[i]);
+            }
+        };
+        const workers = Array.from({ length: Math.min(PROFILE_CONCURRENCY, relativePaths.length) }, () => worker());
+        await Promise.all(workers);
+
+        return TokenBudgetProfiler.aggregate(files.filter((f): f is ProfiledFile => f !== null));
+    }
+
+    /** Builds the per-directory / extension / classification buckets from profiled files. */
+    static aggregate(files: ProfiledFile[]): TokenBudgetProfile {
+        const totals = emptyBucket();
+        const byDirectory = new Map<string, BudgetBucket>();
+        const byExtension = new Map<string, BudgetBucket>();
+        const byClassification = new Map<FileBudgetClass, BudgetBucket>();
+
+        for (const file of files) {
+            totals.files++;
+            totals.bytes += file.size;
+            totals.tokens += file.tokens;
+            let dir = path.posix.dirname(file.filePath);
+            while (dir !== '.' && dir !== '/' && dir !== '') {
+                addToBucket(byDirectory, dir, file);
+                dir = path.posix.dirname(dir);
+            }
+            addToBucket(byExtension, extensionKey(file.filePath), file);
+            addToBucket(byClassification, file.classification, file);
+        }
+        return { files, totals, byDirectory, byExtension, byClassification };
+    }
+
+    /**
+     * Proposes .kaiignore rules ranked by how many tokens each one cuts.
+     * Candidates are directories, extensions and file names whose files are all
+     * generated, vendored or binary; rules are picked greedily by marginal token savings
+     * so a parent directory wins over its children and overlapping rules are not repeated.
+     */
+    static suggestIgnoreRules(profile: TokenBudgetProfile, maxRules: number = 25): KaiignoreSuggestion[] {
+        interface Candidate { pattern: string; reason: string; members: number[] }
+        const candidates: Candidate[] = [];
+        const files = profile.files;
+
+        const dirMembers = new Map<string, number[]>();
+        const extMembers = new Map<string, number[]>();
+        const nameMembers = new Map<string, number[]>();
+        files.forEach((file, i) => {
+            let dir = path.posix.dirname(file.filePath);
+            while (dir !== '.' && dir !== '/' && dir !== '') {
+                pushMember(dirMembers, dir, i);
+                dir = path.posix.dirname(dir);
+            }
+            const ext = path.posix.extname(file.filePath).toLowerCase();
+            if (ext) pushMember(extMembers, ext, i);
+            const base = path.posix.basename(file.filePath);
+            if (GENERATED_FILE_NAMES.has(base)) pushMember(nameMembers, base, i);
+        });
+
+        const dominantClass = (members: number[]): FileBudgetClass | null => {
+            const classes = new Set(members.map(i => files[i].classification));
+            if (classes.has('source')) return null;
+            if (classes.size === 1) return [...classes][0];
+            return classes.has('vendored') ? 'vendored' : 'generated';
+        };
+
+        for (const [dir, members] of dirMembers) {
+            const cls = dominantClass(members);
+            if (cls) candidates.push({ pattern: `/${dir}/`, reason: `${cls} directory`, members });
+        }
+        for (const [ext, members] of extMembers) {
+            const cls = dominantClass(members);
+            // Extension rules only for binaries and known generated types (e.g. images, source maps);
+            // a generic extension like .json is too broad even if today's only match is a lock file.
+            if (cls === 'binary' || (cls === 'generated' && GENERATED_EXTENSIONS.has(ext))) {
+                candidates.push({ pattern: `**/*${ext}`, reason: `${cls} ${ext} files`, members });
+            }
+        }
+        for (const [name, members] of nameMembers) {
+            candidates.push({ pattern: name, reason: 'lock/generated file', members });
+        }
+
+        const covered = new Uint8Array(files.length);
+        const suggestions: KaiignoreSuggestion[] = [];
+        const marginal = (c: Candidate) => {
+            const bucket = emptyBucket();
+            for (const i of c.members) {
+                if (covered[i]) continue;
+                bucket.files++;
+                bucket.bytes += files[i].size;
+                bucket.tokens += files[i].tokens;
+            }
+            return bucket;
+        };
+
+        while (suggestions.length < maxRules && candidates.length > 0) {
+            let bestIndex = -1;
+            let best: BudgetBucket | null = null;
+            for (let ci = 0; ci < candidates.length; ci++) {
+                const m = marginal(candidates[ci]);
+                if (m.files === 0) continue;
+                const better = !best
+                    || m.tokens > best.tokens
+                    || (m.tokens === best.tokens && m.bytes > best.bytes)
+                    // On a tie prefer the shorter rule, i.e. the parent directory over its child.
+                    || (m.tokens === best.tokens && m.bytes === best.bytes && candidates[ci].pattern.length < candidates[bestIndex].pattern.length);
+                if (better) {
+                    best = m;
+                    bestIndex = ci;
+                }
+            }
+            if (!best || bestIndex < 0) break;
+            const [chosen] = candidates.splice(bestIndex, 1);
+            chosen.members.forEach(i => { covered[i] = 1; });
+            suggestions.push({ pattern: chosen.pattern, reason: chosen.reason, ...best });
+        }
+        return suggestions;
+    }
+
+    /**
+     * Renders a compact, prompt-sized summary of the profile (top directories and
+     * extensions by tokens, plus the classification breakdown).
+     */
+    static formatHistogram(profile: TokenBudgetProfile, topN: number = 20): string {
+        const line = (label: string, b: BudgetBucket) =>
+            `  ${label}: ${formatCount(b.tokens)} tokens, ${formatCount(b.bytes)} bytes, ${b.files} files`;
+        const top = <K>(map: Map<K, BudgetBucket>) =>
+            [...map.entries()].sort((a, b) => b[1].tokens - a[1].tokens || b[1].bytes - a[1].bytes).slice(0, topN);
+
+        const out: string[] = [];
+        out.push(`Total: ${formatCount(profile.totals.tokens)} tokens, ${formatCount(profile.totals.bytes)} bytes, ${profile.totals.files} files`);
+        out.push('By classification:');
+        for (const [cls, b] of top(profile.byClassification)) out.push(line(cls, b));
+        out.push(`Top directories by tokens:`);
+        for (const [dir, b] of top(profile.byDirectory)) out.push(line(`${dir}/`, b));
+        out.push(`Top extensions by tokens:`);
+        for (const [ext, b] of top(profile.byExtension)) out.push(line(ext, b));
+        return out.join('\n');
+    }
+
+    /** Renders suggestions as .kaiignore content, one commented rule per line. */
+    static formatKaiignore(suggestions: KaiignoreSuggestion[]): string {
+        const lines = ['# Generated by Kai from the local token budget profile.', '# Rules are ranked by estimated tokens removed from the context.', ''];
+        for (const s of suggestions) {
+            lines.push(`# ${s.reason}: ~${formatCount(s.tokens)} tokens, ${s.files} files`);
+            lines.push(s.pattern);
+        }
+        return lines.join('\n') + '\n';
+    }
+
+    private async _walk(dirPath: string, ig: Ignore): Promise<string[]> {
+        const results: string[] = [];
+        const entries = await this.fsUtil.readDir(dirPath);
+        for (const entry of entries) {
+            const fullPath = path.join(dirPath, entry.name);
+            const relativePath = path.relative(this.projectRoot, fullPath).replace(/\\/g, '/');
+            if (entry.isDirectory()) {
+                if (ig.ignores(relativePath + '/')) continue;
+                for (const child of await this._walk(fullPath, ig)) results.push(child);
+            } else if (entry.isFile()) {
+                if (ig.ignores(relativePath)) continue;
+                results.push(relativePath);
+            }
+        }
+        return results;
+    }
+
+    /**
+     * Estimates a file's cost from its size, so profiling stays cheap: each file is stat'ed and
+     * its first 512 bytes are sniffed to tell text from binary, but it is never read in full.
+     */
+    private async _profileFile(relativePath: string): Promise<ProfiledFile | null> {
+        const absolutePath = path.join(this.projectRoot, relativePath);
+        let size: number;
+        try {
+            const stats = await this.fsUtil.stat(absolutePath);
+            if (!stats) return null; // Removed while profiling
+            size = stats.size;
+        } catch {
+            return null; // Already logged by FileSystem.stat
+        }
+        let classification = TokenBudgetProfiler.classifyPath(relativePath);
+        const isText = await this.fsUtil.isTextFile(absolutePath);
+        if (!classification) {
+            classification = isText ? 'source' : 'binary';
+        }
+        // Binary files never reach the prompt, so they cost bytes but no tokens.
+        const tokens = isText ? Math.ceil(size * ESTIMATED_TOKENS_PER_BYTE) : 0;
+        return { filePath: relativePath, size, tokens, classification };
+    }
+}
@@ -0,0 +1,202 @@
+// src/lib/analysis/TreeSitterBackend.ts
+import path from 'path';
+import * as fsSync from 'fs';
+import chalk from 'chalk';
+import { SymbolEntry } from './types';
+
+/** Grammar name (as in `tree-sitter-<name>.wasm`) per file extension. */
+const GRAMMAR_BY_EXTENSION: Record<string, string> = {
+    '.py': 'python', '.go': 'go', '.rs': 'rust', '.java': 'java', '.rb': 'ruby',
+    '.cs': 'c_sharp', '.c': 'c', '.h': 'c', '.cc': 'cpp', '.cpp': 'cpp', '.hpp': 'cpp',
+    '.kt': 'kotlin', '.php': 'php', '.ts': 'typescript', '.tsx': 'tsx',
+    '.js': 'javascript', '.jsx': 'javascript', '.mjs': 'javascript', '.cjs': 'javascript',
+};
+
+/** Node types treated as symbols, per grammar. Classes are searched for member functions. */
+const NODE_KINDS: Record<string, { classes: string[]; functions: string[] }> = {
+    python: { classes: ['class_definition'], functions: ['function_definition'] },
+    go: { classes: ['type_declaration'], functions: ['function_declaration', 'method_declaration'] },
+    rust: { classes: ['impl_item', 'trait_item', 'struct_item', 'enum_item'], functions: ['function_item'] },
+    java: { classes: ['class_declaration', 'interface_declaration', 'enum_declaration', 'record_declaration'], functions: ['method_declaration', 'constructor_declaration'] },
+    ruby: { classes: ['class', 'module'], functions: ['method', 'singleton_method'] },
+    c_sharp: { classes: ['class_declaration', 'interface_declaration', 'struct_declaration', 'record_declaration'], functions: ['method_declaration', 'constructor_declaration'] },
+    c: { classes: ['struct_specifier'], functions: ['function_definition'] },
+    cpp: { classes: ['class_specifier', 'struct_specifier'], functions: ['function_definition'] },
+    kotlin: { classes: ['class_declaration', 'object_declaration'], functions: ['function_declaration'] },
+    php: { classes: ['class_declaration', 'interface_declaration', 'trait_declaration'], functions: ['function_definition', 'method_declaration'] },
+    typescript: { classes: ['class_declaration', 'interface_declaration'], functions: ['function_declaration', 'method_definition', 'generator_function_declaration'] },
+    tsx: { classes: ['class_declaration', 'interface_declaration'], functions: ['function_declaration', 'method_definition', 'generator_function_declaration'] },
+    javascript: { classes: ['class_declaration'], functions: ['function_declaration', 'method_definition', 'generator_function_declaration'] },
+};
+
+// Wrapper nodes whose range (decorators, `export`) belongs to the symbol they wrap.
+const WRAPPER_TYPES = new Set(['export_statement', 'decorated_definition']);
+const MAX_DEPTH = 4;
+
+/** Minimal structural view of a web-tree-sitter node. */
+export interface SyntaxNode {
+    type: string;
+    text: string;
+    startPosition: { row: number };
+    endPosition: { row: number };
+    namedChildren: SyntaxNode[];
+    childForFieldName(name: string): SyntaxNode | null;
+}
+
+/**
+ * Symbol extraction backed by WASM tree-sitter grammars (no native build). `web-tree-sitter`
+ * and the `tree-sitter-wasms` grammar bundle are optional dependencies, installed by default;
+ * a grammar file `tree-sitter-<language>.wasm` in `.kai/grammars/` takes precedence over the
+ * bundled one. When either is missing `extract()` returns null and callers fall back to
+ * SymbolExtractor.
+ */
+export class TreeSitterBackend {
+    readonly name = 'tree-sitter';
+    private grammarDirs: string[];
+    private runtime: Promise<any | null> | null = null;
+    private languages = new Map<string, Promise<any | null>>();
+
+    constructor(projectRoot: string) {
+        this.grammarDirs = [path.join(projectRoot, '.kai', 'grammars')];
+        const bundled = TreeSitterBackend.bundledGrammarDir();
+        if (bundled) this.grammarDirs.push(bundled);
+    }
+
+    /** Directory of the `tree-sitter-wasms` grammars, or null when the optional package is not installed. */
+    static bundledGrammarDir(): string | null {
+        try {
+            return path.join(path.dirname(require.resolve('tree-sitter-wasms/package.json')), 'out');
+        } catch {
+            return null;
+        }
+    }
+
+    /** True if the runtime package can be resolved; grammars are checked per language. */
+    static isAvailable(): boolean {
+        try {
+            require.resolve('web-tree-sitter');
+            return true;
+        } catch {
+            return false;
+        }
+    }
+
+    static grammarFor(filePath: string): string | null {
+        return GRAMMAR_BY_EXTENSION[path.extname(filePath).toLowerCase()] ?? null;
+    }
+
+    /** Returns the symbols of a file, or null when tree-sitter cannot handle it. */
+    async extract(filePath: string, content: string): Promise<SymbolEntry[] | null> {
+        const grammar = TreeSitterBackend.grammarFor(filePath);
+        if (!grammar) return null;
+        const parser = await this._parserFor(grammar);
+        if (!parser) return null;
+        const tree = parser.parse(content);
+        try {
+            return TreeSitterBackend.collectSymbols(tree.rootNode as SyntaxNode, grammar);
+        } finally {
+            tree.delete?.();
+        }
+    }
+
+    /** Walks a syntax tree and collects class/function symbols. Exposed for tests. */
+    static collectSymbols(root: SyntaxNode, grammar: string): SymbolEntry[] {
+        const kinds = NODE_KINDS[grammar];
+        if (!kinds) return [];
+        const symbols: SymbolEntry[] = [];
+        const visit = (node: SyntaxNode, parent: string | null, depth: number) => {
+            for (const child of node.namedChildren) {
+                let target = child;
+                while (WRAPPER_TYPES.has(target.type)) {
+                    const inner: SyntaxNode | undefined = target.childForFieldName('definition')
+                        ?? target.childForFieldName('declaration')
+                        ?? target.namedChildren.find(c => !['decorator', 'comment'].includes(c.type));
+                    if (!inner) break;
+                    target = inner;
+                }
+                const isClass = kinds.classes.includes(target.type);
+                const isFunction = kinds.functions.includes(target.type);
+                if (isClass || isFunction) {
+                    const name = TreeSitterBackend._nameOf(target);
+                    const qualified = parent ? `${parent}.${name}` : name;
+                    symbols.push({
+                        name: qualified,
+                        kind: isClass ? 'class' : parent ? 'method' : 'function',
+                        startLine: child.startPosition.row + 1,
+                        endLine: child.endPosition.row + 1,
+                        signature: TreeSitterBackend._signatureOf(target),
+                        summary: null,
+                    });
+                    // Members of classes are symbols too; function bodies are not descended into.
+                    if (isClass) visit(target, qualified, depth + 1);
+                } else if (depth < MAX_DEPTH) {
+                    visit(child, parent, depth + 1);
+                }
+            }
+        };
+        visit(root, null, 0);
+        return symbols;
+    }
+
+    private static _nameOf(node: SyntaxNode): string {
+        const named = node.childForFieldName('name');
+        if (named) return named.text;
+        // C/C++ functions: the name is the start of the declarator, e.g. `*parse(const char *s)`
+        const declarator = node.childForFieldName('declarator');
+        if (declarator) return declarator.text.split('(')[0].replace(/^[*&\s]+/, '').trim();
+        // Rust `impl Type` blocks
+        const implType = node.childForFieldName('type');
+        if (implType) return implType.text;
+        // Go type declarations keep the name in their type_spec child
+        for (const child of node.namedChildren) {
+            const inner = child.childForFieldName('name');
+            if (inner) return inner.text;
+        }
+        return `${node.type}@${node.startPosition.row + 1}`;
+    }
+
+    private static _signatureOf(node: SyntaxNode): string {
+        const body = node.childForFieldName('body');
+        const text = body ? node.text.slice(0, node.text.length - body.text.length) : node.text.split('\n')[0];
+        const oneLine = text.replace(/\s+/g, ' ').replace(/[{:]\s*$/, '').trim();
+        return oneLine.length > 200 ? `${oneLine.slice(0, 197)}...` : oneLine;
+    }
+
+    private _loadRuntime(): Promise<any | null> {
+        if (!this.runtime) {
+            this.runtime = (async () => {
+                try {
+                    const mod = require('web-tree-sitter');
+                    const Parser = mod.Parser ?? mod; // 0.22+ exports { Parser, Language }
+                    await Parser.init();
+                    return { Parser, Language: mod.Language ?? Parser.Language };
+                } catch (error) {
+                    console.warn(chalk.yellow(`tree-sitter unavailable, using heuristic symbol extraction: ${(error as Error).message}`));
+                    return null;
+                }
+            })();
+        }
+        return this.runtime;
+    }
+
+    private async _parserFor(grammar: string): Promise<any | null> {
+        if (!this.languages.has(grammar)) {
+            this.languages.set(grammar, (async () => {
+                const wasmPath = this.grammarDirs
+                    .map(dir => path.join(dir, `tree-sitter-${grammar}.wasm`))
+                    .find(p => fsSync.existsSync(p));
+                if (!wasmPath) return null;
+                const runtime = await this._loadRuntime();
+                if (!runtime) return null;
+                const language = await runtime.Language.load(wasmPath);
+                const parser = new runtime.Parser();
+                parser.setLanguage(language);
+                return parser;
+            })().catch(error => {
+                console.warn(chalk.yellow(`Failed to load tree-sitter grammar '${grammar}': ${(error as Error).message}`));
+                return null;
+            }));
+        }
+        return this.languages.get(grammar)!;
+    }
+}
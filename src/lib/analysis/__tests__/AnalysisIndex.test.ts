@@ -0,0 +1,50 @@
+import { AnalysisIndex } from '../AnalysisIndex';
+import { ProjectAnalysisCache } from '../types';
+
+describe('AnalysisIndex', () => {
+  const cache: ProjectAnalysisCache = {
+    overallSummary: 'project',
+    entries: [
+      {
+        filePath: 'src/a.ts', type: 'text_analyze', size: 1024, loc: 10, summary: 'Does a ✓', lastAnalyzed: '2024-01-02T03:04:05.678Z',
+        symbols: [{ name: 'A', kind: 'class', startLine: 1, endLine: 3, signature: 'class A', summary: null }],
+      },
+      { filePath: 'img/logo.png', type: 'binary', size: 5e9, loc: null, summary: null, lastAnalyzed: 'n' },
+      { filePath: 'src/a.ts', type: 'text_large', size: 1, loc: 0, summary: '', lastAnalyzed: '2024-01-02' },
+    ],
+  };
+
+  it('round-trips a cache exactly', () => {
+    const index = AnalysisIndex.fromCache(cache);
+    expect(index.length).toBe(3);
+    expect(index.toCache()).toEqual(cache);
+    expect([...index]).toEqual(cache.entries);
+  });
+
+  it('reads columns without materialising entries', () => {
+    const index = AnalysisIndex.fromCache(cache);
+    expect(index.rowOf('src/a.ts')).toBe(0); // First entry for a repeated path
+    expect(index.rowOf('img/logo.png')).toBe(1);
+    expect(index.rowOf('missing.ts')).toBe(-1);
+    expect(index.type(1)).toBe('binary');
+    expect(index.size(1)).toBe(5e9);
+    expect(index.loc(1)).toBeNull();
+    expect(index.summary(1)).toBeNull();
+    expect(index.summaryLength(0)).toBe(8);
+    expect(index.symbols(0)?.[0].name).toBe('A');
+    expect(index.symbols(2)).toBeUndefined();
+    expect(index.paths.has('img/logo.png')).toBe(true);
+    expect(index.sizeBytes()).toBeGreaterThan(0);
+  });
+
+  it('stays compact as it grows', () => {
+    const index = new AnalysisIndex();
+    for (let i = 0; i < 50000; i++) {
+      index.add({ filePath: `packages/p${i % 20}/src/module${i}.ts`, type: 'text_analyze', size: i, loc: i % 500, summary: `Module ${i}`, lastAnalyzed: '2024-01-02T03:04:05.678Z' });
+    }
+    expect(index.filePath(43210)).toBe('packages/p10/src/module43210.ts');
+    expect(index.rowOf('packages/p10/src/module43210.ts')).toBe(43210);
+    expect(index.lastAnalyzed(43210)).toBe('2024-01-02T03:04:05.678Z');
+    expect(index.sizeBytes() / index.length).toBeLessThan(200); // Including spare capacity; an entry object with its strings takes several hundred
+  });
+});
@@ -0,0 +1,85 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { RelevanceFeedback, RelevanceModel, FeedbackRecord, RELEVANCE_FEEDBACK_FILE } from '../RelevanceFeedback';
+
+const record = (terms: string[], selected: string[], changed: string[], referenced: string[] = []): FeedbackRecord => ({
+  timestamp: 't', query: terms.join(' '), terms, selected, tokens: 100, changed, referenced, precision: 0, recall: null,
+});
+
+describe('RelevanceFeedback', () => {
+  beforeAll(() => {
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+  });
+
+  it('scores a selection against changed and referenced files', () => {
+    const scored = RelevanceFeedback.score(
+      { timestamp: 't', query: 'q', terms: [], selected: ['a.ts', 'b.ts', 'c.ts', 'd.ts'], tokens: 10 },
+      ['a.ts', 'e.ts'],
+      'the bug is in b.ts',
+    );
+    expect(scored.referenced).toEqual(['b.ts']);
+    expect(scored.precision).toBe(0.5);
+    expect(scored.recall).toBe(0.5);
+    expect(RelevanceFeedback.score({ ...scored, selected: ['a.ts'] }, [], '').recall).toBeNull();
+  });
+
+  it('persists pending selections with their outcome and learns from them', async () => {
+    const tmpDir = fs.mkdtempSync(path.join(os.tmpdir(), 'relevance-'));
+    const feedback = new RelevanceFeedback();
+    feedback.configure(tmpDir);
+    feedback.recordSelection('chat-a.jsonl', 'Fix the login handler', ['src/auth.ts', 'src/util.ts'], 900);
+    feedback.recordSelection('chat-a.jsonl', 'login timeout', ['src/util.ts'], 300);
+    feedback.recordSelection('chat-b.jsonl', 'render the chart', ['src/chart.ts'], 400);
+    expect(feedback.pendingCount()).toBe(3);
+
+    // Only chat-a's consolidation: chat-b's selection waits for its own
+    const records = await feedback.recordOutcome('chat-a.jsonl', ['src/auth.ts'], '');
+    expect(feedback.pendingCount('chat-a.jsonl')).toBe(0);
+    expect(feedback.pendingCount('chat-b.jsonl')).toBe(1);
+    expect(records.map(r => [r.terms, r.precision, r.recall])).toEqual([
+      [['fix', 'login', 'handler'], 0.5, 1],
+      [['login', 'timeout'], 0, 0],
+    ]);
+    expect(await RelevanceFeedback.readRecords(tmpDir)).toHaveLength(2);
+    expect(fs.existsSync(path.join(tmpDir, RELEVANCE_FEEDBACK_FILE))).toBe(true);
+
+    // A fresh instance trains on the persisted records
+    const reloaded = new RelevanceFeedback();
+    reloaded.configure(tmpDir);
+    const model = await reloaded.getModel();
+    expect(model.suggest(['login'])).toEqual([{ file: 'src/auth.ts', score: 2 / 3 }]);
+    expect(await new RelevanceFeedback().recordOutcome('chat-a.jsonl', ['x.ts'], '')).toEqual([]);
+  });
+
+  it('keeps only the latest selections of a conversation that never consolidates', async () => {
+    const feedback = new RelevanceFeedback();
+    for (let i = 0; i < 60; i++) feedback.recordSelection('desktop.jsonl', `turn ${i}`, ['a.ts'], 10);
+    expect(feedback.pendingCount('desktop.jsonl')).toBe(50);
+    const records = await feedback.recordOutcome('desktop.jsonl', ['a.ts'], '');
+    expect(records[0].query).toBe('turn 10');
+  });
+
+  it('ranks files by hit rate and term association', () => {
+    const model = new RelevanceModel([
+      record(['parser'], ['src/parser.ts', 'src/noise.ts'], ['src/parser.ts']),
+      record(['parser'], ['src/parser.ts', 'src/noise.ts'], ['src/parser.ts']),
+      record(['render'], ['src/view.ts'], [], ['src/view.ts']),
+    ]);
+    expect(model.score('src/parser.ts', ['parser'])).toBeGreaterThan(model.score('src/noise.ts', ['parser']));
+    expect(model.score('src/noise.ts', [])).toBe(0.25);
+    expect(model.score('unknown.ts', [])).toBe(0.5);
+    expect(model.suggest(['parser']).map(s => s.file)).toEqual(['src/parser.ts']);
+    expect(model.suggest(['render'])).toEqual([]); // Seen only once
+    expect(new RelevanceModel().isEmpty).toBe(true);
+  });
+
+  it('reports precision and recall overall and per window', () => {
+    const records = Array.from({ length: 4 }, (_, i) => ({ ...record([], ['a.ts'], ['a.ts']), precision: i < 2 ? 0 : 1, recall: i < 2 ? 0 : 1 }));
+    const report = RelevanceFeedback.formatReport(records, 2);
+    expect(report).toContain('all: precision 50.0%, recall 50.0%, ~100 tokens/turn (4 turns)');
+    expect(report).toContain('last 2: precision 100.0%');
+    expect(report).toContain('previous 2: precision 0.0%');
+    expect(RelevanceFeedback.formatReport([])).toContain('no feedback recorded yet');
+  });
+});
@@ -0,0 +1,46 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { SummaryCache } from '../SummaryCache';
+import { metrics } from '../../telemetry/Metrics';
+
+describe('SummaryCache', () => {
+  const originalEnv = { ...process.env };
+  afterEach(() => {
+    process.env = { ...originalEnv };
+  });
+
+  it('computes the same blob hash as git hash-object', () => {
+    expect(SummaryCache.blobHash('hello\n')).toBe('ce013625030ba8dba906f756967f9e9ca394464a');
+  });
+
+  it('stores and reuses summaries per blob, version and subject', async () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'summary-cache-'));
+    const cache = new SummaryCache(dir);
+    const blob = SummaryCache.blobHash('export const a = 1;\n');
+    const v1 = SummaryCache.version('prompt', 'model-a');
+    const v2 = SummaryCache.version('prompt', 'model-b');
+
+    metrics.reset();
+    expect(await cache.get(SummaryCache.key(blob, v1))).toBeNull();
+    await cache.set(SummaryCache.key(blob, v1), 'Defines a.');
+    await cache.set(SummaryCache.key(blob, v1, 'symbol:a'), 'The constant a.');
+
+    // A second instance (another checkout) sees the same entries
+    const other = new SummaryCache(dir);
+    expect(await other.get(SummaryCache.key(blob, v1))).toBe('Defines a.');
+    expect(await other.get(SummaryCache.key(blob, v1, 'symbol:a'))).toBe('The constant a.');
+    expect(await other.get(SummaryCache.key(blob, v2))).toBeNull();
+    expect(metrics.counter('cache.hit', { cache: 'analysis.shared_summaries' })).toBe(2);
+    expect(metrics.counter('cache.miss', { cache: 'analysis.shared_summaries' })).toBe(2);
+    expect(fs.readdirSync(dir, { recursive: true } as any).some((f: any) => String(f).endsWith('.tmp'))).toBe(false);
+  });
+
+  it('resolves the user-level directory from the environment', () => {
+    process.env.KAI_CACHE_DIR = '/tmp/kai-cache';
+    expect(SummaryCache.defaultDir()).toBe(path.join('/tmp/kai-cache', 'summaries'));
+    delete process.env.KAI_CACHE_DIR;
+    process.env.XDG_CACHE_HOME = '/tmp/xdg';
+    expect(SummaryCache.defaultDir()).toBe(path.join('/tmp/xdg', 'kai', 'summaries'));
+  });
+});
@@ -0,0 +1,86 @@
+import { SymbolExtractor } from '../SymbolExtractor';
+
+describe('SymbolExtractor', () => {
+  it('extracts exported TypeScript symbols, public methods and line ranges', () => {
+    const source = [
+      'import x from "y";',                                  // 1
+      '/** Adds numbers. */',                                // 2
+      'export function add(a: number, b: number): number {', // 3
+      '  return a + b;',                                     // 4
+      '}',                                                   // 5
+      'function internal() {}',                              // 6
+      'export class Store extends Base {',                   // 7
+      '  private cache = new Map();',                        // 8
+      '  get(key: string) {',                                // 9
+      '    return this.cache.get(key);',                     // 10
+      '  }',                                                 // 11
+      '  private hidden() {}',                               // 12
+      '}',                                                   // 13
+      'export const double = (n: number) => n * 2;',         // 14
+    ].join('\n');
+    const symbols = SymbolExtractor.extract('src/store.ts', source);
+    expect(symbols.map(s => [s.name, s.kind, s.startLine, s.endLine])).toEqual([
+      ['add', 'function', 2, 5],
+      ['Store', 'class', 7, 13],
+      ['Store.get', 'method', 9, 11],
+      ['double', 'function', 14, 14],
+    ]);
+    expect(symbols[0].signature).toBe('export function add(a: number, b: number): number');
+    expect(symbols[1].signature).toBe('export class Store extends Base');
+    expect(symbols.every(s => s.summary === null)).toBe(true);
+  });
+
+  it('marks capitalised functions in TSX files as components', () => {
+    const symbols = SymbolExtractor.extract('Button.tsx', 'export const Button = () => <button/>;\nexport function useThing() {}\n');
+    expect(symbols.map(s => [s.name, s.kind])).toEqual([['Button', 'component'], ['useThing', 'function']]);
+  });
+
+  it('extracts Python classes, methods and functions by indentation', () => {
+    const source = [
+      'import os',              // 1
+      '@decorator',             // 2
+      'def load(path):',        // 3
+      '    return open(path)',  // 4
+      '',                       // 5
+      'class Repo:',            // 6
+      '    def __init__(self):',// 7
+      '        def inner():',   // 8
+      '            pass',       // 9
+      '    def _private(self):',// 10
+      '        pass',           // 11
+      '    def save(self):',    // 12
+      '        pass',           // 13
+      'def _hidden():',         // 14
+      '    pass',               // 15
+    ].join('\n');
+    expect(SymbolExtractor.extract('repo.py', source).map(s => [s.name, s.kind, s.startLine, s.endLine])).toEqual([
+      ['load', 'function', 2, 4],
+      ['Repo', 'class', 6, 13],
+      ['Repo.__init__', 'method', 7, 9],
+      ['Repo.save', 'method', 12, 13],
+    ]);
+  });
+
+  it('extracts exported Go declarations using brace matching', () => {
+    const source = [
+      'package store',                 // 1
+      'type Store struct {',           // 2
+      '  items map[string]string',     // 3
+      '}',                             // 4
+      'func (s *Store) Get(k string) string {', // 5
+      '  if v, ok := s.items[k]; ok { return "}" + v }', // 6
+      '  return ""',                   // 7
+      '}',                             // 8
+      'func helper() {}',              // 9
+    ].join('\n');
+    expect(SymbolExtractor.extract('store.go', source).map(s => [s.name, s.kind, s.startLine, s.endLine])).toEqual([
+      ['Store', 'class', 2, 4],
+      ['Get', 'function', 5, 8],
+    ]);
+  });
+
+  it('returns nothing for unsupported files', () => {
+    expect(SymbolExtractor.supports('README.md')).toBe(false);
+    expect(SymbolExtractor.extract('README.md', '# hi')).toEqual([]);
+  });
+});
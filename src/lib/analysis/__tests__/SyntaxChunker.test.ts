@@ -0,0 +1,126 @@
+import { SyntaxChunker } from '../SyntaxChunker';
+import { SyntaxNode, TreeSitterBackend } from '../TreeSitterBackend';
+import { SymbolEntry } from '../types';
+
+const PYTHON = [
+  'import os',            // 1
+  '',                     // 2
+  'class Store:',         // 3
+  '    def get(self):',   // 4
+  '        return 1',     // 5
+  '    def _hidden(self):', // 6
+  '        return 2',     // 7
+  '',                     // 8
+  'CONSTANT = 3',         // 9
+  '',                     // 10
+  'def run():',           // 11
+  '    return Store()',   // 12
+].join('\n');
+
+describe('SyntaxChunker', () => {
+  it('covers every non-blank line with symbol, class header and gap chunks', async () => {
+    const chunker = new SyntaxChunker('/r', { backend: null });
+    const chunks = await chunker.chunk('src/store.py', PYTHON);
+    expect(chunks.map(c => [c.name, c.kind, c.startLine, c.endLine])).toEqual([
+      ['(preamble)', 'preamble', 1, 2],
+      ['Store', 'class', 3, 3],
+      ['Store.get', 'method', 4, 5],
+      ['(after:Store.get)', 'block', 6, 7],
+      ['(after:Store)', 'block', 8, 10],
+      ['run', 'function', 11, 12],
+    ]);
+    expect(chunks[2].id).toBe('src/store.py#Store.get');
+    expect(SyntaxChunker.chunkText(PYTHON, chunks[5])).toBe('def run():\n    return Store()');
+  });
+
+  it('splits oversized chunks and keeps ids unique', async () => {
+    const body = Array.from({ length: 5 }, (_, i) => `    x = ${i}`);
+    const source = ['def run():', ...body, 'def run():', '    pass'].join('\n');
+    const chunks = await new SyntaxChunker('/r', { backend: null, maxChunkLines: 4 }).chunk('a.py', source);
+    expect(chunks.map(c => [c.name, c.startLine, c.endLine])).toEqual([
+      ['run', 1, 4],
+      ['run@2', 5, 6],
+      ['run~2', 7, 8],
+    ]);
+  });
+
+  it('keeps only public symbols for the analysis cache', async () => {
+    const symbols = await new SyntaxChunker('/r', { backend: null }).extractPublicSymbols('src/store.py', PYTHON);
+    expect(symbols.map(s => s.name)).toEqual(['Store', 'Store.get', 'run']);
+  });
+
+  it('prefers the backend and falls back to heuristics when it fails', async () => {
+    const fromBackend: SymbolEntry = { name: 'only', kind: 'function', startLine: 11, endLine: 12, signature: 'def only()', summary: null };
+    const working = new SyntaxChunker('/r', { backend: { name: 'fake', extract: async () => [fromBackend] } });
+    expect((await working.extractSymbols('a.py', PYTHON)).map(s => s.name)).toEqual(['only']);
+
+    const failing = new SyntaxChunker('/r', { backend: { name: 'fake', extract: async () => { throw new Error('boom'); } } });
+    expect((await failing.extractSymbols('a.py', PYTHON)).map(s => s.name)).toEqual(['Store', 'Store.get', 'run']);
+
+    const declining = new SyntaxChunker('/r', { backend: { name: 'fake', extract: async () => null } });
+    expect((await declining.extractSymbols('a.py', PYTHON)).map(s => s.name)).toEqual(['Store', 'Store.get', 'run']);
+  });
+
+  it('ranks chunks by query terms and drops non-matching ones', async () => {
+    const chunks = await new SyntaxChunker('/r', { backend: null }).chunk('src/store.py', PYTHON);
+    const ranked = SyntaxChunker.rankChunks(chunks, PYTHON, 'Why does the run function return a Store?');
+    expect(ranked[0].chunk.name).toBe('run');
+    expect(ranked.map(r => r.chunk.name)).not.toContain('(preamble)');
+    expect(SyntaxChunker.rankChunks(chunks, PYTHON, 'the and')).toEqual([]);
+    expect(SyntaxChunker.queryTerms('parseHeader for user_id')).toEqual(['parse', 'header', 'user']);
+  });
+});
+
+describe('TreeSitterBackend.collectSymbols', () => {
+  const node = (type: string, start: number, end: number, text: string, fields: Record<string, SyntaxNode> = {}, children: SyntaxNode[] = []): SyntaxNode => ({
+    type, text, startPosition: { row: start }, endPosition: { row: end },
+    namedChildren: [...Object.values(fields), ...children],
+    childForFieldName: (name: string) => fields[name] ?? null,
+  });
+
+  it('collects classes, their methods and functions through export wrappers', () => {
+    const methodBody = node('statement_block', 2, 4, '{\n  return 1;\n}');
+    const method = node('method_definition', 2, 4, 'get(key: string) {\n  return 1;\n}', { name: node('property_identifier', 2, 2, 'get'), body: methodBody });
+    const classBody = node('class_body', 1, 5, '{...}', {}, [method]);
+    const cls = node('class_declaration', 1, 5, 'class Store {...}', { name: node('type_identifier', 1, 1, 'Store'), body: classBody });
+    const exported = node('export_statement', 0, 5, 'export class Store {...}', { declaration: cls });
+    const fnBody = node('statement_block', 6, 6, '{}');
+    const fn = node('function_declaration', 6, 6, 'function run() {}', { name: node('identifier', 6, 6, 'run'), body: fnBody });
+    const root = node('program', 0, 6, '', {}, [exported, fn]);
+
+    const symbols = TreeSitterBackend.collectSymbols(root, 'typescript');
+    expect(symbols.map(s => [s.name, s.kind, s.startLine, s.endLine, s.signature])).toEqual([
+      ['Store', 'class', 1, 6, 'class Store'],
+      ['Store.get', 'method', 3, 5, 'get(key: string)'],
+      ['run', 'function', 7, 7, 'function run()'],
+    ]);
+  });
+
+  it('maps file extensions to grammars', () => {
+    expect(TreeSitterBackend.grammarFor('main.rs')).toBe('rust');
+    expect(TreeSitterBackend.grammarFor('README.md')).toBeNull();
+  });
+});
+
+// Runs only where the optional web-tree-sitter and tree-sitter-wasms packages are installed.
+const withParser = TreeSitterBackend.isAvailable() && TreeSitterBackend.bundledGrammarDir() ? describe : describe.skip;
+
+withParser('TreeSitterBackend with the bundled grammars', () => {
+  it('parses Python into class, method and function symbols', async () => {
+    const symbols = await new TreeSitterBackend('/no-project').extract('src/store.py', PYTHON);
+    expect(symbols?.map(s => [s.name, s.kind, s.startLine, s.endLine])).toEqual([
+      ['Store', 'class', 3, 7],
+      ['Store.get', 'method', 4, 5],
+      ['Store._hidden', 'method', 6, 7],
+      ['run', 'function', 11, 12],
+    ]);
+  });
+
+  it('is the default SyntaxChunker backend', async () => {
+    const source = 'package main\n\nfunc Run() int {\n\treturn 1\n}\n';
+    const chunker = new SyntaxChunker('/no-project');
+    expect((chunker as any).backend?.name).toBe('tree-sitter');
+    const symbols = await chunker.extractSymbols('main.go', source);
+    expect(symbols.map(s => [s.name, s.kind, s.startLine, s.endLine])).toEqual([['Run', 'function', 3, 5]]);
+  });
+});
@@ -0,0 +1,84 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import ignore from 'ignore';
+import { FileSystem } from '../../FileSystem';
+import { TokenBudgetProfiler, ProfiledFile } from '../TokenBudgetProfiler';
+
+describe('TokenBudgetProfiler', () => {
+  let tmpDir: string;
+
+  const write = (rel: string, content: string | Buffer) => {
+    const abs = path.join(tmpDir, rel);
+    fs.mkdirSync(path.dirname(abs), { recursive: true });
+    fs.writeFileSync(abs, content);
+  };
+
+  beforeEach(() => {
+    tmpDir = fs.mkdtempSync(path.join(os.tmpdir(), 'budget-'));
+    write('src/index.ts', 'export const a = 1;\n'.repeat(50));
+    write('src/util.ts', 'export const b = 2;\n'.repeat(10));
+    write('node_modules/lib/index.js', 'module.exports = {};\n'.repeat(400));
+    write('dist/index.js', 'var a = 1;\n'.repeat(200));
+    write('package-lock.json', '{}\n'.repeat(300));
+    write('assets/logo.png', Buffer.from([0x89, 0x50, 0x00, 0x01, 0x02]));
+    write('.git/HEAD', 'ref: refs/heads/main\n');
+  });
+
+  afterEach(() => {
+    fs.rmSync(tmpDir, { recursive: true, force: true });
+  });
+
+  it('classifies paths by name', () => {
+    expect(TokenBudgetProfiler.classifyPath('node_modules/x/y.js')).toBe('vendored');
+    expect(TokenBudgetProfiler.classifyPath('packages/a/dist/y.js')).toBe('generated');
+    expect(TokenBudgetProfiler.classifyPath('public/app.min.js')).toBe('generated');
+    expect(TokenBudgetProfiler.classifyPath('yarn.lock')).toBe('generated');
+    expect(TokenBudgetProfiler.classifyPath('src/app.ts')).toBeNull();
+  });
+
+  it('profiles files per directory, extension and classification', async () => {
+    const profiler = new TokenBudgetProfiler(new FileSystem(), tmpDir);
+    const profile = await profiler.profile(ignore().add(['.git']));
+
+    expect(profile.totals.files).toBe(6);
+    expect(profile.byClassification.get('source')?.files).toBe(2);
+    expect(profile.byClassification.get('vendored')?.files).toBe(1);
+    expect(profile.byClassification.get('generated')?.files).toBe(2);
+    expect(profile.byClassification.get('binary')?.tokens).toBe(0);
+    expect(profile.byDirectory.get('node_modules')?.files).toBe(1);
+    expect(profile.byDirectory.get('node_modules/lib')?.files).toBe(1);
+    expect(profile.byExtension.get('.ts')?.files).toBe(2);
+    expect(profile.files.some(f => f.filePath.startsWith('.git/'))).toBe(false);
+  });
+
+  it('ranks ignore rules by tokens cut and never ignores source', async () => {
+    const profiler = new TokenBudgetProfiler(new FileSystem(), tmpDir);
+    const profile = await profiler.profile(ignore().add(['.git']));
+    const suggestions = TokenBudgetProfiler.suggestIgnoreRules(profile);
+    const patterns = suggestions.map(s => s.pattern);
+
+    expect(patterns[0]).toBe('/node_modules/');
+    expect(patterns).toEqual(expect.arrayContaining(['/dist/', 'package-lock.json']));
+    expect(patterns).not.toContain('/src/');
+    expect(patterns).not.toContain('/node_modules/lib/'); // covered by the parent rule
+    for (let i = 1; i < suggestions.length; i++) {
+      expect(suggestions[i - 1].tokens).toBeGreaterThanOrEqual(suggestions[i].tokens);
+    }
+  });
+
+  it('formats a compact histogram and kaiignore content', () => {
+    const files: ProfiledFile[] = [
+      { filePath: 'src/a.ts', size: 100, tokens: 30, classification: 'source' },
+      { filePath: 'build/a.js', size: 1000, tokens: 300, classification: 'generated' },
+    ];
+    const profile = TokenBudgetProfiler.aggregate(files);
+    const histogram = TokenBudgetProfiler.formatHistogram(profile);
+    expect(histogram).toContain('Total: 330 tokens');
+    expect(histogram).toContain('build/: 300 tokens');
+
+    const kaiignore = TokenBudgetProfiler.formatKaiignore(TokenBudgetProfiler.suggestIgnoreRules(profile));
+    expect(kaiignore).toContain('/build/');
+    expect(kaiignore).not.toContain('/src/');
+  });
+});
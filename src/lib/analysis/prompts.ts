@@ -49,6 +49,34 @@ Example Response Structure:
 \`\`\`
 
 Ensure ALL file paths provided in the input context have a corresponding key in the output "summaries" object. Do NOT include explanations, comments, or any other text outside the single JSON object response.
+`.trim(),
+
+    /**
+     * Prompt for one-line summaries of a BATCH of symbols (classes, functions, methods).
+     * @param batchSymbolContent Concatenated symbol snippets, each preceded by a 'Symbol: <path>#<name>' header.
+     * @param symbolIds The `<path>#<name>` ids included in the batch.
+     * @returns The formatted prompt string.
+     */
+    batchSummarizeSymbolsPrompt: (batchSymbolContent: string, symbolIds: string[]): string => `
+CONTEXT: You are an AI assistant indexing the symbols (classes, functions, methods, components) of source files. Each symbol shows its declaration and the start of its body.
+SYMBOLS IN BATCH:
+${batchSymbolContent}
+---
+TASK: For EACH symbol above, write a one-line summary (at most 20 words) of what it does. Focus on *what*, not *how*.
+
+Respond ONLY with a single JSON object containing a single key "summaries" whose value is an object mapping each **exact symbol id** (the text after "Symbol: ", e.g. "src/lib/utils.ts#parseConfig") to its summary string.
+
+Example Response Structure:
+\`\`\`json
+{
+  "summaries": {
+    "src/lib/utils.ts#parseConfig": "Parses and validates the YAML configuration into typed settings.",
+    "src/lib/Cache.ts#Cache.get": "Returns a cached value by key, refreshing its LRU position."
+  }
+}
+\`\`\`
+
+Ensure ALL ${symbolIds.length} symbol ids have a key in the output. Do NOT include any other text outside the JSON object.
 `.trim(),
 
     /**
@@ -58,13 +86,15 @@ Ensure ALL file paths provided in the input context have a corresponding key in
      * @param historySummary A brief summary of recent conversation history (optional).
      * @param cacheSummary A formatted string listing files, types, sizes, and summaries from the cache.
      * @param fileContentTokenBudget The approximate token budget available for loading full file content.
+     * @param learnedHints Files that were changed/referenced for similar past queries (optional).
      * @returns The formatted prompt string.
      */
     selectRelevantFilesPrompt: (
         userQuery: string,
         historySummary: string | null,
         cacheSummary: string,
-        fileContentTokenBudget: number
+        fileContentTokenBudget: number,
+        learnedHints: string[] = []
     ): string => `
 CONTEXT: You are an AI assistant responsible for selecting the most relevant files to include in the context for answering a user's query based on a project analysis summary.
 
@@ -75,16 +105,40 @@ ${historySummary ? `RECENT CONVERSATION SUMMARY:\n${historySummary}\n` : ''}
 PROJECT ANALYSIS SUMMARY:
 ${cacheSummary}
 ---
-TASK: Analyze the User Query (and Conversation Summary, if provided) in the context of the Project Analysis Summary. Identify the files whose **full content** is most likely needed to address the user's query accurately and completely.
+${learnedHints.length > 0 ? `FILES THAT WERE NEEDED FOR SIMILAR PAST REQUESTS (hints only; include them if they fit this query):\n${learnedHints.join('\n')}\n---\n` : ''}TASK: Analyze the User Query (and Conversation Summary, if provided) in the context of the Project Analysis Summary. Identify the files whose **full content** is most likely needed to address the user's query accurately and completely.
+
+Large files may list their symbols as \`path#Symbol\` lines with line ranges. When only part of such a file is relevant, select those symbol ids instead of the whole file path so that only that code is included.
 
 Consider the file summaries, types, and sizes. The total token count of the full content of the files you select should ideally fit within a budget of approximately **${fileContentTokenBudget} tokens**. Prioritize files directly related to the query's entities and actions. Include essential configuration or utility files if relevant. Do not select binary files unless the query specifically asks about them.
 
-Respond ONLY with a list of the selected relative file paths, one path per line. Do NOT include explanations, apologies, greetings, or any other text. If no files seem particularly relevant, respond with "NONE".
+Respond ONLY with a list of the selected relative file paths (or \`path#Symbol\` ids), one per line. Do NOT include explanations, apologies, greetings, or any other text. If no files seem particularly relevant, respond with "NONE".
 
 Example Response:
 src/controllers/UserController.ts
 src/views/user/profile.html
 src/models/User.ts
+src/services/UserService.ts#UserService.updateProfile
 config/routes.ts
 `.trim(),
-};
\ No newline at end of file
+
+    /**
+     * Prompt for refining locally proposed .kaiignore rules from a compact token budget histogram.
+     * Sends aggregates only, never the raw file list, so it stays small on large repositories.
+     * @param histogram Output of TokenBudgetProfiler.formatHistogram.
+     * @param suggestedKaiignore Locally proposed .kaiignore content (ranked rules).
+     * @returns The formatted prompt string.
+     */
+    refineKaiignorePrompt: (histogram: string, suggestedKaiignore: string): string => `
+CONTEXT: You are an AI assistant helping keep an AI coding assistant's context window small. Below is a token budget histogram of a project (estimated tokens, bytes and file counts per classification, directory and extension), followed by .kaiignore rules proposed locally from that histogram. .kaiignore uses .gitignore syntax.
+
+TOKEN BUDGET HISTOGRAM:
+${histogram}
+
+LOCALLY PROPOSED .kaiignore:
+${suggestedKaiignore}
+---
+TASK: Produce the final .kaiignore. Keep the proposed rules unless one would hide hand-written source code. Add rules for other directories or extensions in the histogram that are clearly not useful for code generation (build output, vendored code, large data or fixtures). Never ignore the main source directories.
+
+Respond ONLY with the .kaiignore file contents. Comments starting with '#' are allowed.
+`.trim(),
+};
@@ -1,4 +1,15 @@
 // src/lib/analysis/types.ts
+
+/** A top-level symbol within a file, so context builders can include part of a large file. */
+export interface SymbolEntry {
+    name: string; // e.g. "parseConfig" or "UserService.save" for methods
+    kind: 'class' | 'function' | 'component' | 'method';
+    startLine: number; // 1-based, inclusive (includes leading doc comments/decorators)
+    endLine: number; // 1-based, inclusive
+    signature: string; // Declaration header, collapsed to one line
+    summary: string | null; // AI-generated one-line summary (null if not summarized)
+}
+
 export interface AnalysisCacheEntry {
     filePath: string; // Relative path from project root
     type: 'binary' | 'text_large' | 'text_analyze'; // File classification
@@ -6,6 +17,7 @@ export interface AnalysisCacheEntry {
     loc: number | null; // Lines of Code (null for binary/large)
     summary: string | null; // AI-generated summary (null for non-analyzed)
     lastAnalyzed: string; // ISO timestamp of when this entry was created/updated
+    symbols?: SymbolEntry[]; // Only for larger source files; absent in caches written before symbol analysis
 }
 
 // --- UPDATED: Top-level Cache Structure for Milestone 2 ---
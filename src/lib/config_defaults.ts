@@ -18,21 +18,36 @@ project:
 # --- Analysis & Context Caching (Optional) ---
 # analysis:
 #   cache_file_path: ".kai/project_analysis.json" # Location for the analysis cache
+#   shared_summary_cache: true # Reuse summaries across clones/worktrees/branches (~/.cache/kai/summaries, or $KAI_CACHE_DIR)
 #   # phind_command is no longer configurable; Kai checks for 'phind' then falls back to 'find'.
 
 # --- Context Mode (Determined automatically on first run if not set) ---
 # The 'context.mode' setting will be added here automatically after the first run.
-# Options: "full", "analysis_cache", "dynamic"
+# Options: "full", "analysis_cache", "dynamic", "auto" (chooses one of the others on each prompt)
+# context:
+#   retrieval_tools: false # Gemini only: send a file overview and let the model read/grep the code it needs
+#   max_tool_rounds: 6 # Tool round trips per chat turn (calls within a round run concurrently)
+#   delta_mode: false # After the first full context, send only files changed since it
+#                     # Only for models with prompt caching (OpenAI, Gemini 2.5+): the full context is still resent
+#   delta_reanchor_turns: 20 # Delta turns before the full context is sent again
+
+# --- Memory Budget (Optional) ---
+# Caches are shed, and 'full' context falls back to a cheaper tier, before the heap exceeds this budget.
+# memory:
+#   heap_budget_mb: 2048 # Default: 80% of the Node heap limit
+#   shed_ratio: 0.85 # Start shedding caches above this fraction of the budget
 
 # --- Gemini Configuration ---
 gemini:
   # API Key is read from the GEMINI_API_KEY environment variable, not set here.
+  # Several keys (GEMINI_API_KEYS, comma-separated) form a key pool; calls are spread across them.
   model_name: "gemini-2.5-pro" # Default primary model (Pro)
   subsequent_chat_model_name: "gemini-2.5-flash" # Default secondary model (Flash)
   max_output_tokens: 8192 # Max tokens for model response
   max_prompt_tokens: 32000 # Max tokens for input context (adjust based on model limits)
   rate_limit:
-    requests_per_minute: 60
+    requests_per_minute: 60 # Per API key
+    # key_quarantine_ms: 60000 # Cooldown for a rate-limited pool key; doubles on each repeat
   # Specific retries for the generation step (Consolidation Step B)
   generation_max_retries: 3 # Retries for consolidation generation step
   generation_retry_base_delay_ms: 2000 # Base delay for generation retries (ms)
@@ -40,7 +55,10 @@ gemini:
 
 # --- OpenAI Configuration (optional) ---
 openai:
-  # API key read from OPENAI_API_KEY environment variable
+  # API key read from OPENAI_API_KEY environment variable (several: OPENAI_API_KEYS)
   max_output_tokens: 8192
   max_prompt_tokens: 128000
+  # rate_limit: # Per OpenAI key, like gemini.rate_limit (same defaults)
+  #   requests_per_minute: 60
+  #   key_quarantine_ms: 60000
 `;
\ No newline at end of file
@@ -95,6 +95,23 @@ describe('ConsolidationAnalyzer detailed', () => {
     expect(res).toEqual({ operations: [] });
   });
 
+  test('analyze keeps only groups of two or more generated files', async () => {
+    ai.getResponseTextFromAI.mockResolvedValueOnce(JSON.stringify({
+      operations: [
+        { filePath: 'src/api.ts', action: 'MODIFY' },
+        { filePath: 'src/impl.ts', action: 'MODIFY' },
+        { filePath: 'src/impl.test.ts', action: 'CREATE' },
+        { filePath: 'src/old.ts', action: 'DELETE' },
+      ],
+      groups: [['/src/api.ts', 'src/impl.ts', 'src/old.ts', 'src/unknown.ts'], ['src/impl.ts', 'src/impl.test.ts'], 'bad'],
+    }));
+    const res = await analyzer.analyze([], 'ctx', '/c', false, 'model');
+    expect(res.groups).toEqual([['src/api.ts', 'src/impl.ts']]);
+
+    ai.getResponseTextFromAI.mockResolvedValueOnce(JSON.stringify({ operations: [{ filePath: 'a.ts', action: 'CREATE' }], groups: [['a.ts']] }));
+    expect(await analyzer.analyze([], 'ctx', '/c', false, 'model')).toEqual({ operations: [{ filePath: 'a.ts', action: 'CREATE' }] });
+  });
+
   test('parseAndAdaptAnalysisResponse matches fenced snippet', () => {
     expect(() => (analyzer as any)._parseAndAdaptAnalysisResponse('```x```', 'm')).toThrow(/Failed to parse JSON analysis/);
   });
@@ -74,6 +74,13 @@ export class ConsolidationAnalyzer {
 
             // Step 3: Validate and Normalize Operations (Accepts looser type, returns strict type)
             analysis.operations = this._validateAndNormalizeOperations(analysis.operations as RawOperationFromAI[]); // Cast input here
+            const groups = this._validateGroups(analysis.groups, analysis.operations);
+            if (groups.length > 0) {
+                analysis.groups = groups;
+                console.log(chalk.dim(`      ${groups.length} group(s) of related files will be generated together.`));
+            } else {
+                delete analysis.groups;
+            }
 
             console.log(chalk.cyan(`    Analysis received from ${modelName}. Found ${analysis.operations.length} valid operations.`));
             if (analysis.operations.length === 0) {
@@ -265,6 +272,37 @@ export class ConsolidationAnalyzer {
         return validOperations; // Return the array of strictly typed operations
     }
 
+    /**
+     * Keeps only usable groups: paths normalized like operations and limited to CREATE/MODIFY
+     * targets, each file in at most one group (first wins), and at least two files per group.
+     * @param groups The raw "groups" value from the parsed AI response.
+     * @param operations The validated operations.
+     * @returns The cleaned groups (empty when the AI gave none).
+     */
+    private _validateGroups(groups: unknown, operations: ConsolidationAnalysis['operations']): string[][] {
+        if (!Array.isArray(groups)) return [];
+        const generated = new Set(operations.filter(op => op.action !== 'DELETE').map(op => op.filePath));
+        const assigned = new Set<string>();
+        const validGroups: string[][] = [];
+        for (const group of groups) {
+            if (!Array.isArray(group)) continue;
+            const members: string[] = [];
+            for (const filePath of group) {
+                if (typeof filePath !== 'string') continue;
+                const normalizedPath = path.normalize(filePath).replace(/^[\\\/]+|[\\\/]+$/g, '');
+                if (!generated.has(normalizedPath) || assigned.has(normalizedPath)) continue;
+                assigned.add(normalizedPath);
+                members.push(normalizedPath);
+            }
+            if (members.length >= 2) {
+                validGroups.push(members);
+            } else {
+                members.forEach(member => assigned.delete(member));
+            }
+        }
+        return validGroups;
+    }
+
     /**
      * Logs an error message to the conversation file.
      * @param conversationFilePath The path to the conversation log file.
@@ -1,6 +1,8 @@
 // File: src/lib/consolidation/ConsolidationGenerator.ts
 import path from 'path';
 import chalk from 'chalk';
+import { tracer } from '../telemetry/Tracer';
+import { metrics } from '../telemetry/Metrics';
 import { FileSystem } from '../FileSystem';
 import { AIClient, LogEntryData } from '../AIClient';
 import { Config } from '../Config'; // Keep Config
@@ -8,7 +10,14 @@ import { Config } from '../Config'; // Keep Config
 import { Message } from '../models/Conversation'; // <-- Import Message directly
 import { ConsolidationPrompts } from './prompts';
 import { FinalFileStates, ConsolidationAnalysis } from './types';
-import { HIDDEN_CONSOLIDATION_GENERATION_INSTRUCTION } from '../internal_prompts'; // Import hidden instruction
+import { HIDDEN_CONSOLIDATION_GENERATION_INSTRUCTION, HIDDEN_CONSOLIDATION_GROUP_GENERATION_INSTRUCTION } from '../internal_prompts'; // Import hidden instructions
+import { ESTIMATED_TOKENS_PER_BYTE } from '../analysis/TokenBudgetProfiler';
+import { GenerationOrder } from './GenerationOrder';
+
+const GROUP_OUTPUT_SHARE = 0.8;         // Grouped output may use at most this share of max_output_tokens (estimates are rough)
+const MODIFIED_FILE_GROWTH = 1.2;       // Modified files usually come back a little longer
+const NEW_FILE_OUTPUT_TOKENS = 1500;    // Output estimate for a file that doesn't exist yet
+const FILE_BLOCK_OVERHEAD_TOKENS = 20;  // "=== FILE ===" / "=== END FILE ===" markers
 
 export class ConsolidationGenerator {
     private config: Config;
@@ -71,17 +80,44 @@ export class ConsolidationGenerator {
         if (filesToGenerate.length === 0) {
             console.log(chalk.yellow("    No files require content generation based on analysis."));
         } else {
-            console.log(chalk.cyan(`    Generating content for ${filesToGenerate.length} file(s) individually using ${modelName}...`));
-            for (const filePath of filesToGenerate) {
-                await this._generateContentForFile(
-                    filePath,
+            // Related files (analysis groups) share one call when their output fits the budget
+            const currentContents = new Map<string, string | null>();
+            const units = await this._planGenerationUnits(filesToGenerate, analysisResult.groups ?? [], currentContents);
+            const files = units.flat();
+            for (const filePath of files) {
+                if (!currentContents.has(filePath)) currentContents.set(filePath, await this._readCurrentFileContent(filePath));
+            }
+            // Files are generated after the files they import; calls within a level run in parallel
+            const levels = GenerationOrder.levels(units, GenerationOrder.dependencies(files, currentContents));
+            metrics.observe('consolidation.generation_levels', levels.length, undefined, 'count');
+            console.log(chalk.cyan(`    Generating content for ${filesToGenerate.length} file(s) in ${units.length} call(s) over ${levels.length} dependency level(s) using ${modelName}...`));
+
+            let levelContext = codeContext;
+            const apiChanges: string[] = [];
+            for (let i = 0; i < levels.length; i++) {
+                await Promise.all(levels[i].map(unit => this._generateUnit(
+                    unit,
+                    currentContents,
                     finalStates,
-                    codeContext,
+                    levelContext,
                     historyString, // Pass the potentially sliced history string
                     useFlashModel,
                     modelName,
                     conversationFilePath
-                );
+                )));
+                if (i === levels.length - 1) break;
+                // Later levels see the exported API this level produced, not just the old code
+                for (const filePath of levels[i].flat()) {
+                    const generated = finalStates[filePath];
+                    if (generated === undefined) continue;
+                    const change = generated === 'DELETE_CONFIRMED'
+                        ? `File: ${filePath}\n  (deleted)`
+                        : GenerationOrder.apiChanges(filePath, currentContents.get(filePath) ?? null, generated);
+                    if (change) apiChanges.push(change);
+                }
+                if (apiChanges.length > 0) {
+                    levelContext = `${codeContext}\n---\nEXPORTED API CHANGED EARLIER IN THIS CONSOLIDATION (the code above may predate it; use these signatures):\n${apiChanges.join('\n')}\n`;
+                }
             }
         }
 
@@ -112,17 +148,7 @@ export class ConsolidationGenerator {
             currentContent
         );
 
-        // Optionally prepend consolidation guidelines from Kai-consolidation.md if present
-        let promptWithGuidelines = basePrompt;
-        try {
-            const guidePath = path.resolve(this.projectRoot, 'Kai-consolidation.md');
-            const guideContent = await this.fileSystem.readFile(guidePath);
-            if (guideContent && guideContent.trim()) {
-                promptWithGuidelines = `GUIDELINES (Consolidation):\n${guideContent.trim()}\n\n---\n${basePrompt}`;
-            }
-        } catch (e) {
-            // ignore
-        }
+        const promptWithGuidelines = await this._withConsolidationGuidelines(basePrompt);
 
         // Prepend the hidden instruction directly from import
         const finalPromptToSend = `${HIDDEN_CONSOLIDATION_GENERATION_INSTRUCTION}\n\n---\n\n${promptWithGuidelines}`;
@@ -149,6 +175,8 @@ export class ConsolidationGenerator {
                     if (attempt < maxAttempts) {
                         attempt++;
                         console.warn(chalk.yellow(`      Empty content generated for ${normalizedPath}. Retrying (${attempt}/${maxAttempts})...`));
+                        tracer.instant('consolidation.retry', 'consolidation', { file: normalizedPath, attempt, reason: 'empty content' });
+                        metrics.increment('consolidation.retries');
                         continue;
                     } else {
                         throw new Error('AI returned empty content');
@@ -171,6 +199,180 @@ export class ConsolidationGenerator {
         }
     }
 
+    /** Generates one unit: a single file, or a group of related files in one call. */
+    private async _generateUnit(
+        unit: string[],
+        currentContents: Map<string, string | null>,
+        finalStates: FinalFileStates,
+        codeContext: string,
+        historyString: string,
+        useFlashModel: boolean,
+        modelName: string,
+        conversationFilePath: string
+    ): Promise<void> {
+        if (unit.length > 1) {
+            await tracer.span('consolidation.generateGroup', 'consolidation', () => this._generateContentForGroup(
+                unit,
+                currentContents,
+                finalStates,
+                codeContext,
+                historyString,
+                useFlashModel,
+                modelName,
+                conversationFilePath
+            ), { files: unit.length });
+            return;
+        }
+        await tracer.span('consolidation.generateFile', 'consolidation', () => this._generateContentForFile(
+            unit[0],
+            finalStates,
+            codeContext,
+            historyString,
+            useFlashModel,
+            modelName,
+            conversationFilePath
+        ), { file: unit[0] });
+    }
+
+    /**
+     * Splits the files to generate into calls: each analysis group becomes one or more grouped
+     * calls whose estimated output fits the output budget, everything else is generated on its
+     * own. Keeps the analysis order. Current contents read for grouped files are cached in
+     * `currentContents` for the prompts.
+     */
+    private async _planGenerationUnits(
+        filesToGenerate: string[],
+        groups: string[][],
+        currentContents: Map<string, string | null>
+    ): Promise<string[][]> {
+        const normalize = (filePath: string) => path.normalize(filePath).replace(/^[\\\/]+|[\\\/]+$/g, '');
+        const files = filesToGenerate.map(normalize);
+        const groupOf = new Map<string, string[]>();
+        for (const group of groups) {
+            const members = [...new Set(group.map(normalize))].filter(member => files.includes(member) && !groupOf.has(member));
+            if (members.length > 1) members.forEach(member => groupOf.set(member, members));
+        }
+
+        const budget = (this.config.gemini.max_output_tokens ?? 8192) * GROUP_OUTPUT_SHARE;
+        const units: string[][] = [];
+        const planned = new Set<string>();
+        for (const filePath of files) {
+            if (planned.has(filePath)) continue;
+            const group = groupOf.get(filePath);
+            if (!group) {
+                units.push([filePath]);
+                planned.add(filePath);
+                continue;
+            }
+            // First fit in group order; a file too large to share a call ends up alone
+            const chunks: Array<{ files: string[]; tokens: number }> = [];
+            for (const member of group) {
+                planned.add(member);
+                const content = await this._readCurrentFileContent(member);
+                currentContents.set(member, content);
+                const tokens = (content === null ? NEW_FILE_OUTPUT_TOKENS : Math.ceil(content.length * ESTIMATED_TOKENS_PER_BYTE * MODIFIED_FILE_GROWTH)) + FILE_BLOCK_OVERHEAD_TOKENS;
+                const chunk = chunks.find(c => c.tokens + tokens <= budget);
+                if (chunk) {
+                    chunk.files.push(member);
+                    chunk.tokens += tokens;
+                } else {
+                    chunks.push({ files: [member], tokens });
+                }
+            }
+            units.push(...chunks.map(c => c.files));
+        }
+        return units;
+    }
+
+    /**
+     * Generates several related files with one call. Files the response leaves out, or leaves
+     * empty, and all files of a failed call are generated individually afterwards.
+     */
+    private async _generateContentForGroup(
+        filePaths: string[],
+        currentContents: Map<string, string | null>,
+        finalStates: FinalFileStates,
+        codeContext: string,
+        historyString: string,
+        useFlashModel: boolean,
+        modelName: string,
+        conversationFilePath: string
+    ): Promise<void> {
+        console.log(chalk.cyan(`      Generating content together for: ${filePaths.join(', ')}`));
+        const basePrompt = ConsolidationPrompts.groupFileGenerationPrompt(
+            codeContext,
+            historyString,
+            filePaths.map(filePath => ({ filePath, currentContent: currentContents.get(filePath) ?? null }))
+        );
+        const finalPromptToSend = `${HIDDEN_CONSOLIDATION_GROUP_GENERATION_INSTRUCTION}\n\n---\n\n${await this._withConsolidationGuidelines(basePrompt)}`;
+
+        let missing = filePaths;
+        try {
+            const responseTextRaw = await this._callGenerationAIWithRetry(finalPromptToSend, `group of ${filePaths.length} files`, useFlashModel);
+            const blocks = this._parseGroupGenerationResponse(responseTextRaw);
+            missing = [];
+            for (const filePath of filePaths) {
+                const block = blocks.get(filePath);
+                const content = block === undefined ? '' : this._parseGenerationAIResponse(block, filePath, conversationFilePath);
+                if (content !== 'DELETE_CONFIRMED' && content.length === 0) {
+                    missing.push(filePath);
+                    continue;
+                }
+                finalStates[filePath] = content;
+                if (content === 'DELETE_CONFIRMED') {
+                    console.log(chalk.yellow(`      AI suggested DELETE for ${filePath}. Marked for deletion.`));
+                } else {
+                    console.log(chalk.green(`      Successfully generated content for ${filePath} (${content.length} characters)`));
+                }
+            }
+            metrics.increment('consolidation.group_calls');
+            metrics.increment('consolidation.group_files', undefined, filePaths.length - missing.length);
+        } catch (error) {
+            console.warn(chalk.yellow(`      Grouped generation failed using ${modelName}: ${(error as Error).message}`));
+        }
+
+        if (missing.length > 0) {
+            console.warn(chalk.yellow(`      Generating ${missing.join(', ')} individually instead.`));
+            metrics.increment('consolidation.group_fallbacks', undefined, missing.length);
+            for (const filePath of missing) {
+                await tracer.span('consolidation.generateFile', 'consolidation', () => this._generateContentForFile(
+                    filePath,
+                    finalStates,
+                    codeContext,
+                    historyString,
+                    useFlashModel,
+                    modelName,
+                    conversationFilePath
+                ), { file: filePath });
+            }
+        }
+    }
+
+    /** Splits a grouped response into file path -> raw content. */
+    private _parseGroupGenerationResponse(responseTextRaw: string): Map<string, string> {
+        const blocks = new Map<string, string>();
+        const blockPattern = /^=== FILE: (.+?) ===[ \t]*\r?\n([\s\S]*?)\r?\n=== END FILE ===[ \t]*$/gm;
+        for (const match of responseTextRaw.matchAll(blockPattern)) {
+            const filePath = path.normalize(match[1].trim().replace(/^['"`]|['"`]$/g, '')).replace(/^[\\\/]+|[\\\/]+$/g, '');
+            blocks.set(filePath, match[2]);
+        }
+        return blocks;
+    }
+
+    /** Prepends consolidation guidelines from Kai-consolidation.md if present. */
+    private async _withConsolidationGuidelines(basePrompt: string): Promise<string> {
+        try {
+            const guidePath = path.resolve(this.projectRoot, 'Kai-consolidation.md');
+            const guideContent = await this.fileSystem.readFile(guidePath);
+            if (guideContent && guideContent.trim()) {
+                return `GUIDELINES (Consolidation):\n${guideContent.trim()}\n\n---\n${basePrompt}`;
+            }
+        } catch (e) {
+            // ignore
+        }
+        return basePrompt;
+    }
+
     /** Reads the current content of a file, handling ENOENT. */
     private async _readCurrentFileContent(normalizedPath: string): Promise<string | null> {
         try {
@@ -209,6 +411,8 @@ export class ConsolidationGenerator {
                      attempt++;
                      const delay = baseDelay * Math.pow(2, attempt - 1) + Math.random() * 1000;
                      console.warn(chalk.yellow(`        AI Error for ${filePathForLog} (Attempt ${attempt}/${maxAttempts + 1}): ${aiError.message || aiError.code}. Retrying in ${(delay / 1000).toFixed(1)}s...`));
+                     tracer.instant('consolidation.retry', 'consolidation', { file: filePathForLog, attempt, reason: aiError.code || 'ai error', delayMs: Math.round(delay) });
+                     metrics.increment('consolidation.retries');
                      await new Promise(resolve => setTimeout(resolve, delay));
                  } else {
                      console.error(chalk.red(`        Failed AI call for ${filePathForLog} after ${attempt + 1} attempts.`));
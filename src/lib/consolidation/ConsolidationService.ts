@@ -13,8 +13,13 @@ import { ConsolidationGenerator } from './ConsolidationGenerator';
 import { ConsolidationApplier } from './ConsolidationApplier';
 import { ConsolidationAnalyzer } from './ConsolidationAnalyzer';
 import { FinalFileStates, ConsolidationAnalysis } from './types';
-import { CONSOLIDATION_SUCCESS_MARKER } from './constants';
+import { CONSOLIDATION_SUCCESS_MARKER, CONSOLIDATION_CHANGED_FILES_PREFIX } from './constants';
 import { FeedbackLoop } from './feedback/FeedbackLoop';
+import { tracer } from '../telemetry/Tracer';
+import { metrics } from '../telemetry/Metrics';
+import { profiler } from '../telemetry/Profiler';
+import { taskScheduler } from '../scheduling/TaskScheduler';
+import { RelevanceFeedback, relevanceFeedback } from '../analysis/RelevanceFeedback';
 
 interface ModelSelection {
     analysisModelName: string;
@@ -37,6 +42,7 @@ export class ConsolidationService {
     private consolidationApplier: ConsolidationApplier;
     private consolidationAnalyzer: ConsolidationAnalyzer;
     private feedbackLoops: FeedbackLoop[];
+    private relevanceFeedback: RelevanceFeedback;
 
     constructor(
         config: Config,
@@ -46,7 +52,8 @@ export class ConsolidationService {
         gitService: GitService,
         ui: UserInterface,
         commitMessageService: CommitMessageService,
-        feedbackLoops: FeedbackLoop[] = []
+        feedbackLoops: FeedbackLoop[] = [],
+        feedback: RelevanceFeedback = relevanceFeedback
     ) {
         this.config = config;
         this.fs = fileSystem;
@@ -62,6 +69,7 @@ export class ConsolidationService {
         this.consolidationApplier = new ConsolidationApplier(this.fs);
         this.consolidationAnalyzer = new ConsolidationAnalyzer(this.aiClient);
         this.feedbackLoops = feedbackLoops;
+        this.relevanceFeedback = feedback;
     }
 
     /**
@@ -81,17 +89,38 @@ export class ConsolidationService {
         conversation: Conversation, // Receive the full conversation
         currentContextString: string,
         conversationFilePath: string
+    ): Promise<void> {
+        try {
+            // Model calls made during consolidation queue behind chat turns but ahead of background work
+            await taskScheduler.withPriority('consolidation', () => tracer.span('consolidation', 'consolidation',
+                () => metrics.time('consolidation.duration_ms', undefined,
+                    () => profiler.around('consolidation',
+                        () => this._process(conversationName, conversation, currentContextString, conversationFilePath))),
+                { conversation: conversationName }));
+        } finally {
+            // One trace file per consolidation (no-op unless tracing is enabled)
+            await tracer.flush(this.projectRoot, `consolidation-${conversationName}`);
+        }
+    }
+
+    private async _process(
+        conversationName: string,
+        conversation: Conversation,
+        currentContextString: string,
+        conversationFilePath: string
     ): Promise<void> {
         await this._logStart(conversationName, conversationFilePath);
         let consolidationSucceeded = false; // Flag to track success for logging marker
         let changesApplied = false; // Flag to track if apply step actually ran successfully
+        let appliedFiles: string[] = [];
+        let relevantHistory: Message[] = [];
 
         try {
             // Step 0: Git Check
-            await this._performGitCheck(conversationFilePath);
+            await tracer.span('consolidation.gitCheck', 'consolidation', () => this._performGitCheck(conversationFilePath));
 
             // --- Step 0.5: Determine Relevant History ---
-            const relevantHistory = this._findRelevantHistorySlice(conversation);
+            relevantHistory = this._findRelevantHistorySlice(conversation);
             if (relevantHistory.length === 0) {
                 console.log(chalk.yellow("  No relevant new conversation history found since last successful consolidation. Skipping."));
                 await this._logSystemMessage(conversationFilePath, "System: No new history since last successful consolidation. Skipping.");
@@ -104,22 +133,22 @@ export class ConsolidationService {
             const models = this._determineModels();
 
             // Step A: Analyze (using relevant history)
-            const analysisResult = await this._runAnalysisStep(
+            const analysisResult = await tracer.span('consolidation.analyze', 'consolidation', () => this._runAnalysisStep(
                 relevantHistory, // Pass the slice
                 currentContextString,
                 conversationFilePath,
                 models
-            );
+            ), { messages: relevantHistory.length });
             if (!analysisResult) return; // Analysis found nothing or failed critically
 
             // Step B: Generate (using relevant history)
-            const finalStates = await this._runGenerationStep(
+            const finalStates = await tracer.span('consolidation.generate', 'consolidation', () => this._runGenerationStep(
                 relevantHistory, // Pass the slice
                 currentContextString,
                 analysisResult,
                 conversationFilePath,
                 models
-            );
+            ), { operations: analysisResult.operations.length });
 
             // REMOVED: Step C: Review
             // const userApproved = await this._runReviewStep(finalStates); // REMOVED
@@ -130,12 +159,17 @@ export class ConsolidationService {
 
             while (iterations > 0) {
                 // Step C: Apply (always attempts if generation succeeded)
-                changesApplied = await this._runApplyStep(states, conversationFilePath);
+                changesApplied = await tracer.span('consolidation.apply', 'consolidation', () => this._runApplyStep(states, conversationFilePath));
+                appliedFiles = Object.keys(states);
 
                 const loopLogs: string[] = [];
                 loopsOk = true;
                 for (const loop of this.feedbackLoops) {
-                    const result = await loop.run(this.projectRoot);
+                    const loopName = loop.constructor.name;
+                    const result = await tracer.span('consolidation.feedbackLoop', 'feedback',
+                        () => metrics.time('feedback.duration_ms', { loop: loopName }, () => loop.run(this.projectRoot)),
+                        { loop: loopName });
+                    metrics.increment(result.success ? 'feedback.passed' : 'feedback.failed', { loop: loopName });
                     if (result.log) loopLogs.push(result.log);
                     if (!result.success) loopsOk = false;
                 }
@@ -150,24 +184,32 @@ export class ConsolidationService {
 
                 const errorMessage: Message = { role: 'system', content: `Compilation errors:\n${loopLogs.join('\n')}` };
                 const retryHistory = relevantHistory.concat(errorMessage);
-                states = await this._runGenerationStep(
+                states = await tracer.span('consolidation.generate', 'consolidation', () => this._runGenerationStep(
                     retryHistory,
                     currentContextString,
                     analysisResult,
                     conversationFilePath,
                     models
-                );
+                ), { operations: analysisResult.operations.length, retry: true });
             }
 
         } catch (error) {
             await this._handleConsolidationError(error, conversationName, conversationFilePath);
             consolidationSucceeded = false; // Ensure flag is false on error
         } finally {
+            if (changesApplied && appliedFiles.length > 0) {
+                // Before the marker, so the next consolidation's history slice doesn't include it
+                await this._logSystemMessage(conversationFilePath,
+                    `${CONSOLIDATION_CHANGED_FILES_PREFIX}\n${appliedFiles.map(f => `- ${f}`).join('\n')}`);
+            }
             // Add success marker only if the process completed without errors AND changes were applied
             if (consolidationSucceeded) {
                 await this._logSuccessMarker(conversationFilePath);
                 conversation.addMessage('system', CONSOLIDATION_SUCCESS_MARKER); // Add to in-memory convo too
             }
+            if (changesApplied) {
+                await this._recordRelevanceOutcome(conversationFilePath, appliedFiles, relevantHistory);
+            }
         }
     }
 
@@ -375,6 +417,19 @@ export class ConsolidationService {
         // No need to re-throw here, as the main process loop will terminate.
     }
 
+    /** Scores this conversation's dynamic context selections since its last consolidation against what was applied. */
+    private async _recordRelevanceOutcome(conversationFilePath: string, appliedFiles: string[], relevantHistory: Message[]): Promise<void> {
+        try {
+            const records = await this.relevanceFeedback.recordOutcome(conversationFilePath, appliedFiles, relevantHistory.map(m => m.content).join('\n'));
+            if (records.length === 0) return;
+            const summary = RelevanceFeedback.summarize(records);
+            const recall = summary.recall === null ? 'n/a' : `${Math.round(summary.recall * 100)}%`;
+            console.log(chalk.dim(`  Context selection over ${records.length} turn(s): precision ${Math.round(summary.precision * 100)}%, recall ${recall}.`));
+        } catch (error) {
+            console.warn(chalk.yellow(`  Could not record relevance feedback: ${(error as Error).message}`));
+        }
+    }
+
     // --- Private Logging Helpers ---
 
     /** Logs an error message to the conversation file. */
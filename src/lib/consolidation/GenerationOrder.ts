@@ -0,0 +1,158 @@
+// File: src/lib/consolidation/GenerationOrder.ts
+import path from 'path';
+import { SymbolExtractor } from '../analysis/SymbolExtractor';
+
+const RESOLVE_EXTENSIONS = ['.ts', '.tsx', '.mts', '.cts', '.js', '.jsx', '.mjs', '.cjs', '.py'];
+// import ... from 'x' / export ... from 'x' / import 'x' / require('x') / import('x')
+const IMPORT_PATTERN = /(?:\bfrom\s*|\bimport\s*\(?\s*|\brequire\s*\(\s*)['"]([^'"\n]+)['"]/g;
+// Python: from .module import name / from ..pkg.module import name
+const PYTHON_RELATIVE_IMPORT = /^\s*from\s+(\.+)([\w.]*)\s+import\b/gm;
+
+/**
+ * Orders consolidation generation by the import graph between the files being generated, so
+ * a file is generated after the files it imports and can be told about their new exported
+ * signatures. Units (single files or generation groups) in the same level don't depend on each
+ * other and can be generated in parallel; import cycles are kept together in one level.
+ */
+export class GenerationOrder {
+    /**
+     * Relative imports from each file to other files in the set, resolved from the files'
+     * current content (files that don't exist yet have no known imports).
+     */
+    static dependencies(files: string[], contents: Map<string, string | null>): Map<string, Set<string>> {
+        const targets = new Set(files);
+        const deps = new Map<string, Set<string>>();
+        for (const file of files) {
+            const found = new Set<string>();
+            const content = contents.get(file);
+            if (typeof content === 'string') {
+                for (const specifier of GenerationOrder.relativeImports(file, content)) {
+                    const resolved = GenerationOrder._resolve(file, specifier, targets);
+                    if (resolved && resolved !== file) found.add(resolved);
+                }
+            }
+            deps.set(file, found);
+        }
+        return deps;
+    }
+
+    /** Relative module specifiers imported by a file, as written ('./a', '../lib/b'). */
+    static relativeImports(filePath: string, content: string): string[] {
+        const specifiers: string[] = [];
+        if (path.extname(filePath).toLowerCase() === '.py') {
+            for (const match of content.matchAll(PYTHON_RELATIVE_IMPORT)) {
+                const up = match[1].length - 1;
+                specifiers.push(`${up === 0 ? './' : '../'.repeat(up)}${match[2].replace(/\./g, '/')}`);
+            }
+            return specifiers;
+        }
+        for (const match of content.matchAll(IMPORT_PATTERN)) {
+            if (match[1].startsWith('.')) specifiers.push(match[1]);
+        }
+        return specifiers;
+    }
+
+    /**
+     * Groups units into levels: every unit comes after the units it imports from. Units on an
+     * import cycle share a level (Tarjan's strongly connected components).
+     * @param units Files generated together (a unit per call).
+     * @returns Levels of units, in generation order.
+     */
+    static levels(units: string[][], deps: Map<string, Set<string>>): string[][][] {
+        const unitOf = new Map<string, number>();
+        units.forEach((unit, i) => unit.forEach(file => unitOf.set(file, i)));
+        const edges = units.map((unit, i) => {
+            const targets = new Set<number>();
+            for (const file of unit) {
+                for (const dep of deps.get(file) ?? []) {
+                    const target = unitOf.get(dep);
+                    if (target !== undefined && target !== i) targets.add(target);
+                }
+            }
+            return [...targets];
+        });
+
+        // Tarjan emits components dependencies-first, so levels can be assigned in one pass
+        const index = new Array<number>(units.length).fill(-1);
+        const low = new Array<number>(units.length).fill(0);
+        const onStack = new Array<boolean>(units.length).fill(false);
+        const stack: number[] = [];
+        const componentOf = new Array<number>(units.length).fill(-1);
+        const componentLevels: number[] = [];
+        let counter = 0;
+        const connect = (v: number) => {
+            index[v] = low[v] = counter++;
+            stack.push(v);
+            onStack[v] = true;
+            for (const w of edges[v]) {
+                if (index[w] === -1) {
+                    connect(w);
+                    low[v] = Math.min(low[v], low[w]);
+                } else if (onStack[w]) {
+                    low[v] = Math.min(low[v], index[w]);
+                }
+            }
+            if (low[v] !== index[v]) return;
+            const component = componentLevels.length;
+            const members: number[] = [];
+            let w: number;
+            do {
+                w = stack.pop()!;
+                onStack[w] = false;
+                componentOf[w] = component;
+                members.push(w);
+            } while (w !== v);
+            let level = 0;
+            for (const member of members) {
+                for (const dep of edges[member]) {
+                    if (componentOf[dep] !== component) level = Math.max(level, componentLevels[componentOf[dep]] + 1);
+                }
+            }
+            componentLevels.push(level);
+        };
+        for (let v = 0; v < units.length; v++) {
+            if (index[v] === -1) connect(v);
+        }
+
+        const levels: string[][][] = [];
+        units.forEach((unit, i) => {
+            const level = componentLevels[componentOf[i]];
+            (levels[level] ??= []).push(unit);
+        });
+        return levels.filter(level => level && level.length > 0);
+    }
+
+    /**
+     * Describes how a file's exported API changed (new or changed signatures, removed names),
+     * or returns null when it didn't or the language has no symbol extractor.
+     */
+    static apiChanges(filePath: string, before: string | null, after: string): string | null {
+        if (!SymbolExtractor.supports(filePath)) return null;
+        const previous = new Map(SymbolExtractor.extract(filePath, before ?? '').map(s => [s.name, s.signature]));
+        const current = SymbolExtractor.extract(filePath, after);
+        const lines: string[] = [];
+        for (const symbol of current) {
+            if (previous.get(symbol.name) !== symbol.signature) lines.push(`  ${symbol.signature}`);
+        }
+        const currentNames = new Set(current.map(s => s.name));
+        const removed = [...previous.keys()].filter(name => !currentNames.has(name));
+        if (removed.length > 0) lines.push(`  (removed: ${removed.join(', ')})`);
+        return lines.length > 0 ? `File: ${filePath}\n${lines.join('\n')}` : null;
+    }
+
+    /** Resolves a relative specifier to a file in `targets` (exact, with extension, or index file). */
+    private static _resolve(fromFile: string, specifier: string, targets: Set<string>): string | null {
+        const base = path.posix.normalize(path.posix.join(path.posix.dirname(fromFile.split(path.sep).join('/')), specifier));
+        const stripped = base.replace(/\.(js|jsx|mjs|cjs)$/, ''); // TS sources imported with a .js suffix
+        const candidates = [base];
+        for (const stem of new Set([base, stripped])) {
+            for (const ext of RESOLVE_EXTENSIONS) candidates.push(`${stem}${ext}`, `${stem}/index${ext}`);
+        }
+        candidates.push(`${base}/__init__.py`);
+        for (const candidate of candidates) {
+            const native = candidate.split('/').join(path.sep);
+            if (targets.has(native)) return native;
+        }
+        return null;
+    }
+}
@@ -0,0 +1,111 @@
+import { ConsolidationGenerator } from '../ConsolidationGenerator';
+import { FileSystem } from '../../FileSystem';
+
+jest.spyOn(console, 'log').mockImplementation(() => {});
+jest.spyOn(console, 'warn').mockImplementation(() => {});
+jest.spyOn(console, 'error').mockImplementation(() => {});
+
+describe('ConsolidationGenerator grouped and ordered generation', () => {
+    let existing: Record<string, string>;
+    let aiClient: any;
+    let generator: ConsolidationGenerator;
+
+    const analysis = (groups?: string[][]) => ({
+        operations: [
+            { filePath: 'src/api.ts', action: 'MODIFY' as const },
+            { filePath: 'README.md', action: 'MODIFY' as const },
+            { filePath: 'src/impl.ts', action: 'MODIFY' as const },
+            { filePath: 'src/impl.test.ts', action: 'CREATE' as const },
+        ],
+        groups,
+    });
+
+    beforeEach(() => {
+        existing = { '/project/src/api.ts': 'export interface Api {}', '/project/src/impl.ts': 'x'.repeat(20000) };
+        const fsMock = {
+            readFile: jest.fn(async (filePath: string) => {
+                if (filePath in existing) return existing[filePath];
+                throw Object.assign(new Error('missing'), { code: 'ENOENT' });
+            }),
+        } as unknown as FileSystem;
+        aiClient = { getResponseTextFromAI: jest.fn(), logConversation: jest.fn() };
+        const config: any = { gemini: { generation_max_retries: 0, generation_retry_base_delay_ms: 0, max_output_tokens: 8192 } };
+        generator = new ConsolidationGenerator(config, fsMock, aiClient, '/project');
+    });
+
+    const prompts = (): string[] => aiClient.getResponseTextFromAI.mock.calls.map((call: any) => call[0][0].content);
+    const answerBy = (answers: Record<string, string>) => async ([message]: Array<{ content: string }>) => {
+        const key = Object.keys(answers).find(k => message.content.includes(k));
+        return key === undefined ? '' : answers[key];
+    };
+
+    it('generates a group in one call and splits groups whose output would not fit', async () => {
+        aiClient.getResponseTextFromAI.mockImplementation(answerBy({
+            '=== FILE: <file path> ===': "=== FILE: src/api.ts ===\nexport interface Api { run(): void }\n=== END FILE ===\n=== FILE: src/impl.test.ts ===\n```ts\ntest('runs', () => {});\n```\n=== END FILE ===",
+            "File Path: 'README.md'": '# Readme',
+            "File Path: 'src/impl.ts'": 'impl',
+        }));
+
+        const states = await generator.generate([], 'ctx', analysis([['src/api.ts', 'src/impl.ts', 'src/impl.test.ts']]), 'conv', false, 'model');
+
+        // impl.ts (~7200 output tokens) cannot share the 6553-token budget, so it goes alone
+        expect(aiClient.getResponseTextFromAI).toHaveBeenCalledTimes(3);
+        const grouped = prompts().filter(p => p.includes('=== FILE: <file path> ==='));
+        expect(grouped).toHaveLength(1);
+        expect(grouped[0]).toContain("- 'src/api.ts'\n- 'src/impl.test.ts'");
+        expect(grouped[0]).not.toContain("- 'src/impl.ts'");
+        expect(states).toEqual({
+            'src/api.ts': 'export interface Api { run(): void }',
+            'README.md': '# Readme',
+            'src/impl.ts': 'impl',
+            'src/impl.test.ts': "test('runs', () => {});",
+        });
+    });
+
+    it('generates files the grouped response left out individually', async () => {
+        existing['/project/src/impl.ts'] = 'export class Impl {}';
+        aiClient.getResponseTextFromAI.mockImplementation(answerBy({
+            '=== FILE: <file path> ===': '=== FILE: src/api.ts ===\napi\n=== END FILE ===', // impl.ts missing
+            "File Path: 'src/impl.ts'": 'impl',
+            "File Path: 'README.md'": 'readme',
+            "File Path: 'src/impl.test.ts'": 'test',
+        }));
+
+        const states = await generator.generate([], 'ctx', analysis([['src/api.ts', 'src/impl.ts']]), 'conv', false, 'model');
+
+        expect(prompts().filter(p => p.includes("File Path: 'src/impl.ts'"))).toHaveLength(1);
+        expect(states['src/api.ts']).toBe('api');
+        expect(states['src/impl.ts']).toBe('impl');
+        expect(states['README.md']).toBe('readme');
+        expect(states['src/impl.test.ts']).toBe('test');
+    });
+
+    it('generates importers after their dependencies and tells them about changed signatures', async () => {
+        existing = {
+            '/project/src/util.ts': 'export function load(path: string): string { return path; }',
+            '/project/src/app.ts': "import { load } from './util';\nexport const run = () => load('x');",
+        };
+        const started: string[] = [];
+        aiClient.getResponseTextFromAI.mockImplementation(async ([message]: Array<{ content: string }>) => {
+            const file = message.content.match(/File Path: '([^']+)'/)![1];
+            started.push(file);
+            return file === 'src/util.ts'
+                ? 'export async function load(path: string, encoding: string): Promise<string> { return path + encoding; }'
+                : `// ${file}`;
+        });
+
+        await generator.generate([], 'ctx', {
+            operations: [
+                { filePath: 'src/app.ts', action: 'MODIFY' },
+                { filePath: 'src/other.ts', action: 'CREATE' },
+                { filePath: 'src/util.ts', action: 'MODIFY' },
+            ],
+        }, 'conv', false, 'model');
+
+        expect(started.indexOf('src/util.ts')).toBeLessThan(started.indexOf('src/app.ts'));
+        const appPrompt = prompts().find(p => p.includes("File Path: 'src/app.ts'"))!;
+        expect(appPrompt).toContain('EXPORTED API CHANGED EARLIER IN THIS CONSOLIDATION');
+        expect(appPrompt).toContain('export async function load(path: string, encoding: string): Promise<string>');
+        expect(prompts().find(p => p.includes("File Path: 'src/other.ts'"))).not.toContain('EXPORTED API CHANGED');
+    });
+});
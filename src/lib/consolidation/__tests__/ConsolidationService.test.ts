@@ -1,6 +1,6 @@
 import Conversation, { Message } from '../../models/Conversation';
 import { ConsolidationService } from '../ConsolidationService';
-import { CONSOLIDATION_SUCCESS_MARKER } from '../constants';
+import { CONSOLIDATION_SUCCESS_MARKER, CONSOLIDATION_CHANGED_FILES_PREFIX } from '../constants';
 import { FileSystem } from '../../FileSystem';
 
 // Silence console output during tests
@@ -76,6 +76,23 @@ describe('ConsolidationService internals', () => {
     expect(last?.content).toBe(CONSOLIDATION_SUCCESS_MARKER);
   });
 
+  test('process logs the changed files before the success marker', async () => {
+    const { service, ai } = createService();
+    const convo = new Conversation(undefined, [ { role: 'user', content: 'x' } ] as Message[]);
+    (service as any)._performGitCheck = jest.fn();
+    (service as any)._determineModels = jest.fn().mockReturnValue({analysisModelName:'a',generationModelName:'b',useFlashForAnalysis:false,useFlashForGeneration:false});
+    (service as any)._runAnalysisStep = jest.fn().mockResolvedValue({ operations:[{ action:'CREATE', filePath:'a.ts' }] });
+    (service as any)._runGenerationStep = jest.fn().mockResolvedValue({ 'a.ts': 'x', 'old.ts': 'DELETE_CONFIRMED' });
+    (service as any)._runApplyStep = jest.fn().mockResolvedValue(true);
+
+    await service.process('conv', convo, 'ctx', 'file');
+
+    const contents = ai.logConversation.mock.calls.map((call: any[]) => call[1].content);
+    const changedIndex = contents.indexOf(`${CONSOLIDATION_CHANGED_FILES_PREFIX}\n- a.ts\n- old.ts`);
+    expect(changedIndex).toBeGreaterThan(-1);
+    expect(contents.indexOf(CONSOLIDATION_SUCCESS_MARKER)).toBeGreaterThan(changedIndex);
+  });
+
   test('process handles failure and does not log success', async () => {
     const { service } = createService();
     const convo = new Conversation(undefined, []);
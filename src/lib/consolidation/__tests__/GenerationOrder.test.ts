@@ -0,0 +1,48 @@
+import path from 'path';
+import { GenerationOrder } from '../GenerationOrder';
+
+const p = (posixPath: string) => posixPath.split('/').join(path.sep);
+
+describe('GenerationOrder', () => {
+  it('resolves relative imports to files being generated', () => {
+    const files = [p('src/a.ts'), p('src/lib/b.ts'), p('src/lib/index.ts'), p('pkg/mod.py'), p('pkg/util.py')];
+    const contents = new Map<string, string | null>([
+      [p('src/a.ts'), "import { b } from './lib/b.js';\nimport lib from './lib';\nimport fs from 'fs';\nconst c = require('../outside');"],
+      [p('src/lib/b.ts'), "export * from './index';\nconst lazy = () => import('./b');"],
+      [p('src/lib/index.ts'), null],
+      [p('pkg/mod.py'), 'from .util import helper\nimport os'],
+    ]);
+    const deps = GenerationOrder.dependencies(files, contents);
+    expect([...deps.get(p('src/a.ts'))!]).toEqual([p('src/lib/b.ts'), p('src/lib/index.ts')]);
+    expect([...deps.get(p('src/lib/b.ts'))!]).toEqual([p('src/lib/index.ts')]); // Self-import ignored
+    expect([...deps.get(p('pkg/mod.py'))!]).toEqual([p('pkg/util.py')]);
+    expect(deps.get(p('pkg/util.py'))!.size).toBe(0);
+  });
+
+  it('orders units into levels and keeps import cycles together', () => {
+    const deps = new Map<string, Set<string>>([
+      ['app', new Set(['service', 'types'])],
+      ['service', new Set(['repo'])],
+      ['repo', new Set(['service', 'types'])], // Cycle with service
+      ['types', new Set()],
+      ['readme', new Set()],
+      ['test', new Set(['app'])],
+    ]);
+    const levels = GenerationOrder.levels([['app', 'test'], ['service'], ['repo'], ['types'], ['readme']], deps);
+    expect(levels).toEqual([
+      [['types'], ['readme']],
+      [['service'], ['repo']],
+      [['app', 'test']], // Imports inside a unit don't count
+    ]);
+  });
+
+  it('describes exported API changes', () => {
+    const before = 'export function load(path: string): string { return path; }\nexport function save() {}';
+    const after = 'export function load(path: string): string { return path.trim(); }\nexport class Store {\n  get(key: string): number { return 1; }\n}';
+    expect(GenerationOrder.apiChanges('src/store.ts', before, after)).toBe(
+      'File: src/store.ts\n  export class Store\n  get(key: string): number\n  (removed: save)'
+    );
+    expect(GenerationOrder.apiChanges('src/store.ts', before, before)).toBeNull();
+    expect(GenerationOrder.apiChanges('notes.md', null, '# Notes')).toBeNull();
+  });
+});
@@ -4,3 +4,10 @@
  * Marker used to detect when a consolidation process has completed successfully.
  */
 export const CONSOLIDATION_SUCCESS_MARKER = "[System: Consolidation Completed Successfully]";
+
+/**
+ * Starts the system entry listing the files a consolidation wrote or deleted (one `- path`
+ * line each). Logged just before the success marker; offline context evaluation uses it as
+ * the ground truth for the conversation turns that led to the consolidation.
+ */
+export const CONSOLIDATION_CHANGED_FILES_PREFIX = "[System: Consolidation changed files]";
@@ -21,18 +21,23 @@ ${historyString}
 TASK:
 Analyze the CONVERSATION HISTORY in the context of the CODEBASE CONTEXT. Identify all files that need to be created, modified, or deleted to fulfill the user's requests throughout the conversation.
 
-Respond ONLY with a JSON object containing a single key "operations".
+Respond ONLY with a JSON object containing the key "operations" and, optionally, "groups".
 The "operations" key should be an array of objects, where each object has:
 1.  "filePath": The relative path of the file from the project root (e.g., "src/lib/utils.ts").
 2.  "action": A string, either "CREATE", "MODIFY", or "DELETE".
+The optional "groups" key lists sets of CREATE/MODIFY files whose changes depend on each other and should be written together (e.g., an interface, its implementations and their tests). Each group is an array of at least two file paths; a file appears in at most one group. Omit files that can be written on their own.
 
 Example Response:
 \`\`\`json
 {
   "operations": [
     { "filePath": "src/newFeature.js", "action": "CREATE" },
+    { "filePath": "src/newFeature.test.js", "action": "CREATE" },
     { "filePath": "README.md", "action": "MODIFY" },
     { "filePath": "old_scripts/cleanup.sh", "action": "DELETE" }
+  ],
+  "groups": [
+    ["src/newFeature.js", "src/newFeature.test.js"]
   ]
 }
 \`\`\`
@@ -76,5 +81,39 @@ File Path: '${filePath}'
 
 Respond ONLY with the raw file content for '${filePath}'.
 Do NOT include explanations, markdown code fences (\`\`\`), file path headers, or any other text outside the file content itself.
-If the conversation implies this file ('${filePath}') should ultimately be deleted, respond ONLY with the exact text "DELETE_FILE".`
+If the conversation implies this file ('${filePath}') should ultimately be deleted, respond ONLY with the exact text "DELETE_FILE".`,
+
+    /**
+     * Generates the prompt for creating the final content of several related files in one response.
+     * @param codeContext The string containing the current codebase context.
+     * @param historyString The stringified conversation history.
+     * @param files The files to generate with their current content (null if they don't exist).
+     * @returns The formatted multi-file generation prompt.
+     */
+    groupFileGenerationPrompt: (
+        codeContext: string,
+        historyString: string,
+        files: Array<{ filePath: string; currentContent: string | null }>
+    ): string => `CONTEXT:
+You are an expert AI assisting with code generation based on a conversation.
+CODEBASE CONTEXT:
+${codeContext}
+---
+CONVERSATION HISTORY:
+${historyString}
+---
+${files.map(f => `CURRENT FILE CONTENT for '${f.filePath}' (if it exists):
+${f.currentContent === null ? '(File does not exist - generate content for creation)' : `\`\`\`\n${f.currentContent}\n\`\`\``}
+---
+`).join('')}TASK:
+Based *only* on the conversation history and provided context/current content, generate the **complete and final content** for each of these related files, keeping them consistent with each other:
+${files.map(f => `- '${f.filePath}'`).join('\n')}
+
+Respond ONLY with one block per file, in this exact format:
+=== FILE: <file path> ===
+<raw file content>
+=== END FILE ===
+
+Do NOT include explanations, markdown code fences (\`\`\`) or any other text outside the blocks.
+If the conversation implies a file should ultimately be deleted, its block must contain ONLY the exact text "DELETE_FILE".`
 };
\ No newline at end of file
@@ -0,0 +1,159 @@
+// File: src/lib/context/ContextDeltaTracker.ts
+import { createPatch } from 'diff';
+import { Message } from '../models/Conversation';
+import { countTokens } from '../utils';
+
+export interface ContextDeltaOptions {
+    reanchorTurns?: number; // Resend the full context after this many delta turns
+    maxDeltaRatio?: number; // ...or once the delta against the anchor exceeds this share of it
+}
+
+export interface ContextTurnPlan {
+    kind: 'anchor' | 'delta';
+    context: string;      // What to send with this turn's user message
+    tokenCount: number;
+    requestTokens: number; // Context tokens in the whole request: the anchor is replayed with its message
+    fullTokens: number;    // This turn's full context, for comparison
+    changed: number;
+    added: number;
+    removed: number;
+    reason?: string;      // Why an anchor was (re)sent
+}
+
+const DEFAULT_REANCHOR_TURNS = 20;
+const DEFAULT_MAX_DELTA_RATIO = 0.5;
+const BLOCK_SEPARATOR = '\n---\nFile: ';
+
+interface ParsedContext {
+    header: string;                 // Text before the first file block
+    blocks: Map<string, string>;    // Header line after "File: " -> block body
+}
+
+/**
+ * Turns the per-turn code base context of one conversation into an anchor plus one delta. The
+ * first turn (and every re-anchor) sends the full context; later turns send only the blocks
+ * that differ from the anchor, as a unified diff when that is smaller, plus the paths that
+ * dropped out. The anchor stays attached to its user message and earlier deltas are not
+ * replayed, so the request prefix up to the previous turn is byte-identical between turns and
+ * each request carries the anchor plus a single delta. That is more than the full context
+ * alone, so this only saves where the provider caches the repeated prefix; callers use it for
+ * such models only (see AIClient.cachesPromptPrefix).
+ *
+ * Re-anchors after `reanchorTurns` deltas, when the delta outgrows `maxDeltaRatio` of the
+ * anchor, or when the anchor message is no longer in the history.
+ */
+export class ContextDeltaTracker {
+    private readonly reanchorTurns: number;
+    private readonly maxDeltaRatio: number;
+    private readonly countTokens: (text: string) => number;
+
+    private anchorMessage: Message | null = null;
+    private anchorContext = '';
+    private anchorTokens = 0;
+    private deltaTurns = 0;
+    private anchor: ParsedContext | null = null; // What the model sees with the anchor message
+
+    constructor(options: ContextDeltaOptions = {}, countTokensFn: (text: string) => number = countTokens) {
+        this.reanchorTurns = options.reanchorTurns ?? DEFAULT_REANCHOR_TURNS;
+        this.maxDeltaRatio = options.maxDeltaRatio ?? DEFAULT_MAX_DELTA_RATIO;
+        this.countTokens = countTokensFn;
+    }
+
+    /**
+     * Decides what to send with `message` (the new user message, already in `history`).
+     * @param exhaustive True when the context lists every file it covers (full and summary
+     *   modes), so a missing block means the file is gone. Dynamic selections are not
+     *   exhaustive: files left out this turn keep their anchor content.
+     */
+    plan(message: Message, history: Message[], context: string, exhaustive: boolean): ContextTurnPlan {
+        const fullTokens = this.countTokens(context);
+        const reason = this._reanchorReason(history);
+        if (reason) return this._anchor(message, context, fullTokens, reason);
+
+        const current = ContextDeltaTracker.parse(context);
+        const anchor = this.anchor!;
+        const parts: string[] = [];
+        let changed = 0;
+        let added = 0;
+        if (current.header !== anchor.header) parts.push(`Overview (updated):\n${current.header.trim()}\n`);
+        for (const [key, body] of current.blocks) {
+            const previous = anchor.blocks.get(key);
+            if (previous === body) continue;
+            if (previous === undefined) {
+                added++;
+                parts.push(`${BLOCK_SEPARATOR}${key}${body}`);
+                continue;
+            }
+            changed++;
+            parts.push(ContextDeltaTracker._changedBlock(key, previous, body));
+        }
+        const removed = exhaustive ? [...anchor.blocks.keys()].filter(key => !current.blocks.has(key)) : [];
+        if (removed.length > 0) parts.push(`\n---\nNo longer in the project context:\n${removed.map(key => `- ${key}`).join('\n')}\n`);
+
+        const delta = parts.length === 0
+            ? 'Code Base Context Update: nothing changed since the code base context sent earlier in this conversation.'
+            : `Code Base Context Update: only what changed since the code base context sent earlier in this conversation is listed; everything else from it still applies.\n${parts.join('')}`;
+        const tokenCount = this.countTokens(delta);
+        if (tokenCount > this.anchorTokens * this.maxDeltaRatio) {
+            return this._anchor(message, context, fullTokens, 'delta outgrew the anchor');
+        }
+
+        this.deltaTurns++;
+        return {
+            kind: 'delta', context: delta, tokenCount, requestTokens: this.anchorTokens + tokenCount, fullTokens,
+            changed, added, removed: removed.length,
+        };
+    }
+
+    /** The anchor, to be replayed with its message while that is still in `history` (and not the current one). */
+    earlierContext(history: Message[]): Map<Message, string> {
+        const earlier = new Map<Message, string>();
+        const anchorMessage = this.anchorMessage;
+        if (anchorMessage && anchorMessage !== history[history.length - 1] && history.includes(anchorMessage)) {
+            earlier.set(anchorMessage, this.anchorContext);
+        }
+        return earlier;
+    }
+
+    /** Splits a context string into its preamble and `File:` blocks. */
+    static parse(context: string): ParsedContext {
+        const [header, ...rest] = context.split(BLOCK_SEPARATOR);
+        const blocks = new Map<string, string>();
+        for (const block of rest) {
+            const lineEnd = block.indexOf('\n');
+            const key = lineEnd === -1 ? block : block.slice(0, lineEnd);
+            blocks.set(key, lineEnd === -1 ? '' : block.slice(lineEnd));
+        }
+        return { header, blocks };
+    }
+
+    // --- Private helpers ---
+
+    private _reanchorReason(history: Message[]): string | null {
+        if (!this.anchorMessage || !this.anchor) return 'first turn';
+        if (!history.includes(this.anchorMessage)) return 'anchor dropped from history';
+        if (this.deltaTurns >= this.reanchorTurns) return `${this.deltaTurns} turns since the last anchor`;
+        return null;
+    }
+
+    private _anchor(message: Message, context: string, tokenCount: number, reason: string): ContextTurnPlan {
+        this.anchorMessage = message; // Earlier turns go back to plain text
+        this.anchorContext = context;
+        this.anchorTokens = tokenCount;
+        this.deltaTurns = 0;
+        this.anchor = ContextDeltaTracker.parse(context);
+        return { kind: 'anchor', context, tokenCount, requestTokens: tokenCount, fullTokens: tokenCount, changed: 0, added: 0, removed: 0, reason };
+    }
+
+    /** The new block, or a unified diff against the anchor's when that is shorter. */
+    private static _changedBlock(key: string, previous: string, body: string): string {
+        const fullBlock = `${BLOCK_SEPARATOR}${key}${body}`;
+        const patch = createPatch(key, previous, body, '', '', { context: 2 })
+            .split('\n')
+            .slice(4) // Index/separator/---/+++ lines; the key already names the file
+            .join('\n')
+            .trimEnd();
+        const diffBlock = `${BLOCK_SEPARATOR}${key} (diff against the earlier code base context)\n\`\`\`diff\n${patch}\n\`\`\`\n`;
+        return diffBlock.length < fullBlock.length ? diffBlock : fullBlock;
+    }
+}
@@ -0,0 +1,111 @@
+// File: src/lib/context/ContextModeSelector.ts
+import path from 'path';
+import { AnalysisIndex } from '../analysis/AnalysisIndex';
+import { ESTIMATED_TOKENS_PER_BYTE } from '../analysis/TokenBudgetProfiler';
+import { SyntaxChunker } from '../analysis/SyntaxChunker';
+
+/** The modes 'auto' resolves to on each turn. */
+export type ConcreteContextMode = 'full' | 'analysis_cache' | 'dynamic';
+
+/** Cheap statistics from the analysis cache; nothing here reads project files. */
+export interface ContextIndexStats {
+    files: number;          // Non-binary entries
+    fullTokens: number;     // Estimated tokens of full context (file sizes)
+    summaryTokens: number;  // Estimated tokens of the analysis-cache (summaries) context
+    overviewTokens: number; // Estimated tokens of the file overview the selection call sends
+}
+
+export interface ContextDecision {
+    mode: ConcreteContextMode;
+    reason: string;
+    predictedTokens: number;  // Context tokens for the main call
+    extraModelCalls: number;  // Round trips spent before the main call (dynamic selection)
+    extraTokens: number;      // Prompt tokens of those round trips
+}
+
+const FULL_CONTEXT_SHARE = 0.8;          // Full context may use at most this share of the budget (estimates are rough)
+const DYNAMIC_PROMPT_OVERHEAD = 500;     // Selection instructions (matches buildDynamicContext's base estimate)
+const DYNAMIC_FILL_RATIO = 0.6;          // Selections typically use about this share of the content budget
+const SUMMARY_ENTRY_OVERHEAD_CHARS = 40; // Separator, "File:" header, LOC and "Summary:" labels per entry
+const OVERVIEW_ENTRY_OVERHEAD_CHARS = 30;
+const OVERVIEW_SUMMARY_CHARS = 100;      // _formatCacheForRelevance truncates summaries to this
+// Questions about the project as a whole are answered from summaries; no file contents needed
+const BROAD_QUERY = /\b(overview|architecture|high[- ]level|structure of|summar(y|ize|ise)|explain (the|this) (project|codebase|repo(sitory)?)|what does (this|the) (project|codebase|repo(sitory)?) do|tour)\b/i;
+
+/**
+ * Picks a context mode per turn for `context.mode: auto`, from analysis-cache statistics, the
+ * query and the prompt budget: full context when the whole project fits comfortably, summaries
+ * when the question is about the project as a whole (or there is no query to select files
+ * with), otherwise dynamic selection, which spends one extra model call to load only
+ * relevant files. Without an analysis cache only full context is possible.
+ */
+export class ContextModeSelector {
+    /** Reads only the index's columns: no summary is decoded. */
+    static indexStats(index: AnalysisIndex | null): ContextIndexStats | null {
+        if (!index || index.length === 0) return null;
+        let files = 0;
+        let fullBytes = 0;
+        let summaryChars = (index.overallSummary ?? '').length;
+        let overviewChars = 0;
+        for (let row = 0; row < index.length; row++) {
+            if (index.type(row) !== 'binary') {
+                files++;
+                fullBytes += index.size(row);
+            }
+            const pathLength = index.filePath(row).length;
+            const summaryLength = index.summaryLength(row);
+            summaryChars += pathLength + summaryLength + SUMMARY_ENTRY_OVERHEAD_CHARS;
+            overviewChars += pathLength + Math.min(summaryLength, OVERVIEW_SUMMARY_CHARS) + OVERVIEW_ENTRY_OVERHEAD_CHARS;
+            for (const symbol of index.symbols(row) ?? []) {
+                overviewChars += pathLength + symbol.name.length + Math.min(symbol.summary?.length ?? 0, OVERVIEW_SUMMARY_CHARS) + OVERVIEW_ENTRY_OVERHEAD_CHARS;
+            }
+        }
+        return {
+            files,
+            fullTokens: Math.ceil(fullBytes * ESTIMATED_TOKENS_PER_BYTE),
+            summaryTokens: Math.ceil(summaryChars * ESTIMATED_TOKENS_PER_BYTE),
+            overviewTokens: Math.ceil(overviewChars * ESTIMATED_TOKENS_PER_BYTE),
+        };
+    }
+
+    /** How many cache entries the query names directly, by file name or symbol. */
+    static specificMatches(index: AnalysisIndex | null, query: string): number {
+        const terms = new Set(SyntaxChunker.queryTerms(query));
+        if (!index || terms.size === 0) return 0;
+        let matches = 0;
+        for (let row = 0; row < index.length; row++) {
+            const names = [path.posix.basename(index.filePath(row)).replace(/\.[^.]+$/, ''), ...(index.symbols(row) ?? []).map(s => s.name)];
+            const entryTerms = names.flatMap(name => SyntaxChunker.queryTerms(name));
+            if (entryTerms.some(term => terms.has(term))) matches++;
+        }
+        return matches;
+    }
+
+    /**
+     * @param budget Prompt tokens available for context (max prompt tokens minus query and history).
+     */
+    static choose(stats: ContextIndexStats | null, budget: number, query?: string, specificMatches: number = 0): ContextDecision {
+        if (!stats) {
+            return { mode: 'full', reason: 'no analysis cache to summarize or select from', predictedTokens: 0, extraModelCalls: 0, extraTokens: 0 };
+        }
+        const summaries = (reason: string): ContextDecision =>
+            ({ mode: 'analysis_cache', reason, predictedTokens: stats.summaryTokens, extraModelCalls: 0, extraTokens: 0 });
+        if (budget <= 0) return summaries('query and history leave no room for file contents');
+
+        if (stats.fullTokens <= budget * FULL_CONTEXT_SHARE) {
+            return { mode: 'full', reason: `all ${stats.files} files fit the budget`, predictedTokens: stats.fullTokens, extraModelCalls: 0, extraTokens: 0 };
+        }
+        if (!query?.trim()) return summaries('no query to select files with');
+        if (specificMatches === 0 && BROAD_QUERY.test(query) && stats.summaryTokens <= budget) {
+            return summaries('question about the project as a whole');
+        }
+        const contentTokens = Math.min(stats.fullTokens, Math.round(budget * DYNAMIC_FILL_RATIO));
+        return {
+            mode: 'dynamic',
+            reason: specificMatches > 0 ? `query names ${specificMatches} indexed file(s)/symbol(s)` : 'project too large for full context',
+            predictedTokens: contentTokens,
+            extraModelCalls: 1,
+            extraTokens: stats.overviewTokens + DYNAMIC_PROMPT_OVERHEAD,
+        };
+    }
+}
@@ -0,0 +1,91 @@
+import { ContextDeltaTracker } from '../ContextDeltaTracker';
+import { Message } from '../../models/Conversation';
+
+const block = (file: string, content: string) => `\n---\nFile: ${file}\n\`\`\`\n${content}\n\`\`\`\n`;
+const context = (files: Record<string, string>) =>
+  'Code Base Context:\n' + Object.entries(files).map(([file, content]) => block(file, content)).join('');
+const tokens = (text: string) => Math.ceil(text.length / 4);
+const bigFile = (tag: string) => Array.from({ length: 40 }, (_, i) => `const line${i} = '${tag}';`).join('\n');
+
+describe('ContextDeltaTracker', () => {
+  let history: Message[];
+  const turn = (content: string): Message => {
+    const message: Message = { role: 'user', content };
+    history.push(message);
+    return message;
+  };
+  const answer = () => history.push({ role: 'assistant', content: 'ok' });
+
+  beforeEach(() => {
+    history = [];
+  });
+
+  it('sends the full context first, then only files changed, added or removed since it', () => {
+    const tracker = new ContextDeltaTracker({}, tokens);
+    const files = { 'a.ts': bigFile('a'), 'b.ts': bigFile('b'), 'c.ts': bigFile('c'), 'd.ts': bigFile('d') };
+    const first = turn('q1');
+    const anchor = tracker.plan(first, history, context(files), true);
+    expect(anchor).toMatchObject({ kind: 'anchor', reason: 'first turn', context: context(files) });
+    answer();
+
+    const second = turn('q2');
+    const unchanged = tracker.plan(second, history, context(files), true);
+    expect(unchanged.kind).toBe('delta');
+    expect(unchanged.context).toContain('nothing changed');
+    answer();
+
+    const edited = bigFile('a').replace("line3 = 'a'", "line3 = 'edited'");
+    const { 'd.ts': _dropped, ...rest } = files;
+    const third = turn('q3');
+    const delta = tracker.plan(third, history, context({ ...rest, 'a.ts': edited, 'e.ts': 'new file' }), true);
+    expect(delta).toMatchObject({ kind: 'delta', changed: 1, added: 1, removed: 1 });
+    expect(delta.context).toContain('File: a.ts (diff against the earlier code base context)');
+    expect(delta.context).toContain("+const line3 = 'edited';");
+    expect(delta.context).toContain(block('e.ts', 'new file'));
+    expect(delta.context).toContain('- d.ts');
+    expect(delta.context).not.toContain('b.ts');
+    // Only the anchor is replayed; earlier deltas are not
+    expect(delta.requestTokens).toBe(anchor.tokenCount + delta.tokenCount);
+    const earlier = tracker.earlierContext(history);
+    expect([...earlier.keys()]).toEqual([first]);
+    expect(earlier.get(first)).toBe(anchor.context);
+    answer();
+
+    // Each delta is against the anchor, so it still lists the earlier edit
+    const fourth = tracker.plan(turn('q4'), history, context({ ...rest, 'a.ts': edited, 'e.ts': 'new file' }), true);
+    expect(fourth.context).toBe(delta.context);
+  });
+
+  it('keeps files a non-exhaustive selection left out', () => {
+    const tracker = new ContextDeltaTracker({}, tokens);
+    const files = { 'a.ts': bigFile('a'), 'b.ts': bigFile('b'), 'c.ts': bigFile('c') };
+    tracker.plan(turn('q1'), history, context(files), false);
+    answer();
+    const delta = tracker.plan(turn('q2'), history, context({ 'a.ts': bigFile('a') }), false);
+    expect(delta).toMatchObject({ kind: 'delta', removed: 0 });
+    answer();
+    // b.ts is still known, so sending it again unchanged costs nothing
+    const again = tracker.plan(turn('q3'), history, context({ 'b.ts': bigFile('b') }), false);
+    expect(again.context).toContain('nothing changed');
+  });
+
+  it('re-anchors after the configured turns, when the delta outgrows the anchor or the anchor leaves the history', () => {
+    const tracker = new ContextDeltaTracker({ reanchorTurns: 2, maxDeltaRatio: 0.5 }, tokens);
+    const files = { 'a.ts': bigFile('a'), 'b.ts': bigFile('b') };
+    tracker.plan(turn('q1'), history, context(files), true);
+    answer();
+    tracker.plan(turn('q2'), history, context(files), true);
+    answer();
+    tracker.plan(turn('q3'), history, context(files), true);
+    answer();
+    expect(tracker.plan(turn('q4'), history, context(files), true)).toMatchObject({ kind: 'anchor', reason: '2 turns since the last anchor' });
+    answer();
+
+    const rewritten = tracker.plan(turn('q5'), history, context({ 'a.ts': bigFile('x'), 'b.ts': bigFile('y') }), true);
+    expect(rewritten).toMatchObject({ kind: 'anchor', reason: 'delta outgrew the anchor' });
+    answer();
+
+    history.splice(0, history.length - 1); // History trimmed past the anchor
+    expect(tracker.plan(turn('q6'), history, context(files), true)).toMatchObject({ kind: 'anchor', reason: 'anchor dropped from history' });
+  });
+});
@@ -0,0 +1,44 @@
+import { ContextModeSelector } from '../ContextModeSelector';
+import { ProjectAnalysisCache } from '../../analysis/types';
+import { AnalysisIndex } from '../../analysis/AnalysisIndex';
+
+const entry = (filePath: string, size: number, summary: string | null = 'does things', symbols: any[] = []) =>
+  ({ filePath, type: 'text_analyze' as const, size, loc: 10, summary, lastAnalyzed: 'n', symbols });
+
+describe('ContextModeSelector', () => {
+  const cache: ProjectAnalysisCache = {
+    overallSummary: 'project',
+    entries: [
+      entry('src/lib/TokenBucket.ts', 40000, 'rate limiting', [{ name: 'TokenBucket.refill', kind: 'method', startLine: 1, endLine: 9, signature: 'refill()', summary: null }]),
+      entry('src/app.ts', 40000),
+      { filePath: 'logo.png', type: 'binary', size: 90000, loc: null, summary: null, lastAnalyzed: 'n' },
+    ],
+  };
+  const index = AnalysisIndex.fromCache(cache);
+  const stats = ContextModeSelector.indexStats(index)!;
+
+  it('estimates full, summary and overview sizes from the cache alone', () => {
+    expect(stats).toMatchObject({ files: 2, fullTokens: 24000 }); // Binary entries are not sent in full context
+    expect(stats.summaryTokens).toBeGreaterThan(0);
+    expect(stats.overviewTokens).toBeLessThan(stats.fullTokens);
+    expect(ContextModeSelector.indexStats(new AnalysisIndex())).toBeNull();
+  });
+
+  it('uses full context when it fits and there is no cache', () => {
+    expect(ContextModeSelector.choose(stats, 100000, 'fix the refill bug')).toMatchObject({ mode: 'full', predictedTokens: 24000, extraModelCalls: 0 });
+    expect(ContextModeSelector.choose(null, 1000, 'anything').mode).toBe('full');
+  });
+
+  it('answers broad or query-less requests from summaries and selects files for specific ones', () => {
+    expect(ContextModeSelector.choose(stats, 8000).mode).toBe('analysis_cache');
+    expect(ContextModeSelector.choose(stats, 8000, 'Give me an overview of the architecture').mode).toBe('analysis_cache');
+
+    const query = 'Why does TokenBucket refill too slowly?';
+    const matches = ContextModeSelector.specificMatches(index, query);
+    expect(matches).toBe(1);
+    const decision = ContextModeSelector.choose(stats, 8000, query, matches);
+    expect(decision).toMatchObject({ mode: 'dynamic', predictedTokens: 4800, extraModelCalls: 1 });
+    expect(decision.extraTokens).toBe(stats.overviewTokens + 500);
+    expect(ContextModeSelector.choose(stats, -5, query, matches).mode).toBe('analysis_cache');
+  });
+});
@@ -0,0 +1,77 @@
+// File: src/lib/desktop/DesktopChat.ts
+import chalk from 'chalk';
+import { Config } from '../Config';
+import { FileSystem } from '../FileSystem';
+import { CommandService } from '../CommandService';
+import { GitService } from '../GitService';
+import { AIClient } from '../AIClient';
+import { ProjectContextBuilder } from '../ProjectContextBuilder';
+import Conversation, { JsonlLogEntry, summarizeHistory } from '../models/Conversation';
+import { relevanceFeedback } from '../analysis/RelevanceFeedback';
+
+export interface DesktopChatResult {
+    text: string;
+    cancelled: boolean;
+}
+
+/**
+ * Chat turns for Kai Desktop. The Electron main process calls `send` for each user message;
+ * the conversation is reloaded from its JSONL log (the renderer only keeps the path), context
+ * is built as in the CLI chat, and the answer is streamed back through `onDelta`.
+ */
+export class DesktopChat {
+    private config: Config;
+    private fs: FileSystem;
+    private aiClient: AIClient;
+    private contextBuilder: ProjectContextBuilder;
+
+    constructor(config: Config, fileSystem: FileSystem, aiClient: AIClient, contextBuilder: ProjectContextBuilder) {
+        this.config = config;
+        this.fs = fileSystem;
+        this.aiClient = aiClient;
+        this.contextBuilder = contextBuilder;
+        if (this.config.context.mode === undefined) {
+            // The CLI asks once and saves the choice; the desktop app picks per prompt without saving
+            this.config.context.mode = 'auto';
+        }
+    }
+
+    /**
+     * Wires the core services for a project. Every path is resolved from `projectRoot`, never
+     * the working directory, so one process can serve several projects at once.
+     * @throws MissingApiKeyError when no Gemini API key is set.
+     */
+    static async create(projectRoot: string): Promise<DesktopChat> {
+        const config = await Config.load(projectRoot);
+        relevanceFeedback.configure(projectRoot);
+        const fs = new FileSystem(projectRoot);
+        const gitService = new GitService(new CommandService(), fs);
+        const aiClient = new AIClient(config, projectRoot);
+        const contextBuilder = new ProjectContextBuilder(fs, gitService, projectRoot, config, aiClient);
+        return new DesktopChat(config, fs, aiClient, contextBuilder);
+    }
+
+    /**
+     * Adds `prompt` to the conversation and streams the answer. Both are appended to the
+     * conversation log; an aborted answer is kept as far as it got.
+     */
+    async send(conversationFilePath: string, prompt: string, onDelta: (text: string) => void, signal?: AbortSignal): Promise<DesktopChatResult> {
+        const entries = await this.fs.readJsonlFile(conversationFilePath) as JsonlLogEntry[];
+        const conversation = Conversation.fromJsonlData(entries);
+        conversation.addMessage('user', prompt);
+
+        const mode = this.config.context.mode;
+        console.log(chalk.blue(`\nBuilding context using mode: ${mode}...`));
+        const historySummary = summarizeHistory(conversation.getMessages());
+        const { context } = mode === 'dynamic'
+            ? await this.contextBuilder.buildDynamicContext(prompt, historySummary, conversationFilePath)
+            : mode === 'auto'
+            ? await this.contextBuilder.buildContext(prompt, historySummary, conversationFilePath)
+            : await this.contextBuilder.buildContext();
+        if (signal?.aborted) {
+            // Cancelled while the context was being built: nothing was sent, so nothing is logged
+            return { text: '', cancelled: true };
+        }
+        return this.aiClient.streamResponseFromAI(conversation, conversationFilePath, context, onDelta, signal);
+    }
+}
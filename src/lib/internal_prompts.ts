@@ -9,6 +9,15 @@ export const HIDDEN_CONSOLIDATION_GENERATION_INSTRUCTION = `
 SYSTEM INSTRUCTION: Generate only the raw, complete code for the requested file based on the conversation and context. Adhere strictly to the user's requirements and coding style visible in the context. Do not add any explanations, comments outside the code, or markdown formatting. If deletion is intended, output only "DELETE_FILE". Ensure the output is ready to be directly written to the file system.
     `.trim(); // Use trim() to remove leading/trailing whitespace
 
+/**
+ * Hidden system instruction prepended to prompts that generate several
+ * related files in one call during consolidation.
+ * This instruction is NOT logged or shown to the user.
+ */
+export const HIDDEN_CONSOLIDATION_GROUP_GENERATION_INSTRUCTION = `
+SYSTEM INSTRUCTION: Generate the raw, complete code for every requested file based on the conversation and context, keeping the files consistent with each other (shared types, signatures, imports and tests must match). Adhere strictly to the user's requirements and coding style visible in the context. Output each file between its "=== FILE: <path> ===" and "=== END FILE ===" markers with nothing outside the markers and no markdown formatting inside them. If deletion of a file is intended, its content must be only "DELETE_FILE".
+    `.trim();
+
 /**
  * Hidden system instruction prepended to the user's prompt during
  * regular conversation mode.
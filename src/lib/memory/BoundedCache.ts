@@ -0,0 +1,72 @@
+// File: src/lib/memory/BoundedCache.ts
+import { metrics } from '../telemetry/Metrics';
+import { SheddableCache } from './MemoryGovernor';
+
+/**
+ * LRU cache bounded by approximate byte size rather than entry count. Implements
+ * SheddableCache so the MemoryGovernor can evict from it under heap pressure.
+ */
+export class BoundedCache<V> implements SheddableCache {
+    readonly name: string;
+    private readonly maxBytes: number;
+    private readonly sizeOf: (value: V) => number;
+    private entries = new Map<string, { value: V; bytes: number }>(); // Insertion order = LRU order
+    private bytes = 0;
+
+    constructor(name: string, maxBytes: number, sizeOf: (value: V) => number) {
+        this.name = name;
+        this.maxBytes = maxBytes;
+        this.sizeOf = sizeOf;
+    }
+
+    get(key: string): V | undefined {
+        const entry = this.entries.get(key);
+        metrics.recordCacheAccess(this.name, !!entry);
+        if (!entry) return undefined;
+        // Move to the most-recently-used end
+        this.entries.delete(key);
+        this.entries.set(key, entry);
+        return entry.value;
+    }
+
+    set(key: string, value: V): void {
+        this.delete(key);
+        const bytes = this.sizeOf(value);
+        if (bytes > this.maxBytes) return; // Never let one entry flush the whole cache
+        this.entries.set(key, { value, bytes });
+        this.bytes += bytes;
+        if (this.bytes > this.maxBytes) this.shed(this.bytes - this.maxBytes);
+    }
+
+    delete(key: string): void {
+        const entry = this.entries.get(key);
+        if (!entry) return;
+        this.entries.delete(key);
+        this.bytes -= entry.bytes;
+    }
+
+    clear(): void {
+        this.entries.clear();
+        this.bytes = 0;
+    }
+
+    get size(): number {
+        return this.entries.size;
+    }
+
+    sizeBytes(): number {
+        return this.bytes;
+    }
+
+    /** Evicts least-recently-used entries until `bytesToFree` is released or the cache is empty. */
+    shed(bytesToFree: number): number {
+        let freed = 0;
+        for (const [key, entry] of this.entries) {
+            if (freed >= bytesToFree) break;
+            this.entries.delete(key);
+            this.bytes -= entry.bytes;
+            freed += entry.bytes;
+        }
+        return freed;
+    }
+}
@@ -0,0 +1,163 @@
+// File: src/lib/memory/MemoryGovernor.ts
+import v8 from 'v8';
+import chalk from 'chalk';
+import { metrics } from '../telemetry/Metrics';
+
+const MB = 1024 * 1024;
+const DEFAULT_BUDGET_FRACTION = 0.8; // Of V8's heap_size_limit when no budget is configured
+const DEFAULT_SHED_RATIO = 0.85;     // Start shedding caches above this fraction of the budget
+const MAX_DECISIONS = 100;
+
+/** A cache that can give memory back when the governor asks for it. */
+export interface SheddableCache {
+    readonly name: string;
+    /** Approximate bytes currently held. */
+    sizeBytes(): number;
+    /** Evicts entries until roughly `bytesToFree` bytes are released; returns the bytes actually released. */
+    shed(bytesToFree: number): number;
+}
+
+export interface MemoryDecision {
+    timestamp: string;
+    action: 'shed' | 'allow' | 'deny';
+    purpose: string;
+    heapUsedBytes: number;
+    budgetBytes: number;
+    detail: string;
+}
+
+export interface MemoryGovernorOptions {
+    budgetBytes?: number;         // Heap budget; defaults to 80% of V8's heap limit
+    shedRatio?: number;           // Fraction of the budget above which caches are shed
+    heapUsed?: () => number;      // Injectable for tests; defaults to process.memoryUsage().heapUsed
+    quiet?: boolean;              // Suppress console output (decisions are still recorded)
+}
+
+interface Registration {
+    cache: SheddableCache;
+    priority: number;
+}
+
+/**
+ * Process-wide heap budget. Caches register here and are shed (lowest priority first) when
+ * the heap approaches the budget; large allocations such as a full-context build ask
+ * `canAfford()` first so callers can pick a cheaper strategy instead of running out of memory.
+ * Every shed/deny decision is logged, counted in metrics and kept for `getDecisions()`.
+ */
+export class MemoryGovernor {
+    private budget: number;
+    private shedRatio: number;
+    private heapUsedFn: () => number;
+    private quiet: boolean;
+    private registrations: Registration[] = [];
+    private decisions: MemoryDecision[] = [];
+
+    constructor(options: MemoryGovernorOptions = {}) {
+        this.budget = options.budgetBytes ?? MemoryGovernor.defaultBudgetBytes();
+        this.shedRatio = options.shedRatio ?? DEFAULT_SHED_RATIO;
+        this.heapUsedFn = options.heapUsed ?? (() => process.memoryUsage().heapUsed);
+        this.quiet = !!options.quiet;
+    }
+
+    static defaultBudgetBytes(): number {
+        return Math.floor(v8.getHeapStatistics().heap_size_limit * DEFAULT_BUDGET_FRACTION);
+    }
+
+    /** Applies `memory.heap_budget_mb` / `memory.shed_ratio` from config; unset values keep their defaults. */
+    configure(options: { heap_budget_mb?: number; shed_ratio?: number } | undefined): void {
+        if (options?.heap_budget_mb && options.heap_budget_mb > 0) this.budget = options.heap_budget_mb * MB;
+        if (options?.shed_ratio && options.shed_ratio > 0 && options.shed_ratio <= 1) this.shedRatio = options.shed_ratio;
+    }
+
+    get budgetBytes(): number {
+        return this.budget;
+    }
+
+    heapUsed(): number {
+        return this.heapUsedFn();
+    }
+
+    /**
+     * Registers a cache. Lower `priority` values are shed first.
+     * @returns A function that unregisters the cache.
+     */
+    register(cache: SheddableCache, priority: number = 0): () => void {
+        const registration = { cache, priority };
+        this.registrations.push(registration);
+        this.registrations.sort((a, b) => a.priority - b.priority);
+        return () => {
+            this.registrations = this.registrations.filter(r => r !== registration);
+        };
+    }
+
+    /** Total bytes held by registered caches. */
+    cachedBytes(): number {
+        return this.registrations.reduce((sum, r) => sum + r.cache.sizeBytes(), 0);
+    }
+
+    /** Sheds caches if the heap is above the shed threshold. Returns the bytes released. */
+    relieve(purpose: string = 'pressure'): number {
+        const excess = this.heapUsed() - this.budget * this.shedRatio;
+        return excess > 0 ? this._shed(excess, purpose) : 0;
+    }
+
+    /**
+     * Checks whether `bytes` more can be allocated without exceeding the budget, shedding caches
+     * first if that would help. A denial means the caller should fall back to something cheaper.
+     */
+    canAfford(bytes: number, purpose: string): boolean {
+        const heapUsed = this.heapUsed();
+        let projected = heapUsed + bytes;
+        const threshold = this.budget * this.shedRatio;
+        let freed = 0;
+        if (projected > threshold) {
+            freed = this._shed(projected - threshold, purpose);
+            // Released bytes are only reclaimed at the next GC; count them as available anyway.
+            projected -= freed;
+        }
+        if (projected > this.budget) {
+            this._record('deny', purpose, heapUsed,
+                `needs ~${this._mb(bytes)} MB; heap ${this._mb(heapUsed)} MB, freed ${this._mb(freed)} MB, budget ${this._mb(this.budget)} MB`);
+            metrics.increment('memory.denied', { purpose });
+            return false;
+        }
+        if (freed > 0) {
+            this._record('allow', purpose, heapUsed, `allowed ~${this._mb(bytes)} MB after freeing ${this._mb(freed)} MB`);
+        }
+        return true;
+    }
+
+    getDecisions(): MemoryDecision[] {
+        return [...this.decisions];
+    }
+
+    private _shed(bytesToFree: number, purpose: string): number {
+        let freed = 0;
+        for (const { cache } of this.registrations) {
+            if (freed >= bytesToFree) break;
+            if (cache.sizeBytes() === 0) continue;
+            const released = cache.shed(bytesToFree - freed);
+            if (released <= 0) continue;
+            freed += released;
+            metrics.increment('memory.shed_bytes', { cache: cache.name }, released);
+            this._record('shed', purpose, this.heapUsed(), `shed ${this._mb(released)} MB from '${cache.name}'`);
+        }
+        return freed;
+    }
+
+    private _record(action: MemoryDecision['action'], purpose: string, heapUsedBytes: number, detail: string): void {
+        this.decisions.push({ timestamp: new Date().toISOString(), action, purpose, heapUsedBytes, budgetBytes: this.budget, detail });
+        if (this.decisions.length > MAX_DECISIONS) this.decisions.shift();
+        if (!this.quiet) {
+            const color = action === 'deny' ? chalk.yellow : chalk.dim;
+            console.log(color(`  Memory governor [${purpose}]: ${action} - ${detail}`));
+        }
+    }
+
+    private _mb(bytes: number): string {
+        return (bytes / MB).toFixed(1);
+    }
+}
+
+/** Process-wide governor; kai.ts applies the `memory` config section at startup. */
+export const memoryGovernor = new MemoryGovernor();
@@ -0,0 +1,158 @@
+// File: src/lib/memory/PathTable.ts
+import { HashIndex, StringPool, growArray, hashPair } from './StringPool';
+
+const ROOT_DIR = 0;
+const INITIAL_DIRS = 256;
+const INITIAL_FILES = 1024;
+
+/**
+ * Interned set of relative file paths: a directory trie plus one basename per file, with
+ * every segment stored once in a StringPool. A file costs 8 bytes of typed-array columns and a
+ * hash slot; path strings are only built when asked for. Segments are split on '/' only, so
+ * any path round-trips exactly. File ids follow insertion order.
+ */
+export class PathTable implements Iterable<string> {
+    private names = new StringPool();
+    private dirParent = new Int32Array(INITIAL_DIRS);  // Parent dir id (-1 for the root)
+    private dirName = new Int32Array(INITIAL_DIRS);    // Segment name id
+    private dirCount = 1;                              // Dir 0 is the root
+    private dirPaths: Array<string | undefined> = [];  // Materialised on first use; dirs are few
+    private dirLookup: HashIndex;
+    private fileDir = new Int32Array(INITIAL_FILES);
+    private fileName = new Int32Array(INITIAL_FILES);
+    private fileCount = 0;
+    private fileLookup: HashIndex;
+
+    constructor() {
+        this.dirParent[ROOT_DIR] = -1;
+        this.dirName[ROOT_DIR] = -1;
+        this.dirLookup = new HashIndex(id => hashPair(this.dirParent[id], this.dirName[id]));
+        this.fileLookup = new HashIndex(id => hashPair(this.fileDir[id], this.fileName[id]));
+    }
+
+    static from(paths: Iterable<string>): PathTable {
+        const table = new PathTable();
+        for (const p of paths) table.add(p);
+        return table;
+    }
+
+    get size(): number {
+        return this.fileCount;
+    }
+
+    /** Adds a path (once) and returns its id. */
+    add(filePath: string): number {
+        const segments = filePath.split('/');
+        const baseName = this.names.intern(segments.pop()!);
+        let dir = ROOT_DIR;
+        for (const segment of segments) {
+            const name = this.names.intern(segment);
+            const existing = this._findDir(dir, name);
+            if (existing !== -1) {
+                dir = existing;
+                continue;
+            }
+            const id = this.dirCount++;
+            this.dirParent = growArray(this.dirParent, this.dirCount);
+            this.dirName = growArray(this.dirName, this.dirCount);
+            this.dirParent[id] = dir;
+            this.dirName[id] = name;
+            this.dirLookup.insert(id);
+            dir = id;
+        }
+        const existing = this._findFile(dir, baseName);
+        if (existing !== -1) return existing;
+        const id = this.fileCount++;
+        this.fileDir = growArray(this.fileDir, this.fileCount);
+        this.fileName = growArray(this.fileName, this.fileCount);
+        this.fileDir[id] = dir;
+        this.fileName[id] = baseName;
+        this.fileLookup.insert(id);
+        return id;
+    }
+
+    /** Id of a path, or -1. Looking up never adds segments. */
+    indexOf(filePath: string): number {
+        const dir = this._resolveDir(filePath.split('/'), true);
+        if (dir === -1) return -1;
+        const baseName = this.names.find(filePath.slice(filePath.lastIndexOf('/') + 1));
+        return baseName === -1 ? -1 : this._findFile(dir, baseName);
+    }
+
+    has(filePath: string): boolean {
+        return this.indexOf(filePath) !== -1;
+    }
+
+    get(id: number): string {
+        const baseName = this.names.get(this.fileName[id]);
+        const dir = this.fileDir[id];
+        return dir === ROOT_DIR ? baseName : `${this._dirPath(dir)}/${baseName}`;
+    }
+
+    basename(id: number): string {
+        return this.names.get(this.fileName[id]);
+    }
+
+    /** Paths equal to `prefix` or inside the directory `prefix`, in id order ('' for all). */
+    under(prefix: string): string[] {
+        if (!prefix) return [...this];
+        const trimmed = prefix.replace(/\/+$/, '');
+        const matches: string[] = [];
+        const exact = this.indexOf(trimmed);
+        const dir = this._resolveDir(trimmed.split('/'), false);
+        for (let id = 0; id < this.fileCount; id++) {
+            if (id === exact || (dir !== -1 && this._isWithin(this.fileDir[id], dir))) matches.push(this.get(id));
+        }
+        return matches;
+    }
+
+    *[Symbol.iterator](): Iterator<string> {
+        for (let id = 0; id < this.fileCount; id++) yield this.get(id);
+    }
+
+    /** Approximate bytes held. */
+    sizeBytes(): number {
+        return this.names.sizeBytes() + this.dirParent.byteLength + this.dirName.byteLength + this.dirLookup.sizeBytes()
+            + this.fileDir.byteLength + this.fileName.byteLength + this.fileLookup.sizeBytes();
+    }
+
+    // --- Private helpers ---
+
+    private _findDir(parent: number, name: number): number {
+        return this.dirLookup.find(hashPair(parent, name), id => this.dirParent[id] === parent && this.dirName[id] === name);
+    }
+
+    private _findFile(dir: number, name: number): number {
+        return this.fileLookup.find(hashPair(dir, name), id => this.fileDir[id] === dir && this.fileName[id] === name);
+    }
+
+    /** Dir id for the segments (without the last one when `dropLast`), or -1 if unknown. */
+    private _resolveDir(segments: string[], dropLast: boolean): number {
+        let dir = ROOT_DIR;
+        for (let i = 0; i < segments.length - (dropLast ? 1 : 0); i++) {
+            const name = this.names.find(segments[i]);
+            if (name === -1) return -1;
+            dir = this._findDir(dir, name);
+            if (dir === -1) return -1;
+        }
+        return dir;
+    }
+
+    private _dirPath(dir: number): string {
+        let cached = this.dirPaths[dir];
+        if (cached === undefined) {
+            const parent = this.dirParent[dir];
+            const name = this.names.get(this.dirName[dir]);
+            cached = parent === ROOT_DIR ? name : `${this._dirPath(parent)}/${name}`;
+            this.dirPaths[dir] = cached;
+        }
+        return cached;
+    }
+
+    private _isWithin(dir: number, ancestor: number): boolean {
+        for (let d = dir; d !== -1; d = this.dirParent[d]) {
+            if (d === ancestor) return true;
+        }
+        return false;
+    }
+}
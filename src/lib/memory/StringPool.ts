@@ -0,0 +1,145 @@
+// File: src/lib/memory/StringPool.ts
+
+const INITIAL_IDS = 1024;
+const INITIAL_BYTES = 64 * 1024;
+
+type NumericArray = Int32Array | Uint32Array | Float64Array | Uint8Array;
+
+/** Returns `array`, or a copy at least twice as long when it cannot hold `needed` elements. */
+export function growArray<T extends NumericArray>(array: T, needed: number): T {
+    if (needed <= array.length) return array;
+    const grown = new (array.constructor as new (length: number) => T)(Math.max(needed, array.length * 2));
+    grown.set(array);
+    return grown;
+}
+
+/** FNV-1a over UTF-16 code units, as a signed 32-bit integer. */
+export function hashString(text: string): number {
+    let h = 0x811c9dc5;
+    for (let i = 0; i < text.length; i++) {
+        h ^= text.charCodeAt(i);
+        h = Math.imul(h, 0x01000193);
+    }
+    return h | 0;
+}
+
+/** Mixes two 32-bit integers (e.g. a parent id and a name id) into one hash. */
+export function hashPair(a: number, b: number): number {
+    let h = Math.imul(a ^ 0x9e3779b9, 0x85ebca6b) ^ b;
+    h = Math.imul(h ^ (h >>> 16), 0x85ebca6b);
+    h = Math.imul(h ^ (h >>> 13), 0xc2b2ae35);
+    return (h ^ (h >>> 16)) | 0;
+}
+
+/**
+ * Open-addressing hash table of ids in one Int32Array (no per-entry objects). It stores only
+ * ids; `hashOf` recomputes an id's hash when the table grows and callers confirm matches.
+ */
+export class HashIndex {
+    private readonly hashOf: (id: number) => number;
+    private slots = new Int32Array(INITIAL_IDS * 2); // id + 1; 0 marks an empty slot
+    private count = 0;
+
+    constructor(hashOf: (id: number) => number) {
+        this.hashOf = hashOf;
+    }
+
+    /** First id with this hash for which `matches` holds, or -1. */
+    find(hash: number, matches: (id: number) => boolean): number {
+        const mask = this.slots.length - 1;
+        for (let slot = hash & mask; this.slots[slot] !== 0; slot = (slot + 1) & mask) {
+            const id = this.slots[slot] - 1;
+            if (matches(id)) return id;
+        }
+        return -1;
+    }
+
+    insert(id: number): void {
+        if ((this.count + 1) * 2 > this.slots.length) this._rehash(this.slots.length * 2);
+        this._place(id);
+        this.count++;
+    }
+
+    sizeBytes(): number {
+        return this.slots.byteLength;
+    }
+
+    private _place(id: number): void {
+        const mask = this.slots.length - 1;
+        let slot = this.hashOf(id) & mask;
+        while (this.slots[slot] !== 0) slot = (slot + 1) & mask;
+        this.slots[slot] = id + 1;
+    }
+
+    private _rehash(capacity: number): void {
+        const previous = this.slots;
+        this.slots = new Int32Array(capacity);
+        for (const stored of previous) {
+            if (stored !== 0) this._place(stored - 1);
+        }
+    }
+}
+
+/**
+ * Append-only strings stored as UTF-8 in one growable Buffer, addressed by id and decoded on
+ * access. A million strings cost a few bytes of heap each (their end offset and hash) instead
+ * of a JS string apiece; the text itself lives in the Buffer, outside the V8 heap. `intern`
+ * stores each distinct string once, `add` always appends.
+ */
+export class StringPool {
+    private bytes = Buffer.allocUnsafe(INITIAL_BYTES);
+    private used = 0;
+    private ends = new Uint32Array(INITIAL_IDS);   // Byte offset where each string ends
+    private hashes = new Int32Array(INITIAL_IDS);
+    private count = 0;
+    private interned: HashIndex | null = null;     // Created by the first intern()/find()
+
+    get size(): number {
+        return this.count;
+    }
+
+    add(text: string): number {
+        const byteLength = Buffer.byteLength(text, 'utf8');
+        if (this.used + byteLength > this.bytes.length) {
+            const grown = Buffer.allocUnsafe(Math.max(this.used + byteLength, this.bytes.length * 2));
+            this.bytes.copy(grown, 0, 0, this.used);
+            this.bytes = grown;
+        }
+        this.bytes.write(text, this.used, 'utf8');
+        this.used += byteLength;
+        const id = this.count++;
+        this.ends = growArray(this.ends, this.count);
+        this.hashes = growArray(this.hashes, this.count);
+        this.ends[id] = this.used;
+        this.hashes[id] = hashString(text);
+        return id;
+    }
+
+    /** Id of `text`, adding it if it is not in the pool yet. */
+    intern(text: string): number {
+        const existing = this.find(text);
+        if (existing !== -1) return existing;
+        const id = this.add(text);
+        this._internedIndex().insert(id);
+        return id;
+    }
+
+    /** Id of an interned string, or -1. */
+    find(text: string): number {
+        const hash = hashString(text);
+        return this._internedIndex().find(hash, id => this.hashes[id] === hash && this.get(id) === text);
+    }
+
+    get(id: number): string {
+        return this.bytes.toString('utf8', id === 0 ? 0 : this.ends[id - 1], this.ends[id]);
+    }
+
+    /** Approximate bytes held (Buffer and typed arrays). */
+    sizeBytes(): number {
+        return this.bytes.length + this.ends.byteLength + this.hashes.byteLength + (this.interned?.sizeBytes() ?? 0);
+    }
+
+    private _internedIndex(): HashIndex {
+        return this.interned ??= new HashIndex(id => this.hashes[id]);
+    }
+}
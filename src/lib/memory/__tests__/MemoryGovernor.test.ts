@@ -0,0 +1,82 @@
+import { MemoryGovernor } from '../MemoryGovernor';
+import { BoundedCache } from '../BoundedCache';
+
+const MB = 1024 * 1024;
+
+describe('BoundedCache', () => {
+  it('evicts least-recently-used entries past its byte limit', () => {
+    const cache = new BoundedCache<string>('test', 10, v => v.length);
+    cache.set('a', 'xxxx');
+    cache.set('b', 'yyyy');
+    expect(cache.get('a')).toBe('xxxx'); // a is now most recently used
+    cache.set('c', 'zzzz');
+    expect(cache.get('b')).toBeUndefined();
+    expect(cache.get('a')).toBe('xxxx');
+    expect(cache.sizeBytes()).toBe(8);
+    cache.set('huge', 'x'.repeat(11));
+    expect(cache.get('huge')).toBeUndefined();
+    expect(cache.shed(5)).toBe(8);
+    expect(cache.size).toBe(0);
+  });
+});
+
+describe('MemoryGovernor', () => {
+  let heapUsed: number;
+  const governor = () => new MemoryGovernor({ budgetBytes: 100 * MB, shedRatio: 0.8, heapUsed: () => heapUsed, quiet: true });
+
+  beforeEach(() => {
+    heapUsed = 10 * MB;
+  });
+
+  it('does nothing below the shed threshold', () => {
+    const g = governor();
+    const cache = new BoundedCache<number>('c', 50 * MB, v => v);
+    g.register(cache);
+    cache.set('k', 10 * MB);
+    expect(g.relieve()).toBe(0);
+    expect(g.canAfford(20 * MB, 'test')).toBe(true);
+    expect(cache.sizeBytes()).toBe(10 * MB);
+    expect(g.getDecisions()).toHaveLength(0);
+  });
+
+  it('sheds lower-priority caches first under pressure', () => {
+    const g = governor();
+    const low = new BoundedCache<number>('low', 50 * MB, v => v);
+    const high = new BoundedCache<number>('high', 50 * MB, v => v);
+    g.register(high, 10);
+    g.register(low, 0);
+    low.set('a', 5 * MB);
+    high.set('b', 20 * MB);
+    heapUsed = 84 * MB; // 4 MB over the 80 MB threshold
+
+    expect(g.relieve('test')).toBe(5 * MB);
+    expect(low.sizeBytes()).toBe(0);
+    expect(high.sizeBytes()).toBe(20 * MB);
+    expect(g.getDecisions()).toEqual([expect.objectContaining({ action: 'shed', purpose: 'test' })]);
+  });
+
+  it('allows an allocation after shedding and denies one that cannot fit', () => {
+    const g = governor();
+    const cache = new BoundedCache<number>('c', 50 * MB, v => v);
+    const unregister = g.register(cache);
+    cache.set('a', 15 * MB);
+    heapUsed = 70 * MB;
+
+    expect(g.canAfford(20 * MB, 'context.full')).toBe(true); // 90 MB projected, 15 MB freed
+    expect(cache.sizeBytes()).toBe(0);
+    expect(g.getDecisions().map(d => d.action)).toEqual(['shed', 'allow']);
+
+    unregister();
+    expect(g.canAfford(40 * MB, 'context.full')).toBe(false);
+    expect(g.getDecisions().pop()).toEqual(expect.objectContaining({ action: 'deny', purpose: 'context.full' }));
+  });
+
+  it('applies config overrides and ignores invalid values', () => {
+    const g = governor();
+    g.configure({ heap_budget_mb: 512, shed_ratio: 2 });
+    expect(g.budgetBytes).toBe(512 * MB);
+    g.configure(undefined);
+    expect(g.budgetBytes).toBe(512 * MB);
+    expect(MemoryGovernor.defaultBudgetBytes()).toBeGreaterThan(0);
+  });
+});
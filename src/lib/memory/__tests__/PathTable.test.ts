@@ -0,0 +1,45 @@
+import { PathTable } from '../PathTable';
+import { StringPool } from '../StringPool';
+
+describe('StringPool', () => {
+  it('interns strings once and decodes them on access', () => {
+    const pool = new StringPool();
+    const ids = Array.from({ length: 5000 }, (_, i) => pool.intern(`name${i % 1234}`));
+    expect(pool.size).toBe(1234);
+    expect(pool.get(ids[1300])).toBe('name66');
+    expect(pool.find('missing')).toBe(-1);
+    const added = pool.add('ünïcødé ✓');
+    expect(pool.get(added)).toBe('ünïcødé ✓');
+    expect(pool.find('ünïcødé ✓')).toBe(-1); // add() does not intern
+  });
+});
+
+describe('PathTable', () => {
+  const paths = [
+    ...Array.from({ length: 3000 }, (_, i) => `src/m${i % 37}/sub${i % 5}/file${i}.ts`),
+    'README.md', 'src', 'a//b', '/abs/x',
+  ];
+  const table = PathTable.from(paths);
+
+  it('round-trips every path and looks ids up without adding', () => {
+    expect(table.size).toBe(paths.length);
+    paths.forEach((p, id) => {
+      expect(table.get(id)).toBe(p);
+      expect(table.indexOf(p)).toBe(id);
+    });
+    expect([...table]).toEqual(paths);
+    expect(table.add('src/m1/sub1/file1.ts')).toBe(1); // Already present
+    expect(table.indexOf('src/m1/sub1/other.ts')).toBe(-1);
+    expect(table.indexOf('src/m1')).toBe(-1); // A directory, not a file
+    expect(table.basename(0)).toBe('file0.ts');
+    expect(table.size).toBe(paths.length);
+  });
+
+  it('lists files under a directory or matching a path', () => {
+    expect(table.under('src/m3/')).toEqual(paths.filter(p => p.startsWith('src/m3/')));
+    expect(table.under('src')).toEqual(paths.filter(p => p === 'src' || p.startsWith('src/')));
+    expect(table.under('README.md')).toEqual(['README.md']);
+    expect(table.under('missing')).toEqual([]);
+    expect(table.under('')).toHaveLength(paths.length);
+  });
+});
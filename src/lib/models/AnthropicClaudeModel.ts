@@ -17,7 +17,8 @@ export default class AnthropicClaudeModel extends BaseModel {
   private client: any;
   public modelName: string;
 
-  constructor(config: Config) {
+  /** @param apiKey Key from the provider's key pool; defaults to the configured key. */
+  constructor(config: Config, apiKey?: string) {
     super(config);
     if (!config.anthropic?.api_key) {
       throw new Error('Anthropic API key is missing in the configuration.');
@@ -27,7 +28,7 @@ export default class AnthropicClaudeModel extends BaseModel {
     try {
       // eslint-disable-next-line @typescript-eslint/no-var-requires
       const { Anthropic } = require('@anthropic-ai/sdk');
-      this.client = new Anthropic({ apiKey: config.anthropic.api_key });
+      this.client = new Anthropic({ apiKey: apiKey ?? config.anthropic.api_key });
     } catch (err) {
       throw new Error(
         'Failed to load @anthropic-ai/sdk. Please install it to use Anthropic Claude models.'
@@ -96,6 +97,48 @@ export default class AnthropicClaudeModel extends BaseModel {
    * Sends a chat conversation to Claude and returns the assistant's response.
    */
   async getResponseFromAI(messages: Message[]): Promise<string> {
+    const response = await this.client.messages.create(this._chatParams(messages));
+    const completion = response.content[0].text;
+    if (!completion) {
+      throw new Error(`Anthropic Claude response missing completion text.`);
+    }
+    console.log(
+      chalk.blue(`Received response from Claude (${completion.length} characters)`)
+    );
+    return completion;
+  }
+
+  /**
+   * Streams a chat response from Claude, passing each text delta to `onDelta`.
+   * Resolves with the text received so far when `signal` aborts.
+   */
+  async streamResponseFromAI(
+    messages: Message[],
+    onDelta: (text: string) => void,
+    signal?: AbortSignal
+  ): Promise<string> {
+    const params = { ...this._chatParams(messages), stream: true };
+    let completion = '';
+    try {
+      const stream = await this.client.messages.create(params, { signal });
+      for await (const event of stream) {
+        if (event.type === 'content_block_delta' && event.delta?.type === 'text_delta' && event.delta.text) {
+          completion += event.delta.text;
+          onDelta(event.delta.text);
+        }
+      }
+    } catch (error) {
+      if (signal?.aborted) return completion;
+      throw error;
+    }
+    console.log(
+      chalk.blue(`Streamed response from Claude (${completion.length} characters)`)
+    );
+    return completion;
+  }
+
+  /** Builds Messages API parameters; a system message becomes the system prompt. */
+  private _chatParams(messages: Message[]): any {
     if (!messages.length) {
       throw new Error('Cannot get AI response with empty message history.');
     }
@@ -126,15 +169,6 @@ export default class AnthropicClaudeModel extends BaseModel {
     if (systemPrompt) {
       params.system = systemPrompt;
     }
-
-    const response = await this.client.messages.create(params);
-    const completion = response.content[0].text;
-    if (!completion) {
-      throw new Error(`Anthropic Claude response missing completion text.`);
-    }
-    console.log(
-      chalk.blue(`Received response from Claude (${completion.length} characters)`)
-    );
-    return completion;
+    return params;
   }
-}
\ No newline at end of file
+}
@@ -14,6 +14,27 @@ describe('BaseModel', () => {
     );
   });
 
+  describe('streamResponseFromAI', () => {
+    it('delivers the full response as one delta', async () => {
+      const model = new BaseModel({});
+      jest.spyOn(model, 'getResponseFromAI').mockResolvedValue('whole answer');
+      const onDelta = jest.fn();
+      await expect(model.streamResponseFromAI([], onDelta)).resolves.toBe('whole answer');
+      expect(onDelta).toHaveBeenCalledWith('whole answer');
+    });
+
+    it('stops waiting when the signal aborts', async () => {
+      const model = new BaseModel({});
+      jest.spyOn(model, 'getResponseFromAI').mockReturnValue(new Promise(() => {}));
+      const controller = new AbortController();
+      const onDelta = jest.fn();
+      const pending = model.streamResponseFromAI([], onDelta, controller.signal);
+      controller.abort();
+      await expect(pending).resolves.toBe('');
+      expect(onDelta).not.toHaveBeenCalled();
+    });
+  });
+
   describe('flattenMessages', () => {
     it('logs an error and returns empty array when input is not an array', () => {
       const model = new BaseModel({});
@@ -10,6 +10,20 @@ class BaseModel {
         throw new Error("getResponseFromAI must be implemented in derived classes");
     }
 
+    /**
+     * Streams a chat response: `onDelta` receives each text fragment as it arrives and the
+     * whole text is returned. Providers without streaming deliver the full response as one
+     * fragment. When `signal` aborts, resolves with the text received so far.
+     */
+    async streamResponseFromAI(messages: any[], onDelta: (text: string) => void, signal?: AbortSignal): Promise<string> {
+        if (signal?.aborted) return '';
+        const aborted = new Promise<null>(resolve => signal?.addEventListener('abort', () => resolve(null), { once: true }));
+        const text = await Promise.race([this.getResponseFromAI(messages), aborted]);
+        if (text === null) return '';
+        if (text) onDelta(text);
+        return text;
+    }
+
     flattenMessages(messages: any[]): any[] { // Type as array of any
         if (!Array.isArray(messages)) {
             console.error("flattenMessages expects an array of messages.");
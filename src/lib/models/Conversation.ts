@@ -83,4 +83,14 @@ export class Conversation {
     }
 }
 
+/**
+ * The last few messages, each trimmed to 100 characters, as the history hint dynamic and
+ * auto context selection receive. Null when there is no history.
+ */
+export function summarizeHistory(history: Message[]): string | null {
+    if (!history || history.length === 0) return null;
+    const lines = history.slice(-4).map(m => `  ${m.role}: ${m.content.substring(0, 100)}${m.content.length > 100 ? '...' : ''}`);
+    return `Recent conversation highlights:\n${lines.join('\n')}\n`;
+}
+
 export default Conversation;
\ No newline at end of file
@@ -12,6 +12,10 @@ import {
 import { Config } from "../Config"; // Correct path if needed
 import { Message } from "../models/Conversation"; // Correct path
 import chalk from 'chalk';
+import { tracer } from '../telemetry/Tracer';
+import { metrics } from '../telemetry/Metrics';
+import { ApiKeyPool } from '../scheduling/ApiKeyPool';
+import { streamGeminiChat } from './geminiStream';
 
 // Types for internal conversion (unchanged)
 interface GeminiMessagePart { text: string; }
@@ -25,14 +29,21 @@ class Gemini2FlashModel extends BaseModel {
     // --- ADD RETRY CONFIG ---
     private maxRetries: number;
     private retryBaseDelay: number;
+    private keyFailover: boolean;
     // --- END RETRY CONFIG ---
 
-    constructor(config: Config) {
+    /**
+     * @param apiKey Key from the provider's key pool; defaults to the configured key.
+     * @param keyFailover True when the pool has other keys: rate-limit and auth errors are then
+     *   thrown at once, for the pool to quarantine this key and retry on another.
+     */
+    constructor(config: Config, apiKey?: string, keyFailover: boolean = false) {
         super(config);
+        this.keyFailover = keyFailover;
         if (!config.gemini?.api_key) {
             throw new Error("Gemini API key is missing in the configuration.");
         }
-        this.genAI = new GoogleGenerativeAI(config.gemini.api_key);
+        this.genAI = new GoogleGenerativeAI(apiKey ?? config.gemini.api_key);
         const selectedModelName = config.gemini.subsequent_chat_model_name;
 
         // If a non-Gemini model (like Claude) is selected elsewhere, the config might
@@ -70,6 +81,15 @@ class Gemini2FlashModel extends BaseModel {
         return this.queryGeminiChat(geminiConversation); // Use chat-specific method
     }
 
+    // --- streamResponseFromAI (streamed chat for UIs without a terminal; no prompt review) ---
+    async streamResponseFromAI(messages: Message[], onDelta: (text: string) => void, signal?: AbortSignal): Promise<string> {
+        if (!messages || messages.length === 0) {
+            throw new Error("Cannot get AI response with empty message history.");
+        }
+        return streamGeminiChat(this.model, this.modelName, this.convertToGeminiConversation(messages),
+            this.config.gemini.max_output_tokens || 8192, onDelta, signal, error => this.handleError(error, this.modelName));
+    }
+
     // --- queryGeminiChat (Helper for getResponseFromAI - Unchanged) ---
     async queryGeminiChat(geminiMessages: GeminiChatHistory): Promise<string> {
         try {
@@ -166,6 +186,8 @@ class Gemini2FlashModel extends BaseModel {
                 return result; // Success
 
             } catch (error: any) {
+                // A rate-limited or rejected key is the key pool's to handle when it has others
+                if (this.keyFailover && ApiKeyPool.classify(error) !== null) this.handleError(error, this.modelName);
                 const errorCode = (error as any).code || 'UNKNOWN'; // Get error code if attached by handleError or added by us
                 const isRetryable = ['RATE_LIMIT', 'SERVER_OVERLOADED', 'NETWORK_ERROR', 'NO_RESPONSE'].includes(errorCode);
 
@@ -175,6 +197,9 @@ class Gemini2FlashModel extends BaseModel {
                     attempts++;
                     const delay = this.retryBaseDelay * Math.pow(2, attempts - 1); // Exponential backoff
                     console.log(chalk.yellow(`Retrying in ${delay / 1000}s... (${attempts}/${this.maxRetries})`));
+                    tracer.instant('model.retry', 'model', { model: this.modelName, attempt: attempts, code: errorCode, delayMs: Math.round(delay) });
+                    metrics.increment('model.retries', { provider: 'gemini' });
+                    if (ApiKeyPool.classify(error) === 'rate_limited') metrics.increment('model.rate_limited', { provider: 'gemini' }); // The last attempt's is counted by AIClient
                     await new Promise(resolve => setTimeout(resolve, delay));
                     continue; // Retry the loop
                 } else {
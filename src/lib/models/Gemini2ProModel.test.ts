@@ -137,6 +137,13 @@ describe('Gemini2ProModel', () => {
       expect(text).toBe(MOCK_GENERATED_TEXT);
     });
 
+    it('leaves a rate-limited key to the key pool instead of retrying it when the pool has other keys', async () => {
+      const pooled = new Gemini2ProModel(defaultConfig as Config, 'second-key', true);
+      mockGenerateContent.mockRejectedValue(Object.assign(new Error('[GoogleGenerativeAI Error]: 429 Too Many Requests'), { status: 429 }));
+      await expect(pooled.generateContent(MOCK_GENERATE_CONTENT_REQUEST)).rejects.toMatchObject({ code: 'RATE_LIMIT' });
+      expect(mockGenerateContent).toHaveBeenCalledTimes(1);
+    });
+
     it('should handle errors from the Gemini API during content generation', async () => {
       const errorMessage = 'API error occurred during generation';
       mockGenerateContent.mockRejectedValue(new Error(errorMessage));
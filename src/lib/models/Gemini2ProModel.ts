@@ -13,6 +13,10 @@ import { Config } from "../Config";
 import { InteractivePromptReviewer } from "../UserInteraction/InteractivePromptReviewer"; // NEW Import
 import { Message } from "../models/Conversation"; // Correct path
 import chalk from 'chalk';
+import { tracer } from '../telemetry/Tracer';
+import { metrics } from '../telemetry/Metrics';
+import { ApiKeyPool } from '../scheduling/ApiKeyPool';
+import { streamGeminiChat } from './geminiStream';
 // --- Conditional Imports ---
 // Removed: inquirer
 // Removed: fs
@@ -32,14 +36,21 @@ class Gemini2ProModel extends BaseModel {
     model: GenerativeModel; // The specific model instance
     private maxRetries: number;
     private retryBaseDelay: number;
+    private keyFailover: boolean;
     private promptReviewer: InteractivePromptReviewer; // NEW Property
 
-    constructor(config: Config) {
+    /**
+     * @param apiKey Key from the provider's key pool; defaults to the configured key.
+     * @param keyFailover True when the pool has other keys: rate-limit and auth errors are then
+     *   thrown at once, for the pool to quarantine this key and retry on another.
+     */
+    constructor(config: Config, apiKey?: string, keyFailover: boolean = false) {
         super(config);
+        this.keyFailover = keyFailover;
         if (!config.gemini?.api_key) {
             throw new Error("Gemini API key is missing in the configuration.");
         }
-        this.genAI = new GoogleGenerativeAI(config.gemini.api_key);
+        this.genAI = new GoogleGenerativeAI(apiKey ?? config.gemini.api_key);
         const selectedModelName = config.gemini.model_name;
 
         // If a non-Gemini model (like Claude) is selected, `config.gemini.model_name`
@@ -80,6 +91,15 @@ class Gemini2ProModel extends BaseModel {
         return this.queryGeminiChat(geminiConversation); // Use chat-specific method
     }
 
+    // --- streamResponseFromAI (streamed chat for UIs without a terminal; no prompt review) ---
+    async streamResponseFromAI(messages: Message[], onDelta: (text: string) => void, signal?: AbortSignal): Promise<string> {
+        if (!messages || messages.length === 0) {
+            throw new Error("Cannot get AI response with empty message history.");
+        }
+        return streamGeminiChat(this.model, this.modelName, this.convertToGeminiConversation(messages),
+            this.config.gemini.max_output_tokens || 8192, onDelta, signal, error => this.handleError(error, this.modelName));
+    }
+
     // --- queryGeminiChat (Helper for getResponseFromAI - MODIFIED) ---
     async queryGeminiChat(geminiMessages: GeminiChatHistory): Promise<string> {
         try {
@@ -192,6 +212,8 @@ class Gemini2ProModel extends BaseModel {
                 return result;
 
             } catch (error: any) {
+                // A rate-limited or rejected key is the key pool's to handle when it has others
+                if (this.keyFailover && ApiKeyPool.classify(error) !== null) this.handleError(error, this.modelName);
                 // --- Retry Logic ---
                 const isBlockError = error instanceof Error && error.message.startsWith('Model') && error.message.includes('generation blocked');
                  const assignedErrorCode = (error as any).code; // Code from block error or handleError
@@ -218,6 +240,9 @@ class Gemini2ProModel extends BaseModel {
                      attempts++;
                     const delay = this.retryBaseDelay * Math.pow(2, attempts - 1) + Math.random() * 1000; // Add jitter
                     console.log(chalk.yellow(`Retrying in ${(delay / 1000).toFixed(1)}s... (${attempts}/${this.maxRetries})`));
+                    tracer.instant('model.retry', 'model', { model: this.modelName, attempt: attempts, code: assignedErrorCode ?? 'UNKNOWN', delayMs: Math.round(delay) });
+                    metrics.increment('model.retries', { provider: 'gemini' });
+                    if (ApiKeyPool.classify(error) === 'rate_limited') metrics.increment('model.rate_limited', { provider: 'gemini' }); // The last attempt's is counted by AIClient
                     await new Promise(resolve => setTimeout(resolve, delay));
                     continue;
                  } else {
@@ -2,7 +2,7 @@ import BaseModel from './BaseModel';
 import chalk from 'chalk';
 import { Config } from '../Config';
 import { Message } from './Conversation';
-import { encode as gpt3Encode, decode as gpt3Decode } from 'gpt-3-encoder';
+import { getTokenEncoder } from '../utils';
 import OpenAI from 'openai';
 
 export default class OpenAIChatModel extends BaseModel {
@@ -10,26 +10,28 @@ export default class OpenAIChatModel extends BaseModel {
   public modelName: string;
   private maxPromptTokens: number;
 
-  constructor(config: Config, modelName: string) {
+  /** @param apiKey Key from the provider's key pool; defaults to the configured key. */
+  constructor(config: Config, modelName: string, apiKey?: string) {
     super(config);
     if (!config.openai?.api_key) {
       throw new Error('OpenAI API key is missing in the configuration.');
     }
-    this.client = new OpenAI({ apiKey: config.openai.api_key });
+    this.client = new OpenAI({ apiKey: apiKey ?? config.openai.api_key });
     this.modelName = modelName;
     this.maxPromptTokens = config.openai.max_prompt_tokens || 128000;
   }
 
   private countTokens(text: string): number {
-    return gpt3Encode(text).length;
+    return getTokenEncoder().encode(text).length;
   }
 
   private chunkByTokens(text: string, maxTokens: number): string[] {
-    const tokens = gpt3Encode(text);
+    const { encode, decode } = getTokenEncoder();
+    const tokens = encode(text);
     const chunks: string[] = [];
     for (let i = 0; i < tokens.length; i += maxTokens) {
       const slice = tokens.slice(i, i + maxTokens);
-      chunks.push(gpt3Decode(slice));
+      chunks.push(decode(slice));
     }
     return chunks;
   }
@@ -72,6 +74,38 @@ export default class OpenAIChatModel extends BaseModel {
     return response;
   }
 
+  /**
+   * Streams a chat response, passing each content delta to `onDelta`. Prompts over the token
+   * limit go through the chunked path and arrive as one delta.
+   */
+  async streamResponseFromAI(messages: Message[], onDelta: (text: string) => void, signal?: AbortSignal): Promise<string> {
+    if (!messages.length) {
+      throw new Error('Cannot get AI response with empty message history.');
+    }
+    const chatMessages = messages.map(m => ({ role: m.role, content: m.content }));
+    if (this.countTokens(chatMessages.map(m => m.content).join(' ')) > this.maxPromptTokens) {
+      return super.streamResponseFromAI(messages, onDelta, signal);
+    }
+    let response = '';
+    try {
+      const stream = await (this.client.chat.completions.create as any)({
+        model: this.modelName,
+        messages: chatMessages as any,
+        stream: true,
+      }, { signal });
+      for await (const chunk of stream) {
+        const delta = chunk.choices?.[0]?.delta?.content;
+        if (!delta) continue;
+        response += delta;
+        onDelta(delta);
+      }
+    } catch (error) {
+      if (signal?.aborted) return response;
+      throw error;
+    }
+    return response;
+  }
+
   async generateContent(request: any): Promise<any> {
     const messages = (request.contents || []).map((c: any) => ({
       role: c.role,
@@ -1,4 +1,4 @@
-import Conversation, { JsonlLogEntry } from '../Conversation';
+import Conversation, { JsonlLogEntry, Message, summarizeHistory } from '../Conversation';
 import { v4 as uuidv4 } from 'uuid';
 
 jest.mock('uuid', () => ({ v4: jest.fn(() => 'generated-id') }));
@@ -74,4 +74,26 @@ describe('Conversation', () => {
         expect(conv.getMessages()).toEqual([]);
         expect(warnSpy).toHaveBeenCalledTimes(3);
     });
-});
\ No newline at end of file
+
+    describe('summarizeHistory', () => {
+        it('should return null for empty history', () => {
+            expect(summarizeHistory([])).toBeNull();
+        });
+
+        it('should summarize recent messages', () => {
+            const history: Message[] = [
+                { role: 'user', content: 'old 1', timestamp: '' },
+                { role: 'assistant', content: 'old 2', timestamp: '', },
+                { role: 'user', content: 'recent 1', timestamp: '' },
+                { role: 'assistant', content: 'recent 2', timestamp: '' },
+                { role: 'user', content: 'recent 3', timestamp: '' },
+                { role: 'assistant', content: 'recent 4', timestamp: '' },
+            ];
+            const summary = summarizeHistory(history);
+            expect(summary).toContain('Recent conversation highlights:');
+            expect(summary).toContain('user: recent 1');
+            expect(summary).toContain('assistant: recent 4');
+            expect(summary).not.toContain('old 1'); // Should only take last 4
+        });
+    });
+});
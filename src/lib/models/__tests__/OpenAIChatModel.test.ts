@@ -43,6 +43,22 @@ describe('OpenAIChatModel', () => {
     expect(mockCreate).toHaveBeenCalled();
   });
 
+  it('streams deltas and keeps partial text when aborted', async () => {
+    const controller = new AbortController();
+    mockCreate.mockResolvedValueOnce((async function* () {
+      yield { choices: [{ delta: { content: 'Hel' } }] };
+      yield { choices: [{ delta: {} }] };
+      yield { choices: [{ delta: { content: 'lo' } }] };
+      controller.abort();
+      throw Object.assign(new Error('Request was aborted.'), { name: 'AbortError' });
+    })());
+    const deltas: string[] = [];
+    const model = new OpenAIChatModel(baseConfig as Config, 'gpt-4o');
+    await expect(model.streamResponseFromAI([{ role: 'user', content: 'hi' }], d => deltas.push(d), controller.signal)).resolves.toBe('Hello');
+    expect(deltas).toEqual(['Hel', 'lo']);
+    expect(mockCreate).toHaveBeenCalledWith(expect.objectContaining({ stream: true }), { signal: controller.signal });
+  });
+
   it('splits long prompts', async () => {
     const model = new OpenAIChatModel(baseConfig as Config, 'gpt-4o');
     const long = 'a'.repeat(100);
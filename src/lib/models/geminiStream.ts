@@ -0,0 +1,45 @@
+// File: src/lib/models/geminiStream.ts
+import { Content, GenerativeModel } from "@google/generative-ai";
+import chalk from 'chalk';
+
+/**
+ * Streamed chat turn shared by the Gemini Pro and Flash models. `geminiMessages` is the
+ * converted conversation, ending with the user message to send; each text fragment goes to
+ * `onDelta` and the whole text is returned. A failed stream goes to `handleError` (the model's,
+ * which throws a coded error), except after `signal` aborted: then the text received so far
+ * is returned.
+ */
+export async function streamGeminiChat(
+    model: GenerativeModel,
+    modelName: string,
+    geminiMessages: Content[],
+    maxOutputTokens: number,
+    onDelta: (text: string) => void,
+    signal: AbortSignal | undefined,
+    handleError: (error: unknown) => void
+): Promise<string> {
+    const lastMessageToSend = geminiMessages[geminiMessages.length - 1];
+    if (!lastMessageToSend || lastMessageToSend.role !== "user") throw new Error("Internal Error: Last message must be user.");
+
+    let responseText = '';
+    try {
+        const chatSession = model.startChat({
+            history: geminiMessages.slice(0, -1),
+            generationConfig: { maxOutputTokens },
+        });
+        const lastMessageText = lastMessageToSend.parts.map((part) => part.text).join('');
+        console.log(chalk.blue(`Streaming prompt to ${modelName}... (last message: ${lastMessageText.length} characters)`));
+        const result = await chatSession.sendMessageStream(lastMessageText, { signal });
+        for await (const chunk of result.stream) {
+            const delta = chunk.text(); // Throws if the candidate was blocked
+            if (!delta) continue;
+            responseText += delta;
+            onDelta(delta);
+        }
+        console.log(chalk.blue(`Streamed response from ${modelName}. (${responseText.length} characters)`));
+    } catch (error) {
+        if (signal?.aborted) return responseText; // Cancelled: keep what arrived
+        handleError(error);
+    }
+    return responseText;
+}
@@ -0,0 +1,306 @@
+// File: src/lib/retrieval/RetrievalTools.ts
+import fsPromises from 'fs/promises';
+import path from 'path';
+import type { Ignore } from 'ignore';
+import { SchemaType, FunctionCallingMode, FunctionDeclaration, ToolConfig } from '@google/generative-ai';
+import { FileSystem } from '../FileSystem';
+import { SyntaxChunker } from '../analysis/SyntaxChunker';
+import { SymbolEntry } from '../analysis/types';
+import { AnalysisIndex } from '../analysis/AnalysisIndex';
+import { PathTable } from '../memory/PathTable';
+import { tracer } from '../telemetry/Tracer';
+import { metrics } from '../telemetry/Metrics';
+
+const MAX_READ_LINES = 400; // Per read_file call; the model can page with start_line
+const MAX_GREP_RESULTS = 50;
+const MAX_LINE_CHARS = 200;
+const MAX_RESULT_CHARS = 24000; // Any single tool result is truncated beyond this
+const GREP_READ_CONCURRENCY = 16;
+
+/** One function call requested by the model. */
+export interface ToolCall {
+    name: string;
+    args: Record<string, any>;
+}
+
+/** What a tool returned, sent back to the model as a functionResponse. */
+export interface ToolResult {
+    name: string;
+    response: Record<string, unknown>;
+}
+
+/** The local index the tools search: the (possibly scoped) file list and analysis cache. */
+export interface RetrievalIndex {
+    files(): Promise<PathTable>; // Relative, POSIX-separated paths
+    cache(): Promise<AnalysisIndex | null>;
+    roots?(): string[] | null;   // Workspace scope: relative package directories; null for the whole project
+}
+
+export const RETRIEVAL_TOOL_DECLARATIONS: FunctionDeclaration[] = [
+    {
+        name: 'read_file',
+        description: `Reads a project file, optionally only a line range. Lines are prefixed with their 1-based number. At most ${MAX_READ_LINES} lines are returned per call; request the next range to continue.`,
+        parameters: {
+            type: SchemaType.OBJECT,
+            properties: {
+                path: { type: SchemaType.STRING, description: 'File path relative to the project root.' },
+                start_line: { type: SchemaType.INTEGER, description: 'First line to read (1-based, default 1).' },
+                end_line: { type: SchemaType.INTEGER, description: 'Last line to read (inclusive).' },
+            },
+            required: ['path'],
+        },
+    },
+    {
+        name: 'grep',
+        description: 'Searches project text files for a regular expression (case-insensitive) and returns matching lines with their file and line number.',
+        parameters: {
+            type: SchemaType.OBJECT,
+            properties: {
+                pattern: { type: SchemaType.STRING, description: 'Regular expression or plain text to search for.' },
+                path_prefix: { type: SchemaType.STRING, description: 'Only search files under this directory or path prefix.' },
+                max_results: { type: SchemaType.INTEGER, description: `Maximum matches to return (default and limit ${MAX_GREP_RESULTS}).` },
+            },
+            required: ['pattern'],
+        },
+    },
+    {
+        name: 'list_dir',
+        description: 'Lists the entries of a project directory. Directories end with "/". Ignored files are not listed.',
+        parameters: {
+            type: SchemaType.OBJECT,
+            properties: {
+                path: { type: SchemaType.STRING, description: 'Directory relative to the project root (default ".").' },
+            },
+        },
+    },
+    {
+        name: 'get_symbol',
+        description: 'Returns the source of a class, function, component or method by name (e.g. "parseConfig" or "UserService.save"), with its line range.',
+        parameters: {
+            type: SchemaType.OBJECT,
+            properties: {
+                name: { type: SchemaType.STRING, description: 'Symbol name; methods may be qualified with their class.' },
+                path: { type: SchemaType.STRING, description: 'File to look in. Without it, symbols from the project analysis are searched.' },
+            },
+            required: ['name'],
+        },
+    },
+];
+
+/**
+ * Read-only retrieval tools the model can call instead of receiving the code base up front:
+ * read_file (line ranges), grep over the local file index, list_dir and get_symbol.
+ * Paths are confined to the project root (and to the workspace scope's package directories,
+ * like grep's file index) and ignored files are hidden. Tool errors are
+ * returned to the model as `{ error }` rather than thrown, so one bad call does not end a turn.
+ */
+export class RetrievalTools {
+    private fs: FileSystem;
+    private projectRoot: string;
+    private ignoreRules: Ignore;
+    private index: RetrievalIndex;
+    private chunker: SyntaxChunker;
+
+    constructor(fs: FileSystem, projectRoot: string, ignoreRules: Ignore, index: RetrievalIndex, chunker: SyntaxChunker = new SyntaxChunker(projectRoot)) {
+        this.fs = fs;
+        this.projectRoot = projectRoot;
+        this.ignoreRules = ignoreRules;
+        this.index = index;
+        this.chunker = chunker;
+    }
+
+    get declarations(): FunctionDeclaration[] {
+        return RETRIEVAL_TOOL_DECLARATIONS;
+    }
+
+    /** Tool config that makes the model answer instead of calling more tools. */
+    get answerOnlyConfig(): ToolConfig {
+        return { functionCallingConfig: { mode: FunctionCallingMode.NONE } };
+    }
+
+    /** Runs all calls of one model turn concurrently; results keep the order of the calls. */
+    async executeAll(calls: ToolCall[]): Promise<ToolResult[]> {
+        return tracer.span('retrieval.tools', 'context', () => Promise.all(calls.map(call => this.execute(call))), { calls: calls.length });
+    }
+
+    async execute(call: ToolCall): Promise<ToolResult> {
+        metrics.increment('retrieval.tool_calls', { tool: call.name });
+        let response: Record<string, unknown>;
+        try {
+            response = await tracer.span(`retrieval.${call.name}`, 'context', () => this._dispatch(call), { args: JSON.stringify(call.args ?? {}) });
+        } catch (error) {
+            metrics.increment('retrieval.tool_errors', { tool: call.name });
+            response = { error: (error as Error).message };
+        }
+        return { name: call.name, response: RetrievalTools._truncate(response) };
+    }
+
+    private async _dispatch(call: ToolCall): Promise<Record<string, unknown>> {
+        const args = call.args ?? {};
+        switch (call.name) {
+            case 'read_file': return this._readFile(String(args.path ?? ''), args.start_line, args.end_line);
+            case 'grep': return this._grep(String(args.pattern ?? ''), args.path_prefix, args.max_results);
+            case 'list_dir': return this._listDir(String(args.path ?? '.'));
+            case 'get_symbol': return this._getSymbol(String(args.name ?? ''), args.path);
+            default: throw new Error(`Unknown tool '${call.name}'. Available: ${RETRIEVAL_TOOL_DECLARATIONS.map(d => d.name).join(', ')}`);
+        }
+    }
+
+    // --- Tools ---
+
+    private async _readFile(requestedPath: string, startLine?: number, endLine?: number): Promise<Record<string, unknown>> {
+        const { absolute, relative } = this._resolveInScope(requestedPath);
+        const content = await this.fs.readFile(absolute);
+        if (content === null) throw new Error(`File not found: ${relative}`);
+        const lines = content.split('\n');
+        const start = Math.max(1, Math.floor(Number(startLine) || 1));
+        const requestedEnd = Math.min(lines.length, Math.floor(Number(endLine) || lines.length));
+        const end = Math.min(requestedEnd, start + MAX_READ_LINES - 1);
+        if (start > lines.length) throw new Error(`${relative} has only ${lines.length} lines.`);
+        return {
+            path: relative,
+            start_line: start,
+            end_line: end,
+            total_lines: lines.length,
+            content: RetrievalTools._numbered(lines.slice(start - 1, end), start),
+            ...(end < requestedEnd ? { note: `Truncated at ${MAX_READ_LINES} lines; continue with start_line ${end + 1}.` } : {}),
+        };
+    }
+
+    private async _grep(pattern: string, pathPrefix?: string, maxResults?: number): Promise<Record<string, unknown>> {
+        if (!pattern) throw new Error('grep requires a pattern.');
+        let regex: RegExp;
+        try {
+            regex = new RegExp(pattern, 'i');
+        } catch {
+            regex = new RegExp(pattern.replace(/[.*+?^${}()|[\]\\]/g, '\\$&'), 'i'); // Not a valid regex: search literally
+        }
+        const limit = Math.min(MAX_GREP_RESULTS, Math.max(1, Math.floor(Number(maxResults) || MAX_GREP_RESULTS)));
+        const prefix = pathPrefix ? this._resolve(pathPrefix).relative.replace(/^\.$/, '') : '';
+        const files = (await this.index.files()).under(prefix);
+
+        const contents = await this.fs.readFileContents(files.map(f => path.join(this.projectRoot, f)), GREP_READ_CONCURRENCY);
+        const matches: { path: string; line: number; text: string }[] = [];
+        let total = 0;
+        for (const file of files) {
+            const content = contents[path.join(this.projectRoot, file)];
+            if (!content) continue;
+            const lines = content.split('\n');
+            for (let i = 0; i < lines.length; i++) {
+                if (!regex.test(lines[i])) continue;
+                total++;
+                if (matches.length < limit) matches.push({ path: file, line: i + 1, text: lines[i].trim().slice(0, MAX_LINE_CHARS) });
+            }
+        }
+        return { pattern, files_searched: files.length, total_matches: total, matches };
+    }
+
+    private async _listDir(requestedPath: string): Promise<Record<string, unknown>> {
+        const { absolute, relative } = this._resolve(requestedPath);
+        const placement = this._scopePlacement(relative);
+        if (placement === 'outside') throw new Error(`Path '${relative}' is outside the workspace scope.`);
+        const entries = await fsPromises.readdir(absolute, { withFileTypes: true });
+        const listed = entries
+            .map(entry => {
+                const entryPath = relative ? `${relative}/${entry.name}` : entry.name;
+                return { entryPath, name: entry.isDirectory() ? `${entry.name}/` : entry.name, isDir: entry.isDirectory() };
+            })
+            .filter(e => !this.ignoreRules.ignores(e.isDir ? `${e.entryPath}/` : e.entryPath))
+            // Above the scope only the way down to its packages is shown
+            .filter(e => placement === 'inside' || this._scopePlacement(e.entryPath) !== 'outside')
+            .sort((a, b) => Number(b.isDir) - Number(a.isDir) || a.name.localeCompare(b.name))
+            .map(e => e.name);
+        return { path: relative || '.', entries: listed };
+    }
+
+    private async _getSymbol(name: string, requestedPath?: string): Promise<Record<string, unknown>> {
+        if (!name) throw new Error('get_symbol requires a name.');
+        const matchesName = (s: SymbolEntry) => s.name === name || s.name.endsWith(`.${name}`);
+        let found: { filePath: string; symbol: SymbolEntry }[] = [];
+
+        if (requestedPath) {
+            const { absolute, relative } = this._resolveInScope(requestedPath);
+            const content = await this.fs.readFile(absolute);
+            if (content === null) throw new Error(`File not found: ${relative}`);
+            found = (await this.chunker.extractSymbols(relative, content)).filter(matchesName).map(symbol => ({ filePath: relative, symbol }));
+        } else {
+            const cache = await this.index.cache();
+            for (let row = 0; row < (cache?.length ?? 0); row++) {
+                for (const symbol of cache!.symbols(row) ?? []) {
+                    if (matchesName(symbol)) found.push({ filePath: cache!.filePath(row), symbol });
+                }
+            }
+        }
+        if (found.length === 0) {
+            throw new Error(`Symbol '${name}' not found${requestedPath ? ` in ${requestedPath}` : ' in the project analysis'}. Try grep, or pass the file path.`);
+        }
+
+        const results = await Promise.all(found.slice(0, 5).map(async ({ filePath, symbol }) => {
+            const content = await this.fs.readFile(path.join(this.projectRoot, filePath));
+            const lines = (content ?? '').split('\n');
+            const end = Math.min(symbol.endLine, symbol.startLine + MAX_READ_LINES - 1);
+            return {
+                path: filePath,
+                name: symbol.name,
+                kind: symbol.kind,
+                start_line: symbol.startLine,
+                end_line: end,
+                content: RetrievalTools._numbered(lines.slice(symbol.startLine - 1, end), symbol.startLine),
+            };
+        }));
+        return { symbols: results, ...(found.length > results.length ? { note: `${found.length - results.length} more matches omitted; pass a path to narrow.` } : {}) };
+    }
+
+    // --- Helpers ---
+
+    /** Confines a model-supplied path to the project root and hides ignored files. */
+    private _resolve(requestedPath: string): { absolute: string; relative: string } {
+        const absolute = path.resolve(this.projectRoot, requestedPath.replace(/^\/+/, ''));
+        const relative = path.relative(this.projectRoot, absolute).replace(/\\/g, '/');
+        if (relative.startsWith('..') || path.isAbsolute(relative)) {
+            throw new Error(`Path '${requestedPath}' is outside the project.`);
+        }
+        if (relative && this.ignoreRules.ignores(relative)) {
+            throw new Error(`Path '${relative}' is ignored by .gitignore/.kaiignore.`);
+        }
+        return { absolute, relative };
+    }
+
+    /** `_resolve`, for reads: the path must also be inside the workspace scope. */
+    private _resolveInScope(requestedPath: string): { absolute: string; relative: string } {
+        const resolved = this._resolve(requestedPath);
+        if (this._scopePlacement(resolved.relative) !== 'inside') {
+            throw new Error(`Path '${resolved.relative}' is outside the workspace scope.`);
+        }
+        return resolved;
+    }
+
+    private _scopePlacement(relative: string): 'inside' | 'ancestor' | 'outside' {
+        return RetrievalTools.scopePlacement(this.index.roots?.() ?? null, relative);
+    }
+
+    /**
+     * Where a project-relative path lies with respect to the scoped package directories
+     * (`roots`, null for the whole project). Also used for dynamic context selections.
+     */
+    static scopePlacement(roots: string[] | null, relative: string): 'inside' | 'ancestor' | 'outside' {
+        if (!roots) return 'inside';
+        if (roots.some(root => !root || relative === root || relative.startsWith(`${root}/`))) return 'inside';
+        if (roots.some(root => !relative || root.startsWith(`${relative}/`))) return 'ancestor';
+        return 'outside';
+    }
+
+    private static _numbered(lines: string[], firstLine: number): string {
+        return lines.map((line, i) => `${firstLine + i}: ${line}`).join('\n');
+    }
+
+    private static _truncate(response: Record<string, unknown>): Record<string, unknown> {
+        const serialized = JSON.stringify(response);
+        if (serialized.length <= MAX_RESULT_CHARS) return response;
+        return {
+            truncated: true,
+            note: `Result exceeded ${MAX_RESULT_CHARS} characters; narrow the request (line range, path_prefix, max_results).`,
+            partial: serialized.slice(0, MAX_RESULT_CHARS),
+        };
+    }
+}
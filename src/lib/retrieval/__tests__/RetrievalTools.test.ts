@@ -0,0 +1,104 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import ignore from 'ignore';
+import { RetrievalTools } from '../RetrievalTools';
+import { FileSystem } from '../../FileSystem';
+import { SyntaxChunker } from '../../analysis/SyntaxChunker';
+import { ProjectAnalysisCache } from '../../analysis/types';
+import { AnalysisIndex } from '../../analysis/AnalysisIndex';
+import { PathTable } from '../../memory/PathTable';
+
+describe('RetrievalTools', () => {
+  let root: string;
+  let tools: RetrievalTools;
+
+  beforeEach(() => {
+    root = fs.mkdtempSync(path.join(os.tmpdir(), 'retrieval-'));
+    fs.mkdirSync(path.join(root, 'src'));
+    fs.mkdirSync(path.join(root, 'dist'));
+    fs.writeFileSync(path.join(root, 'src/config.ts'), [
+      'import fs from "fs";',
+      '',
+      'export function parseConfig(text: string) {',
+      '  return JSON.parse(text);',
+      '}',
+      '',
+      'export class Store {',
+      '  save() {',
+      '    return parseConfig("{}");',
+      '  }',
+      '}',
+    ].join('\n'));
+    fs.writeFileSync(path.join(root, 'src/notes.md'), 'parseConfig is documented here\n');
+    fs.writeFileSync(path.join(root, 'dist/config.js'), 'compiled parseConfig\n');
+    const cache: ProjectAnalysisCache = {
+      overallSummary: null,
+      entries: [{
+        filePath: 'src/config.ts', type: 'text_analyze', size: 200, loc: 11, summary: 's', lastAnalyzed: 'n',
+        symbols: [{ name: 'Store.save', kind: 'method', startLine: 8, endLine: 10, signature: 'save()', summary: null }],
+      }],
+    };
+    tools = new RetrievalTools(new FileSystem(), root, ignore().add('dist/'), {
+      files: async () => PathTable.from(['src/config.ts', 'src/notes.md']),
+      cache: async () => AnalysisIndex.fromCache(cache),
+    }, new SyntaxChunker(root, { backend: null }));
+  });
+
+  it('reads numbered line ranges and confines paths to the project', async () => {
+    const [range, outside, ignored] = await tools.executeAll([
+      { name: 'read_file', args: { path: 'src/config.ts', start_line: 3, end_line: 4 } },
+      { name: 'read_file', args: { path: '../etc/passwd' } },
+      { name: 'read_file', args: { path: 'dist/config.js' } },
+    ]);
+    expect(range.response).toMatchObject({ path: 'src/config.ts', start_line: 3, end_line: 4, total_lines: 11 });
+    expect(range.response.content).toBe('3: export function parseConfig(text: string) {\n4:   return JSON.parse(text);');
+    expect(outside.response.error).toMatch(/outside the project/);
+    expect(ignored.response.error).toMatch(/ignored/);
+  });
+
+  it('greps the index, lists directories and finds symbols', async () => {
+    const [grep, prefixed, list, fromCache, fromFile, unknown] = await tools.executeAll([
+      { name: 'grep', args: { pattern: 'parseconfig' } },
+      { name: 'grep', args: { pattern: 'parseConfig(', path_prefix: 'src/notes.md' } },
+      { name: 'list_dir', args: {} },
+      { name: 'get_symbol', args: { name: 'save' } },
+      { name: 'get_symbol', args: { name: 'parseConfig', path: 'src/config.ts' } },
+      { name: 'delete_everything', args: {} },
+    ]);
+    expect(grep.response.total_matches).toBe(3);
+    expect((grep.response.matches as any[]).map(m => `${m.path}:${m.line}`)).toEqual(['src/config.ts:3', 'src/config.ts:9', 'src/notes.md:1']);
+    expect(prefixed.response).toMatchObject({ files_searched: 1, total_matches: 0 }); // Invalid regex searched literally
+    expect(list.response).toEqual({ path: '.', entries: ['src/'] });
+    expect((fromCache.response.symbols as any[])[0]).toMatchObject({ path: 'src/config.ts', name: 'Store.save', start_line: 8, end_line: 10 });
+    expect((fromFile.response.symbols as any[])[0].content).toContain('3: export function parseConfig');
+    expect(unknown.response.error).toMatch(/Unknown tool/);
+  });
+
+  it('keeps reads and listings inside the workspace scope', async () => {
+    fs.mkdirSync(path.join(root, 'packages/api'), { recursive: true });
+    fs.mkdirSync(path.join(root, 'packages/web'), { recursive: true });
+    fs.writeFileSync(path.join(root, 'packages/api/index.ts'), 'export const api = 1;\n');
+    fs.writeFileSync(path.join(root, 'packages/web/app.ts'), 'export const app = 1;\n');
+    const scoped = new RetrievalTools(new FileSystem(), root, ignore().add('dist/'), {
+      files: async () => PathTable.from(['packages/api/index.ts']),
+      cache: async () => null,
+      roots: () => ['packages/api'],
+    }, new SyntaxChunker(root, { backend: null }));
+
+    const [inside, outside, top, packages, sibling, symbol] = await scoped.executeAll([
+      { name: 'read_file', args: { path: 'packages/api/index.ts' } },
+      { name: 'read_file', args: { path: 'packages/web/app.ts' } },
+      { name: 'list_dir', args: {} },
+      { name: 'list_dir', args: { path: 'packages' } },
+      { name: 'list_dir', args: { path: 'packages/web' } },
+      { name: 'get_symbol', args: { name: 'app', path: 'packages/web/app.ts' } },
+    ]);
+    expect(inside.response).toMatchObject({ path: 'packages/api/index.ts', total_lines: 2 });
+    expect(outside.response.error).toMatch(/outside the workspace scope/);
+    expect(top.response).toEqual({ path: '.', entries: ['packages/'] });
+    expect(packages.response).toEqual({ path: 'packages', entries: ['api/'] });
+    expect(sibling.response.error).toMatch(/outside the workspace scope/);
+    expect(symbol.response.error).toMatch(/outside the workspace scope/);
+  });
+});
@@ -0,0 +1,215 @@
+// File: src/lib/scheduling/ApiKeyPool.ts
+import chalk from 'chalk';
+import { metrics } from '../telemetry/Metrics';
+
+const DEFAULT_QUARANTINE_MS = 60000;
+const MAX_QUARANTINE_MS = 10 * 60000;
+
+export interface ApiKeyPoolOptions {
+    requestsPerMinute?: number | null; // Per key; null/0 means unlimited
+    quarantineMs?: number;             // First cooldown for a rate-limited key; doubles on each repeat
+    now?: () => number;                // Injectable for tests
+}
+
+/** What a failed call says about the key it used (null: nothing, e.g. a bad request). */
+export type KeyFailure = 'rate_limited' | 'auth' | null;
+
+export interface KeyStatus {
+    key: string; // Masked
+    inFlight: number;
+    calls: number;
+    strikes: number;
+    quarantinedForMs: number;
+}
+
+interface KeyState {
+    key: string;
+    tokens: number;
+    inFlight: number;
+    calls: number;
+    strikes: number;          // Consecutive failures; reset by a successful call
+    quarantinedUntil: number;
+}
+
+/**
+ * Spreads one provider's calls over several API keys. Each key has its own per-minute request
+ * budget and health state; a call takes the least-loaded key that has budget (fewest calls in
+ * flight, then most budget left, then fewest calls so far). A key that is rate limited or
+ * rejected is quarantined (rate limits back off exponentially, auth failures for the maximum)
+ * and the call is retried on another key. The last usable key is never quarantined, so a
+ * single-key pool passes errors through exactly as before.
+ */
+export class ApiKeyPool {
+    readonly provider: string;
+    private states: KeyState[];
+    private requestsPerMinute: number | null;
+    private quarantineMs: number;
+    private now: () => number;
+    private lastRefill: number;
+    private waiters: Array<(index: number) => void> = [];
+    private timer: NodeJS.Timeout | null = null;
+
+    constructor(provider: string, keys: string[], options: ApiKeyPoolOptions = {}) {
+        const unique = [...new Set(keys.filter(Boolean))];
+        if (unique.length === 0) throw new Error(`No API keys configured for ${provider}.`);
+        this.provider = provider;
+        this.now = options.now ?? (() => Date.now());
+        this.requestsPerMinute = options.requestsPerMinute && options.requestsPerMinute > 0 ? options.requestsPerMinute : null;
+        this.quarantineMs = options.quarantineMs && options.quarantineMs > 0 ? options.quarantineMs : DEFAULT_QUARANTINE_MS;
+        this.lastRefill = this.now();
+        this.states = unique.map(key => ({
+            key,
+            tokens: this.requestsPerMinute ?? 0,
+            inFlight: 0,
+            calls: 0,
+            strikes: 0,
+            quarantinedUntil: Number.NEGATIVE_INFINITY,
+        }));
+    }
+
+    get size(): number {
+        return this.states.length;
+    }
+
+    key(index: number): string {
+        return this.states[index].key;
+    }
+
+    /** Classifies an error thrown by a model call (SDK errors and the models' coded errors). */
+    static classify(error: any): KeyFailure {
+        const code = String(error?.code ?? '');
+        const status = error?.status ?? error?.originalError?.status;
+        const message = String(error?.message ?? '').toLowerCase();
+        if (status === 429 || code === 'RATE_LIMIT' || message.includes('429') || message.includes('quota') || message.includes('rate limit')) {
+            return 'rate_limited';
+        }
+        if (status === 401 || status === 403 || code === 'AUTH_ERROR' || code === 'INVALID_API_KEY' || message.includes('api key not valid')) {
+            return 'auth';
+        }
+        return null;
+    }
+
+    /**
+     * Runs `fn` with the index of the key it should use, waiting for a key with budget. If the
+     * key turns out to be exhausted or rejected and another key is usable, it is retried there.
+     * @param canRetry Asked after such a failure; false when a retry would repeat output the
+     *   caller already passed on (a stream after its first delta). The key is quarantined anyway.
+     */
+    async run<T>(fn: (keyIndex: number) => Promise<T>, canRetry: () => boolean = () => true): Promise<T> {
+        for (let attempt = 1; ; attempt++) {
+            const waitStart = this.now();
+            const index = await this._acquire();
+            if (this.states.length > 1) metrics.observe('model.key_wait_ms', this.now() - waitStart, { provider: this.provider });
+            try {
+                const result = await fn(index);
+                this.states[index].strikes = 0;
+                return result;
+            } catch (error) {
+                const failure = ApiKeyPool.classify(error);
+                if (failure === null || !this._quarantine(index, failure) || attempt >= this.states.length || !canRetry()) throw error;
+                metrics.increment('model.retries', { provider: this.provider });
+                console.log(chalk.yellow(`Retrying on another ${this.provider} API key...`));
+            } finally {
+                this.states[index].inFlight--;
+                this._pump();
+            }
+        }
+    }
+
+    /** Per-key load and health (keys masked), for stats and tests. */
+    snapshot(): KeyStatus[] {
+        const now = this.now();
+        return this.states.map(s => ({
+            key: ApiKeyPool.mask(s.key),
+            inFlight: s.inFlight,
+            calls: s.calls,
+            strikes: s.strikes,
+            quarantinedForMs: Math.max(0, s.quarantinedUntil - now),
+        }));
+    }
+
+    static mask(key: string): string {
+        return key.length <= 8 ? '****' : `${key.slice(0, 4)}…${key.slice(-4)}`;
+    }
+
+    // --- Dispatch ---
+
+    private _acquire(): Promise<number> {
+        return new Promise(resolve => {
+            this.waiters.push(resolve);
+            this._pump();
+        });
+    }
+
+    private _pump(): void {
+        if (this.timer) {
+            clearTimeout(this.timer);
+            this.timer = null;
+        }
+        this._refill();
+        while (this.waiters.length > 0) {
+            const index = this._pick();
+            if (index === -1) break;
+            const state = this.states[index];
+            if (this.requestsPerMinute !== null) state.tokens -= 1;
+            state.inFlight++;
+            state.calls++;
+            this.waiters.shift()!(index);
+        }
+        if (this.waiters.length > 0) {
+            this.timer = setTimeout(() => this._pump(), Math.max(1, Math.ceil(this._readyInMs())));
+            this.timer.unref?.();
+        }
+    }
+
+    /** Least-loaded usable key with budget left, or -1. */
+    private _pick(): number {
+        const now = this.now();
+        let best = -1;
+        for (let i = 0; i < this.states.length; i++) {
+            const s = this.states[i];
+            if (s.quarantinedUntil > now || (this.requestsPerMinute !== null && s.tokens < 1)) continue;
+            const b = best === -1 ? null : this.states[best];
+            if (!b || s.inFlight < b.inFlight
+                || (s.inFlight === b.inFlight && (s.tokens > b.tokens || (s.tokens === b.tokens && s.calls < b.calls)))) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    /** Time until some key comes out of quarantine or regains a request. */
+    private _readyInMs(): number {
+        const now = this.now();
+        let wait = Number.POSITIVE_INFINITY;
+        for (const s of this.states) {
+            const budgetWait = this.requestsPerMinute !== null && s.tokens < 1 ? ((1 - s.tokens) * 60000) / this.requestsPerMinute : 0;
+            wait = Math.min(wait, Math.max(s.quarantinedUntil - now, budgetWait));
+        }
+        return wait;
+    }
+
+    /** Quarantines a key unless no other key is usable. Returns whether it did. */
+    private _quarantine(index: number, failure: Exclude<KeyFailure, null>): boolean {
+        const now = this.now();
+        const othersUsable = this.states.some((s, i) => i !== index && s.quarantinedUntil <= now);
+        if (!othersUsable) return false;
+        const state = this.states[index];
+        state.strikes++;
+        const duration = failure === 'auth'
+            ? MAX_QUARANTINE_MS
+            : Math.min(MAX_QUARANTINE_MS, this.quarantineMs * Math.pow(2, state.strikes - 1));
+        state.quarantinedUntil = now + duration;
+        metrics.increment('model.key_quarantined', { provider: this.provider, reason: failure });
+        console.log(chalk.yellow(`${this.provider} API key ${ApiKeyPool.mask(state.key)} ${failure === 'auth' ? 'was rejected' : 'is rate limited'}; quarantined for ${Math.round(duration / 1000)}s.`));
+        return true;
+    }
+
+    private _refill(): void {
+        if (this.requestsPerMinute === null) return;
+        const now = this.now();
+        const added = ((now - this.lastRefill) * this.requestsPerMinute) / 60000;
+        for (const s of this.states) s.tokens = Math.min(this.requestsPerMinute, s.tokens + added);
+        this.lastRefill = now;
+    }
+}
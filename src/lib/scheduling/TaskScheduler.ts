@@ -0,0 +1,240 @@
+// File: src/lib/scheduling/TaskScheduler.ts
+import { AsyncLocalStorage, AsyncResource } from 'async_hooks';
+import { metrics } from '../telemetry/Metrics';
+
+/** Priority classes, highest first. */
+export type TaskPriority = 'interactive' | 'consolidation' | 'background';
+/** Lanes with separate capacity: model calls (also rate limited) and heavy local work. */
+export type TaskKind = 'model' | 'cpu';
+
+const PRIORITY_RANK: Record<TaskPriority, number> = { interactive: 0, consolidation: 1, background: 2 };
+export const DEFAULT_MODEL_CONCURRENCY = 8; // Per API key: kai.ts scales it by the largest key pool
+const DEFAULT_CPU_CONCURRENCY = 2;
+const DEFAULT_IDLE_MS = 500;              // Quiet period after foreground work before background may start
+const DEFAULT_BACKGROUND_RATE_SHARE = 0.8; // Background never takes the last 20% of the request budget
+
+export interface TaskSchedulerOptions {
+    modelConcurrency?: number;
+    cpuConcurrency?: number;
+    requestsPerMinute?: number | null; // Model-call rate limit; null/0 means unlimited
+    idleMs?: number;
+    backgroundRateShare?: number;
+    now?: () => number; // Injectable for tests
+}
+
+export interface ScheduleOptions {
+    kind?: TaskKind;          // Default 'model'
+    priority?: TaskPriority;  // Default: the caller's ambient priority (see withPriority), else 'interactive'
+    label?: string;
+}
+
+export class TaskCancelledError extends Error {
+    constructor(label: string) {
+        super(`Task '${label}' was cancelled before it started.`);
+        this.name = 'TaskCancelledError';
+    }
+}
+
+interface QueuedTask {
+    seq: number;
+    priority: TaskPriority;
+    kind: TaskKind;
+    label: string;
+    enqueuedAt: number;
+    start: () => void;
+    cancel: () => void;
+}
+
+/**
+ * Process-wide scheduler for model calls and heavy local work. Every task carries a priority
+ * class (interactive > consolidation > background) and queued tasks always start in priority
+ * order, so a chat turn overtakes any queued background work. Background tasks additionally
+ * run only at idle time: never while foreground work is queued or running, never in the last
+ * free slot of a lane, and never with the last share of the per-minute request budget.
+ * Priority is ambient: code inside `withPriority()` schedules at that priority without
+ * threading it through every call, and tasks started by a task inherit its priority.
+ */
+export class TaskScheduler {
+    private storage = new AsyncLocalStorage<TaskPriority>();
+    private queue: QueuedTask[] = [];
+    private running: Record<TaskKind, Record<TaskPriority, number>> = {
+        model: { interactive: 0, consolidation: 0, background: 0 },
+        cpu: { interactive: 0, consolidation: 0, background: 0 },
+    };
+    private capacity: Record<TaskKind, number>;
+    private requestsPerMinute: number | null;
+    private idleMs: number;
+    private backgroundRateShare: number;
+    private now: () => number;
+    private tokens: number;
+    private lastRefill: number;
+    private lastForegroundAt = Number.NEGATIVE_INFINITY;
+    private seq = 0;
+    private timer: NodeJS.Timeout | null = null;
+
+    constructor(options: TaskSchedulerOptions = {}) {
+        this.now = options.now ?? (() => Date.now());
+        this.capacity = { model: DEFAULT_MODEL_CONCURRENCY, cpu: DEFAULT_CPU_CONCURRENCY };
+        this.requestsPerMinute = null;
+        this.idleMs = DEFAULT_IDLE_MS;
+        this.backgroundRateShare = DEFAULT_BACKGROUND_RATE_SHARE;
+        this.tokens = 0;
+        this.lastRefill = this.now();
+        this.configure(options);
+    }
+
+    /** Applies options; unset values keep their current setting. */
+    configure(options: TaskSchedulerOptions): void {
+        if (options.modelConcurrency && options.modelConcurrency > 0) this.capacity.model = Math.floor(options.modelConcurrency);
+        if (options.cpuConcurrency && options.cpuConcurrency > 0) this.capacity.cpu = Math.floor(options.cpuConcurrency);
+        if (options.requestsPerMinute !== undefined) {
+            this.requestsPerMinute = options.requestsPerMinute && options.requestsPerMinute > 0 ? options.requestsPerMinute : null;
+            this.tokens = this.requestsPerMinute ?? 0;
+            this.lastRefill = this.now();
+        }
+        if (options.idleMs !== undefined && options.idleMs >= 0) this.idleMs = options.idleMs;
+        if (options.backgroundRateShare && options.backgroundRateShare > 0 && options.backgroundRateShare <= 1) {
+            this.backgroundRateShare = options.backgroundRateShare;
+        }
+        this._pump();
+    }
+
+    /** Runs `fn` with `priority` as the ambient priority for everything it schedules. */
+    withPriority<T>(priority: TaskPriority, fn: () => Promise<T>): Promise<T> {
+        return this.storage.run(priority, fn);
+    }
+
+    get currentPriority(): TaskPriority {
+        return this.storage.getStore() ?? 'interactive';
+    }
+
+    /** Queues `fn` and resolves with its result once it has run. */
+    run<T>(fn: () => Promise<T>, options: ScheduleOptions = {}): Promise<T> {
+        const priority = options.priority ?? this.currentPriority;
+        const kind = options.kind ?? 'model';
+        const label = options.label ?? kind;
+        // A queued task starts from whichever task's completion frees its slot; binding it here
+        // keeps the caller's async context (trace spans, request ids) instead of that task's.
+        const bound = AsyncResource.bind(() => this.storage.run(priority, fn));
+        return new Promise<T>((resolve, reject) => {
+            const task: QueuedTask = {
+                seq: this.seq++,
+                priority,
+                kind,
+                label,
+                enqueuedAt: this.now(),
+                start: () => {
+                    metrics.observe('scheduler.wait_ms', this.now() - task.enqueuedAt, { priority, kind });
+                    this.running[kind][priority]++;
+                    let result: Promise<T>;
+                    try {
+                        result = bound();
+                    } catch (error) {
+                        result = Promise.reject(error);
+                    }
+                    result.then(resolve, reject).finally(() => {
+                        this.running[kind][priority]--;
+                        if (priority !== 'background') this.lastForegroundAt = this.now();
+                        this._pump();
+                    });
+                },
+                cancel: () => reject(new TaskCancelledError(label)),
+            };
+            this.queue.push(task);
+            this._pump();
+        });
+    }
+
+    /** Background work that should only use otherwise idle capacity. */
+    whenIdle<T>(fn: () => Promise<T>, label: string = 'idle', kind: TaskKind = 'cpu'): Promise<T> {
+        return this.run(fn, { priority: 'background', kind, label });
+    }
+
+    /**
+     * Drops queued (not yet started) tasks at `priority` or lower, rejecting them with
+     * TaskCancelledError. Returns how many were dropped.
+     */
+    cancelQueued(priority: TaskPriority = 'background'): number {
+        const dropped = this.queue.filter(t => PRIORITY_RANK[t.priority] >= PRIORITY_RANK[priority]);
+        this.queue = this.queue.filter(t => !dropped.includes(t));
+        for (const task of dropped) task.cancel();
+        if (dropped.length > 0) metrics.increment('scheduler.cancelled', { priority }, dropped.length);
+        return dropped.length;
+    }
+
+    /** Queued and running task counts per priority (for stats and tests). */
+    snapshot(): Record<TaskPriority, { queued: number; running: number }> {
+        const out = {} as Record<TaskPriority, { queued: number; running: number }>;
+        for (const priority of Object.keys(PRIORITY_RANK) as TaskPriority[]) {
+            out[priority] = {
+                queued: this.queue.filter(t => t.priority === priority).length,
+                running: this.running.model[priority] + this.running.cpu[priority],
+            };
+        }
+        return out;
+    }
+
+    // --- Dispatch ---
+
+    private _pump(): void {
+        if (this.timer) {
+            clearTimeout(this.timer);
+            this.timer = null;
+        }
+        this._refill();
+        this.queue.sort((a, b) => PRIORITY_RANK[a.priority] - PRIORITY_RANK[b.priority] || a.seq - b.seq);
+
+        let retryInMs: number | null = null;
+        const blockedLanes = new Set<TaskKind>(); // A waiting higher-priority task blocks its lane for lower ones
+        for (const task of [...this.queue]) {
+            if (blockedLanes.has(task.kind)) continue;
+            const wait = this._waitBeforeStart(task);
+            if (wait === 0) {
+                this.queue.splice(this.queue.indexOf(task), 1);
+                if (task.kind === 'model' && this.requestsPerMinute !== null) this.tokens -= 1;
+                task.start();
+                continue;
+            }
+            blockedLanes.add(task.kind);
+            if (wait !== null) retryInMs = retryInMs === null ? wait : Math.min(retryInMs, wait);
+        }
+        if (retryInMs !== null) {
+            this.timer = setTimeout(() => this._pump(), Math.max(1, Math.ceil(retryInMs)));
+            this.timer.unref?.();
+        }
+    }
+
+    /** 0 to start now, ms to wait for idle time or rate budget, null to wait for a running task to finish. */
+    private _waitBeforeStart(task: QueuedTask): number | null {
+        const running = this.running[task.kind];
+        const total = running.interactive + running.consolidation + running.background;
+        if (total >= this.capacity[task.kind]) return null;
+
+        if (task.priority === 'background') {
+            // Keep a slot free for foreground work arriving while background runs
+            if (this.capacity[task.kind] > 1 && running.background >= this.capacity[task.kind] - 1) return null;
+            const foregroundActive = this.queue.some(t => t.priority !== 'background')
+                || (['model', 'cpu'] as TaskKind[]).some(k => this.running[k].interactive + this.running[k].consolidation > 0);
+            if (foregroundActive) return null;
+            const idleFor = this.now() - this.lastForegroundAt;
+            if (idleFor < this.idleMs) return this.idleMs - idleFor;
+        }
+
+        if (task.kind === 'model' && this.requestsPerMinute !== null) {
+            const reserve = task.priority === 'background' ? this.requestsPerMinute * (1 - this.backgroundRateShare) : 0;
+            const needed = reserve + 1;
+            if (this.tokens < needed) return ((needed - this.tokens) * 60000) / this.requestsPerMinute;
+        }
+        return 0;
+    }
+
+    private _refill(): void {
+        if (this.requestsPerMinute === null) return;
+        const now = this.now();
+        this.tokens = Math.min(this.requestsPerMinute, this.tokens + ((now - this.lastRefill) * this.requestsPerMinute) / 60000);
+        this.lastRefill = now;
+    }
+}
+
+/** Process-wide scheduler; kai.ts applies the configured request rate. */
+export const taskScheduler = new TaskScheduler();
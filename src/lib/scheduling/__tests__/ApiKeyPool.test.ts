@@ -0,0 +1,95 @@
+import { ApiKeyPool } from '../ApiKeyPool';
+
+jest.mock('chalk');
+jest.spyOn(console, 'log').mockImplementation(() => {});
+
+const deferred = () => {
+  let resolve!: () => void;
+  const promise = new Promise<void>(r => { resolve = r; });
+  return { promise, resolve };
+};
+const flush = async () => { for (let i = 0; i < 10; i++) await Promise.resolve(); };
+const rateLimited = () => Object.assign(new Error('AI API Error (RATE_LIMIT)'), { code: 'RATE_LIMIT' });
+
+describe('ApiKeyPool', () => {
+  it('sends concurrent calls to the least-loaded key and spreads sequential ones', async () => {
+    const pool = new ApiKeyPool('gemini', ['k1', 'k2', 'k3', 'k2']);
+    expect(pool.size).toBe(3);
+    const gate = deferred();
+    const used: number[] = [];
+    const running = [0, 1, 2].map(() => pool.run(async key => { used.push(key); await gate.promise; }));
+    await flush();
+    expect(used).toEqual([0, 1, 2]);
+    gate.resolve();
+    await Promise.all(running);
+
+    const sequential: number[] = [];
+    for (let i = 0; i < 3; i++) await pool.run(async key => { sequential.push(key); });
+    expect(sequential.sort()).toEqual([0, 1, 2]);
+  });
+
+  it('gives every key its own per-minute budget', async () => {
+    jest.useFakeTimers();
+    try {
+      let now = 0;
+      const pool = new ApiKeyPool('gemini', ['k1', 'k2'], { requestsPerMinute: 1, now: () => now });
+      const used: number[] = [];
+      const calls = [0, 1, 2].map(() => pool.run(async key => { used.push(key); }));
+      await Promise.all(calls.slice(0, 2));
+      expect(used.sort()).toEqual([0, 1]); // The third waits for a key to regain budget
+      now = 60000;
+      jest.advanceTimersByTime(60000);
+      await calls[2];
+      expect(used).toHaveLength(3);
+    } finally {
+      jest.useRealTimers();
+    }
+  });
+
+  it('quarantines an exhausted key and retries the call on another', async () => {
+    const now = 1000;
+    const pool = new ApiKeyPool('gemini', ['key-one-aaaa', 'key-two-bbbb'], { quarantineMs: 5000, now: () => now });
+    const keysTried: number[] = [];
+    const result = await pool.run(async key => {
+      keysTried.push(key);
+      if (key === 0) throw rateLimited();
+      return 'ok';
+    });
+    expect(result).toBe('ok');
+    expect(keysTried).toEqual([0, 1]);
+    expect(pool.snapshot()[0]).toMatchObject({ key: 'key-…aaaa', strikes: 1, quarantinedForMs: 5000 });
+
+    // While key 0 is quarantined every call goes to key 1, which is never quarantined itself
+    await expect(pool.run(async key => { keysTried.push(key); throw rateLimited(); })).rejects.toThrow('RATE_LIMIT');
+    expect(keysTried).toEqual([0, 1, 1]);
+    expect(pool.snapshot()[1].quarantinedForMs).toBe(0);
+  });
+
+  it('quarantines but does not retry when the caller says a retry is no longer safe', async () => {
+    const pool = new ApiKeyPool('gemini', ['key-one-aaaa', 'key-two-bbbb']);
+    const fn = jest.fn(async () => { throw rateLimited(); });
+    await expect(pool.run(fn, () => false)).rejects.toThrow('RATE_LIMIT');
+    expect(fn).toHaveBeenCalledTimes(1);
+    expect(pool.snapshot()[0].strikes).toBe(1);
+  });
+
+  it('passes errors through unchanged with a single key or when the key is not at fault', async () => {
+    const single = new ApiKeyPool('openai', ['only']);
+    await expect(single.run(async () => { throw Object.assign(new Error('denied'), { status: 401 }); })).rejects.toThrow('denied');
+    expect(single.snapshot()[0].quarantinedForMs).toBe(0);
+
+    const pool = new ApiKeyPool('anthropic', ['a', 'b']);
+    const fn = jest.fn(async () => { throw new Error('400 Bad Request'); });
+    await expect(pool.run(fn)).rejects.toThrow('Bad Request');
+    expect(fn).toHaveBeenCalledTimes(1);
+  });
+
+  it('classifies rate-limit and auth failures', () => {
+    expect(ApiKeyPool.classify({ status: 429 })).toBe('rate_limited');
+    expect(ApiKeyPool.classify(new Error('Resource has been exhausted (e.g. check quota).'))).toBe('rate_limited');
+    expect(ApiKeyPool.classify({ code: 'INVALID_API_KEY' })).toBe('auth');
+    expect(ApiKeyPool.classify({ status: 403 })).toBe('auth');
+    expect(ApiKeyPool.classify(new Error('fetch failed'))).toBeNull();
+    expect(() => new ApiKeyPool('gemini', [''])).toThrow('No API keys');
+  });
+});
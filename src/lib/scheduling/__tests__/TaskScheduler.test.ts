@@ -0,0 +1,100 @@
+import { AsyncLocalStorage } from 'async_hooks';
+import { TaskScheduler, TaskCancelledError } from '../TaskScheduler';
+
+const deferred = () => {
+  let resolve!: () => void;
+  const promise = new Promise<void>(r => { resolve = r; });
+  return { promise, resolve };
+};
+// Lets settled tasks run their completion handlers (works under fake timers, unlike setImmediate)
+const flush = async () => { for (let i = 0; i < 10; i++) await Promise.resolve(); };
+
+describe('TaskScheduler', () => {
+  it('starts queued work in priority order and background only once foreground is done', async () => {
+    const scheduler = new TaskScheduler({ modelConcurrency: 1, idleMs: 0 });
+    const started: string[] = [];
+    const gate = deferred();
+    const blocker = scheduler.run(() => gate.promise);
+    const track = (name: string) => async () => { started.push(name); };
+
+    const tasks = [
+      scheduler.run(track('background'), { priority: 'background' }),
+      scheduler.run(track('consolidation'), { priority: 'consolidation' }),
+      scheduler.run(track('interactive')),
+    ];
+    expect(scheduler.snapshot().interactive).toEqual({ queued: 1, running: 1 });
+    gate.resolve();
+    await Promise.all([blocker, ...tasks]);
+    expect(started).toEqual(['interactive', 'consolidation', 'background']);
+  });
+
+  it('keeps a slot free for foreground work and waits for idle time', async () => {
+    jest.useFakeTimers();
+    try {
+      const scheduler = new TaskScheduler({ cpuConcurrency: 2, idleMs: 1000 });
+      const gates = [deferred(), deferred()];
+      const bg = gates.map((g, i) => scheduler.whenIdle(() => g.promise, `bg${i}`));
+      expect(scheduler.snapshot().background).toEqual({ queued: 1, running: 1 }); // One slot reserved
+
+      const chat = scheduler.run(async () => 'answer', { kind: 'cpu' });
+      await expect(chat).resolves.toBe('answer');
+      gates[0].resolve();
+      await flush();
+      expect(scheduler.snapshot().background).toEqual({ queued: 1, running: 0 }); // Idle period after the chat task
+      jest.advanceTimersByTime(1000);
+      expect(scheduler.snapshot().background).toEqual({ queued: 0, running: 1 });
+      gates[1].resolve();
+      await Promise.all(bg);
+    } finally {
+      jest.useRealTimers();
+    }
+  });
+
+  it('inherits ambient priority and lets queued low-priority work be cancelled', async () => {
+    const scheduler = new TaskScheduler({ modelConcurrency: 1, idleMs: 0 });
+    const gate = deferred();
+    const blocker = scheduler.run(() => gate.promise);
+    const queued = scheduler.withPriority('background', () => scheduler.run(async () => scheduler.currentPriority));
+    const consolidation = scheduler.withPriority('consolidation', () => scheduler.run(async () => scheduler.currentPriority));
+
+    expect(scheduler.cancelQueued('background')).toBe(1);
+    await expect(queued).rejects.toBeInstanceOf(TaskCancelledError);
+    gate.resolve();
+    await blocker;
+    await expect(consolidation).resolves.toBe('consolidation');
+  });
+
+  it('runs a queued task in the async context of the caller that queued it', async () => {
+    const scheduler = new TaskScheduler({ modelConcurrency: 1, idleMs: 0 });
+    const requestId = new AsyncLocalStorage<string>();
+    const gate = deferred();
+    const blocker = requestId.run('first', () => scheduler.run(() => gate.promise));
+    const queued = requestId.run('second', () => scheduler.run(async () => requestId.getStore()));
+    expect(scheduler.snapshot().interactive).toEqual({ queued: 1, running: 1 });
+    requestId.run('releaser', () => gate.resolve());
+    await blocker;
+    await expect(queued).resolves.toBe('second');
+  });
+
+  it('rate limits model calls and keeps a reserve for foreground requests', async () => {
+    jest.useFakeTimers();
+    try {
+      const scheduler = new TaskScheduler({ requestsPerMinute: 5, idleMs: 0, backgroundRateShare: 0.6 });
+      const results: string[] = [];
+      const call = (name: string, priority: 'interactive' | 'background') =>
+        scheduler.run(async () => { results.push(name); }, { priority });
+
+      const background = [1, 2, 3].map(i => call(`bg${i}`, 'background'));
+      await flush();
+      expect(results).toEqual(['bg1', 'bg2', 'bg3']); // 5 tokens, 2 kept in reserve
+      const foreground = [call('chat1', 'interactive'), call('chat2', 'interactive'), call('chat3', 'interactive')];
+      await flush();
+      expect(results).toEqual(['bg1', 'bg2', 'bg3', 'chat1', 'chat2']);
+      jest.advanceTimersByTime(12000); // One token per 12s
+      await Promise.all([...background, ...foreground]);
+      expect(results.slice(-1)).toEqual(['chat3']);
+    } finally {
+      jest.useRealTimers();
+    }
+  });
+});
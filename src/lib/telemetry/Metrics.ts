@@ -0,0 +1,300 @@
+// File: src/lib/telemetry/Metrics.ts
+import { performance } from 'perf_hooks';
+import fsPromises from 'fs/promises';
+import path from 'path';
+import chalk from 'chalk';
+import { appendLinesLocked } from '../FileLock';
+
+export type MetricLabels = Record<string, string | number | boolean>;
+
+/** What a histogram measures: latencies in milliseconds, percentages or plain counts. */
+export type HistogramUnit = 'ms' | '%' | 'count';
+
+export interface HistogramSummary {
+    unit?: HistogramUnit; // Missing in snapshots written before units were recorded
+    count: number;
+    sum: number;
+    min: number;
+    max: number;
+    p50: number;
+    p95: number;
+    p99: number;
+}
+
+/** A point-in-time copy of every metric; one line of `.kai/metrics/snapshots.jsonl`. */
+export interface MetricsSnapshot {
+    timestamp: string;
+    kaiVersion: string;
+    sessionSeconds: number;
+    counters: Record<string, number>;
+    histograms: Record<string, HistogramSummary>;
+}
+
+interface Histogram {
+    unit: HistogramUnit;
+    count: number;
+    sum: number;
+    min: number;
+    max: number;
+    samples: number[]; // Bounded reservoir used for percentiles
+}
+
+export const METRICS_DIR = path.join('.kai', 'metrics');
+export const METRICS_SNAPSHOT_FILE = 'snapshots.jsonl';
+const MAX_SAMPLES = 4096;
+
+/** Serialises a metric name plus labels as `name{a=1,b=x}` (labels sorted for stable keys). */
+export function metricKey(name: string, labels?: MetricLabels): string {
+    if (!labels) return name;
+    const keys = Object.keys(labels).sort();
+    if (keys.length === 0) return name;
+    return `${name}{${keys.map(k => `${k}=${labels[k]}`).join(',')}}`;
+}
+
+/** Splits a metric key back into its name and labels. */
+export function parseMetricKey(key: string): { name: string; labels: Record<string, string> } {
+    const open = key.indexOf('{');
+    if (open === -1 || !key.endsWith('}')) return { name: key, labels: {} };
+    const labels: Record<string, string> = {};
+    for (const pair of key.slice(open + 1, -1).split(',')) {
+        const eq = pair.indexOf('=');
+        if (eq > 0) labels[pair.slice(0, eq)] = pair.slice(eq + 1);
+    }
+    return { name: key.slice(0, open), labels };
+}
+
+/** Nearest-rank percentile of samples sorted ascending; `p` is 0-100. 0 when there are none. */
+export function percentile(sorted: number[], p: number): number {
+    if (sorted.length === 0) return 0;
+    const rank = Math.ceil((p / 100) * sorted.length) - 1;
+    return sorted[Math.min(sorted.length - 1, Math.max(0, rank))];
+}
+
+/** A summary's unit; older snapshots did not record one, so it is inferred from the name. */
+function unitOf(key: string, h: HistogramSummary): HistogramUnit {
+    if (h.unit) return h.unit;
+    const { name } = parseMetricKey(key);
+    return name.endsWith('_ms') ? 'ms' : name.endsWith('_pct') ? '%' : 'count';
+}
+
+/** A value with its unit for reports: `12 ms`, `40%`, `3`. */
+function withUnit(value: number, unit: HistogramUnit): string {
+    return unit === 'ms' ? `${value} ms` : unit === '%' ? `${value}%` : `${value}`;
+}
+
+function round(value: number): number {
+    return Math.round(value * 100) / 100;
+}
+
+function readKaiVersion(): string {
+    try {
+        // Same depth from src/lib/telemetry (tests) and bin/lib/telemetry (build) to the package root.
+        return require('../../../package.json').version ?? 'unknown';
+    } catch {
+        return 'unknown';
+    }
+}
+
+/**
+ * In-process registry of counters and histograms (latencies and other values) shared by all subsystems.
+ * Recording is a map lookup plus an add, so call sites do not need to guard it.
+ */
+export class MetricsRegistry {
+    private counters = new Map<string, number>();
+    private histograms = new Map<string, Histogram>();
+    private startedAt = performance.now();
+
+    increment(name: string, labels?: MetricLabels, by: number = 1): void {
+        const key = metricKey(name, labels);
+        this.counters.set(key, (this.counters.get(key) ?? 0) + by);
+    }
+
+    /** Records `value` in the `name` histogram; `unit` says what it measures (milliseconds by default). */
+    observe(name: string, value: number, labels?: MetricLabels, unit: HistogramUnit = 'ms'): void {
+        const key = metricKey(name, labels);
+        let h = this.histograms.get(key);
+        if (!h) {
+            h = { unit, count: 0, sum: 0, min: Infinity, max: -Infinity, samples: [] };
+            this.histograms.set(key, h);
+        }
+        h.count++;
+        h.sum += value;
+        h.min = Math.min(h.min, value);
+        h.max = Math.max(h.max, value);
+        if (h.samples.length < MAX_SAMPLES) {
+            h.samples.push(value);
+        } else {
+            // Reservoir sampling keeps percentiles representative for long sessions.
+            const slot = Math.floor(Math.random() * h.count);
+            if (slot < MAX_SAMPLES) h.samples[slot] = value;
+        }
+    }
+
+    /** Times `fn` into the `name` histogram (milliseconds), including failed calls. */
+    async time<T>(name: string, labels: MetricLabels | undefined, fn: () => Promise<T>): Promise<T> {
+        const start = performance.now();
+        try {
+            return await fn();
+        } finally {
+            this.observe(name, performance.now() - start, labels);
+        }
+    }
+
+    /** Records a cache lookup; hit rates are derived from these counters in the report. */
+    recordCacheAccess(cache: string, hit: boolean): void {
+        this.increment(hit ? 'cache.hit' : 'cache.miss', { cache });
+    }
+
+    counter(name: string, labels?: MetricLabels): number {
+        return this.counters.get(metricKey(name, labels)) ?? 0;
+    }
+
+    histogram(name: string, labels?: MetricLabels): HistogramSummary | null {
+        const h = this.histograms.get(metricKey(name, labels));
+        return h ? this._summarize(h) : null;
+    }
+
+    reset(): void {
+        this.counters.clear();
+        this.histograms.clear();
+        this.startedAt = performance.now();
+    }
+
+    snapshot(): MetricsSnapshot {
+        const histograms: Record<string, HistogramSummary> = {};
+        for (const [key, h] of this.histograms) histograms[key] = this._summarize(h);
+        return {
+            timestamp: new Date().toISOString(),
+            kaiVersion: readKaiVersion(),
+            sessionSeconds: round((performance.now() - this.startedAt) / 1000),
+            counters: Object.fromEntries(this.counters),
+            histograms,
+        };
+    }
+
+    /**
+     * Appends the current snapshot to `.kai/metrics/snapshots.jsonl` so trends can be
+     * compared across sessions and releases. Does nothing when nothing was recorded.
+     */
+    async writeSnapshot(projectRoot: string): Promise<string | null> {
+        if (this.counters.size === 0 && this.histograms.size === 0) return null;
+        const filePath = path.join(projectRoot, METRICS_DIR, METRICS_SNAPSHOT_FILE);
+        try {
+            await appendLinesLocked(filePath, [JSON.stringify(this.snapshot())]);
+            return filePath;
+        } catch (error) {
+            console.error(chalk.red(`Failed to write metrics snapshot ${filePath}:`), error);
+            return null;
+        }
+    }
+
+    /** Reads the most recent `limit` snapshots (oldest first). Malformed lines are skipped. */
+    static async readSnapshots(projectRoot: string, limit: number = 10): Promise<MetricsSnapshot[]> {
+        const filePath = path.join(projectRoot, METRICS_DIR, METRICS_SNAPSHOT_FILE);
+        let content: string;
+        try {
+            content = await fsPromises.readFile(filePath, 'utf-8');
+        } catch (error) {
+            if ((error as NodeJS.ErrnoException).code === 'ENOENT') return [];
+            throw error;
+        }
+        const snapshots: MetricsSnapshot[] = [];
+        for (const line of content.split('\n')) {
+            if (!line.trim()) continue;
+            try { snapshots.push(JSON.parse(line)); } catch { /* skip partial line */ }
+        }
+        return snapshots.slice(-limit);
+    }
+
+    /** Renders a snapshot as a plain-text report: latencies, other values, cache hit rates, throughput, counters. */
+    static formatReport(snapshot: MetricsSnapshot): string {
+        const out: string[] = [];
+        out.push(`Kai ${snapshot.kaiVersion} - session ${snapshot.sessionSeconds}s (${snapshot.timestamp})`);
+
+        const histogramKeys = Object.keys(snapshot.histograms).sort();
+        const latencyKeys = histogramKeys.filter(k => unitOf(k, snapshot.histograms[k]) === 'ms');
+        const valueKeys = histogramKeys.filter(k => unitOf(k, snapshot.histograms[k]) !== 'ms');
+        const rows = (title: string, keys: string[], format: (value: number, unit: HistogramUnit) => string) => {
+            if (keys.length === 0) return;
+            out.push(title);
+            const width = Math.max(...keys.map(k => k.length));
+            for (const key of keys) {
+                const h = snapshot.histograms[key];
+                const v = (value: number) => format(value, unitOf(key, h));
+                out.push(`  ${key.padEnd(width)}  n=${h.count}  p50=${v(h.p50)}  p95=${v(h.p95)}  p99=${v(h.p99)}  max=${v(h.max)}`);
+            }
+        };
+        rows('Latencies (ms):', latencyKeys, value => `${value}`);
+        rows('Values:', valueKeys, withUnit);
+
+        const caches = new Map<string, { hits: number; misses: number }>();
+        for (const [key, value] of Object.entries(snapshot.counters)) {
+            const { name, labels } = parseMetricKey(key);
+            if ((name === 'cache.hit' || name === 'cache.miss') && labels.cache) {
+                const c = caches.get(labels.cache) ?? { hits: 0, misses: 0 };
+                if (name === 'cache.hit') c.hits += value; else c.misses += value;
+                caches.set(labels.cache, c);
+            }
+        }
+        if (caches.size > 0) {
+            out.push('Cache hit rates:');
+            for (const [cache, c] of [...caches.entries()].sort()) {
+                const total = c.hits + c.misses;
+                out.push(`  ${cache}: ${total ? ((c.hits / total) * 100).toFixed(1) : '0.0'}% (${c.hits}/${total})`);
+            }
+        }
+
+        const scanned = snapshot.counters['fs.files_scanned'];
+        const scanMs = snapshot.histograms['fs.scan_ms']?.sum;
+        if (scanned && scanMs) {
+            out.push(`Files scanned: ${scanned} (${Math.round(scanned / (scanMs / 1000))} files/s)`);
+        }
+
+        const otherCounters = Object.keys(snapshot.counters)
+            .filter(k => !k.startsWith('cache.hit') && !k.startsWith('cache.miss'))
+            .sort();
+        if (otherCounters.length > 0) {
+            out.push('Counters:');
+            for (const key of otherCounters) out.push(`  ${key}: ${snapshot.counters[key]}`);
+        }
+        if (out.length === 1) out.push('No metrics recorded yet.');
+        return out.join('\n');
+    }
+
+    /** Compares p95 values (latencies and others, each in its unit) of the latest snapshot against the one before it. */
+    static formatTrend(snapshots: MetricsSnapshot[]): string {
+        if (snapshots.length < 2) return 'Not enough snapshots to compare yet.';
+        const [previous, latest] = snapshots.slice(-2);
+        const out = [`p95 change vs. previous session (${previous.kaiVersion} -> ${latest.kaiVersion}):`];
+        for (const key of Object.keys(latest.histograms).sort()) {
+            const before = previous.histograms[key];
+            const after = latest.histograms[key];
+            const unit = unitOf(key, after);
+            if (!before || before.p95 === 0) {
+                out.push(`  ${key}: ${withUnit(after.p95, unit)} (new)`);
+                continue;
+            }
+            const change = ((after.p95 - before.p95) / before.p95) * 100;
+            const from = unit === 'ms' ? `${before.p95}` : withUnit(before.p95, unit); // `100 -> 150 ms`, `40% -> 55%`
+            out.push(`  ${key}: ${from} -> ${withUnit(after.p95, unit)} (${change >= 0 ? '+' : ''}${change.toFixed(1)}%)`);
+        }
+        return out.join('\n');
+    }
+
+    private _summarize(h: Histogram): HistogramSummary {
+        const sorted = [...h.samples].sort((a, b) => a - b);
+        return {
+            unit: h.unit,
+            count: h.count,
+            sum: round(h.sum),
+            min: round(h.min),
+            max: round(h.max),
+            p50: round(percentile(sorted, 50)),
+            p95: round(percentile(sorted, 95)),
+            p99: round(percentile(sorted, 99)),
+        };
+    }
+}
+
+/** Process-wide metrics registry. */
+export const metrics = new MetricsRegistry();
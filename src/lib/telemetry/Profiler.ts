@@ -0,0 +1,219 @@
+// File: src/lib/telemetry/Profiler.ts
+import type { Session } from 'inspector';
+import fsPromises from 'fs/promises';
+import path from 'path';
+import chalk from 'chalk';
+
+/** Flows that can be profiled. */
+export type ProfileFlow = 'context' | 'analysis' | 'consolidation';
+export const PROFILE_FLOWS: ProfileFlow[] = ['context', 'analysis', 'consolidation'];
+export const PROFILES_DIR = path.join('.kai', 'profiles');
+
+export interface ProfilerOptions {
+    flows?: ProfileFlow[]; // Defaults to all flows
+    heap?: boolean;        // Also take a heap snapshot when the flow finishes
+}
+
+/** Subset of the V8 CPU profile format we read. */
+export interface CpuProfile {
+    nodes: Array<{ id: number; callFrame: { functionName: string; url: string; lineNumber: number }; hitCount?: number }>;
+    startTime: number;
+    endTime: number;
+    samples?: number[];
+    timeDeltas?: number[];
+}
+
+export interface SelfTimeEntry {
+    functionName: string;
+    location: string;
+    selfMs: number;
+    percent: number;
+}
+
+// Pseudo-frames that are not useful to optimise.
+const IGNORED_FRAMES = new Set(['(idle)', '(root)', '(program)']);
+
+/**
+ * Captures CPU profiles (and optionally heap snapshots) around selected flows using the
+ * inspector module, writing `.cpuprofile` / `.heapsnapshot` files to `.kai/profiles/`.
+ * Only one capture runs at a time; flows nested inside a profiled flow (e.g. the context
+ * build inside a consolidation) are included in the outer profile.
+ */
+export class Profiler {
+    private enabled = false;
+    private flows = new Set<ProfileFlow>(PROFILE_FLOWS);
+    private heap = false;
+    private active: ProfileFlow | null = null;
+    private projectRoot: string = process.cwd();
+
+    get isEnabled(): boolean {
+        return this.enabled;
+    }
+
+    configure(projectRoot: string, options: ProfilerOptions = {}): void {
+        this.projectRoot = projectRoot;
+        this.flows = new Set(options.flows && options.flows.length > 0 ? options.flows : PROFILE_FLOWS);
+        this.heap = !!options.heap;
+    }
+
+    setEnabled(enabled: boolean): void {
+        this.enabled = enabled;
+    }
+
+    /** Parses `--profile`, `--profile=context,analysis` and `--profile-heap` from CLI args. */
+    static parseArgs(args: string[]): { enabled: boolean; options: ProfilerOptions } {
+        let enabled = false;
+        const options: ProfilerOptions = {};
+        for (const arg of args) {
+            if (arg === '--profile') {
+                enabled = true;
+            } else if (arg.startsWith('--profile=')) {
+                enabled = true;
+                const requested = arg.slice('--profile='.length).split(',').map(f => f.trim()).filter(Boolean);
+                const unknown = requested.filter(f => !PROFILE_FLOWS.includes(f as ProfileFlow));
+                if (unknown.length > 0) {
+                    throw new Error(`Unknown profile flow(s): ${unknown.join(', ')}. Expected: ${PROFILE_FLOWS.join(', ')}.`);
+                }
+                options.flows = requested as ProfileFlow[];
+            } else if (arg === '--profile-heap') {
+                enabled = true;
+                options.heap = true;
+            }
+        }
+        return { enabled, options };
+    }
+
+    /** Runs `fn`, capturing a CPU profile around it when profiling is enabled for `flow`. */
+    async around<T>(flow: ProfileFlow, fn: () => Promise<T>): Promise<T> {
+        if (!this.enabled || this.active !== null || !this.flows.has(flow)) return fn();
+
+        this.active = flow;
+        let session: Session | null = null;
+        try {
+            session = await this._startCpuProfile();
+        } catch (error) {
+            console.warn(chalk.yellow(`Profiler: could not start CPU profile for '${flow}':`), (error as Error).message);
+            this.active = null;
+            return fn();
+        }
+
+        try {
+            return await fn();
+        } finally {
+            try {
+                await this._finish(session, flow);
+            } catch (error) {
+                console.error(chalk.red(`Profiler: failed to save profile for '${flow}':`), error);
+            } finally {
+                session.disconnect();
+                this.active = null;
+            }
+        }
+    }
+
+    /** Aggregates self time per function from a CPU profile, highest first. */
+    static topSelfTime(profile: CpuProfile, limit: number = 15): SelfTimeEntry[] {
+        const byId = new Map(profile.nodes.map(n => [n.id, n]));
+        const selfMicros = new Map<number, number>();
+        const samples = profile.samples ?? [];
+        const deltas = profile.timeDeltas ?? [];
+        if (samples.length > 0 && deltas.length === samples.length) {
+            // Each delta is the time since the previous sample; attribute it to the following sample.
+            for (let i = 0; i < samples.length; i++) {
+                const delta = deltas[i + 1] ?? 0;
+                selfMicros.set(samples[i], (selfMicros.get(samples[i]) ?? 0) + Math.max(0, delta));
+            }
+        } else {
+            // No sample timeline: fall back to hit counts spread evenly over the profile.
+            const totalHits = profile.nodes.reduce((sum, n) => sum + (n.hitCount ?? 0), 0) || 1;
+            const perHit = (profile.endTime - profile.startTime) / totalHits;
+            for (const n of profile.nodes) selfMicros.set(n.id, (n.hitCount ?? 0) * perHit);
+        }
+
+        const aggregated = new Map<string, SelfTimeEntry>();
+        let total = 0;
+        for (const [id, micros] of selfMicros) {
+            const node = byId.get(id);
+            if (!node || micros <= 0) continue;
+            total += micros;
+            const name = node.callFrame.functionName || '(anonymous)';
+            if (IGNORED_FRAMES.has(name)) continue;
+            const location = node.callFrame.url
+                ? `${node.callFrame.url.replace(/^file:\/\//, '')}:${node.callFrame.lineNumber + 1}`
+                : '(native)';
+            const key = `${name}@${location}`;
+            const entry = aggregated.get(key) ?? { functionName: name, location, selfMs: 0, percent: 0 };
+            entry.selfMs += micros / 1000;
+            aggregated.set(key, entry);
+        }
+        return [...aggregated.values()]
+            .map(e => ({ ...e, selfMs: Math.round(e.selfMs * 10) / 10, percent: total ? Math.round((e.selfMs * 1000 / total) * 1000) / 10 : 0 }))
+            .sort((a, b) => b.selfMs - a.selfMs)
+            .slice(0, limit);
+    }
+
+    static formatSelfTime(entries: SelfTimeEntry[]): string {
+        if (entries.length === 0) return '  (no samples recorded)';
+        return entries
+            .map(e => `  ${e.selfMs.toFixed(1).padStart(9)} ms  ${e.percent.toFixed(1).padStart(5)}%  ${e.functionName}  ${e.location}`)
+            .join('\n');
+    }
+
+    // --- Inspector plumbing ---
+
+    private _post<T = any>(session: Session, method: string, params?: object): Promise<T> {
+        return new Promise((resolve, reject) => {
+            session.post(method, params ?? {}, (err: Error | null, result?: any) => err ? reject(err) : resolve(result as T));
+        });
+    }
+
+    private async _startCpuProfile(): Promise<Session> {
+        // Required lazily so normal sessions never load the inspector.
+        const inspector: typeof import('inspector') = require('inspector');
+        const session = new inspector.Session();
+        session.connect();
+        await this._post(session, 'Profiler.enable');
+        await this._post(session, 'Profiler.setSamplingInterval', { interval: 1000 }); // 1ms
+        await this._post(session, 'Profiler.start');
+        return session;
+    }
+
+    private async _finish(session: Session, flow: ProfileFlow): Promise<void> {
+        const { profile } = await this._post<{ profile: CpuProfile }>(session, 'Profiler.stop');
+        const dir = path.join(this.projectRoot, PROFILES_DIR);
+        await fsPromises.mkdir(dir, { recursive: true });
+        const base = path.join(dir, `${new Date().toISOString().replace(/[:.]/g, '-')}-${flow}`);
+
+        await fsPromises.writeFile(`${base}.cpuprofile`, JSON.stringify(profile));
+        const top = Profiler.topSelfTime(profile);
+        const summary = `Top self time for '${flow}' (${((profile.endTime - profile.startTime) / 1000).toFixed(0)} ms profiled):\n${Profiler.formatSelfTime(top)}\n`;
+        await fsPromises.writeFile(`${base}.summary.txt`, summary);
+        console.log(chalk.cyan(`\n🔬 CPU profile saved: ${path.relative(this.projectRoot, base)}.cpuprofile`));
+        console.log(chalk.dim(summary));
+
+        if (this.heap) {
+            await this._writeHeapSnapshot(session, `${base}.heapsnapshot`);
+            console.log(chalk.cyan(`🔬 Heap snapshot saved: ${path.relative(this.projectRoot, base)}.heapsnapshot`));
+        }
+    }
+
+    private async _writeHeapSnapshot(session: Session, filePath: string): Promise<void> {
+        const handle = await fsPromises.open(filePath, 'w');
+        // Chunks arrive as events while takeHeapSnapshot runs; chain writes to keep them ordered.
+        let writes = Promise.resolve();
+        const onChunk = (message: { params: { chunk: string } }) => {
+            writes = writes.then(() => handle.write(message.params.chunk).then(() => undefined));
+        };
+        session.on('HeapProfiler.addHeapSnapshotChunk', onChunk);
+        try {
+            await this._post(session, 'HeapProfiler.takeHeapSnapshot', { reportProgress: false });
+            await writes;
+        } finally {
+            session.removeListener('HeapProfiler.addHeapSnapshotChunk', onChunk);
+            await handle.close();
+        }
+    }
+}
+
+/** Process-wide profiler, configured from `--profile` or the menu toggle. */
+export const profiler = new Profiler();
@@ -0,0 +1,182 @@
+// File: src/lib/telemetry/Tracer.ts
+import { AsyncLocalStorage } from 'async_hooks';
+import { performance } from 'perf_hooks';
+import fsPromises from 'fs/promises';
+import path from 'path';
+import chalk from 'chalk';
+
+export type SpanArgs = Record<string, string | number | boolean | null | undefined>;
+
+/** One Chrome trace-event record (see the "Trace Event Format" spec; ts/dur are microseconds). */
+export interface TraceEvent {
+    name: string;
+    cat: string;
+    ph: 'X' | 'i' | 'M';
+    ts: number;
+    dur?: number;
+    pid: number;
+    tid: number;
+    s?: 't';
+    args?: SpanArgs;
+}
+
+interface OpenSpan {
+    lane: number;
+}
+
+export const TRACES_DIR = path.join('.kai', 'traces');
+const DEFAULT_MAX_EVENTS = 200000;
+
+/**
+ * Lightweight span recorder that exports Chrome trace-event JSON (open in chrome://tracing
+ * or https://ui.perfetto.dev for a flame chart).
+ *
+ * When disabled, `span()` calls straight through to the wrapped function: no clock reads,
+ * no allocation beyond the call itself. When enabled, spans nest via AsyncLocalStorage and
+ * concurrent spans are spread over separate "lanes" (trace threads) so the chart stays readable.
+ */
+export class Tracer {
+    private enabled: boolean;
+    private events: TraceEvent[] = [];
+    private lanes: OpenSpan[][] = [];
+    private storage = new AsyncLocalStorage<OpenSpan>();
+    private dropped = 0;
+    private readonly maxEvents: number;
+
+    constructor(enabled: boolean = false, maxEvents: number = DEFAULT_MAX_EVENTS) {
+        this.enabled = enabled;
+        this.maxEvents = maxEvents;
+    }
+
+    get isEnabled(): boolean {
+        return this.enabled;
+    }
+
+    setEnabled(enabled: boolean): void {
+        this.enabled = enabled;
+    }
+
+    /** Times an async (or sync) operation as a span. Errors are recorded and rethrown. */
+    async span<T>(name: string, cat: string, fn: () => Promise<T> | T, args?: SpanArgs): Promise<T> {
+        if (!this.enabled) return fn();
+        const span = this._open();
+        const start = performance.now();
+        let error: string | undefined;
+        try {
+            return await this.storage.run(span, fn);
+        } catch (e) {
+            error = e instanceof Error ? e.message : String(e);
+            throw e;
+        } finally {
+            this._close(span, name, cat, start, error ? { ...args, error } : args);
+        }
+    }
+
+    /** Synchronous variant of span() for CPU-bound work such as tokenization. */
+    spanSync<T>(name: string, cat: string, fn: () => T, args?: SpanArgs): T {
+        if (!this.enabled) return fn();
+        const span = this._open();
+        const start = performance.now();
+        try {
+            return this.storage.run(span, fn);
+        } finally {
+            this._close(span, name, cat, start, args);
+        }
+    }
+
+    /** Records a zero-duration marker (e.g. a retry or a rate-limit hit) on the current lane. */
+    instant(name: string, cat: string, args?: SpanArgs): void {
+        if (!this.enabled) return;
+        const lane = this.storage.getStore()?.lane ?? 0;
+        this._push({ name, cat, ph: 'i', s: 't', ts: this._micros(performance.now()), pid: process.pid, tid: lane + 1, args });
+    }
+
+    /** Returns a copy of the recorded events (mainly for tests). */
+    getEvents(): TraceEvent[] {
+        return [...this.events];
+    }
+
+    /**
+     * Writes the recorded events to `.kai/traces/trace-<timestamp>-<label>.json` and clears the buffer.
+     * @returns The written file path, or null if tracing is disabled or nothing was recorded.
+     */
+    async flush(projectRoot: string, label: string = 'session'): Promise<string | null> {
+        if (!this.enabled || this.events.length === 0) return null;
+        const events = this.events;
+        const dropped = this.dropped;
+        this.events = [];
+        this.dropped = 0;
+
+        const laneCount = events.reduce((max, e) => Math.max(max, e.tid), Math.max(1, this.lanes.length));
+        const metadata: TraceEvent[] = [
+            { name: 'process_name', cat: '__metadata', ph: 'M', ts: 0, pid: process.pid, tid: 0, args: { name: 'kai' } },
+        ];
+        for (let tid = 1; tid <= laneCount; tid++) {
+            metadata.push({ name: 'thread_name', cat: '__metadata', ph: 'M', ts: 0, pid: process.pid, tid, args: { name: `lane ${tid}` } });
+        }
+
+        const stamp = new Date().toISOString().replace(/[:.]/g, '-');
+        const safeLabel = label.replace(/[^a-zA-Z0-9_-]+/g, '_').slice(0, 60) || 'session';
+        const dir = path.join(projectRoot, TRACES_DIR);
+        const filePath = path.join(dir, `trace-${stamp}-${safeLabel}.json`);
+        try {
+            await fsPromises.mkdir(dir, { recursive: true });
+            await fsPromises.writeFile(filePath, JSON.stringify({
+                traceEvents: [...metadata, ...events],
+                displayTimeUnit: 'ms',
+                otherData: { droppedEvents: dropped },
+            }));
+            console.log(chalk.dim(`Trace written to ${path.relative(projectRoot, filePath)} (${events.length} events${dropped ? `, ${dropped} dropped` : ''}).`));
+            return filePath;
+        } catch (error) {
+            console.error(chalk.red(`Failed to write trace file ${filePath}:`), error);
+            return null;
+        }
+    }
+
+    // --- Lane bookkeeping ---
+
+    private _open(): OpenSpan {
+        const parent = this.storage.getStore();
+        let lane = -1;
+        if (parent) {
+            const stack = this.lanes[parent.lane];
+            // Stay on the parent's lane only while the parent is innermost; siblings running
+            // concurrently would otherwise overlap without nesting.
+            if (stack && stack[stack.length - 1] === parent) lane = parent.lane;
+        }
+        if (lane === -1) {
+            lane = this.lanes.findIndex(stack => stack.length === 0);
+            if (lane === -1) {
+                lane = this.lanes.length;
+                this.lanes.push([]);
+            }
+        }
+        const span: OpenSpan = { lane };
+        this.lanes[lane].push(span);
+        return span;
+    }
+
+    private _close(span: OpenSpan, name: string, cat: string, start: number, args?: SpanArgs): void {
+        const stack = this.lanes[span.lane];
+        const idx = stack.lastIndexOf(span);
+        if (idx !== -1) stack.splice(idx, 1);
+        const ts = this._micros(start);
+        this._push({ name, cat, ph: 'X', ts, dur: Math.max(0, this._micros(performance.now()) - ts), pid: process.pid, tid: span.lane + 1, args });
+    }
+
+    private _push(event: TraceEvent): void {
+        if (this.events.length >= this.maxEvents) {
+            this.dropped++;
+            return;
+        }
+        this.events.push(event);
+    }
+
+    private _micros(ms: number): number {
+        return Math.round(ms * 1000);
+    }
+}
+
+/** Process-wide tracer. Enabled with `KAI_TRACE=1` or the `--trace` flag. */
+export const tracer = new Tracer(!!process.env.KAI_TRACE && process.env.KAI_TRACE !== '0');
@@ -0,0 +1,89 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { MetricsRegistry, metricKey, parseMetricKey, METRICS_DIR } from '../Metrics';
+
+describe('MetricsRegistry', () => {
+  it('keys labels in a stable order and parses them back', () => {
+    expect(metricKey('model.calls', { provider: 'gemini', op: 'text' })).toBe('model.calls{op=text,provider=gemini}');
+    expect(metricKey('plain')).toBe('plain');
+    expect(parseMetricKey('cache.hit{cache=analysis}')).toEqual({ name: 'cache.hit', labels: { cache: 'analysis' } });
+  });
+
+  it('counts and summarises latencies with percentiles', async () => {
+    const registry = new MetricsRegistry();
+    registry.increment('model.calls', { provider: 'gemini' });
+    registry.increment('model.calls', { provider: 'gemini' }, 2);
+    for (let i = 1; i <= 100; i++) registry.observe('model.latency_ms', i);
+    await registry.time('fs.scan_ms', undefined, async () => undefined);
+
+    expect(registry.counter('model.calls', { provider: 'gemini' })).toBe(3);
+    const h = registry.histogram('model.latency_ms')!;
+    expect(h).toMatchObject({ count: 100, min: 1, max: 100, p50: 50, p95: 95, p99: 99 });
+    expect(registry.histogram('fs.scan_ms')!.count).toBe(1);
+  });
+
+  it('reports cache hit rates, throughput and counters', () => {
+    const registry = new MetricsRegistry();
+    registry.recordCacheAccess('analysis', true);
+    registry.recordCacheAccess('analysis', true);
+    registry.recordCacheAccess('analysis', false);
+    registry.increment('fs.files_scanned', undefined, 500);
+    registry.observe('fs.scan_ms', 250);
+    registry.increment('model.rate_limited', { provider: 'gemini' });
+
+    const report = MetricsRegistry.formatReport(registry.snapshot());
+    expect(report).toContain('analysis: 66.7% (2/3)');
+    expect(report).toContain('Files scanned: 500 (2000 files/s)');
+    expect(report).toContain('model.rate_limited{provider=gemini}: 1');
+    expect(report).toMatch(/fs\.scan_ms\s+n=1\s+p50=250/);
+  });
+
+  it('reports non-latency histograms in their own unit', () => {
+    const registry = new MetricsRegistry();
+    registry.observe('model.latency_ms', 120);
+    registry.observe('context.selection_precision_pct', 40, undefined, '%');
+    registry.observe('consolidation.generation_levels', 3, undefined, 'count');
+    expect(registry.histogram('consolidation.generation_levels')!.unit).toBe('count');
+
+    const report = MetricsRegistry.formatReport(registry.snapshot());
+    const [latencies, values] = report.split('Values:');
+    expect(latencies).toMatch(/Latencies \(ms\):\n\s+model\.latency_ms\s+n=1\s+p50=120\s/);
+    expect(latencies).not.toContain('generation_levels');
+    expect(values).toMatch(/context\.selection_precision_pct\s+n=1\s+p50=40%/);
+    expect(values).toMatch(/consolidation\.generation_levels\s+n=1\s+p50=3\s/);
+
+    const previous = registry.snapshot();
+    registry.reset();
+    registry.observe('context.selection_precision_pct', 60, undefined, '%');
+    registry.observe('consolidation.generation_levels', 4, undefined, 'count');
+    const { unit: _unit, ...legacy } = previous.histograms['consolidation.generation_levels']; // Written before units were recorded
+    previous.histograms['consolidation.generation_levels'] = legacy;
+    const trend = MetricsRegistry.formatTrend([previous, registry.snapshot()]);
+    expect(trend).toContain('context.selection_precision_pct: 40% -> 60% (+50.0%)');
+    expect(trend).toContain('consolidation.generation_levels: 3 -> 4 (+33.3%)');
+  });
+
+  it('appends snapshots to disk and compares the last two', async () => {
+    const tmpDir = fs.mkdtempSync(path.join(os.tmpdir(), 'metrics-'));
+    try {
+      const registry = new MetricsRegistry();
+      await expect(registry.writeSnapshot(tmpDir)).resolves.toBeNull(); // nothing recorded yet
+
+      registry.observe('context.build_ms', 100);
+      await registry.writeSnapshot(tmpDir);
+      registry.reset();
+      registry.observe('context.build_ms', 150);
+      const file = await registry.writeSnapshot(tmpDir);
+      expect(file).toBe(path.join(tmpDir, METRICS_DIR, 'snapshots.jsonl'));
+      fs.appendFileSync(file!, '{"partial');
+
+      const snapshots = await MetricsRegistry.readSnapshots(tmpDir);
+      expect(snapshots).toHaveLength(2);
+      expect(MetricsRegistry.formatTrend(snapshots)).toContain('context.build_ms: 100 -> 150 ms (+50.0%)');
+      await expect(MetricsRegistry.readSnapshots(path.join(tmpDir, 'missing'))).resolves.toEqual([]);
+    } finally {
+      fs.rmSync(tmpDir, { recursive: true, force: true });
+    }
+  });
+});
@@ -0,0 +1,67 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { CpuProfile, Profiler, PROFILES_DIR } from '../Profiler';
+
+const frame = (functionName: string, lineNumber = 0) => ({ functionName, url: 'file:///app/x.js', lineNumber });
+
+describe('Profiler', () => {
+  it('parses --profile flags', () => {
+    expect(Profiler.parseArgs(['--trace'])).toEqual({ enabled: false, options: {} });
+    expect(Profiler.parseArgs(['--profile'])).toEqual({ enabled: true, options: {} });
+    expect(Profiler.parseArgs(['--profile=analysis,context', '--profile-heap']))
+      .toEqual({ enabled: true, options: { flows: ['analysis', 'context'], heap: true } });
+    expect(() => Profiler.parseArgs(['--profile=bogus'])).toThrow('Unknown profile flow');
+  });
+
+  it('ranks functions by self time from the sample timeline', () => {
+    const profile: CpuProfile = {
+      nodes: [
+        { id: 1, callFrame: frame('(root)') },
+        { id: 2, callFrame: frame('hot', 9) },
+        { id: 3, callFrame: frame('warm', 19) },
+        { id: 4, callFrame: frame('(idle)') },
+      ],
+      startTime: 0,
+      endTime: 10000,
+      samples: [2, 2, 3, 4, 2],
+      timeDeltas: [0, 1000, 1000, 2000, 4000],
+    };
+    const top = Profiler.topSelfTime(profile);
+    expect(top.map(e => e.functionName)).toEqual(['hot', 'warm']);
+    expect(top[0]).toEqual({ functionName: 'hot', location: '/app/x.js:10', selfMs: 2, percent: 25 });
+    expect(top[1].selfMs).toBe(2);
+    expect(Profiler.formatSelfTime(top)).toContain('hot  /app/x.js:10');
+  });
+
+  it('falls back to hit counts when there is no timeline', () => {
+    const top = Profiler.topSelfTime({
+      nodes: [{ id: 1, callFrame: frame('a'), hitCount: 3 }, { id: 2, callFrame: frame('b'), hitCount: 1 }],
+      startTime: 0,
+      endTime: 4000,
+    });
+    expect(top.map(e => [e.functionName, e.selfMs])).toEqual([['a', 3], ['b', 1]]);
+  });
+
+  it('calls straight through when disabled and captures a profile when enabled', async () => {
+    const tmpDir = fs.mkdtempSync(path.join(os.tmpdir(), 'profile-'));
+    const log = jest.spyOn(console, 'log').mockImplementation(() => undefined);
+    try {
+      const profiler = new Profiler();
+      profiler.configure(tmpDir, { flows: ['analysis'] });
+      await expect(profiler.around('analysis', async () => 1)).resolves.toBe(1);
+      expect(fs.existsSync(path.join(tmpDir, PROFILES_DIR))).toBe(false);
+
+      profiler.setEnabled(true);
+      await expect(profiler.around('context', async () => 2)).resolves.toBe(2); // Not a selected flow
+      await expect(profiler.around('analysis', async () => 3)).resolves.toBe(3);
+      const files = fs.readdirSync(path.join(tmpDir, PROFILES_DIR)).sort();
+      expect(files.some(f => f.endsWith('-analysis.cpuprofile'))).toBe(true);
+      expect(files.some(f => f.endsWith('-analysis.summary.txt'))).toBe(true);
+      expect(files.some(f => f.includes('context'))).toBe(false);
+    } finally {
+      log.mockRestore();
+      fs.rmSync(tmpDir, { recursive: true, force: true });
+    }
+  });
+});
@@ -0,0 +1,66 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { Tracer, TRACES_DIR } from '../Tracer';
+
+describe('Tracer', () => {
+  it('calls straight through and records nothing when disabled', async () => {
+    const tracer = new Tracer(false);
+    await expect(tracer.span('a', 'test', async () => 42)).resolves.toBe(42);
+    expect(tracer.spanSync('b', 'test', () => 'x')).toBe('x');
+    tracer.instant('c', 'test');
+    expect(tracer.getEvents()).toHaveLength(0);
+  });
+
+  it('records nested spans on the same lane and errors as args', async () => {
+    const tracer = new Tracer(true);
+    await tracer.span('outer', 'test', async () => {
+      await tracer.span('inner', 'test', async () => undefined);
+      tracer.instant('retry', 'test', { attempt: 1 });
+    });
+    await expect(tracer.span('fails', 'test', async () => { throw new Error('boom'); })).rejects.toThrow('boom');
+
+    const events = tracer.getEvents();
+    const outer = events.find(e => e.name === 'outer')!;
+    const inner = events.find(e => e.name === 'inner')!;
+    expect(outer.ph).toBe('X');
+    expect(inner.tid).toBe(outer.tid);
+    expect(inner.ts).toBeGreaterThanOrEqual(outer.ts);
+    expect(inner.ts + inner.dur!).toBeLessThanOrEqual(outer.ts + outer.dur!);
+    expect(events.find(e => e.name === 'retry')!.ph).toBe('i');
+    expect(events.find(e => e.name === 'fails')!.args).toEqual({ error: 'boom' });
+  });
+
+  it('puts concurrent siblings on separate lanes', async () => {
+    const tracer = new Tracer(true);
+    const sleep = (ms: number) => new Promise(r => setTimeout(r, ms));
+    await tracer.span('parent', 'test', () => Promise.all([
+      tracer.span('a', 'test', () => sleep(5)),
+      tracer.span('b', 'test', () => sleep(5)),
+    ]));
+    const events = tracer.getEvents();
+    const a = events.find(e => e.name === 'a')!;
+    const b = events.find(e => e.name === 'b')!;
+    expect(a.tid).not.toBe(b.tid);
+  });
+
+  it('caps the buffer and flushes Chrome trace JSON', async () => {
+    const tmpDir = fs.mkdtempSync(path.join(os.tmpdir(), 'trace-'));
+    try {
+      const tracer = new Tracer(true, 2);
+      for (let i = 0; i < 4; i++) tracer.spanSync(`s${i}`, 'test', () => i);
+      const file = await tracer.flush(tmpDir, 'unit test');
+      expect(file).not.toBeNull();
+      expect(path.dirname(file!)).toBe(path.join(tmpDir, TRACES_DIR));
+      expect(path.basename(file!)).toMatch(/^trace-.*-unit_test\.json$/);
+      const trace = JSON.parse(fs.readFileSync(file!, 'utf8'));
+      expect(trace.traceEvents.filter((e: any) => e.ph === 'X')).toHaveLength(2);
+      expect(trace.traceEvents.some((e: any) => e.ph === 'M' && e.name === 'process_name')).toBe(true);
+      expect(trace.otherData.droppedEvents).toBe(2);
+      expect(tracer.getEvents()).toHaveLength(0);
+      await expect(tracer.flush(tmpDir)).resolves.toBeNull();
+    } finally {
+      fs.rmSync(tmpDir, { recursive: true, force: true });
+    }
+  });
+});
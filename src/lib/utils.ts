@@ -1,4 +1,14 @@
-import {encode as gpt3Encode} from "gpt-3-encoder";
+import type * as Gpt3Encoder from "gpt-3-encoder";
+
+// The encoder ships a large BPE vocabulary; load it on the first token count, not at startup.
+let tokenEncoder: typeof Gpt3Encoder | null = null;
+
+export function getTokenEncoder(): typeof Gpt3Encoder {
+    if (!tokenEncoder) {
+        tokenEncoder = require("gpt-3-encoder") as typeof Gpt3Encoder;
+    }
+    return tokenEncoder;
+}
 
 export function toSnakeCase(str: string): string {
     return str.trim()
@@ -8,5 +18,5 @@ export function toSnakeCase(str: string): string {
         .toLowerCase(); // Convert to lowercase
 }
 export function countTokens(text: string): number {
-    return gpt3Encode(text).length;
+    return getTokenEncoder().encode(text).length;
 }
\ No newline at end of file
@@ -0,0 +1,179 @@
+// File: src/lib/workspace/WorkspaceDetector.ts
+import fsPromises from 'fs/promises';
+import type { Dirent } from 'fs';
+import path from 'path';
+import yaml from 'js-yaml';
+
+export interface WorkspacePackage {
+    name: string;
+    dir: string; // Relative to the project root, POSIX separators
+    dependencies: string[]; // Names of other workspace packages this one depends on
+}
+
+export interface WorkspaceInfo {
+    tool: 'npm' | 'yarn' | 'pnpm';
+    packages: WorkspacePackage[];
+}
+
+const WORKSPACE_CACHE_DIR = path.join('.kai', 'workspaces');
+const SKIPPED_DIRS = new Set(['node_modules', '.git', '.kai']);
+const MAX_GLOBSTAR_DEPTH = 6;
+
+/**
+ * Detects npm/yarn/pnpm workspaces (package.json `workspaces` or pnpm-workspace.yaml),
+ * resolves their package globs and the dependency graph between workspace packages.
+ */
+export class WorkspaceDetector {
+    /** Returns null when the project is not a workspaces monorepo. */
+    static async detect(projectRoot: string): Promise<WorkspaceInfo | null> {
+        let patterns: string[] = [];
+        let tool: WorkspaceInfo['tool'] = 'npm';
+
+        const pnpmConfig = await WorkspaceDetector._readText(path.join(projectRoot, 'pnpm-workspace.yaml'));
+        if (pnpmConfig !== null) {
+            const parsed = yaml.load(pnpmConfig) as { packages?: unknown } | null;
+            if (Array.isArray(parsed?.packages)) patterns = parsed!.packages as string[];
+            tool = 'pnpm';
+        } else {
+            const rootManifest = await WorkspaceDetector._readJson(path.join(projectRoot, 'package.json'));
+            const workspaces = rootManifest?.workspaces;
+            patterns = Array.isArray(workspaces) ? workspaces : Array.isArray(workspaces?.packages) ? workspaces.packages : [];
+            if (await WorkspaceDetector._readText(path.join(projectRoot, 'yarn.lock')) !== null) tool = 'yarn';
+        }
+        patterns = patterns.filter(p => typeof p === 'string' && p.trim());
+        if (patterns.length === 0) return null;
+
+        const includes = patterns.filter(p => !p.startsWith('!'));
+        const excludes = patterns.filter(p => p.startsWith('!')).map(p => WorkspaceDetector._globToRegExp(p.slice(1)));
+        const dirs = new Set<string>();
+        for (const pattern of includes) {
+            for (const dir of await WorkspaceDetector._expand(projectRoot, pattern)) {
+                if (!excludes.some(re => re.test(dir))) dirs.add(dir);
+            }
+        }
+
+        const manifests: { dir: string; manifest: any }[] = [];
+        for (const dir of [...dirs].sort()) {
+            const manifest = await WorkspaceDetector._readJson(path.join(projectRoot, dir, 'package.json'));
+            if (manifest) manifests.push({ dir, manifest });
+        }
+        const names = new Set(manifests.map(m => m.manifest.name ?? m.dir));
+        const packages = manifests.map(({ dir, manifest }) => {
+            const declared = { ...manifest.dependencies, ...manifest.devDependencies, ...manifest.peerDependencies };
+            return {
+                name: manifest.name ?? dir,
+                dir,
+                dependencies: Object.keys(declared).filter(dep => names.has(dep)).sort(),
+            };
+        });
+        return packages.length > 0 ? { tool, packages } : null;
+    }
+
+    /**
+     * Resolves package names (or directories) to those packages plus every workspace package
+     * they depend on, directly or transitively. Throws on an unknown name.
+     */
+    static resolveScope(info: WorkspaceInfo, requested: string[]): WorkspacePackage[] {
+        const byName = new Map(info.packages.map(p => [p.name, p]));
+        const byDir = new Map(info.packages.map(p => [p.dir, p]));
+        const selected = new Map<string, WorkspacePackage>();
+        const queue: WorkspacePackage[] = [];
+        for (const name of requested) {
+            const pkg = byName.get(name) ?? byDir.get(name.replace(/\\/g, '/').replace(/\/+$/, ''));
+            if (!pkg) throw new Error(`Unknown workspace package '${name}'. Known packages: ${info.packages.map(p => p.name).join(', ')}`);
+            queue.push(pkg);
+        }
+        while (queue.length > 0) {
+            const pkg = queue.shift()!;
+            if (selected.has(pkg.name)) continue;
+            selected.set(pkg.name, pkg);
+            for (const dep of pkg.dependencies) {
+                const depPkg = byName.get(dep);
+                if (depPkg) queue.push(depPkg);
+            }
+        }
+        return info.packages.filter(p => selected.has(p.name));
+    }
+
+    /** Relative path of a package's own analysis cache. */
+    static cachePathFor(pkg: WorkspacePackage): string {
+        const safeName = pkg.name.replace(/^@/, '').replace(/[^A-Za-z0-9._-]+/g, '__');
+        return path.join(WORKSPACE_CACHE_DIR, safeName, 'project_analysis.json');
+    }
+
+    /** True if a project-relative path lies inside one of the packages. */
+    static contains(packages: WorkspacePackage[], relativePath: string): boolean {
+        const normalized = relativePath.replace(/\\/g, '/');
+        return packages.some(p => normalized === p.dir || normalized.startsWith(`${p.dir}/`));
+    }
+
+    // --- Glob expansion (the subset workspace globs use: literal segments, `*`, `**`, `name-*`) ---
+
+    private static async _expand(projectRoot: string, pattern: string): Promise<string[]> {
+        const segments = pattern.replace(/\\/g, '/').replace(/^\.\//, '').replace(/\/+$/, '').split('/').filter(Boolean);
+        let current = [''];
+        for (const segment of segments) {
+            const next: string[] = [];
+            for (const base of current) {
+                if (segment === '**') {
+                    next.push(base, ...await WorkspaceDetector._subdirs(projectRoot, base, MAX_GLOBSTAR_DEPTH));
+                } else if (/[*?]/.test(segment)) {
+                    const re = WorkspaceDetector._globToRegExp(segment);
+                    for (const dir of await WorkspaceDetector._subdirs(projectRoot, base, 1)) {
+                        if (re.test(path.posix.basename(dir))) next.push(dir);
+                    }
+                } else {
+                    next.push(base ? `${base}/${segment}` : segment);
+                }
+            }
+            current = [...new Set(next)];
+        }
+        return current.filter(Boolean);
+    }
+
+    private static async _subdirs(projectRoot: string, base: string, depth: number): Promise<string[]> {
+        let entries: Dirent[];
+        try {
+            entries = await fsPromises.readdir(path.join(projectRoot, base), { withFileTypes: true });
+        } catch {
+            return [];
+        }
+        const dirs: string[] = [];
+        for (const entry of entries) {
+            if (!entry.isDirectory() || SKIPPED_DIRS.has(entry.name) || entry.name.startsWith('.')) continue;
+            const dir = base ? `${base}/${entry.name}` : entry.name;
+            dirs.push(dir);
+            if (depth > 1) dirs.push(...await WorkspaceDetector._subdirs(projectRoot, dir, depth - 1));
+        }
+        return dirs;
+    }
+
+    private static _globToRegExp(glob: string): RegExp {
+        const source = glob.replace(/\\/g, '/').replace(/^\.\//, '').replace(/\/+$/, '')
+            .split('/')
+            .map(segment => segment === '**'
+                ? '(?:.*)'
+                : segment.replace(/[.+^${}()|[\]]/g, '\\$&').replace(/\*/g, '[^/]*').replace(/\?/g, '[^/]'))
+            .join('/')
+            .replace(/\(\?:\.\*\)\//g, '(?:.*/)?');
+        return new RegExp(`^${source}$`);
+    }
+
+    private static async _readText(filePath: string): Promise<string | null> {
+        try {
+            return await fsPromises.readFile(filePath, 'utf-8');
+        } catch {
+            return null;
+        }
+    }
+
+    private static async _readJson(filePath: string): Promise<any | null> {
+        const text = await WorkspaceDetector._readText(filePath);
+        if (text === null) return null;
+        try {
+            return JSON.parse(text);
+        } catch {
+            return null;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { WorkspaceDetector } from '../WorkspaceDetector';
+
+const writeJson = (file: string, data: unknown) => {
+  fs.mkdirSync(path.dirname(file), { recursive: true });
+  fs.writeFileSync(file, JSON.stringify(data));
+};
+
+describe('WorkspaceDetector', () => {
+  let root: string;
+  beforeEach(() => {
+    root = fs.mkdtempSync(path.join(os.tmpdir(), 'workspaces-'));
+    writeJson(path.join(root, 'packages/core/package.json'), { name: '@acme/core' });
+    writeJson(path.join(root, 'packages/api/package.json'), { name: '@acme/api', dependencies: { '@acme/core': '*', express: '^4' } });
+    writeJson(path.join(root, 'packages/web/package.json'), { name: '@acme/web', devDependencies: { '@acme/api': 'workspace:*' } });
+    writeJson(path.join(root, 'packages/legacy/package.json'), { name: '@acme/legacy' });
+    fs.mkdirSync(path.join(root, 'packages/notes')); // No package.json: not a package
+    writeJson(path.join(root, 'tools/nested/cli/package.json'), { name: 'cli' });
+  });
+
+  it('returns null for a project without workspaces', async () => {
+    writeJson(path.join(root, 'package.json'), { name: 'plain' });
+    expect(await WorkspaceDetector.detect(root)).toBeNull();
+  });
+
+  it('reads package.json workspaces with exclusions and globstars', async () => {
+    writeJson(path.join(root, 'package.json'), { workspaces: ['packages/*', '!packages/legacy', 'tools/**'] });
+    fs.writeFileSync(path.join(root, 'yarn.lock'), '');
+    const info = await WorkspaceDetector.detect(root);
+    expect(info?.tool).toBe('yarn');
+    expect(info?.packages).toEqual([
+      { name: '@acme/api', dir: 'packages/api', dependencies: ['@acme/core'] },
+      { name: '@acme/core', dir: 'packages/core', dependencies: [] },
+      { name: '@acme/web', dir: 'packages/web', dependencies: ['@acme/api'] },
+      { name: 'cli', dir: 'tools/nested/cli', dependencies: [] },
+    ]);
+  });
+
+  it('reads pnpm-workspace.yaml and resolves the dependency closure of a scope', async () => {
+    fs.writeFileSync(path.join(root, 'pnpm-workspace.yaml'), "packages:\n  - 'packages/*'\n");
+    const info = (await WorkspaceDetector.detect(root))!;
+    expect(info.tool).toBe('pnpm');
+    expect(info.packages.map(p => p.name)).toContain('@acme/legacy');
+
+    const scope = WorkspaceDetector.resolveScope(info, ['@acme/web']);
+    expect(scope.map(p => p.name)).toEqual(['@acme/api', '@acme/core', '@acme/web']);
+    expect(WorkspaceDetector.resolveScope(info, ['packages/core/']).map(p => p.name)).toEqual(['@acme/core']);
+    expect(() => WorkspaceDetector.resolveScope(info, ['nope'])).toThrow(/Unknown workspace package 'nope'/);
+
+    expect(WorkspaceDetector.contains(scope, 'packages/api/src/index.ts')).toBe(true);
+    expect(WorkspaceDetector.contains(scope, 'packages/apiary/index.ts')).toBe(false);
+    expect(WorkspaceDetector.cachePathFor(scope[0])).toBe(path.join('.kai', 'workspaces', 'acme__api', 'project_analysis.json'));
+  });
+});